@@ -0,0 +1,137 @@
+#include "msg_bus.h"
+
+#define TAG "MSG_BUS"
+
+esp_err_t msg_bus_publish(msg_topic_t *topic, const void *value, size_t size) {
+    if (!topic || !value) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (size != topic->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    TaskHandle_t subscribers[MSG_BUS_MAX_SUBSCRIBERS];
+    uint32_t notify_bits[MSG_BUS_MAX_SUBSCRIBERS];
+    taskENTER_CRITICAL(&topic->lock);
+    atomic_fetch_add_explicit(&topic->seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(topic->data, value, size);
+    topic->publish_us = esp_timer_get_time();
+    atomic_fetch_add_explicit(&topic->seq, 1, memory_order_release);
+    topic->stats.published++;
+    int num = topic->subscriber_num;
+    memcpy(subscribers, topic->subscribers, sizeof(TaskHandle_t) * num);
+    memcpy(notify_bits, topic->notify_bits, sizeof(uint32_t) * num);
+    taskEXIT_CRITICAL(&topic->lock);
+
+    // 通知位可合并, 订阅者处理慢时不会堆积
+    for (int i = 0; i < num; i++) {
+        xTaskNotify(subscribers[i], notify_bits[i], eSetBits);
+    }
+    return ESP_OK;
+}
+
+esp_err_t msg_bus_subscribe(msg_topic_t *topic, msg_sub_t *sub, TaskHandle_t task, uint32_t notify_bits) {
+    if (!topic || !sub) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!task) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    sub->topic = topic;
+    sub->last_seq = atomic_load_explicit(&topic->seq, memory_order_acquire) & ~1U;
+    if (!notify_bits) {
+        return ESP_OK; // 只轮询读取, 不需要通知
+    }
+
+    esp_err_t ret = ESP_OK;
+    taskENTER_CRITICAL(&topic->lock);
+    if (topic->subscriber_num < MSG_BUS_MAX_SUBSCRIBERS) {
+        topic->subscribers[topic->subscriber_num] = task;
+        topic->notify_bits[topic->subscriber_num] = notify_bits;
+        topic->subscriber_num++;
+    } else {
+        ret = ESP_ERR_NO_MEM;
+    }
+    taskEXIT_CRITICAL(&topic->lock);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "主题 %s 订阅者已满", topic->name);
+    }
+    return ret;
+}
+
+esp_err_t msg_bus_unsubscribe(msg_sub_t *sub, TaskHandle_t task) {
+    if (!sub || !sub->topic) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!task) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    msg_topic_t *topic = sub->topic;
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    taskENTER_CRITICAL(&topic->lock);
+    for (int i = 0; i < topic->subscriber_num; i++) {
+        if (topic->subscribers[i] == task) {
+            topic->subscriber_num--;
+            topic->subscribers[i] = topic->subscribers[topic->subscriber_num];
+            topic->notify_bits[i] = topic->notify_bits[topic->subscriber_num];
+            ret = ESP_OK;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&topic->lock);
+    sub->topic = NULL;
+    return ret;
+}
+
+esp_err_t msg_bus_read(msg_sub_t *sub, void *value, size_t size) {
+    if (!sub || !sub->topic || !value) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    msg_topic_t *topic = sub->topic;
+    if (size != topic->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // 顺序锁读取, 与写者冲突时重试
+    unsigned seq;
+    int64_t publish_us;
+    do {
+        seq = atomic_load_explicit(&topic->seq, memory_order_acquire);
+        if (seq & 1) {
+            continue;
+        }
+        memcpy(value, topic->data, size);
+        publish_us = topic->publish_us;
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1) || seq != atomic_load_explicit(&topic->seq, memory_order_relaxed));
+
+    if (seq == sub->last_seq) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    uint32_t dropped = (seq - sub->last_seq) / 2 - 1;
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - publish_us);
+    sub->last_seq = seq;
+
+    taskENTER_CRITICAL(&topic->lock);
+    topic->stats.read++;
+    topic->stats.dropped += dropped;
+    topic->stats.last_latency_us = latency;
+    if (latency > topic->stats.max_latency_us) {
+        topic->stats.max_latency_us = latency;
+    }
+    taskEXIT_CRITICAL(&topic->lock);
+    return ESP_OK;
+}
+
+uint32_t msg_bus_wait(uint32_t bits, TickType_t timeout) {
+    uint32_t received = 0;
+    xTaskNotifyWait(0, bits, &received, timeout);
+    return received & bits;
+}
+
+void msg_bus_get_stats(msg_topic_t *topic, msg_topic_stats_t *stats) {
+    taskENTER_CRITICAL(&topic->lock);
+    *stats = topic->stats;
+    taskEXIT_CRITICAL(&topic->lock);
+}
@@ -0,0 +1,79 @@
+#ifndef __MSG_BUS_H__
+#define __MSG_BUS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_err.h"
+#include "esp_log.h"
+
+#define MSG_BUS_MAX_SUBSCRIBERS 4   // 每个主题的最大订阅任务数
+
+// 主题统计
+typedef struct {
+    uint32_t published;      // 发布次数
+    uint32_t read;           // 订阅者读到的新值次数
+    uint32_t dropped;        // 订阅者读取前被覆盖的值的个数
+    uint32_t last_latency_us;// 发布到读取的延迟
+    uint32_t max_latency_us;
+} msg_topic_stats_t;
+
+// 主题 只保留最新值, 发布不会阻塞, 订阅者读取时总是拿到最新的一份
+// 值由顺序锁保护 (与时间服务相同): 写者在临界区内更新, 读者不加锁
+typedef struct {
+    const char *name;
+    size_t size;             // 值的大小 发布/读取时校验
+    void *data;              // 值的存储 由MSG_BUS_TOPIC_DEFINE静态分配
+    atomic_uint seq;         // 偶数: 稳定 奇数: 正在写, 每次发布+2
+    int64_t publish_us;      // 最近一次发布的时刻
+    portMUX_TYPE lock;
+
+    TaskHandle_t subscribers[MSG_BUS_MAX_SUBSCRIBERS];
+    uint32_t notify_bits[MSG_BUS_MAX_SUBSCRIBERS];
+    int subscriber_num;
+
+    msg_topic_stats_t stats;
+} msg_topic_t;
+
+// 订阅者自己的读取位置
+typedef struct {
+    msg_topic_t *topic;
+    unsigned last_seq;
+} msg_sub_t;
+
+// 定义一个类型为type的主题, 头文件中用MSG_BUS_TOPIC_DECLARE声明
+#define MSG_BUS_TOPIC_DEFINE(topic, type)                  \
+    static type topic##_storage;                           \
+    msg_topic_t topic = {                                  \
+        .name = #topic,                                    \
+        .size = sizeof(type),                              \
+        .data = &topic##_storage,                          \
+        .lock = portMUX_INITIALIZER_UNLOCKED,              \
+    }
+
+#define MSG_BUS_TOPIC_DECLARE(topic) extern msg_topic_t topic
+
+// 按值的类型发布/读取 大小与主题不符时返回ESP_ERR_INVALID_SIZE
+#define msg_bus_publish_value(topic, value_ptr)  msg_bus_publish((topic), (value_ptr), sizeof(*(value_ptr)))
+#define msg_bus_read_value(sub, value_ptr)       msg_bus_read((sub), (value_ptr), sizeof(*(value_ptr)))
+
+// 发布新值并通知订阅任务 不阻塞, 可在esp_timer回调中调用
+esp_err_t msg_bus_publish(msg_topic_t *topic, const void *value, size_t size);
+
+// 订阅 notify_bits为有新值时给task发送的通知位 (task为NULL时表示当前任务)
+esp_err_t msg_bus_subscribe(msg_topic_t *topic, msg_sub_t *sub, TaskHandle_t task, uint32_t notify_bits);
+esp_err_t msg_bus_unsubscribe(msg_sub_t *sub, TaskHandle_t task);
+
+// 读取最新值 有新值时返回ESP_OK, 没有新值返回ESP_ERR_NOT_FOUND (value仍填入当前值)
+esp_err_t msg_bus_read(msg_sub_t *sub, void *value, size_t size);
+
+// 等待任意一个通知位 返回收到的位, 超时返回0
+uint32_t msg_bus_wait(uint32_t bits, TickType_t timeout);
+
+void msg_bus_get_stats(msg_topic_t *topic, msg_topic_stats_t *stats);
+
+#endif // __MSG_BUS_H__
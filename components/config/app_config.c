@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <string.h>
+#include "app_config.h"
+
+#define APP_READ_CHUNK 128
+
+#define FIELD_STR(sec, k, member, def) \
+    { .section = sec, .key = k, .type = CFG_TYPE_STR, .offset = offsetof(app_config_t, member), \
+      .size = sizeof(((app_config_t *)0)->member), .def_str = def }
+#define FIELD_INT(sec, k, member, lo, hi, def) \
+    { .section = sec, .key = k, .type = CFG_TYPE_INT, .offset = offsetof(app_config_t, member), \
+      .size = sizeof(((app_config_t *)0)->member), .min = lo, .max = hi, .def_int = def }
+#define FIELD_BOOL(sec, k, member, def) \
+    { .section = sec, .key = k, .type = CFG_TYPE_BOOL, .offset = offsetof(app_config_t, member), \
+      .size = sizeof(((app_config_t *)0)->member), .def_int = def }
+
+static const cfg_field_t app_config_fields[] = {
+    // [wifi] 可重复节, 偏移相对app_wifi_network_t
+    { .section = "wifi", .key = "ssid", .type = CFG_TYPE_STR,
+      .offset = offsetof(app_wifi_network_t, ssid), .size = sizeof(((app_wifi_network_t *)0)->ssid) },
+    { .section = "wifi", .key = "password", .type = CFG_TYPE_STR,
+      .offset = offsetof(app_wifi_network_t, password), .size = sizeof(((app_wifi_network_t *)0)->password) },
+
+    // 旧格式
+    FIELD_STR(NULL, "wifi ssid", legacy_wifi.ssid, NULL),
+    FIELD_STR(NULL, "wifi passport", legacy_wifi.password, NULL),
+
+    { .section = "ntp", .key = "server", .type = CFG_TYPE_STR,
+      .offset = offsetof(app_config_t, ntp_server), .size = APP_CONFIG_HOST_LEN,
+      .array_max = APP_CONFIG_MAX_NTP, .array_stride = APP_CONFIG_HOST_LEN,
+      .count_offset = offsetof(app_config_t, ntp_count) },
+    FIELD_STR("ntp", "timezone", timezone, "CST-8"),
+
+    FIELD_INT("led", "brightness", led_brightness, 0, 255, 255),
+    FIELD_BOOL("led", "gamma", led_gamma, 0),
+    FIELD_INT("led", "frame_ms", led_frame_ms, 5, 1000, 20),
+
+    FIELD_INT("display", "contrast", display_contrast, 0, 255, 0xDF),
+    FIELD_BOOL("display", "flip", display_flip, 0),
+};
+
+static const cfg_section_t app_config_sections[] = {
+    { .name = "wifi", .offset = offsetof(app_config_t, wifi), .stride = sizeof(app_wifi_network_t),
+      .max_count = APP_CONFIG_MAX_WIFI, .count_offset = offsetof(app_config_t, wifi_count) },
+};
+
+const cfg_schema_t app_config_schema = {
+    .fields = app_config_fields,
+    .field_num = sizeof(app_config_fields) / sizeof(app_config_fields[0]),
+    .sections = app_config_sections,
+    .section_num = sizeof(app_config_sections) / sizeof(app_config_sections[0]),
+};
+
+// 解析结束后的整理: 去掉没有SSID的网络, 旧格式的网络放到列表最前面, 没有NTP服务器时使用默认值
+static void app_config_finish(app_config_t *config) {
+    int count = 0;
+    for (int i = 0; i < config->wifi_count; i++) {
+        if (config->wifi[i].ssid[0]) {
+            config->wifi[count++] = config->wifi[i];
+        }
+    }
+    config->wifi_count = count;
+    if (config->legacy_wifi.ssid[0]) {
+        int n = config->wifi_count < APP_CONFIG_MAX_WIFI ? config->wifi_count : APP_CONFIG_MAX_WIFI - 1;
+        memmove(&config->wifi[1], &config->wifi[0], n * sizeof(app_wifi_network_t));
+        config->wifi[0] = config->legacy_wifi;
+        config->wifi_count = n + 1;
+    }
+    if (!config->ntp_count) {
+        strcpy(config->ntp_server[0], "pool.ntp.org");
+        config->ntp_count = 1;
+    }
+}
+
+void app_config_parse(const char *text, size_t len, app_config_t *config, cfg_parser_t *parser) {
+    cfg_parser_t local;
+    if (!parser) {
+        parser = &local;
+    }
+    cfg_parser_init(parser, &app_config_schema, config);
+    cfg_parser_feed(parser, text, len);
+    cfg_parser_finish(parser);
+    app_config_finish(config);
+}
+
+bool app_config_load(const char *path, app_config_t *config, cfg_parser_t *parser) {
+    cfg_parser_t local;
+    if (!parser) {
+        parser = &local;
+    }
+    cfg_parser_init(parser, &app_config_schema, config);
+
+    FILE *fd = fopen(path, "r");
+    if (fd) {
+        char chunk[APP_READ_CHUNK];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), fd)) > 0) {
+            cfg_parser_feed(parser, chunk, n);
+        }
+        fclose(fd);
+        cfg_parser_finish(parser);
+    }
+    app_config_finish(config);
+    return fd != NULL;
+}
+
+uint32_t app_config_diff(const app_config_t *a, const app_config_t *b) {
+    uint32_t changed = 0;
+    if (a->wifi_count != b->wifi_count) {
+        changed |= APP_CONFIG_CHANGED_WIFI;
+    }
+    for (int i = 0; !(changed & APP_CONFIG_CHANGED_WIFI) && i < a->wifi_count; i++) {
+        if (strcmp(a->wifi[i].ssid, b->wifi[i].ssid) != 0 ||
+            strcmp(a->wifi[i].password, b->wifi[i].password) != 0) {
+            changed |= APP_CONFIG_CHANGED_WIFI;
+        }
+    }
+    if (a->ntp_count != b->ntp_count) {
+        changed |= APP_CONFIG_CHANGED_NTP;
+    }
+    for (int i = 0; !(changed & APP_CONFIG_CHANGED_NTP) && i < a->ntp_count; i++) {
+        if (strcmp(a->ntp_server[i], b->ntp_server[i]) != 0) {
+            changed |= APP_CONFIG_CHANGED_NTP;
+        }
+    }
+    if (strcmp(a->timezone, b->timezone) != 0) {
+        changed |= APP_CONFIG_CHANGED_TIMEZONE;
+    }
+    if (a->led_brightness != b->led_brightness || a->led_gamma != b->led_gamma ||
+        a->led_frame_ms != b->led_frame_ms) {
+        changed |= APP_CONFIG_CHANGED_LED;
+    }
+    if (a->display_contrast != b->display_contrast || a->display_flip != b->display_flip) {
+        changed |= APP_CONFIG_CHANGED_DISPLAY;
+    }
+    return changed;
+}
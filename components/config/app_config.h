@@ -0,0 +1,75 @@
+#ifndef __APP_CONFIG_H__
+#define __APP_CONFIG_H__
+
+// 应用配置 (config.txt) 的结构与schema
+//
+//   [wifi]                 可重复, 最多APP_CONFIG_MAX_WIFI个, 按顺序尝试
+//   ssid = ...
+//   password = ...
+//
+//   [ntp]
+//   server = pool.ntp.org  可重复, 最多APP_CONFIG_MAX_NTP个
+//   timezone = CST-8
+//
+//   [led]
+//   brightness = 255
+//   gamma = false          颜色表按线性亮度设计, 开启后低亮度颜色会明显变暗
+//   frame_ms = 20
+//
+//   [display]
+//   contrast = 223
+//   flip = false
+//
+// 兼容旧格式: 不在任何节中的 "wifi ssid:" "wifi passport:" 作为第一个网络
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config_parser.h"
+
+#define APP_CONFIG_MAX_WIFI     4
+#define APP_CONFIG_MAX_NTP      4
+#define APP_CONFIG_HOST_LEN     64
+#define APP_CONFIG_TZ_LEN       48
+
+typedef struct {
+    char ssid[33];
+    char password[65];
+} app_wifi_network_t;
+
+typedef struct {
+    app_wifi_network_t wifi[APP_CONFIG_MAX_WIFI];
+    uint8_t wifi_count;
+    app_wifi_network_t legacy_wifi;  // 旧格式的网络
+
+    char ntp_server[APP_CONFIG_MAX_NTP][APP_CONFIG_HOST_LEN];
+    uint8_t ntp_count;
+    char timezone[APP_CONFIG_TZ_LEN];
+
+    uint8_t led_brightness;
+    bool led_gamma;
+    uint16_t led_frame_ms;
+
+    uint8_t display_contrast;
+    bool display_flip;
+} app_config_t;
+
+// app_config_diff的返回值 按设置项分组
+#define APP_CONFIG_CHANGED_WIFI     (1U << 0)
+#define APP_CONFIG_CHANGED_NTP      (1U << 1)
+#define APP_CONFIG_CHANGED_TIMEZONE (1U << 2)
+#define APP_CONFIG_CHANGED_LED      (1U << 3)
+#define APP_CONFIG_CHANGED_DISPLAY  (1U << 4)
+
+extern const cfg_schema_t app_config_schema;
+
+// 从文件流式读取配置 文件不存在时返回false, 配置为默认值
+// parser非NULL时返回诊断信息 (错误数、第一个错误所在行等)
+bool app_config_load(const char *path, app_config_t *config, cfg_parser_t *parser);
+
+// 从内存解析 (用于测试)
+void app_config_parse(const char *text, size_t len, app_config_t *config, cfg_parser_t *parser);
+
+// 比较两份配置 返回发生变化的分组 (APP_CONFIG_CHANGED_*)
+uint32_t app_config_diff(const app_config_t *a, const app_config_t *b);
+
+#endif // __APP_CONFIG_H__
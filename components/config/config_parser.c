@@ -0,0 +1,257 @@
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "config_parser.h"
+
+static void cfg_error(cfg_parser_t *parser, const char *msg, const char *detail) {
+    if (!parser->errors) {
+        parser->error_line = parser->line_no;
+        snprintf(parser->error, sizeof(parser->error), "%s %s", msg, detail ? detail : "");
+    }
+    parser->errors++;
+}
+
+static char *cfg_trim(char *s) {
+    while (isspace((unsigned char)*s)) {
+        s++;
+    }
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) {
+        end--;
+    }
+    *end = '\0';
+    return s;
+}
+
+static bool cfg_section_match(const char *a, const char *b) {
+    return (!a || !*a) ? (!b || !*b) : (b && strcasecmp(a, b) == 0);
+}
+
+// 写入一个字段的默认值
+static void cfg_field_default(const cfg_field_t *field, uint8_t *base) {
+    int count = field->array_max ? field->array_max : 1;
+    for (int i = 0; i < count; i++) {
+        uint8_t *p = base + field->offset + i * field->array_stride;
+        if (field->type == CFG_TYPE_STR) {
+            memset(p, 0, field->size);
+            if (field->def_str && i == 0 && !field->array_max) {
+                strncpy((char *)p, field->def_str, field->size - 1);
+            }
+        } else if (field->size == 1) {
+            *(int8_t *)p = field->def_int;
+        } else if (field->size == 2) {
+            *(int16_t *)p = field->def_int;
+        } else {
+            *(int32_t *)p = field->def_int;
+        }
+    }
+    if (field->array_max) {
+        base[field->count_offset] = 0;
+    }
+}
+
+// 给某个节 (NULL为全局, 或可重复节的一个元素) 的所有字段写默认值
+static void cfg_defaults(cfg_parser_t *parser, const char *section, uint8_t *base) {
+    const cfg_schema_t *schema = parser->schema;
+    for (int i = 0; i < schema->field_num; i++) {
+        if (cfg_section_match(schema->fields[i].section, section)) {
+            cfg_field_default(&schema->fields[i], base);
+        }
+    }
+}
+
+static const cfg_section_t *cfg_find_repeat(const cfg_schema_t *schema, const char *name) {
+    for (int i = 0; i < schema->section_num; i++) {
+        if (strcasecmp(schema->sections[i].name, name) == 0) {
+            return &schema->sections[i];
+        }
+    }
+    return NULL;
+}
+
+void cfg_parser_init(cfg_parser_t *parser, const cfg_schema_t *schema, void *target) {
+    memset(parser, 0, sizeof(cfg_parser_t));
+    parser->schema = schema;
+    parser->target = target;
+    parser->base = target;
+
+    // 普通字段写默认值, 可重复节的计数清零 (元素在出现时才写默认值)
+    for (int i = 0; i < schema->field_num; i++) {
+        const cfg_field_t *field = &schema->fields[i];
+        if (!field->section || !cfg_find_repeat(schema, field->section)) {
+            cfg_field_default(field, parser->target);
+        }
+    }
+    for (int i = 0; i < schema->section_num; i++) {
+        parser->target[schema->sections[i].count_offset] = 0;
+    }
+}
+
+static void cfg_open_section(cfg_parser_t *parser, char *name) {
+    name = cfg_trim(name);
+    strncpy(parser->section, name, sizeof(parser->section) - 1);
+    parser->section[sizeof(parser->section) - 1] = '\0';
+    parser->repeat = cfg_find_repeat(parser->schema, name);
+    parser->base = parser->target;
+    if (!parser->repeat) {
+        return;
+    }
+
+    uint8_t *count = &parser->target[parser->repeat->count_offset];
+    if (*count >= parser->repeat->max_count) {
+        cfg_error(parser, "too many sections", name);
+        parser->base = NULL; // 忽略这个节中的所有值
+        return;
+    }
+    parser->base = parser->target + parser->repeat->offset + *count * parser->repeat->stride;
+    (*count)++;
+    cfg_defaults(parser, parser->repeat->name, parser->base);
+}
+
+static bool cfg_parse_int(const char *value, int32_t *out) {
+    char *end;
+    errno = 0;
+    long v = strtol(value, &end, 0);
+    // long在主机上是64位, 截断前检查, 否则4294967296会变成0并通过字段的范围检查
+    if (end == value || *end || errno == ERANGE || v < INT32_MIN || v > INT32_MAX) {
+        return false;
+    }
+    *out = (int32_t)v;
+    return true;
+}
+
+static bool cfg_parse_bool(const char *value, int32_t *out) {
+    static const char *const yes[] = { "1", "true", "yes", "on" };
+    static const char *const no[] = { "0", "false", "no", "off" };
+    for (int i = 0; i < 4; i++) {
+        if (strcasecmp(value, yes[i]) == 0) {
+            *out = 1;
+            return true;
+        }
+        if (strcasecmp(value, no[i]) == 0) {
+            *out = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void cfg_set_value(cfg_parser_t *parser, const cfg_field_t *field, char *value) {
+    uint8_t *p = parser->base + field->offset;
+    if (field->array_max) {
+        uint8_t *count = &parser->base[field->count_offset];
+        if (*count >= field->array_max) {
+            cfg_error(parser, "too many values", field->key);
+            return;
+        }
+        p += *count * field->array_stride;
+    }
+
+    if (field->type == CFG_TYPE_STR) {
+        size_t len = strlen(value);
+        if (len >= 2 && (value[0] == '"' || value[0] == '\'') && value[len - 1] == value[0]) {
+            value[len - 1] = '\0';
+            value++;
+            len -= 2;
+        }
+        if (len >= field->size) {
+            cfg_error(parser, "value too long", field->key);
+            return;
+        }
+        memcpy(p, value, len + 1);
+    } else {
+        int32_t v;
+        bool ok = field->type == CFG_TYPE_BOOL ? cfg_parse_bool(value, &v) : cfg_parse_int(value, &v);
+        if (!ok) {
+            cfg_error(parser, "invalid value", field->key);
+            return;
+        }
+        if (field->type == CFG_TYPE_INT && (v < field->min || v > field->max)) {
+            cfg_error(parser, "out of range", field->key);
+            return;
+        }
+        if (field->size == 1) {
+            *(int8_t *)p = v;
+        } else if (field->size == 2) {
+            *(int16_t *)p = v;
+        } else {
+            *(int32_t *)p = v;
+        }
+    }
+    if (field->array_max) {
+        parser->base[field->count_offset]++;
+    }
+    parser->values++;
+}
+
+static void cfg_parse_line(cfg_parser_t *parser, char *line) {
+    line = cfg_trim(line);
+    if (!*line || *line == '#' || *line == ';') {
+        return;
+    }
+    if (*line == '[') {
+        char *end = strchr(line, ']');
+        if (!end) {
+            cfg_error(parser, "unterminated section", NULL);
+            return;
+        }
+        *end = '\0';
+        cfg_open_section(parser, line + 1);
+        return;
+    }
+
+    // 以第一个 = 或 : 分隔
+    char *sep = strpbrk(line, "=:");
+    if (!sep) {
+        cfg_error(parser, "missing '='", NULL);
+        return;
+    }
+    *sep = '\0';
+    char *key = cfg_trim(line);
+    char *value = cfg_trim(sep + 1);
+    if (!parser->base) {
+        return; // 节元素已满, 错误已记录
+    }
+
+    const cfg_schema_t *schema = parser->schema;
+    for (int i = 0; i < schema->field_num; i++) {
+        const cfg_field_t *field = &schema->fields[i];
+        if (cfg_section_match(field->section, parser->section) && strcasecmp(field->key, key) == 0) {
+            cfg_set_value(parser, field, value);
+            return;
+        }
+    }
+    parser->unknown++;
+}
+
+void cfg_parser_feed(cfg_parser_t *parser, const char *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        char c = data[i];
+        if (c == '\n') {
+            parser->line_no++;
+            if (parser->overflow) {
+                cfg_error(parser, "line too long", NULL);
+            } else {
+                parser->line[parser->len] = '\0';
+                cfg_parse_line(parser, parser->line);
+            }
+            parser->len = 0;
+            parser->overflow = false;
+        } else if (c == '\r' || c == '\0') {
+            continue;
+        } else if (parser->len < CFG_MAX_LINE - 1) {
+            parser->line[parser->len++] = c;
+        } else {
+            parser->overflow = true;
+        }
+    }
+}
+
+void cfg_parser_finish(cfg_parser_t *parser) {
+    if (parser->len || parser->overflow) {
+        cfg_parser_feed(parser, "\n", 1);
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef __CONFIG_PARSER_H__
+#define __CONFIG_PARSER_H__
+
+// 流式INI/key=value解析器 按schema把值直接写入目标结构体
+// 数据可以任意分块送入, 只占用一行的缓冲区 不依赖ESP-IDF, 可在主机上单独编译
+//
+// 格式:
+//   # 或 ; 开头为注释
+//   [section]          节, 在schema中声明为可重复的节每出现一次新建一个元素
+//   key = value        也接受 key: value, 值两侧的引号会被去掉
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define CFG_MAX_LINE        256
+#define CFG_MAX_SECTION     24
+#define CFG_ERROR_LEN       64
+
+typedef enum {
+    CFG_TYPE_STR = 0,   // size为缓冲区大小 (含结尾0), 超长报错
+    CFG_TYPE_INT,       // size为1/2/4字节, 按min/max检查
+    CFG_TYPE_BOOL,      // true/false yes/no on/off 1/0
+} cfg_type_t;
+
+// 字段 section为NULL时表示不在任何节中
+// 属于可重复节的字段, offset相对节元素; 否则相对目标结构体
+typedef struct {
+    const char *section;
+    const char *key;
+    cfg_type_t type;
+    uint16_t offset;
+    uint16_t size;
+    int32_t min;
+    int32_t max;
+    int32_t def_int;        // 整数/布尔默认值
+    const char *def_str;    // 字符串默认值 (NULL为空串)
+    uint8_t array_max;      // >0时重复出现的key依次写入数组
+    uint16_t array_stride;
+    uint16_t count_offset;  // 数组计数 (uint8_t) 的偏移, 与offset同一基准
+} cfg_field_t;
+
+// 可重复的节
+typedef struct {
+    const char *name;
+    uint16_t offset;        // 第一个元素在目标结构体中的偏移
+    uint16_t stride;
+    uint8_t max_count;
+    uint16_t count_offset;  // 元素计数 (uint8_t) 的偏移
+} cfg_section_t;
+
+typedef struct {
+    const cfg_field_t *fields;
+    int field_num;
+    const cfg_section_t *sections;
+    int section_num;
+} cfg_schema_t;
+
+typedef struct {
+    const cfg_schema_t *schema;
+    uint8_t *target;
+
+    char line[CFG_MAX_LINE];
+    uint16_t len;
+    bool overflow;          // 当前行超长, 丢弃到行尾
+    uint32_t line_no;
+
+    char section[CFG_MAX_SECTION];
+    const cfg_section_t *repeat;  // 当前所在的可重复节 (NULL表示不是)
+    uint8_t *base;                // 当前节字段的基准地址, NULL表示节元素已满
+
+    uint32_t values;        // 成功写入的值
+    uint32_t errors;        // 语法错误/越界/超长
+    uint32_t unknown;       // 未知的节或key
+    uint32_t error_line;    // 第一个错误所在行
+    char error[CFG_ERROR_LEN];
+} cfg_parser_t;
+
+// 初始化并写入默认值
+void cfg_parser_init(cfg_parser_t *parser, const cfg_schema_t *schema, void *target);
+
+// 送入任意长度的数据
+void cfg_parser_feed(cfg_parser_t *parser, const char *data, size_t len);
+
+// 处理没有换行结尾的最后一行
+void cfg_parser_finish(cfg_parser_t *parser);
+
+#endif // __CONFIG_PARSER_H__
@@ -135,6 +135,13 @@ extern "C" {
 #define CFG_TUD_ENDPOINT0_SIZE      64
 #endif
 
+#define CFG_TUD_TASK_QUEUE_SZ       CONFIG_TINYUSB_TASK_QUEUE_SIZE
+#define CFG_TUD_TASK_FUNC_QUEUE_SZ  CONFIG_TINYUSB_TASK_FUNC_QUEUE_SIZE
+
+#ifdef CONFIG_TINYUSB_EVENT_STATS
+#   define CFG_TUD_EVENT_STATS      1
+#endif
+
 // Debug Level
 #define CFG_TUSB_DEBUG              CONFIG_TINYUSB_DEBUG_LEVEL
 #define CFG_TUSB_DEBUG_PRINTF       esp_rom_printf // TinyUSB can print logs from ISR, so we must use esp_rom_printf()
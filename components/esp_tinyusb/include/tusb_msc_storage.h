@@ -43,6 +43,53 @@ typedef struct {
     };
 } tinyusb_msc_event_t;
 
+/**
+ * @brief Latency of the storage handovers between application and Host
+ *
+ * Measured from the request (API call or TinyUSB callback) to the new owner having access.
+ */
+typedef struct {
+    uint32_t to_host_count;                 /*!< Number of handovers to Host */
+    uint32_t last_to_host_us;               /*!< Latency of the last handover to Host */
+    uint32_t max_to_host_us;                /*!< Maximum latency of handovers to Host */
+    uint32_t to_app_count;                  /*!< Number of handovers to the application */
+    uint32_t last_to_app_us;                /*!< Latency of the last handover to the application */
+    uint32_t max_to_app_us;                 /*!< Maximum latency of handovers to the application */
+} tinyusb_msc_handover_stats_t;
+
+#define TINYUSB_MSC_STATS_SIZE_CLASSES    3  /*!< Transfer size classes: up to 512 B, up to 4 KiB, larger */
+#define TINYUSB_MSC_STATS_LATENCY_BUCKETS 10 /*!< Latency buckets: below 64 us, below 128 us, ... below 16 ms, the rest */
+
+/**
+ * @brief Statistics of one kind of storage operation
+ */
+typedef struct {
+    uint32_t count;                         /*!< Number of operations */
+    uint32_t errors;                        /*!< Number of failed operations */
+    uint64_t bytes;                         /*!< Bytes transferred */
+    uint64_t total_us;                      /*!< Time spent */
+    uint32_t max_us;                        /*!< Longest operation */
+    uint32_t histogram[TINYUSB_MSC_STATS_SIZE_CLASSES][TINYUSB_MSC_STATS_LATENCY_BUCKETS]; /*!< Latency histogram by transfer size */
+} tinyusb_msc_op_stats_t;
+
+/**
+ * @brief MSC storage statistics
+ */
+typedef struct {
+    tinyusb_msc_op_stats_t read;            /*!< Host reads (READ10), storage read included */
+    tinyusb_msc_op_stats_t write;           /*!< Deferred host writes, storage write (and erase) included */
+    tinyusb_msc_op_stats_t erase;           /*!< Wear levelling erases, from host and application writes and UNMAP (SPI flash only) */
+    tinyusb_msc_op_stats_t unmap;           /*!< Host UNMAP descriptors and FATFS TRIM requests */
+    uint32_t erase_skipped;                 /*!< Writes to sectors erased by UNMAP, done without an erase */
+    uint32_t defer_pending;                 /*!< Host writes accepted but not written yet */
+    uint32_t defer_max_pending;             /*!< Maximum of defer_pending */
+    uint32_t defer_max_wait_us;             /*!< Longest time between accepting a host write and starting it */
+    uint32_t read_bytes_per_sec;            /*!< Host read throughput over the last 2 s */
+    uint32_t write_bytes_per_sec;           /*!< Host write throughput over the last 2 s */
+    uint32_t scsi_unsupported;              /*!< SCSI commands rejected as not supported */
+    uint8_t scsi_last_unsupported;          /*!< Operation code of the last one */
+} tinyusb_msc_stats_t;
+
 /**
  * @brief MSC callback that is delivered whenever a specific event occurs.
  */
@@ -128,9 +175,10 @@ esp_err_t tinyusb_msc_unregister_callback(tinyusb_msc_event_type_t event_type);
 /**
  * @brief Mount the storage partition locally on the firmware application.
  *
- * Get the available drive number. Register spi flash partition.
- * Connect POSIX and C standard library IO function with FATFS.
- * Mounts the partition.
+ * The first call gets the available drive number, registers the storage with
+ * diskio and connects POSIX and C standard library IO function with FATFS.
+ * The registration is kept, later calls only hand the storage back from Host
+ * and re-mount the FATFS volume.
  * This API is used by the firmware application. If the storage partition is
  * mounted by this API, host (PC) can't access the storage via MSC.
  * When this function is called from the tinyusb callback functions, care must be taken
@@ -148,9 +196,11 @@ esp_err_t tinyusb_msc_storage_mount(const char *base_path);
 /**
  * @brief Unmount the storage partition from the firmware application.
  *
- * Unmount the partition. Unregister diskio driver.
- * Unregister the SPI flash partition.
- * Finally, Un-register FATFS from VFS.
+ * Waits for the FATFS call in progress, writes back the sectors cached by FATFS
+ * and invalidates the volume. diskio and VFS stay registered, application
+ * calls fail (or are read-only, see tinyusb_msc_storage_set_shared()) until
+ * the storage is mounted again.
+ * Open files are not flushed, close them before.
  * After this function is called, storage device can be seen (recognized) by host (PC).
  * When this function is called from the tinyusb callback functions, care must be taken
  * so as to make sure that user callbacks must be completed within a specific time.
@@ -185,6 +235,58 @@ uint32_t tinyusb_msc_storage_get_sector_size(void);
  */
 bool tinyusb_msc_storage_in_use_by_usb_host(void);
 
+/**
+ * @brief Keep a read-only view of the storage for the application while it is exposed to Host
+ *
+ * When enabled, the partition stays readable under the same base path after it is
+ * handed over to Host. Application writes fail
+ * with EROFS. Host writes to the FAT area, the root directory or the directory sector
+ * cached by FATFS invalidate the view: FATFS re-mounts the volume on the next path
+ * based call and files opened before the change return errors and must be reopened.
+ * The view is not a snapshot, a Host update that is still in progress may be observed.
+ *
+ * Takes effect immediately, the setting is checked on every FATFS access to the volume.
+ * The storage stays registered with diskio and VFS in both modes.
+ *
+ * @param shared true to keep the read-only view, false to make the volume report "not ready"
+ *               to the application while it is exposed to Host (default)
+ */
+void tinyusb_msc_storage_set_shared(bool shared);
+
+/**
+ * @brief Get status if the application has the read-only view of the storage
+ *
+ * @return bool
+ *      - true, if the storage is exposed to Host and the read-only view is mounted
+ *      - false, otherwise
+ */
+bool tinyusb_msc_storage_is_shared(void);
+
+/**
+ * @brief Get the handover latency statistics
+ *
+ * TinyUSB callbacks (mount, eject, unmount) request handovers asynchronously, the host
+ * sees "becoming ready" until the handover task has switched the owner.
+ *
+ * @param stats output
+ */
+void tinyusb_msc_storage_get_handover_stats(tinyusb_msc_handover_stats_t *stats);
+
+/**
+ * @brief Get the storage operation statistics
+ *
+ * Available before the storage is initialized. All zero when CONFIG_TINYUSB_MSC_STATS
+ * is disabled.
+ *
+ * @param stats output
+ */
+void tinyusb_msc_storage_get_stats(tinyusb_msc_stats_t *stats);
+
+/**
+ * @brief Clear the storage operation statistics
+ */
+void tinyusb_msc_storage_reset_stats(void);
+
 #ifdef __cplusplus
 }
 #endif
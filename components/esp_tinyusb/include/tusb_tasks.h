@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <stdint.h>
 #include "esp_err.h"
 
 #ifdef __cplusplus
@@ -34,6 +35,29 @@ esp_err_t tusb_run_task(void);
  */
 esp_err_t tusb_stop_task(void);
 
+/**
+ * @brief Wakeup statistics of the task created by `tusb_run_task()`
+ *
+ * The task sleeps until an event arrives, so a mounted but idle device should show close to zero
+ * wakeups per second. Idle wakeups are the ones that handled nothing but SOF, see `tud_sof_cb_enable()`.
+ */
+typedef struct {
+    uint32_t wakeups;               /*!< Returns from tud_task() */
+    uint32_t idle_wakeups;          /*!< Wakeups that only handled SOF events */
+    uint32_t wakeups_per_sec;       /*!< Wakeups over the last second */
+    uint32_t idle_wakeups_per_sec;  /*!< Idle wakeups over the last second */
+} tusb_task_stats_t;
+
+/**
+ * @brief Get the wakeup statistics of the TinyUSB main task
+ *
+ * @param[out] stats Statistics
+ * @retval ESP_OK statistics are filled
+ * @retval ESP_ERR_INVALID_ARG stats is NULL
+ * @retval ESP_ERR_NOT_SUPPORTED CONFIG_TINYUSB_EVENT_STATS is disabled
+ */
+esp_err_t tusb_task_get_stats(tusb_task_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
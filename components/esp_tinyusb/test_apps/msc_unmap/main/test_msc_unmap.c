@@ -0,0 +1,129 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "soc/soc_caps.h"
+#if SOC_USB_OTG_SUPPORTED
+
+//
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+//
+#include "esp_partition.h"
+#include "esp_log.h"
+#include "esp_err.h"
+#include "wear_levelling.h"
+#include "ff.h"
+//
+#include "unity.h"
+#include "tusb_msc_storage.h"
+
+static const char *TAG = "msc_unmap";
+
+#define BASE_PATH               "/data"
+#define CHURN_FILE_SIZE         (16 * 1024)
+#define CHURN_WRITE_SIZE        512     // Sector sized writes, the way the host writes over MSC
+#define CHURN_FILES             4       // Files kept alive, the oldest is deleted before a new one is written
+#define CHURN_WARMUP_ROUNDS     64      // Cycle through the volume once, so freed space has been unmapped
+#define CHURN_ROUNDS            256
+
+static wl_handle_t s_wl_handle = WL_INVALID_HANDLE;
+
+static void storage_setup(void)
+{
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_FAT, NULL);
+    TEST_ASSERT_NOT_NULL(part);
+    TEST_ASSERT_EQUAL(ESP_OK, wl_mount(part, &s_wl_handle));
+
+    const tinyusb_msc_spiflash_config_t config = {
+        .wl_handle = s_wl_handle,
+        .mount_config = {
+            .format_if_mount_failed = true,
+            .max_files = CHURN_FILES + 1,
+        },
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, tinyusb_msc_storage_init_spiflash(&config));
+    TEST_ASSERT_EQUAL(ESP_OK, tinyusb_msc_storage_mount(BASE_PATH));
+}
+
+static void storage_teardown(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, tinyusb_msc_storage_unmount());
+    tinyusb_msc_storage_deinit();
+    TEST_ASSERT_EQUAL(ESP_OK, wl_unmount(s_wl_handle));
+    s_wl_handle = WL_INVALID_HANDLE;
+}
+
+static void churn_path(char *path, size_t len, int round)
+{
+    snprintf(path, len, BASE_PATH "/churn%d.bin", round % CHURN_FILES);
+}
+
+static void churn(int first, int rounds)
+{
+    static uint8_t buf[CHURN_WRITE_SIZE];
+    char path[32];
+    for (int round = first; round < first + rounds; round++) {
+        churn_path(path, sizeof(path), round);
+        unlink(path);
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+        memset(buf, round, sizeof(buf));
+        for (int written = 0; written < CHURN_FILE_SIZE; written += sizeof(buf)) {
+            TEST_ASSERT_EQUAL(sizeof(buf), write(fd, buf, sizeof(buf)));
+        }
+        TEST_ASSERT_EQUAL(0, close(fd));
+    }
+}
+
+/**
+ * @brief Write amplification of a file churn workload
+ *
+ * FATFS TRIM requests deleted clusters the same way a host sends UNMAP. Flash
+ * blocks erased by it take the following sector writes without an erase, so
+ * the number of flash erases drops compared to erasing before every write.
+ */
+TEST_CASE("file churn erases less with UNMAP", "[msc_unmap]")
+{
+#if !FF_USE_TRIM
+    TEST_IGNORE_MESSAGE("FATFS is built without TRIM");
+#endif
+    storage_setup();
+    churn(0, CHURN_WARMUP_ROUNDS);
+
+    tinyusb_msc_storage_reset_stats();
+    churn(CHURN_WARMUP_ROUNDS, CHURN_ROUNDS);
+    tinyusb_msc_stats_t stats;
+    tinyusb_msc_storage_get_stats(&stats);
+
+    // Sector writes erase 512 B (one flash read-modify-write each), UNMAP erases whole 4 KiB blocks
+    uint32_t unmap_erases = 0;
+    for (int i = 0; i < TINYUSB_MSC_STATS_LATENCY_BUCKETS; i++) {
+        unmap_erases += stats.erase.histogram[1][i] + stats.erase.histogram[2][i];
+    }
+    uint32_t erases = stats.erase.count;
+    uint32_t erases_without_unmap = erases - unmap_erases + stats.erase_skipped;
+    uint32_t data_blocks = CHURN_ROUNDS * CHURN_FILE_SIZE / 4096;
+    ESP_LOGI(TAG, "%d KiB written in %d files", CHURN_ROUNDS * CHURN_FILE_SIZE / 1024, CHURN_ROUNDS);
+    ESP_LOGI(TAG, "flash erases: %lu with UNMAP (%lu by UNMAP, %lu writes skipped the erase), %lu without",
+             erases, unmap_erases, stats.erase_skipped, erases_without_unmap);
+    ESP_LOGI(TAG, "erases per 4 KiB of data: %.2f with UNMAP, %.2f without",
+             (float)erases / data_blocks, (float)erases_without_unmap / data_blocks);
+    ESP_LOGI(TAG, "erase time: %llu ms", stats.erase.total_us / 1000);
+
+    TEST_ASSERT_GREATER_THAN(0, stats.unmap.count);
+    TEST_ASSERT_LESS_THAN(erases_without_unmap / 2, erases);
+
+    char path[32];
+    for (int i = 0; i < CHURN_FILES; i++) {
+        churn_path(path, sizeof(path), i);
+        unlink(path);
+    }
+    storage_teardown();
+}
+
+#endif // SOC_USB_OTG_SUPPORTED
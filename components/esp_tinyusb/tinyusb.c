@@ -9,6 +9,7 @@
 #include "esp_log.h"
 #include "esp_check.h"
 #include "esp_err.h"
+#include "esp_timer.h"
 #include "esp_private/usb_phy.h"
 #include "tinyusb.h"
 #include "descriptors_control.h"
@@ -110,3 +111,11 @@ esp_err_t tinyusb_driver_uninstall(void)
     ESP_RETURN_ON_ERROR(usb_del_phy(phy_hdl), TAG, "Unable to delete PHY");
     return ESP_OK;
 }
+
+#if CFG_TUD_EVENT_STATS
+// Timestamps for the TinyUSB event latency statistics, esp_timer can be read from the USB ISR
+uint32_t tud_event_time_us_cb(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+#endif // CFG_TUD_EVENT_STATS
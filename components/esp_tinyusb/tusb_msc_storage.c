@@ -0,0 +1,1708 @@
+/*
+ * SPDX-FileCopyrightText: 2023-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <stdatomic.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_err.h"
+#include "esp_check.h"
+#include "esp_vfs_fat.h"
+#include "diskio_impl.h"
+#include "diskio_wl.h"
+#include "wear_levelling.h"
+#include "esp_partition.h"
+#include "esp_memory_utils.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "spi_flash_mmap.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include "vfs_fat_internal.h"
+#include "tinyusb.h"
+#include "device/usbd_pvt.h"
+#include "class/msc/msc_device.h"
+#include "tusb_msc_storage.h"
+#if SOC_SDMMC_HOST_SUPPORTED
+#include "diskio_sdmmc.h"
+#endif
+
+static const char *TAG = "tinyusb_msc_storage";
+
+#define MSC_STORAGE_MEM_ALIGN 4
+#define MSC_STORAGE_BUFFER_SIZE CONFIG_TINYUSB_MSC_BUFSIZE /*!< Size of the buffer, configured via menuconfig (MSC FIFO size) */
+
+#define MSC_HANDOVER_TASK_STACK_SIZE 4096
+#define MSC_HANDOVER_TASK_PRIORITY   5
+#define MSC_WRITE_DRAIN_TIMEOUT_MS   5000
+
+/* UNMAP limits advertised in the Block Limits VPD page. The parameter list is received
+   in one MSC buffer and the erase runs in the TinyUSB task, so keep both bounded. */
+#define MSC_UNMAP_MAX_DESCRIPTORS ((MSC_STORAGE_BUFFER_SIZE - 8) / 16)
+#define MSC_UNMAP_MAX_BYTES       (256 * 1024)
+
+#if ((MSC_STORAGE_BUFFER_SIZE) % MSC_STORAGE_MEM_ALIGN != 0)
+#error "CONFIG_TINYUSB_MSC_BUFSIZE must be divisible by MSC_STORAGE_MEM_ALIGN. Adjust your configuration (MSC FIFO size) in menuconfig."
+#endif
+
+/**
+ * @brief Structure representing a single write buffer for MSC operations.
+ */
+typedef struct {
+    uint8_t data_buffer[MSC_STORAGE_BUFFER_SIZE]; /*!< Buffer to store write data. The size is defined by MSC_STORAGE_BUFFER_SIZE. */
+    uint32_t lba;                          /*!< Logical Block Address for the current WRITE10 operation. */
+    uint32_t offset;                       /*!< Offset within the specified LBA for the current write operation. */
+    uint32_t bufsize;                      /*!< Number of bytes to be written in this operation. */
+    int64_t queued_us;                     /*!< Time the write was accepted from the host. */
+    atomic_bool pending;                   /*!< Data is accepted but not written to the storage yet. */
+} msc_storage_buffer_t;
+
+/**
+ * @brief Ownership switch in progress
+ */
+typedef enum {
+    MSC_HANDOVER_IDLE = 0,
+    MSC_HANDOVER_TO_HOST,                 /*!< Application is flushing and releasing the storage */
+    MSC_HANDOVER_TO_APP,                  /*!< Host has released the storage, application is re-mounting it */
+} msc_handover_state_t;
+
+/**
+ * @brief Handle for TinyUSB MSC storage interface.
+ *
+ * This structure holds metadata and function pointers required to
+ * manage the underlying storage medium (SPI flash, SDMMC).
+ */
+typedef struct {
+    msc_storage_buffer_t storage_buffer;
+    bool is_fat_mounted;                  /*!< Indicates if the FAT filesystem is currently owned by the application. */
+    bool is_registered;                   /*!< diskio and VFS are registered. Done once, kept across handovers. */
+    const char *base_path;                /*!< Base path where the filesystem is mounted. */
+    BYTE pdrv;                            /*!< FATFS drive number. */
+    FATFS *fs;                            /*!< FATFS object, owned by VFS. */
+    union {
+        wl_handle_t wl_handle;            /*!< Handle for wear leveling on SPI flash. */
+#if SOC_SDMMC_HOST_SUPPORTED
+        sdmmc_card_t *card;               /*!< Handle for SDMMC card. */
+#endif
+    };
+    uint32_t sector_count;                /*!< Total number of sectors in the storage medium. */
+    uint32_t sector_size;                 /*!< Size of a single sector in bytes. */
+    esp_err_t (*read)(size_t sector_size, /*!< Function pointer for reading data. */
+                      uint32_t lba, uint32_t offset, size_t size, void *dest);
+    esp_err_t (*write)(size_t sector_size, /*!< Function pointer for writing data. */
+                       size_t addr, uint32_t lba, uint32_t offset, size_t size, const void *src);
+    esp_err_t (*unmap)(uint32_t lba, uint32_t count); /*!< Function pointer for releasing unused sectors. */
+    uint32_t unmap_granularity;           /*!< Sectors per erase block, UNMAP is applied to whole blocks only. */
+    uint32_t *erased;                     /*!< Bitmap of sectors known to be erased, their next write skips the erase (SPI flash). */
+    tusb_msc_callback_t callback_mount_changed; /*!< Callback for mount state change. */
+    tusb_msc_callback_t callback_premount_changed; /*!< Callback for pre-mount state change. */
+    int max_files;                          /*!< Maximum number of files that can be open simultaneously. */
+    bool shared;                            /*!< Keep a read-only view for the application while the host owns the storage. */
+    atomic_bool shared_stale;               /*!< Host changed FAT or directory sectors since the view was (re)mounted. */
+    volatile msc_handover_state_t handover_state; /*!< Switch in progress, the host sees "becoming ready". */
+    SemaphoreHandle_t owner_lock;           /*!< Serializes host writes and erases with ownership changes and application reads. */
+    SemaphoreHandle_t handover_lock;        /*!< Serializes handovers. */
+    SemaphoreHandle_t drain_done;           /*!< Given by the TinyUSB task once the buffered host write is on the storage. */
+    TaskHandle_t handover_task;             /*!< Runs handovers requested from TinyUSB callbacks. */
+    int64_t handover_request_us;            /*!< Time of the pending asynchronous request. */
+    tinyusb_msc_handover_stats_t handover_stats;
+} tinyusb_msc_storage_handle_s;
+
+/* handle of tinyusb driver connected to application */
+static tinyusb_msc_storage_handle_s *s_storage_handle;
+
+/* Statistics
+   *********************************************************************
+ * Enabled by CONFIG_TINYUSB_MSC_STATS. Each operation costs two esp_timer_get_time()
+ * calls and a short critical section, test/host/bench_msc_stats compares the
+ * throughput with and without. When disabled s_stats stays zero.
+ */
+#define MSC_STATS_RATE_SLOTS   9       /*!< Current slot + 8 complete ones */
+#define MSC_STATS_RATE_SLOT_US 250000  /*!< Throughput is averaged over the last 2 s */
+
+typedef struct {
+    uint32_t epoch[MSC_STATS_RATE_SLOTS];
+    uint32_t bytes[MSC_STATS_RATE_SLOTS];
+} msc_stats_rate_t;
+
+static tinyusb_msc_stats_t s_stats;
+static msc_stats_rate_t s_read_rate;
+static msc_stats_rate_t s_write_rate;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static inline int _stats_size_class(uint32_t size)
+{
+    return size <= 512 ? 0 : (size <= 4096 ? 1 : 2);
+}
+
+// Bucket 0 is below 64 us, bucket i below 64 << i us, the last one takes the rest
+static inline int _stats_latency_bucket(uint32_t us)
+{
+    if (us < 64) {
+        return 0;
+    }
+    return MIN(TINYUSB_MSC_STATS_LATENCY_BUCKETS - 1, 26 - __builtin_clz(us));
+}
+
+// Average over the complete slots, the current one is still filling
+static uint32_t _stats_rate_get(const msc_stats_rate_t *rate, int64_t now_us)
+{
+    uint32_t epoch = (uint32_t)(now_us / MSC_STATS_RATE_SLOT_US);
+    uint64_t bytes = 0;
+    for (int i = 0; i < MSC_STATS_RATE_SLOTS; i++) {
+        uint32_t age = epoch - rate->epoch[i];
+        if (age >= 1 && age < MSC_STATS_RATE_SLOTS) {
+            bytes += rate->bytes[i];
+        }
+    }
+    return (uint32_t)(bytes * 1000000 / ((MSC_STATS_RATE_SLOTS - 1) * MSC_STATS_RATE_SLOT_US));
+}
+
+#if CONFIG_TINYUSB_MSC_STATS
+#define MSC_STATS_NOW() esp_timer_get_time()
+
+static void _stats_rate_add(msc_stats_rate_t *rate, int64_t now_us, uint32_t bytes)
+{
+    uint32_t epoch = (uint32_t)(now_us / MSC_STATS_RATE_SLOT_US);
+    int i = epoch % MSC_STATS_RATE_SLOTS;
+    if (rate->epoch[i] != epoch) {
+        rate->epoch[i] = epoch;
+        rate->bytes[i] = 0;
+    }
+    rate->bytes[i] += bytes;
+}
+
+static void _stats_record(tinyusb_msc_op_stats_t *op, msc_stats_rate_t *rate, int64_t start_us, uint32_t bytes, bool ok)
+{
+    int64_t now = esp_timer_get_time();
+    uint32_t us = (uint32_t)(now - start_us);
+    portENTER_CRITICAL_SAFE(&s_stats_lock);
+    op->count++;
+    op->bytes += bytes;
+    op->total_us += us;
+    op->max_us = MAX(op->max_us, us);
+    op->histogram[_stats_size_class(bytes)][_stats_latency_bucket(us)]++;
+    if (!ok) {
+        op->errors++;
+    }
+    if (rate) {
+        _stats_rate_add(rate, now, bytes);
+    }
+    portEXIT_CRITICAL_SAFE(&s_stats_lock);
+}
+
+static void _stats_erase_skipped(void)
+{
+    portENTER_CRITICAL_SAFE(&s_stats_lock);
+    s_stats.erase_skipped++;
+    portEXIT_CRITICAL_SAFE(&s_stats_lock);
+}
+
+static void _stats_defer_queued(void)
+{
+    portENTER_CRITICAL_SAFE(&s_stats_lock);
+    s_stats.defer_pending++;
+    s_stats.defer_max_pending = MAX(s_stats.defer_max_pending, s_stats.defer_pending);
+    portEXIT_CRITICAL_SAFE(&s_stats_lock);
+}
+
+static void _stats_defer_started(int64_t queued_us, int64_t start_us)
+{
+    uint32_t wait_us = (uint32_t)(start_us - queued_us);
+    portENTER_CRITICAL_SAFE(&s_stats_lock);
+    s_stats.defer_pending--;
+    s_stats.defer_max_wait_us = MAX(s_stats.defer_max_wait_us, wait_us);
+    portEXIT_CRITICAL_SAFE(&s_stats_lock);
+}
+
+static void _stats_scsi_unsupported(uint8_t opcode)
+{
+    portENTER_CRITICAL_SAFE(&s_stats_lock);
+    s_stats.scsi_unsupported++;
+    s_stats.scsi_last_unsupported = opcode;
+    portEXIT_CRITICAL_SAFE(&s_stats_lock);
+}
+#else
+#define MSC_STATS_NOW() 0
+
+static inline void _stats_record(tinyusb_msc_op_stats_t *op, msc_stats_rate_t *rate, int64_t start_us, uint32_t bytes, bool ok) {}
+static inline void _stats_erase_skipped(void) {}
+static inline void _stats_defer_queued(void) {}
+static inline void _stats_defer_started(int64_t queued_us, int64_t start_us) {}
+static inline void _stats_scsi_unsupported(uint8_t opcode) {}
+#endif // CONFIG_TINYUSB_MSC_STATS
+/*********************************************************************** Statistics*/
+
+static uint32_t _get_sector_count_spiflash(void)
+{
+    uint32_t result = 0;
+    assert(s_storage_handle->wl_handle != WL_INVALID_HANDLE);
+    size_t size = wl_sector_size(s_storage_handle->wl_handle);
+    if (size == 0) {
+        ESP_LOGW(TAG, "WL Sector size is zero !!!");
+        result = 0;
+    } else {
+        result = (uint32_t)(wl_size(s_storage_handle->wl_handle) / size);
+    }
+    return result;
+}
+
+static uint32_t _get_sector_size_spiflash(void)
+{
+    assert(s_storage_handle->wl_handle != WL_INVALID_HANDLE);
+    return (uint32_t)wl_sector_size(s_storage_handle->wl_handle);
+}
+
+static esp_err_t _read_sector_spiflash(size_t sector_size,
+                                       uint32_t lba,
+                                       uint32_t offset,
+                                       size_t size,
+                                       void *dest)
+{
+    size_t temp = 0;
+    size_t addr = 0; // Address of the data to be read, relative to the beginning of the partition.
+    ESP_RETURN_ON_FALSE(!__builtin_umul_overflow(lba, sector_size, &temp), ESP_ERR_INVALID_SIZE, TAG, "overflow lba %lu sector_size %u", lba, sector_size);
+    ESP_RETURN_ON_FALSE(!__builtin_uadd_overflow(temp, offset, &addr), ESP_ERR_INVALID_SIZE, TAG, "overflow addr %u offset %lu", temp, offset);
+    return wl_read(s_storage_handle->wl_handle, addr, dest, size);
+}
+
+static bool _erased_test(uint32_t lba, uint32_t count)
+{
+    const uint32_t *erased = s_storage_handle->erased;
+    for (uint32_t i = lba; i < lba + count; i++) {
+        if (!(erased[i / 32] & (1UL << (i % 32)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void _erased_mark(uint32_t lba, uint32_t count, bool erased)
+{
+    uint32_t *bitmap = s_storage_handle->erased;
+    for (uint32_t i = lba; i < lba + count; i++) {
+        if (erased) {
+            bitmap[i / 32] |= 1UL << (i % 32);
+        } else {
+            bitmap[i / 32] &= ~(1UL << (i % 32));
+        }
+    }
+}
+
+static esp_err_t _write_sector_spiflash(size_t sector_size,
+                                        size_t addr,
+                                        uint32_t lba,
+                                        uint32_t offset,
+                                        size_t size,
+                                        const void *src)
+{
+    (void) addr; // addr argument is not used in this function, we calculate it based on lba and offset.
+    size_t temp = 0;
+    size_t src_addr = 0; // Address of the data to be write, relative to the beginning of the partition.
+    ESP_RETURN_ON_FALSE(!__builtin_umul_overflow(lba, sector_size, &temp), ESP_ERR_INVALID_SIZE, TAG, "overflow lba %lu sector_size %u", lba, sector_size);
+    ESP_RETURN_ON_FALSE(!__builtin_uadd_overflow(temp, offset, &src_addr), ESP_ERR_INVALID_SIZE, TAG, "overflow addr %u offset %lu", temp, offset);
+    uint32_t first = src_addr / sector_size;
+    uint32_t count = (src_addr % sector_size + size + sector_size - 1) / sector_size;
+    if (_erased_test(first, count)) {
+        // Erased by UNMAP, written once since then at most partially
+        _stats_erase_skipped();
+    } else {
+        int64_t start = MSC_STATS_NOW();
+        esp_err_t ret = wl_erase_range(s_storage_handle->wl_handle, src_addr, size);
+        _stats_record(&s_stats.erase, NULL, start, size, ret == ESP_OK);
+        ESP_RETURN_ON_ERROR(ret, TAG, "Failed to erase");
+    }
+    _erased_mark(first, count, false);
+    return wl_write(s_storage_handle->wl_handle, src_addr, src, size);
+}
+
+/**
+ * @brief Erase whole flash sectors covered by the range
+ *
+ * Partially covered flash sectors are left alone: erasing them would need a
+ * read-modify-write of the neighbouring data, UNMAP and TRIM are only hints.
+ * Erase blocks already erased since their last write are skipped.
+ */
+static esp_err_t _unmap_spiflash(uint32_t lba, uint32_t count)
+{
+    size_t sector_size = s_storage_handle->sector_size;
+    uint32_t block = s_storage_handle->unmap_granularity;
+    uint32_t first = (lba + block - 1) / block * block;
+    uint32_t end = (lba + count) / block * block;
+    for (uint32_t i = first; i < end; i += block) {
+        if (_erased_test(i, block)) {
+            continue;
+        }
+        int64_t start = MSC_STATS_NOW();
+        esp_err_t ret = wl_erase_range(s_storage_handle->wl_handle, i * sector_size, block * sector_size);
+        _stats_record(&s_stats.erase, NULL, start, block * sector_size, ret == ESP_OK);
+        ESP_RETURN_ON_ERROR(ret, TAG, "Failed to erase");
+        _erased_mark(i, block, true);
+    }
+    return ESP_OK;
+}
+
+#if SOC_SDMMC_HOST_SUPPORTED
+static uint32_t _get_sector_count_sdmmc(void)
+{
+    assert(s_storage_handle->card);
+    return (uint32_t)s_storage_handle->card->csd.capacity;
+}
+
+static uint32_t _get_sector_size_sdmmc(void)
+{
+    assert(s_storage_handle->card);
+    return (uint32_t)s_storage_handle->card->csd.sector_size;
+}
+
+static esp_err_t _read_sector_sdmmc(size_t sector_size,
+                                    uint32_t lba,
+                                    uint32_t offset,
+                                    size_t size,
+                                    void *dest)
+{
+    return sdmmc_read_sectors(s_storage_handle->card, dest, lba, size / sector_size);
+}
+
+static esp_err_t _write_sector_sdmmc(size_t sector_size,
+                                     size_t addr,
+                                     uint32_t lba,
+                                     uint32_t offset,
+                                     size_t size,
+                                     const void *src)
+{
+    (void) addr; // addr argument is not used in this function, we use lba directly
+    return sdmmc_write_sectors(s_storage_handle->card, src, lba, size / sector_size);
+}
+
+static esp_err_t _unmap_sdmmc(uint32_t lba, uint32_t count)
+{
+    // The card is free to ignore a discard, cards without discard support are left alone
+    if (sdmmc_can_discard(s_storage_handle->card) != ESP_OK) {
+        return ESP_OK;
+    }
+    return sdmmc_erase_sectors(s_storage_handle->card, lba, count, SDMMC_DISCARD_ARG);
+}
+#endif
+
+static esp_err_t _msc_storage_read_sector(uint32_t lba,
+        uint32_t offset,
+        size_t size,
+        void *dest)
+{
+    assert(s_storage_handle);
+    size_t sector_size = tinyusb_msc_storage_get_sector_size();
+    return (s_storage_handle->read)(sector_size, lba, offset, size, dest);
+}
+
+/**
+ * @brief Take the FATFS volume lock, for as long as the application's FATFS call in progress needs
+ *
+ * The volume is never touched without the lock: the call in progress uses the same
+ * window buffer. During a handover the handover state stays set meanwhile, so the
+ * host keeps seeing "becoming ready" and retries.
+ */
+static void _volume_lock(void)
+{
+    while (!ff_mutex_take(s_storage_handle->pdrv)) {
+        ESP_LOGW(TAG, "volume busy, waiting for the application to release it");
+    }
+}
+
+/**
+ * @brief Invalidate the read-only view after the host has written sectors.
+ *
+ * Writes below the data area (boot sector, FSInfo, FATs and the FAT12/16 root
+ * directory) and writes to the sector cached in the FATFS window (a directory
+ * or FAT sector) make the view stale. The view is marked as not initialized,
+ * so FATFS re-mounts the volume on the next path based call and rejects file
+ * objects opened before the change.
+ *
+ * The window is read under the volume lock, after owner_lock is released:
+ * the application's FATFS calls take the volume lock first and owner_lock in
+ * _msc_disk_read(). A call in progress delays the host write's completion.
+ */
+static void _shared_invalidate(uint32_t lba, size_t size)
+{
+    FATFS *fs = s_storage_handle->fs;
+    if (!s_storage_handle->shared || !fs) {
+        return;
+    }
+    uint32_t count = size / s_storage_handle->sector_size;
+    _volume_lock();
+    if (fs->fs_type == 0 || lba < fs->database ||
+            (fs->winsect >= lba && fs->winsect < lba + count)) {
+        atomic_store(&s_storage_handle->shared_stale, true);
+    }
+    ff_mutex_give(s_storage_handle->pdrv);
+}
+
+static esp_err_t _msc_storage_write_sector(uint32_t lba,
+        uint32_t offset,
+        size_t size,
+        const void *src)
+{
+    assert(s_storage_handle);
+    size_t sector_size = tinyusb_msc_storage_get_sector_size();
+
+    if (size % sector_size != 0) {
+        ESP_LOGE(TAG, "Invalid Argument lba(%lu) offset(%lu) size(%u) sector_size(%u)", lba, offset, size, sector_size);
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Ownership can't change while the host write is in progress
+    xSemaphoreTake(s_storage_handle->owner_lock, portMAX_DELAY);
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+    bool written = !s_storage_handle->is_fat_mounted;
+    if (written) {
+        ret = (s_storage_handle->write)(sector_size, 0 /* not used */, lba, offset, size, src);
+    } else {
+        ESP_LOGE(TAG, "can't write, FAT mounted");
+    }
+    xSemaphoreGive(s_storage_handle->owner_lock);
+    // Also after a failed write, the sectors may have changed in part
+    if (written) {
+        _shared_invalidate(lba, size);
+    }
+    return ret;
+}
+
+/**
+ * @brief Release sectors the file system no longer uses
+ *
+ * Called for host UNMAP commands and FATFS TRIM requests, the caller owns the storage.
+ */
+static esp_err_t _msc_storage_unmap(uint32_t lba, uint32_t count)
+{
+    uint32_t sector_count = s_storage_handle->sector_count;
+    if (count == 0) {
+        return ESP_OK;
+    }
+    if (lba >= sector_count || count > sector_count - lba) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int64_t start = MSC_STATS_NOW();
+    esp_err_t ret = s_storage_handle->unmap(lba, count);
+    uint64_t bytes = (uint64_t)count * s_storage_handle->sector_size;
+    _stats_record(&s_stats.unmap, NULL, start, (uint32_t)MIN(bytes, UINT32_MAX), ret == ESP_OK);
+    return ret;
+}
+
+/* diskio driver
+   *********************************************************************
+ * Registered once and kept across handovers. While the host owns the storage
+ * the volume is read-only (shared mode) or not ready.
+ */
+
+static DSTATUS _msc_disk_status(BYTE pdrv)
+{
+    (void) pdrv;
+    if (s_storage_handle->is_fat_mounted) {
+        return 0;
+    }
+    if (!s_storage_handle->shared) {
+        return STA_NOINIT;
+    }
+    return STA_PROTECT | (atomic_load(&s_storage_handle->shared_stale) ? STA_NOINIT : 0);
+}
+
+static DSTATUS _msc_disk_initialize(BYTE pdrv)
+{
+    atomic_store(&s_storage_handle->shared_stale, false);
+    return _msc_disk_status(pdrv);
+}
+
+static DRESULT _msc_disk_read(BYTE pdrv, BYTE *buff, uint32_t sector, UINT count)
+{
+    (void) pdrv;
+    size_t sector_size = s_storage_handle->sector_size;
+    // In shared mode the TinyUSB task writes and erases meanwhile, wear levelling doesn't order
+    // a read against a write or the sector remapping that comes with it
+    xSemaphoreTake(s_storage_handle->owner_lock, portMAX_DELAY);
+    esp_err_t err = (s_storage_handle->read)(sector_size, sector, 0, count * sector_size, buff);
+    xSemaphoreGive(s_storage_handle->owner_lock);
+    return err == ESP_OK ? RES_OK : RES_ERROR;
+}
+
+static DRESULT _msc_disk_write(BYTE pdrv, const BYTE *buff, uint32_t sector, UINT count)
+{
+    (void) pdrv;
+    if (!s_storage_handle->is_fat_mounted) {
+        return RES_WRPRT;
+    }
+    size_t sector_size = s_storage_handle->sector_size;
+    esp_err_t err = (s_storage_handle->write)(sector_size, 0 /* not used */, sector, 0, count * sector_size, buff);
+    return err == ESP_OK ? RES_OK : RES_ERROR;
+}
+
+static DRESULT _msc_disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
+{
+    (void) pdrv;
+    switch (cmd) {
+    case CTRL_SYNC:
+        return RES_OK;
+    case GET_SECTOR_COUNT:
+        *((LBA_t *) buff) = s_storage_handle->sector_count;
+        return RES_OK;
+    case GET_SECTOR_SIZE:
+        *((WORD *) buff) = (WORD) s_storage_handle->sector_size;
+        return RES_OK;
+    case GET_BLOCK_SIZE:
+        *((DWORD *) buff) = 1;
+        return RES_OK;
+#if FF_USE_TRIM
+    case CTRL_TRIM: {
+        if (!s_storage_handle->is_fat_mounted) {
+            return RES_WRPRT;
+        }
+        LBA_t *range = (LBA_t *) buff; // first and last sector, inclusive
+        esp_err_t err = _msc_storage_unmap(range[0], range[1] - range[0] + 1);
+        return err == ESP_OK ? RES_OK : RES_ERROR;
+    }
+#endif
+    default:
+        return RES_PARERR;
+    }
+}
+
+static const ff_diskio_impl_t s_msc_diskio = {
+    .init = &_msc_disk_initialize,
+    .status = &_msc_disk_status,
+    .read = &_msc_disk_read,
+    .write = &_msc_disk_write,
+    .ioctl = &_msc_disk_ioctl,
+};
+/*********************************************************************** diskio driver*/
+
+static void _put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void _put_u32(uint8_t *p, uint32_t v)
+{
+    _put_u16(p, (uint16_t)v);
+    _put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+#if CONFIG_TINYUSB_FAT_FAST_FORMAT
+#define FAST_FORMAT_CHUNK_SIZE   4096 /*!< Bytes written per call, one flash erase block */
+#define FAST_FORMAT_ROOT_ENTRIES 512  /*!< Root directory entries, same as f_mkfs */
+#define FAST_FORMAT_MAX_FAT12    0xFF5
+#define FAST_FORMAT_MAX_FAT16    0xFFF5
+
+/**
+ * @brief FAT12/FAT16 volume layout without a partition table
+ */
+typedef struct {
+    uint32_t sector_size;
+    uint32_t sector_count;
+    uint32_t sec_per_clus;
+    uint32_t rsv_sectors;   /*!< Boot sector */
+    uint32_t fat_sectors;   /*!< Sectors per FAT, one FAT */
+    uint32_t root_sectors;
+    uint32_t sys_sectors;   /*!< Boot sector + FAT + root directory */
+    uint32_t clusters;
+    bool fat16;
+} fast_format_layout_t;
+
+/**
+ * @brief Compute the layout for the storage geometry
+ *
+ * @return false if the volume does not fit FAT12/FAT16
+ */
+static bool _fast_format_layout(uint32_t sector_count, uint32_t sector_size, uint32_t au_size, fast_format_layout_t *layout)
+{
+    memset(layout, 0, sizeof(*layout));
+    if (sector_count < 128) {
+        return false; // FATFS does not recognize smaller FAT volumes
+    }
+    layout->sector_size = sector_size;
+    layout->sector_count = sector_count;
+    layout->sec_per_clus = au_size > sector_size ? au_size / sector_size : 1;
+    if (layout->sec_per_clus > 128) {
+        layout->sec_per_clus = 128;
+    }
+    layout->rsv_sectors = 1;
+    layout->root_sectors = (FAST_FORMAT_ROOT_ENTRIES * 32 + sector_size - 1) / sector_size;
+
+    // The FAT size depends on the cluster count and vice versa, grows until it fits
+    layout->fat_sectors = 1;
+    while (1) {
+        uint32_t sys = layout->rsv_sectors + layout->fat_sectors + layout->root_sectors;
+        if (sector_count <= sys) {
+            return false;
+        }
+        layout->clusters = (sector_count - sys) / layout->sec_per_clus;
+        layout->fat16 = layout->clusters > FAST_FORMAT_MAX_FAT12;
+        uint32_t fat_bytes = layout->fat16 ? (layout->clusters + 2) * 2 : ((layout->clusters + 2) * 3 + 1) / 2;
+        uint32_t fat_sectors = (fat_bytes + sector_size - 1) / sector_size;
+        if (fat_sectors <= layout->fat_sectors) {
+            break;
+        }
+        layout->fat_sectors = fat_sectors;
+    }
+    if (layout->clusters < 1 || layout->clusters > FAST_FORMAT_MAX_FAT16) {
+        return false;
+    }
+    layout->sys_sectors = layout->rsv_sectors + layout->fat_sectors + layout->root_sectors;
+    return true;
+}
+
+/**
+ * @brief Fill the content of sectors [first, first + count) of the system area
+ */
+static void _fast_format_fill(const fast_format_layout_t *layout, uint32_t first, uint32_t count, uint32_t volume_id, uint8_t *buf)
+{
+    const uint32_t ss = layout->sector_size;
+    memset(buf, 0, count * ss);
+
+    if (first == 0) {
+        uint8_t *bs = buf;
+        memcpy(bs, "\xEB\xFE\x90" "MSDOS5.0", 11);        // Jump instruction, OEM name
+        _put_u16(bs + 11, (uint16_t)ss);                   // Bytes per sector
+        bs[13] = (uint8_t)layout->sec_per_clus;
+        _put_u16(bs + 14, (uint16_t)layout->rsv_sectors);
+        bs[16] = 1;                                        // Number of FATs
+        _put_u16(bs + 17, FAST_FORMAT_ROOT_ENTRIES);
+        if (layout->sector_count < 0x10000) {
+            _put_u16(bs + 19, (uint16_t)layout->sector_count);
+        } else {
+            _put_u32(bs + 32, layout->sector_count);
+        }
+        bs[21] = 0xF8;                                     // Media descriptor
+        _put_u16(bs + 22, (uint16_t)layout->fat_sectors);
+        _put_u16(bs + 24, 63);                             // Sectors per track
+        _put_u16(bs + 26, 255);                            // Number of heads
+        bs[36] = 0x80;                                     // Drive number
+        bs[38] = 0x29;                                     // Extended boot signature
+        _put_u32(bs + 39, volume_id);
+        memcpy(bs + 43, "NO NAME    ", 11);
+        memcpy(bs + 54, layout->fat16 ? "FAT16   " : "FAT12   ", 8);
+        _put_u16(bs + 510, 0xAA55);
+    }
+
+    // Entries 0 and 1 of the FAT: media descriptor and end of chain
+    uint32_t fat_start = layout->rsv_sectors;
+    if (fat_start >= first && fat_start < first + count) {
+        uint8_t *fat = buf + (fat_start - first) * ss;
+        fat[0] = 0xF8;
+        fat[1] = 0xFF;
+        fat[2] = 0xFF;
+        if (layout->fat16) {
+            fat[3] = 0xFF;
+        }
+    }
+}
+
+/**
+ * @brief Format the storage as FAT12/FAT16 without f_mkfs
+ *
+ * The system area is written in FAST_FORMAT_CHUNK_SIZE chunks instead of one sector
+ * at a time, and chunks that already hold the expected content are not rewritten.
+ * The data area is left untouched, as with f_mkfs.
+ *
+ * @return ESP_ERR_NOT_SUPPORTED if the volume does not fit FAT12/FAT16
+ */
+static esp_err_t _fast_format(uint32_t au_size)
+{
+    const uint32_t ss = tinyusb_msc_storage_get_sector_size();
+    fast_format_layout_t layout;
+    if (!_fast_format_layout(tinyusb_msc_storage_get_sector_count(), ss, au_size, &layout)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    const uint32_t chunk_sectors = FAST_FORMAT_CHUNK_SIZE > ss ? FAST_FORMAT_CHUNK_SIZE / ss : 1;
+    uint8_t *buf = heap_caps_malloc(chunk_sectors * ss, MALLOC_CAP_DEFAULT);
+    uint8_t *cur = heap_caps_malloc(ss, MALLOC_CAP_DEFAULT);
+    esp_err_t ret = ESP_OK;
+    if (!buf || !cur) {
+        ret = ESP_ERR_NO_MEM;
+        goto exit;
+    }
+
+    const uint32_t volume_id = esp_random();
+    uint32_t written = 0;
+    for (uint32_t first = 0; first < layout.sys_sectors; first += chunk_sectors) {
+        uint32_t count = MIN(chunk_sectors, layout.sys_sectors - first);
+        _fast_format_fill(&layout, first, count, volume_id, buf);
+
+        bool same = true;
+        for (uint32_t i = 0; i < count && same; i++) {
+            same = (s_storage_handle->read)(ss, first + i, 0, ss, cur) == ESP_OK &&
+                   memcmp(cur, buf + i * ss, ss) == 0;
+        }
+        // The boot sector always differs (volume id), so a stale volume is never kept
+        if (!same) {
+            ESP_GOTO_ON_ERROR((s_storage_handle->write)(ss, 0, first, 0, count * ss, buf), exit, TAG,
+                              "Failed to write sectors %lu..%lu", first, first + count - 1);
+            written += count;
+        }
+    }
+    ESP_LOGI(TAG, "fast format: FAT%d, %lu clusters of %lu sectors, %lu/%lu system sectors written",
+             layout.fat16 ? 16 : 12, layout.clusters, layout.sec_per_clus, written, layout.sys_sectors);
+
+exit:
+    free(buf);
+    free(cur);
+    return ret;
+}
+#endif // CONFIG_TINYUSB_FAT_FAST_FORMAT
+
+static esp_err_t _mount(char *drv, FATFS *fs)
+{
+    void *workbuf = NULL;
+    const size_t workbuf_size = 4096;
+    esp_err_t ret;
+    // Try to mount partition
+    FRESULT fresult = f_mount(fs, drv, 1);
+    if (fresult != FR_OK) {
+        ESP_LOGW(TAG, "f_mount failed (%d)", fresult);
+        if (!((fresult == FR_NO_FILESYSTEM || fresult == FR_INT_ERR))) {
+            ret = ESP_FAIL;
+            goto fail;
+        }
+        size_t alloc_unit_size = esp_vfs_fat_get_allocation_unit_size(
+                                     CONFIG_WL_SECTOR_SIZE,
+                                     4096);
+        ESP_LOGW(TAG, "formatting card, allocation unit size=%d", alloc_unit_size);
+        int64_t format_start = esp_timer_get_time();
+
+#if CONFIG_TINYUSB_FAT_FAST_FORMAT
+        ret = _fast_format(alloc_unit_size);
+        if (ret == ESP_OK) {
+            fresult = f_mount(fs, drv, 1);
+            if (fresult == FR_OK) {
+                ESP_LOGI(TAG, "formatted in %lld ms (fast format)", (esp_timer_get_time() - format_start) / 1000);
+                return ESP_OK;
+            }
+            ESP_LOGW(TAG, "f_mount failed after fast format (%d), using f_mkfs", fresult);
+        } else if (ret != ESP_ERR_NOT_SUPPORTED) {
+            ESP_LOGW(TAG, "fast format failed (0x%x), using f_mkfs", ret);
+        }
+        format_start = esp_timer_get_time();
+#endif // CONFIG_TINYUSB_FAT_FAST_FORMAT
+
+        workbuf = ff_memalloc(workbuf_size);
+        if (workbuf == NULL) {
+            ret = ESP_ERR_NO_MEM;
+            goto fail;
+        }
+
+        BYTE format_flags;
+#if defined(CONFIG_TINYUSB_FAT_FORMAT_ANY)
+        format_flags = FM_ANY;
+
+#elif defined(CONFIG_TINYUSB_FAT_FORMAT_FAT)
+        format_flags = FM_FAT;
+
+#elif defined(CONFIG_TINYUSB_FAT_FORMAT_FAT32)
+        format_flags = FM_FAT32;
+
+#elif defined(CONFIG_TINYUSB_FAT_FORMAT_EXFAT)
+        format_flags = FM_EXFAT;
+#else
+
+#error "No FAT format type selected"
+
+#endif
+
+#ifdef CONFIG_TINYUSB_FAT_FORMAT_SFD
+        format_flags |= FM_SFD;
+#endif
+        const MKFS_PARM opt = {format_flags, 0, 0, 0, alloc_unit_size};
+        fresult = f_mkfs("", &opt, workbuf, workbuf_size); // Use default volume
+        if (fresult != FR_OK) {
+            ret = ESP_FAIL;
+            ESP_LOGE(TAG, "f_mkfs failed (%d)", fresult);
+            goto fail;
+        }
+        free(workbuf);
+        workbuf = NULL;
+        fresult = f_mount(fs, drv, 0);
+        if (fresult != FR_OK) {
+            ret = ESP_FAIL;
+            ESP_LOGE(TAG, "f_mount failed after formatting (%d)", fresult);
+            goto fail;
+        }
+        ESP_LOGI(TAG, "formatted in %lld ms (f_mkfs)", (esp_timer_get_time() - format_start) / 1000);
+    }
+    return ESP_OK;
+fail:
+    if (workbuf) {
+        free(workbuf);
+    }
+    return ret;
+}
+
+/**
+ * @brief Handles deferred USB MSC write operations.
+ *
+ * This function is invoked via TinyUSB's deferred execution mechanism to perform
+ * write operations to the underlying storage. It writes data from the
+ * `storage_buffer` stored within the `s_storage_handle`.
+ *
+ * @param param Unused. Present for compatibility with deferred function signature.
+ */
+static void _write_func(void *param)
+{
+    // Already written by _write_flush(), or an identical deferred call was batched with this one
+    if (!atomic_exchange(&s_storage_handle->storage_buffer.pending, false)) {
+        return;
+    }
+
+    int64_t start = MSC_STATS_NOW();
+    _stats_defer_started(s_storage_handle->storage_buffer.queued_us, start);
+
+    // Process the data in storage_buffer
+    esp_err_t err = _msc_storage_write_sector(
+                        s_storage_handle->storage_buffer.lba,
+                        s_storage_handle->storage_buffer.offset,
+                        s_storage_handle->storage_buffer.bufsize,
+                        (const void *)s_storage_handle->storage_buffer.data_buffer
+                    );
+    _stats_record(&s_stats.write, &s_write_rate, start, s_storage_handle->storage_buffer.bufsize, err == ESP_OK);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Write failed, error=0x%x", err);
+    }
+}
+
+/**
+ * @brief Write the buffered WRITE10 data now if its deferred write has not run yet
+ *
+ * Deferred functions run after pending USB events, so the next SCSI command can be
+ * handled before the write. Everything that touches the storage flushes first.
+ */
+static void _write_flush(void)
+{
+    if (atomic_load(&s_storage_handle->storage_buffer.pending)) {
+        _write_func(NULL);
+    }
+}
+
+static void _write_drain_func(void *param)
+{
+    _write_flush();
+    xSemaphoreGive((SemaphoreHandle_t) param);
+}
+
+/**
+ * @brief Write the buffered WRITE10 data from outside the TinyUSB task
+ *
+ * The buffer belongs to the TinyUSB task, so the flush is deferred to it and runs after
+ * the write deferred earlier. Every write acknowledged to the host is on the storage when
+ * this returns. Flushes here only when the TinyUSB task does not respond, e.g. it is not
+ * running or this is called from it.
+ */
+static void _write_drain(void)
+{
+    if (!tud_inited()) {
+        _write_flush();
+        return;
+    }
+    // A give left over from a drain that timed out
+    xSemaphoreTake(s_storage_handle->drain_done, 0);
+    usbd_defer_func(_write_drain_func, s_storage_handle->drain_done, false);
+    if (xSemaphoreTake(s_storage_handle->drain_done, pdMS_TO_TICKS(MSC_WRITE_DRAIN_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "TinyUSB task not responding, writing the buffered host data here");
+        _write_flush();
+    }
+}
+
+static void _notify(tusb_msc_callback_t cb, tinyusb_msc_event_type_t type)
+{
+    if (cb) {
+        tinyusb_msc_event_t event = {
+            .type = type,
+            .mount_changed_data = {
+                .is_mounted = s_storage_handle->is_fat_mounted
+            }
+        };
+        cb(&event);
+    }
+}
+
+/**
+ * @brief Register diskio and VFS for the storage, once
+ */
+static esp_err_t _register(const char *base_path)
+{
+    BYTE pdrv = 0xFF;
+    ESP_RETURN_ON_ERROR(ff_diskio_get_drive(&pdrv), TAG,
+                        "The maximum count of volumes is already mounted");
+    char drv[3] = {(char)('0' + pdrv), ':', 0};
+    ff_diskio_register(pdrv, &s_msc_diskio);
+
+    FATFS *fs = NULL;
+    esp_err_t ret = esp_vfs_fat_register(base_path, drv, s_storage_handle->max_files, &fs);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "esp_vfs_fat_register failed (0x%x)", ret);
+        ff_diskio_unregister(pdrv);
+        return ret;
+    }
+    // Lazy mount, creates the volume lock used by the handovers
+    f_mount(fs, drv, 0);
+    s_storage_handle->pdrv = pdrv;
+    s_storage_handle->fs = fs;
+    s_storage_handle->base_path = base_path;
+    s_storage_handle->is_registered = true;
+    return ESP_OK;
+}
+
+/**
+ * @brief Write back the sector cached in the FATFS window and the FSInfo sector
+ *
+ * Same as sync_fs() in FATFS. Caller holds the volume lock.
+ */
+static void _flush_fs(FATFS *fs)
+{
+    const uint32_t ss = s_storage_handle->sector_size;
+    if (fs->fs_type == 0) {
+        return;
+    }
+    if (fs->wflag) {
+        (s_storage_handle->write)(ss, 0, fs->winsect, 0, ss, fs->win);
+        if (fs->n_fats == 2 && fs->winsect - fs->fatbase < fs->fsize) {
+            (s_storage_handle->write)(ss, 0, fs->winsect + fs->fsize, 0, ss, fs->win);
+        }
+        fs->wflag = 0;
+    }
+    if (fs->fs_type == FS_FAT32 && fs->fsi_flag == 1) {
+        memset(fs->win, 0, ss);
+        _put_u32(fs->win + 0, 0x41615252);    // FSI_LeadSig
+        _put_u32(fs->win + 484, 0x61417272);  // FSI_StrucSig
+        _put_u32(fs->win + 488, fs->free_clst);
+        _put_u32(fs->win + 492, fs->last_clst);
+        _put_u16(fs->win + 510, 0xAA55);
+        fs->winsect = fs->volbase + 1;
+        (s_storage_handle->write)(ss, 0, fs->winsect, 0, ss, fs->win);
+        fs->fsi_flag = 0;
+    }
+}
+
+static void _handover_done(bool to_app, int64_t request_us)
+{
+    uint32_t us = (uint32_t)(esp_timer_get_time() - request_us);
+    tinyusb_msc_handover_stats_t *stats = &s_storage_handle->handover_stats;
+    if (to_app) {
+        stats->to_app_count++;
+        stats->last_to_app_us = us;
+        stats->max_to_app_us = MAX(stats->max_to_app_us, us);
+    } else {
+        stats->to_host_count++;
+        stats->last_to_host_us = us;
+        stats->max_to_host_us = MAX(stats->max_to_host_us, us);
+    }
+    ESP_LOGD(TAG, "handover to %s in %lu us", to_app ? "application" : "host", us);
+}
+
+/**
+ * @brief Give the storage to the application
+ *
+ * diskio and VFS stay registered, only the FATFS volume is re-mounted because
+ * the host may have changed anything.
+ */
+static esp_err_t _handover_to_app(const char *base_path, int64_t request_us)
+{
+    esp_err_t ret = ESP_OK;
+    if (s_storage_handle->is_fat_mounted) {
+        goto exit;
+    }
+    s_storage_handle->handover_state = MSC_HANDOVER_TO_APP;
+    _notify(s_storage_handle->callback_premount_changed, TINYUSB_MSC_EVENT_PREMOUNT_CHANGED);
+
+    if (!s_storage_handle->is_registered) {
+        ESP_GOTO_ON_ERROR(_register(base_path ? base_path : CONFIG_TINYUSB_MSC_MOUNT_PATH), exit, TAG, "Failed to register storage");
+    }
+    FATFS *fs = s_storage_handle->fs;
+    char drv[3] = {(char)('0' + s_storage_handle->pdrv), ':', 0};
+
+    // Host writes are refused from now on (handover_state), the ones already acknowledged are written first
+    _write_drain();
+
+    // The read-only view is dropped before the volume becomes writable
+    _volume_lock();
+    fs->fs_type = 0;
+    // Wait for the host write in progress, later ones are refused
+    xSemaphoreTake(s_storage_handle->owner_lock, portMAX_DELAY);
+    s_storage_handle->is_fat_mounted = true;
+    xSemaphoreGive(s_storage_handle->owner_lock);
+    ff_mutex_give(s_storage_handle->pdrv);
+
+    // Mount now rather than on first access, format if the host left no filesystem
+    DIR dir;
+    FRESULT fresult = f_opendir(&dir, drv);
+    if (fresult == FR_OK) {
+        f_closedir(&dir);
+    } else {
+        ret = _mount(drv, fs);
+        if (ret != ESP_OK) {
+            s_storage_handle->is_fat_mounted = false;
+            ESP_LOGW(TAG, "Failed to mount storage (0x%x)", ret);
+            goto exit;
+        }
+    }
+    _handover_done(true, request_us);
+    s_storage_handle->handover_state = MSC_HANDOVER_IDLE;
+    _notify(s_storage_handle->callback_mount_changed, TINYUSB_MSC_EVENT_MOUNT_CHANGED);
+    return ESP_OK;
+
+exit:
+    s_storage_handle->handover_state = MSC_HANDOVER_IDLE;
+    return ret;
+}
+
+/**
+ * @brief Give the storage to the host
+ *
+ * Waits for the application's FATFS call in progress, writes back the cached
+ * sectors and invalidates the volume. diskio and VFS stay registered.
+ */
+static esp_err_t _handover_to_host(int64_t request_us)
+{
+    if (!s_storage_handle->is_fat_mounted) {
+        s_storage_handle->handover_state = MSC_HANDOVER_IDLE;
+        return ESP_OK;
+    }
+    s_storage_handle->handover_state = MSC_HANDOVER_TO_HOST;
+    _notify(s_storage_handle->callback_premount_changed, TINYUSB_MSC_EVENT_PREMOUNT_CHANGED);
+
+    FATFS *fs = s_storage_handle->fs;
+    _volume_lock();
+    _flush_fs(fs);
+    fs->fs_type = 0;
+
+    xSemaphoreTake(s_storage_handle->owner_lock, portMAX_DELAY);
+    s_storage_handle->is_fat_mounted = false;
+    atomic_store(&s_storage_handle->shared_stale, false);
+    xSemaphoreGive(s_storage_handle->owner_lock);
+    ff_mutex_give(s_storage_handle->pdrv);
+
+    _handover_done(false, request_us);
+    s_storage_handle->handover_state = MSC_HANDOVER_IDLE;
+    _notify(s_storage_handle->callback_mount_changed, TINYUSB_MSC_EVENT_MOUNT_CHANGED);
+    return ESP_OK;
+}
+
+static esp_err_t _handover(bool to_app, const char *base_path, int64_t request_us)
+{
+    xSemaphoreTake(s_storage_handle->handover_lock, portMAX_DELAY);
+    esp_err_t ret = to_app ? _handover_to_app(base_path, request_us) : _handover_to_host(request_us);
+    xSemaphoreGive(s_storage_handle->handover_lock);
+    return ret;
+}
+
+/**
+ * @brief Run handovers requested from TinyUSB callbacks, so the TinyUSB task never waits for FATFS
+ */
+static void _handover_task(void *arg)
+{
+    (void) arg;
+    while (1) {
+        uint32_t to_app;
+        xTaskNotifyWait(0, UINT32_MAX, &to_app, portMAX_DELAY);
+        _handover(to_app, NULL, s_storage_handle->handover_request_us);
+    }
+}
+
+/**
+ * @brief Request a handover from a TinyUSB callback
+ *
+ * The host sees "becoming ready" from now until the handover task is done.
+ * A newer request overrides a pending one.
+ */
+static void _handover_async(bool to_app)
+{
+    if (to_app) {
+        _write_flush();
+    }
+    if (to_app == s_storage_handle->is_fat_mounted && s_storage_handle->handover_state == MSC_HANDOVER_IDLE) {
+        return;
+    }
+    s_storage_handle->handover_state = to_app ? MSC_HANDOVER_TO_APP : MSC_HANDOVER_TO_HOST;
+    s_storage_handle->handover_request_us = esp_timer_get_time();
+    xTaskNotify(s_storage_handle->handover_task, to_app, eSetValueWithOverwrite);
+}
+
+esp_err_t tinyusb_msc_storage_mount(const char *base_path)
+{
+    assert(s_storage_handle);
+    return _handover(true, base_path, esp_timer_get_time());
+}
+
+esp_err_t tinyusb_msc_storage_unmount(void)
+{
+    if (!s_storage_handle) {
+        return ESP_FAIL;
+    }
+    return _handover(false, NULL, esp_timer_get_time());
+}
+
+void tinyusb_msc_storage_get_stats(tinyusb_msc_stats_t *stats)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL_SAFE(&s_stats_lock);
+    *stats = s_stats;
+    stats->read_bytes_per_sec = _stats_rate_get(&s_read_rate, now);
+    stats->write_bytes_per_sec = _stats_rate_get(&s_write_rate, now);
+    portEXIT_CRITICAL_SAFE(&s_stats_lock);
+}
+
+void tinyusb_msc_storage_reset_stats(void)
+{
+    portENTER_CRITICAL_SAFE(&s_stats_lock);
+    uint32_t pending = s_stats.defer_pending;
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.defer_pending = pending;
+    memset(&s_read_rate, 0, sizeof(s_read_rate));
+    memset(&s_write_rate, 0, sizeof(s_write_rate));
+    portEXIT_CRITICAL_SAFE(&s_stats_lock);
+}
+
+void tinyusb_msc_storage_get_handover_stats(tinyusb_msc_handover_stats_t *stats)
+{
+    assert(s_storage_handle);
+    *stats = s_storage_handle->handover_stats;
+}
+
+uint32_t tinyusb_msc_storage_get_sector_count(void)
+{
+    assert(s_storage_handle);
+    return (s_storage_handle->sector_count);
+}
+
+uint32_t tinyusb_msc_storage_get_sector_size(void)
+{
+    assert(s_storage_handle);
+    return (s_storage_handle->sector_size);
+}
+
+/**
+ * @brief Handover state common to all media
+ */
+static esp_err_t _storage_init_handover(void)
+{
+    s_storage_handle->is_registered = false;
+    s_storage_handle->fs = NULL;
+    s_storage_handle->shared = false;
+    atomic_init(&s_storage_handle->shared_stale, false);
+    s_storage_handle->handover_state = MSC_HANDOVER_IDLE;
+    memset(&s_storage_handle->handover_stats, 0, sizeof(s_storage_handle->handover_stats));
+    s_storage_handle->handover_task = NULL;
+    s_storage_handle->owner_lock = xSemaphoreCreateMutex();
+    s_storage_handle->handover_lock = xSemaphoreCreateMutex();
+    s_storage_handle->drain_done = xSemaphoreCreateBinary();
+    if (!s_storage_handle->owner_lock || !s_storage_handle->handover_lock || !s_storage_handle->drain_done ||
+            xTaskCreate(_handover_task, "msc_handover", MSC_HANDOVER_TASK_STACK_SIZE, NULL,
+                        MSC_HANDOVER_TASK_PRIORITY, &s_storage_handle->handover_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create handover task");
+        tinyusb_msc_storage_deinit();
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t tinyusb_msc_storage_init_spiflash(const tinyusb_msc_spiflash_config_t *config)
+{
+    assert(!s_storage_handle);
+    ESP_RETURN_ON_FALSE(CONFIG_TINYUSB_MSC_BUFSIZE >= CONFIG_WL_SECTOR_SIZE,
+                        ESP_ERR_NOT_SUPPORTED, TAG,
+                        "CONFIG_TINYUSB_MSC_BUFSIZE (%d) must be at least the size of CONFIG_WL_SECTOR_SIZE (%d)", (int)(CONFIG_TINYUSB_MSC_BUFSIZE), (int)(CONFIG_WL_SECTOR_SIZE));
+    s_storage_handle = (tinyusb_msc_storage_handle_s *)heap_caps_aligned_alloc(MSC_STORAGE_MEM_ALIGN, sizeof(tinyusb_msc_storage_handle_s), MALLOC_CAP_DMA);
+    ESP_RETURN_ON_FALSE(s_storage_handle, ESP_ERR_NO_MEM, TAG, "Failed to allocate memory for storage handle");
+    s_storage_handle->wl_handle = config->wl_handle;
+    s_storage_handle->sector_count = _get_sector_count_spiflash();
+    s_storage_handle->sector_size = _get_sector_size_spiflash();
+    s_storage_handle->read = &_read_sector_spiflash;
+    s_storage_handle->write = &_write_sector_spiflash;
+    s_storage_handle->unmap = &_unmap_spiflash;
+    s_storage_handle->unmap_granularity = MAX(1, SPI_FLASH_SEC_SIZE / s_storage_handle->sector_size);
+    s_storage_handle->erased = heap_caps_calloc((s_storage_handle->sector_count + 31) / 32, sizeof(uint32_t), MALLOC_CAP_DEFAULT);
+    if (!s_storage_handle->erased) {
+        heap_caps_free(s_storage_handle);
+        s_storage_handle = NULL;
+        ESP_LOGE(TAG, "Failed to allocate memory for erased sectors bitmap");
+        return ESP_ERR_NO_MEM;
+    }
+    atomic_init(&s_storage_handle->storage_buffer.pending, false);
+    s_storage_handle->is_fat_mounted = false;
+    s_storage_handle->base_path = NULL;
+    // In case the user does not set mount_config.max_files
+    // and for backward compatibility with versions <1.4.2
+    // max_files is set to 2
+    const int max_files = config->mount_config.max_files;
+    s_storage_handle->max_files = max_files > 0 ? max_files : 2;
+
+    /* Callbacks setting up*/
+    if (config->callback_mount_changed) {
+        tinyusb_msc_register_callback(TINYUSB_MSC_EVENT_MOUNT_CHANGED, config->callback_mount_changed);
+    } else {
+        tinyusb_msc_unregister_callback(TINYUSB_MSC_EVENT_MOUNT_CHANGED);
+    }
+    if (config->callback_premount_changed) {
+        tinyusb_msc_register_callback(TINYUSB_MSC_EVENT_PREMOUNT_CHANGED, config->callback_premount_changed);
+    } else {
+        tinyusb_msc_unregister_callback(TINYUSB_MSC_EVENT_PREMOUNT_CHANGED);
+    }
+
+    if (!esp_ptr_dma_capable((const void *)s_storage_handle->storage_buffer.data_buffer)) {
+        ESP_LOGW(TAG, "storage buffer is not DMA capable");
+    }
+
+    return _storage_init_handover();
+}
+
+#if SOC_SDMMC_HOST_SUPPORTED
+esp_err_t tinyusb_msc_storage_init_sdmmc(const tinyusb_msc_sdmmc_config_t *config)
+{
+    assert(!s_storage_handle);
+    s_storage_handle = (tinyusb_msc_storage_handle_s *)heap_caps_aligned_alloc(MSC_STORAGE_MEM_ALIGN, sizeof(tinyusb_msc_storage_handle_s), MALLOC_CAP_DMA);
+    ESP_RETURN_ON_FALSE(s_storage_handle, ESP_ERR_NO_MEM, TAG, "Failed to allocate memory for storage handle");
+    s_storage_handle->card = config->card;
+    s_storage_handle->sector_count = _get_sector_count_sdmmc();
+    s_storage_handle->sector_size = _get_sector_size_sdmmc();
+    s_storage_handle->read = &_read_sector_sdmmc;
+    s_storage_handle->write = &_write_sector_sdmmc;
+    s_storage_handle->unmap = &_unmap_sdmmc;
+    s_storage_handle->unmap_granularity = 1;
+    s_storage_handle->erased = NULL;
+    atomic_init(&s_storage_handle->storage_buffer.pending, false);
+    s_storage_handle->is_fat_mounted = false;
+    s_storage_handle->base_path = NULL;
+    // In case the user does not set mount_config.max_files
+    // and for backward compatibility with versions <1.4.2
+    // max_files is set to 2
+    const int max_files = config->mount_config.max_files;
+    s_storage_handle->max_files = max_files > 0 ? max_files : 2;
+
+    /* Callbacks setting up*/
+    if (config->callback_mount_changed) {
+        tinyusb_msc_register_callback(TINYUSB_MSC_EVENT_MOUNT_CHANGED, config->callback_mount_changed);
+    } else {
+        tinyusb_msc_unregister_callback(TINYUSB_MSC_EVENT_MOUNT_CHANGED);
+    }
+    if (config->callback_premount_changed) {
+        tinyusb_msc_register_callback(TINYUSB_MSC_EVENT_PREMOUNT_CHANGED, config->callback_premount_changed);
+    } else {
+        tinyusb_msc_unregister_callback(TINYUSB_MSC_EVENT_PREMOUNT_CHANGED);
+    }
+
+    if (!esp_ptr_dma_capable((const void *)s_storage_handle->storage_buffer.data_buffer)) {
+        ESP_LOGW(TAG, "storage buffer is not DMA capable");
+    }
+
+    return _storage_init_handover();
+}
+#endif
+
+void tinyusb_msc_storage_deinit(void)
+{
+    if (s_storage_handle) {
+        if (s_storage_handle->handover_task) {
+            vTaskDelete(s_storage_handle->handover_task);
+        }
+        if (s_storage_handle->is_registered) {
+            char drv[3] = {(char)('0' + s_storage_handle->pdrv), ':', 0};
+            f_mount(0, drv, 0);
+            ff_diskio_unregister(s_storage_handle->pdrv);
+            esp_vfs_fat_unregister_path(s_storage_handle->base_path);
+        }
+        if (s_storage_handle->owner_lock) {
+            vSemaphoreDelete(s_storage_handle->owner_lock);
+        }
+        if (s_storage_handle->handover_lock) {
+            vSemaphoreDelete(s_storage_handle->handover_lock);
+        }
+        if (s_storage_handle->drain_done) {
+            vSemaphoreDelete(s_storage_handle->drain_done);
+        }
+        heap_caps_free(s_storage_handle->erased);
+        heap_caps_free(s_storage_handle);
+        s_storage_handle = NULL;
+    }
+}
+
+esp_err_t tinyusb_msc_register_callback(tinyusb_msc_event_type_t event_type,
+                                        tusb_msc_callback_t callback)
+{
+    assert(s_storage_handle);
+    switch (event_type) {
+    case TINYUSB_MSC_EVENT_MOUNT_CHANGED:
+        s_storage_handle->callback_mount_changed = callback;
+        return ESP_OK;
+    case TINYUSB_MSC_EVENT_PREMOUNT_CHANGED:
+        s_storage_handle->callback_premount_changed = callback;
+        return ESP_OK;
+    default:
+        ESP_LOGE(TAG, "Wrong event type");
+        return ESP_ERR_INVALID_ARG;
+    }
+}
+
+esp_err_t tinyusb_msc_unregister_callback(tinyusb_msc_event_type_t event_type)
+{
+    assert(s_storage_handle);
+    switch (event_type) {
+    case TINYUSB_MSC_EVENT_MOUNT_CHANGED:
+        s_storage_handle->callback_mount_changed = NULL;
+        return ESP_OK;
+    case TINYUSB_MSC_EVENT_PREMOUNT_CHANGED:
+        s_storage_handle->callback_premount_changed = NULL;
+        return ESP_OK;
+    default:
+        ESP_LOGE(TAG, "Wrong event type");
+        return ESP_ERR_INVALID_ARG;
+    }
+}
+
+bool tinyusb_msc_storage_in_use_by_usb_host(void)
+{
+    assert(s_storage_handle);
+    return !s_storage_handle->is_fat_mounted;
+}
+
+void tinyusb_msc_storage_set_shared(bool shared)
+{
+    assert(s_storage_handle);
+    s_storage_handle->shared = shared;
+}
+
+bool tinyusb_msc_storage_is_shared(void)
+{
+    assert(s_storage_handle);
+    return s_storage_handle->shared && s_storage_handle->is_registered && !s_storage_handle->is_fat_mounted;
+}
+
+
+/* TinyUSB MSC callbacks
+   ********************************************************************* */
+
+/** SCSI ASC/ASCQ codes. **/
+/** User can add and use more codes as per the need of the application **/
+#define SCSI_CODE_ASC_MEDIUM_NOT_PRESENT 0x3A /** SCSI ASC code for 'MEDIUM NOT PRESENT' **/
+#define SCSI_CODE_ASC_INVALID_COMMAND_OPERATION_CODE 0x20 /** SCSI ASC code for 'INVALID COMMAND OPERATION CODE' **/
+#define SCSI_CODE_ASCQ 0x00
+#define SCSI_CODE_ASC_LUN_NOT_READY 0x04 /** SCSI ASC code for 'LOGICAL UNIT NOT READY' **/
+#define SCSI_CODE_ASCQ_BECOMING_READY 0x01 /** SCSI ASCQ code for 'IN PROCESS OF BECOMING READY' **/
+#define SCSI_CODE_ASC_PARAMETER_LIST_LENGTH_ERROR 0x1A /** SCSI ASC code for 'PARAMETER LIST LENGTH ERROR' **/
+#define SCSI_CODE_ASC_LBA_OUT_OF_RANGE 0x21 /** SCSI ASC code for 'LOGICAL BLOCK ADDRESS OUT OF RANGE' **/
+#define SCSI_CODE_ASC_INVALID_FIELD_IN_CDB 0x24 /** SCSI ASC code for 'INVALID FIELD IN CDB' **/
+#define SCSI_CODE_ASC_INVALID_FIELD_IN_PARAMETER_LIST 0x26 /** SCSI ASC code for 'INVALID FIELD IN PARAMETER LIST' **/
+#define SCSI_CODE_ASC_WRITE_PROTECTED 0x27 /** SCSI ASC code for 'WRITE PROTECTED' **/
+#define SCSI_CODE_ASC_WRITE_ERROR 0x0C /** SCSI ASC code for 'WRITE ERROR' **/
+
+#define SCSI_SA_READ_CAPACITY_16 0x10 /** SERVICE ACTION IN (16) service action for READ CAPACITY (16) **/
+#define SCSI_VPD_SUPPORTED_PAGES 0x00
+#define SCSI_VPD_BLOCK_LIMITS 0xB0
+#define SCSI_VPD_LOGICAL_BLOCK_PROVISIONING 0xB2
+
+// Invoked when received SCSI_CMD_INQUIRY
+// Application fill vendor id, product id and revision with string up to 8, 16, 4 characters respectively
+void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8], uint8_t product_id[16], uint8_t product_rev[4])
+{
+    (void) lun;
+    const char vid[] = "TinyUSB";
+    const char pid[] = "Flash Storage";
+    const char rev[] = "0.2";
+
+    memcpy(vendor_id, vid, strlen(vid));
+    memcpy(product_id, pid, strlen(pid));
+    memcpy(product_rev, rev, strlen(rev));
+}
+
+// Invoked when received Test Unit Ready command.
+// return true allowing host to read/write this LUN e.g SD card inserted
+bool tud_msc_test_unit_ready_cb(uint8_t lun)
+{
+    // Only the few milliseconds of a handover are reported as "becoming ready", the host retries shortly
+    if (s_storage_handle->handover_state != MSC_HANDOVER_IDLE) {
+        tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, SCSI_CODE_ASC_LUN_NOT_READY, SCSI_CODE_ASCQ_BECOMING_READY);
+        return false;
+    }
+    if (s_storage_handle->is_fat_mounted) {
+        tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, SCSI_CODE_ASC_MEDIUM_NOT_PRESENT, SCSI_CODE_ASCQ);
+        return false;
+    }
+    return true;
+}
+
+// Invoked when received SCSI_CMD_READ_CAPACITY_10 and SCSI_CMD_READ_FORMAT_CAPACITY to determine the disk size
+// Application update block count and block size
+void tud_msc_capacity_cb(uint8_t lun, uint32_t *block_count, uint16_t *block_size)
+{
+    (void) lun;
+
+    uint32_t sec_count = tinyusb_msc_storage_get_sector_count();
+    uint32_t sec_size = tinyusb_msc_storage_get_sector_size();
+    *block_count = sec_count;
+    *block_size  = (uint16_t)sec_size;
+}
+
+// Invoked when received Start Stop Unit command
+// - Start = 0 : stopped power mode, if load_eject = 1 : unload disk storage
+// - Start = 1 : active mode, if load_eject = 1 : load disk storage
+bool tud_msc_start_stop_cb(uint8_t lun, uint8_t power_condition, bool start, bool load_eject)
+{
+    (void) lun;
+    (void) power_condition;
+
+    if (load_eject && !start) {
+        _handover_async(true);
+    }
+    return true;
+}
+
+// Invoked when received SCSI SYNCHRONIZE CACHE(10) command
+// The only cache is the deferred write buffer
+bool tud_msc_synchronize_cache_cb(uint8_t lun, uint32_t lba, uint16_t block_count, bool immed)
+{
+    (void) lun;
+    (void) lba;
+    (void) block_count;
+    (void) immed;
+    _write_flush();
+    return true;
+}
+
+// Invoked when received SCSI READ10 command
+// - Address = lba * BLOCK_SIZE + offset
+// - Application fill the buffer (up to bufsize) with address contents and return number of read byte.
+int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void *buffer, uint32_t bufsize)
+{
+    _write_flush();
+    int64_t start = MSC_STATS_NOW();
+    esp_err_t err = _msc_storage_read_sector(lba, offset, bufsize, buffer);
+    _stats_record(&s_stats.read, &s_read_rate, start, bufsize, err == ESP_OK);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "msc_storage_read_sector failed: 0x%x", err);
+        return 0;
+    }
+    return bufsize;
+}
+
+// Invoked when received SCSI WRITE10 command
+// - Address = lba * BLOCK_SIZE + offset
+// - Application write data from buffer to address contents (up to bufsize) and return number of written byte.
+int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t bufsize)
+{
+    assert(bufsize <= MSC_STORAGE_BUFFER_SIZE);
+    // Refuse rather than acknowledge data that could not be written once the application owns the storage
+    if (s_storage_handle->handover_state == MSC_HANDOVER_TO_APP) {
+        tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, SCSI_CODE_ASC_LUN_NOT_READY, SCSI_CODE_ASCQ_BECOMING_READY);
+        return -1;
+    }
+    if (s_storage_handle->is_fat_mounted) {
+        tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, SCSI_CODE_ASC_MEDIUM_NOT_PRESENT, SCSI_CODE_ASCQ);
+        return -1;
+    }
+    // The previous chunk may still wait in the deferred queue
+    _write_flush();
+    // Copy data to the buffer
+    memcpy((void *)s_storage_handle->storage_buffer.data_buffer, buffer, bufsize);
+    s_storage_handle->storage_buffer.lba = lba;
+    s_storage_handle->storage_buffer.offset = offset;
+    s_storage_handle->storage_buffer.bufsize = bufsize;
+    s_storage_handle->storage_buffer.queued_us = MSC_STATS_NOW();
+    atomic_store(&s_storage_handle->storage_buffer.pending, true);
+    _stats_defer_queued();
+
+    // Defer execution of the write to the TinyUSB task
+    usbd_defer_func(_write_func, NULL, false);
+
+    // Return the number of bytes accepted
+    return bufsize;
+}
+
+/**
+ * Invoked when received an SCSI command not in built-in list below.
+ * - READ_CAPACITY10, READ_FORMAT_CAPACITY, INQUIRY, TEST_UNIT_READY, START_STOP_UNIT, MODE_SENSE6, REQUEST_SENSE
+ * - READ10 and WRITE10 has their own callbacks
+ *
+ * \param[in]   lun         Logical unit number
+ * \param[in]   scsi_cmd    SCSI command contents which application must examine to response accordingly
+ * \param[out]  buffer      Buffer for SCSI Data Stage.
+ *                            - For INPUT: application must fill this with response.
+ *                            - For OUTPUT it holds the Data from host
+ * \param[in]   bufsize     Buffer's length.
+ *
+ * \return      Actual bytes processed, can be zero for no-data command.
+ * \retval      negative    Indicate error e.g unsupported command, tinyusb will \b STALL the corresponding
+ *                          endpoint and return failed status in command status wrapper phase.
+ */
+static void _put_be16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void _put_be32(uint8_t *p, uint32_t v)
+{
+    _put_be16(p, (uint16_t)(v >> 16));
+    _put_be16(p + 2, (uint16_t)v);
+}
+
+static uint32_t _get_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint32_t _unmap_max_sectors(void)
+{
+    return MAX(1, MSC_UNMAP_MAX_BYTES / s_storage_handle->sector_size);
+}
+
+/**
+ * @brief READ CAPACITY (16), reports that the logical unit supports UNMAP (LBPME)
+ */
+static int32_t _scsi_read_capacity16(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t *buf, uint16_t bufsize)
+{
+    if ((scsi_cmd[1] & 0x1F) != SCSI_SA_READ_CAPACITY_16) {
+        tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_CODE_ASC_INVALID_FIELD_IN_CDB, SCSI_CODE_ASCQ);
+        return -1;
+    }
+    uint8_t resp[32] = {0};
+    _put_be32(resp + 4, s_storage_handle->sector_count - 1); // upper 32 bits of the last LBA stay zero
+    _put_be32(resp + 8, s_storage_handle->sector_size);
+    resp[13] = (uint8_t)__builtin_ctz(s_storage_handle->unmap_granularity); // logical blocks per erase block exponent
+    resp[14] = 0x80; // LBPME
+    uint32_t len = MIN(sizeof(resp), MIN(bufsize, _get_be32(scsi_cmd + 10)));
+    memcpy(buf, resp, len);
+    return len;
+}
+
+/**
+ * @brief INQUIRY vital product data: supported pages, block limits and logical block provisioning
+ */
+static int32_t _scsi_inquiry_vpd(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t *buf, uint16_t bufsize)
+{
+    uint8_t resp[64] = {0};
+    uint16_t page_len;
+    resp[1] = scsi_cmd[2];
+    switch (scsi_cmd[2]) {
+    case SCSI_VPD_SUPPORTED_PAGES:
+        resp[4] = SCSI_VPD_SUPPORTED_PAGES;
+        resp[5] = SCSI_VPD_BLOCK_LIMITS;
+        resp[6] = SCSI_VPD_LOGICAL_BLOCK_PROVISIONING;
+        page_len = 3;
+        break;
+    case SCSI_VPD_BLOCK_LIMITS:
+        _put_be32(resp + 20, _unmap_max_sectors());            // MAXIMUM UNMAP LBA COUNT
+        _put_be32(resp + 24, MSC_UNMAP_MAX_DESCRIPTORS);       // MAXIMUM UNMAP BLOCK DESCRIPTOR COUNT
+        _put_be32(resp + 28, s_storage_handle->unmap_granularity); // OPTIMAL UNMAP GRANULARITY
+        resp[32] = 0x80;                                       // UGAVALID, aligned to LBA 0
+        page_len = 0x3C;
+        break;
+    case SCSI_VPD_LOGICAL_BLOCK_PROVISIONING:
+        resp[5] = 0x80; // LBPU: UNMAP supported, unmapped blocks read back unspecified data
+        resp[6] = 0x02; // thin provisioned
+        page_len = 4;
+        break;
+    default:
+        tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_CODE_ASC_INVALID_FIELD_IN_CDB, SCSI_CODE_ASCQ);
+        return -1;
+    }
+    _put_be16(resp + 2, page_len);
+    uint32_t len = MIN((uint32_t)page_len + 4, MIN(bufsize, ((uint32_t)scsi_cmd[3] << 8) | scsi_cmd[4]));
+    memcpy(buf, resp, len);
+    return len;
+}
+
+/**
+ * @brief UNMAP, invoked with the received parameter list
+ *
+ * Runs in the TinyUSB task like the deferred writes, so it is ordered with them.
+ */
+static int32_t _scsi_unmap(uint8_t lun, const uint8_t *buf, uint16_t bufsize)
+{
+    if (bufsize == 0) {
+        return 0; // no parameter list, nothing to unmap
+    }
+    uint32_t desc_len = bufsize < 8 ? 0 : ((uint32_t)buf[2] << 8) | buf[3];
+    if (bufsize < 8 || desc_len > bufsize - 8u || desc_len % 16) {
+        tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_CODE_ASC_PARAMETER_LIST_LENGTH_ERROR, SCSI_CODE_ASCQ);
+        return -1;
+    }
+    // Validate the whole list first, nothing is unmapped if any descriptor is invalid
+    uint32_t total = 0;
+    for (const uint8_t *d = buf + 8; d < buf + 8 + desc_len; d += 16) {
+        uint32_t lba = _get_be32(d + 4);
+        uint32_t count = _get_be32(d + 8);
+        if (_get_be32(d) != 0 || lba > s_storage_handle->sector_count ||
+                count > s_storage_handle->sector_count - lba) {
+            tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_CODE_ASC_LBA_OUT_OF_RANGE, SCSI_CODE_ASCQ);
+            return -1;
+        }
+        total += count;
+        if (total > _unmap_max_sectors()) {
+            tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_CODE_ASC_INVALID_FIELD_IN_PARAMETER_LIST, SCSI_CODE_ASCQ);
+            return -1;
+        }
+    }
+
+    xSemaphoreTake(s_storage_handle->owner_lock, portMAX_DELAY);
+    esp_err_t err = ESP_OK;
+    if (s_storage_handle->is_fat_mounted) {
+        tud_msc_set_sense(lun, SCSI_SENSE_DATA_PROTECT, SCSI_CODE_ASC_WRITE_PROTECTED, SCSI_CODE_ASCQ);
+        err = ESP_ERR_INVALID_STATE;
+    }
+    for (const uint8_t *d = buf + 8; err == ESP_OK && d < buf + 8 + desc_len; d += 16) {
+        err = _msc_storage_unmap(_get_be32(d + 4), _get_be32(d + 8));
+        if (err != ESP_OK) {
+            tud_msc_set_sense(lun, SCSI_SENSE_MEDIUM_ERROR, SCSI_CODE_ASC_WRITE_ERROR, SCSI_CODE_ASCQ);
+        }
+    }
+    xSemaphoreGive(s_storage_handle->owner_lock);
+    return err == ESP_OK ? 0 : -1;
+}
+
+int32_t tud_msc_scsi_cb(uint8_t lun, uint8_t const scsi_cmd[16], void *buffer, uint16_t bufsize)
+{
+    int32_t ret;
+
+    _write_flush();
+
+    switch (scsi_cmd[0]) {
+    case SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL:
+        /* SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL is the Prevent/Allow Medium Removal
+        command (1Eh) that requests the library to enable or disable user access to
+        the storage media/partition. */
+        ret = 0;
+        break;
+    case SCSI_CMD_INQUIRY:
+        // Only the vital product data pages (EVPD = 1) reach this callback
+        ret = _scsi_inquiry_vpd(lun, scsi_cmd, buffer, bufsize);
+        break;
+    case SCSI_CMD_SERVICE_ACTION_IN_16:
+        ret = _scsi_read_capacity16(lun, scsi_cmd, buffer, bufsize);
+        break;
+    case SCSI_CMD_UNMAP:
+        ret = _scsi_unmap(lun, buffer, bufsize);
+        break;
+    default:
+        // Hosts keep probing optional commands, count them rather than logging each one
+        _stats_scsi_unsupported(scsi_cmd[0]);
+        ESP_LOGD(TAG, "tud_msc_scsi_cb() invoked: %d", scsi_cmd[0]);
+        tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, SCSI_CODE_ASC_INVALID_COMMAND_OPERATION_CODE, SCSI_CODE_ASCQ);
+        ret = -1;
+        break;
+    }
+    return ret;
+}
+
+// Invoked when device is unmounted
+void tud_umount_cb(void)
+{
+    _handover_async(true);
+}
+
+// Invoked when device is mounted (configured)
+void tud_mount_cb(void)
+{
+    _handover_async(false);
+}
+/*********************************************************************** TinyUSB MSC callbacks*/
@@ -0,0 +1,149 @@
+/*
+ * SPDX-FileCopyrightText: 2020-2022 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "tinyusb.h"
+#include "tusb_tasks.h"
+
+const static char *TAG = "tusb_tsk";
+static TaskHandle_t s_tusb_tskh;
+
+#if CONFIG_TINYUSB_INIT_IN_DEFAULT_TASK
+const static int INIT_OK = BIT0;
+const static int INIT_FAILED = BIT1;
+#endif
+
+#if CONFIG_TINYUSB_EVENT_STATS
+#define TASK_STATS_WINDOW_US    1000000
+
+static portMUX_TYPE s_task_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static tusb_task_stats_t s_task_stats;
+static uint32_t s_window_wakeups;       // wakeups in the current window
+static uint32_t s_window_idle_wakeups;
+static int64_t s_window_start_us;
+
+/**
+ * @brief Account one return from tud_task(), it was idle if it handled nothing but SOF
+ */
+static void task_stats_wakeup(const tud_event_stats_t *before, const tud_event_stats_t *after)
+{
+    uint32_t handled = 0;
+    for (int i = 0; i < DCD_EVENT_COUNT; i++) {
+        handled += after->handled[i] - before->handled[i];
+    }
+    bool idle = (handled == after->handled[DCD_EVENT_SOF] - before->handled[DCD_EVENT_SOF]);
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_task_stats_lock);
+    s_task_stats.wakeups++;
+    s_window_wakeups++;
+    if (idle) {
+        s_task_stats.idle_wakeups++;
+        s_window_idle_wakeups++;
+    }
+    if (now - s_window_start_us >= TASK_STATS_WINDOW_US) {
+        s_task_stats.wakeups_per_sec = s_window_wakeups;
+        s_task_stats.idle_wakeups_per_sec = s_window_idle_wakeups;
+        s_window_wakeups = 0;
+        s_window_idle_wakeups = 0;
+        s_window_start_us = now;
+    }
+    portEXIT_CRITICAL(&s_task_stats_lock);
+}
+#endif // CONFIG_TINYUSB_EVENT_STATS
+
+/**
+ * @brief This top level thread processes all usb events and invokes callbacks
+ */
+static void tusb_device_task(void *arg)
+{
+    ESP_LOGD(TAG, "tinyusb task started");
+#if CONFIG_TINYUSB_INIT_IN_DEFAULT_TASK
+    EventGroupHandle_t *init_flags = arg;
+    if (!tusb_init()) {
+        ESP_LOGI(TAG, "Init TinyUSB stack failed");
+        xEventGroupSetBits(*init_flags, INIT_FAILED);
+        vTaskDelete(NULL);
+    }
+    ESP_LOGD(TAG, "tinyusb task has been initialized");
+    xEventGroupSetBits(*init_flags, INIT_OK);
+#endif // CONFIG_TINYUSB_INIT_IN_DEFAULT_TASK
+#if CONFIG_TINYUSB_EVENT_STATS
+    tud_event_stats_t stats[2];
+    int cur = 0;
+    tud_event_stats_get(&stats[cur]);
+    s_window_start_us = esp_timer_get_time();
+#endif // CONFIG_TINYUSB_EVENT_STATS
+    while (1) { // RTOS forever loop
+        // No deadline: the task sleeps until the USB ISR or a deferred function queues an event
+        tud_task_ext(UINT32_MAX, false);
+#if CONFIG_TINYUSB_EVENT_STATS
+        tud_event_stats_get(&stats[!cur]);
+        task_stats_wakeup(&stats[cur], &stats[!cur]);
+        cur = !cur;
+#endif // CONFIG_TINYUSB_EVENT_STATS
+    }
+}
+
+esp_err_t tusb_run_task(void)
+{
+    // This function is not guaranteed to be thread safe, if invoked multiple times without calling `tusb_stop_task`, will cause memory leak
+    // doing a sanity check anyway
+    ESP_RETURN_ON_FALSE(!s_tusb_tskh, ESP_ERR_INVALID_STATE, TAG, "TinyUSB main task already started");
+
+    void *task_arg = NULL;
+#if CONFIG_TINYUSB_INIT_IN_DEFAULT_TASK
+    // need to synchronize to potentially report issue if init failed
+    EventGroupHandle_t init_flags = xEventGroupCreate();
+    ESP_RETURN_ON_FALSE(init_flags, ESP_ERR_NO_MEM, TAG, "Failed to allocate task sync flags");
+    task_arg = &init_flags;
+#endif
+    // Create a task for tinyusb device stack:
+    xTaskCreatePinnedToCore(tusb_device_task, "TinyUSB", CONFIG_TINYUSB_TASK_STACK_SIZE, task_arg, CONFIG_TINYUSB_TASK_PRIORITY, &s_tusb_tskh, CONFIG_TINYUSB_TASK_AFFINITY);
+    ESP_RETURN_ON_FALSE(s_tusb_tskh, ESP_FAIL, TAG, "create TinyUSB main task failed");
+#if CONFIG_TINYUSB_INIT_IN_DEFAULT_TASK
+    // wait until tusb initialization has completed
+    EventBits_t bits = xEventGroupWaitBits(init_flags, INIT_OK | INIT_FAILED, pdFALSE, pdFALSE, portMAX_DELAY);
+    vEventGroupDelete(init_flags);
+    ESP_RETURN_ON_FALSE(bits & INIT_OK, ESP_FAIL, TAG, "Init TinyUSB stack failed");
+#endif
+
+    return ESP_OK;
+}
+
+esp_err_t tusb_stop_task(void)
+{
+    ESP_RETURN_ON_FALSE(s_tusb_tskh, ESP_ERR_INVALID_STATE, TAG, "TinyUSB main task not started yet");
+    vTaskDelete(s_tusb_tskh);
+    s_tusb_tskh = NULL;
+    return ESP_OK;
+}
+
+esp_err_t tusb_task_get_stats(tusb_task_stats_t *stats)
+{
+    ESP_RETURN_ON_FALSE(stats, ESP_ERR_INVALID_ARG, TAG, "Stats can't be NULL");
+#if CONFIG_TINYUSB_EVENT_STATS
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_task_stats_lock);
+    *stats = s_task_stats;
+    // The rates are latched on wakeups, a task that has been sleeping longer reports its current window instead
+    int64_t elapsed = now - s_window_start_us;
+    if (elapsed >= 2 * TASK_STATS_WINDOW_US) {
+        stats->wakeups_per_sec = (uint32_t)(s_window_wakeups * (int64_t)TASK_STATS_WINDOW_US / elapsed);
+        stats->idle_wakeups_per_sec = (uint32_t)(s_window_idle_wakeups * (int64_t)TASK_STATS_WINDOW_US / elapsed);
+    }
+    portEXIT_CRITICAL(&s_task_stats_lock);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif // CONFIG_TINYUSB_EVENT_STATS
+}
@@ -0,0 +1,345 @@
+#include "led_effect.h"
+
+#undef TAG
+#define TAG "LED_EFFECT"
+
+#define HUE_MAX 1536 // 色相一圈 6段 * 256
+
+// 只在颜色真正变化时写入, 返回是否变化
+static inline bool led_set_pixel(led_engine_t *engine, size_t i, rgb_color c) {
+    rgb_color *p = &engine->pixels[i];
+    if (p->red == c.red && p->green == c.green && p->blue == c.blue) {
+        return false;
+    }
+    *p = c;
+    return true;
+}
+
+// 线性插值 pos范围0-256
+static inline rgb_color led_lerp(rgb_color a, rgb_color b, uint16_t pos) {
+    return (rgb_color) {
+        .red   = a.red   + (((int)b.red   - a.red)   * pos >> 8),
+        .green = a.green + (((int)b.green - a.green) * pos >> 8),
+        .blue  = a.blue  + (((int)b.blue  - a.blue)  * pos >> 8),
+    };
+}
+
+// 按比例缩放颜色 scale范围0-256
+static inline rgb_color led_scale(rgb_color c, uint16_t scale) {
+    return (rgb_color) {
+        .red   = c.red   * scale >> 8,
+        .green = c.green * scale >> 8,
+        .blue  = c.blue  * scale >> 8,
+    };
+}
+
+// 色相转RGB (饱和度和亮度为最大值)
+static rgb_color led_hue_to_rgb(uint16_t hue) {
+    hue %= HUE_MAX;
+    uint8_t f = hue & 0xff;
+    switch (hue >> 8) {
+    case 0:  return (rgb_color) {.red = 255,     .green = f,       .blue = 0};
+    case 1:  return (rgb_color) {.red = 255 - f, .green = 255,     .blue = 0};
+    case 2:  return (rgb_color) {.red = 0,       .green = 255,     .blue = f};
+    case 3:  return (rgb_color) {.red = 0,       .green = 255 - f, .blue = 255};
+    case 4:  return (rgb_color) {.red = f,       .green = 0,       .blue = 255};
+    default: return (rgb_color) {.red = 255,     .green = 0,       .blue = 255 - f};
+    }
+}
+
+// 渐变: 整条灯带同一颜色, 只在插值位置变化时重算
+static size_t led_render_fade(led_engine_t *engine, uint32_t t) {
+    uint32_t period = engine->fade.period_ms ? engine->fade.period_ms : 1;
+    uint32_t half = period / 2 ? period / 2 : 1;
+    uint32_t phase = t % period;
+    uint16_t pos = phase < half ? phase * 256 / half : (period - phase) * 256 / half;
+    if (pos > 256) {
+        pos = 256;
+    }
+    if (pos == engine->fade.last_pos && !engine->force) {
+        return 0;
+    }
+    engine->fade.last_pos = pos;
+
+    rgb_color c = led_lerp(engine->fade.from, engine->fade.to, pos);
+    size_t changed = 0;
+    for (size_t i = 0; i < engine->led_num; i++) {
+        changed += led_set_pixel(engine, i, c);
+    }
+    return changed;
+}
+
+// 彩虹: 色相未前进时整帧跳过
+static size_t led_render_rainbow(led_engine_t *engine, uint32_t t) {
+    uint16_t hue = (uint64_t)t * engine->rainbow.speed / 1000 % HUE_MAX;
+    if (hue == engine->rainbow.last_hue && !engine->force) {
+        return 0;
+    }
+    engine->rainbow.last_hue = hue;
+
+    size_t changed = 0;
+    for (size_t i = 0; i < engine->led_num; i++) {
+        // 在32位中取模, 先截断到16位会在65536处跳色
+        changed += led_set_pixel(engine, i, led_hue_to_rgb((hue + (uint32_t)i * engine->rainbow.spread) % HUE_MAX));
+    }
+    return changed;
+}
+
+// 跑马灯中第i个像素在头部位于head时的颜色
+static rgb_color led_chase_color(led_engine_t *engine, size_t i, size_t head) {
+    size_t dist = (head + engine->led_num - i) % engine->led_num; // 落后头部的距离
+    if (dist > engine->chase.tail) {
+        return (rgb_color) {0};
+    }
+    return led_scale(engine->chase.color, (engine->chase.tail + 1 - dist) * 256 / (engine->chase.tail + 1));
+}
+
+// 跑马灯: 只重算旧拖尾和新拖尾覆盖的像素
+static size_t led_render_chase(led_engine_t *engine, uint32_t t) {
+    uint32_t step = engine->chase.step_ms ? engine->chase.step_ms : 1;
+    size_t head = (t / step) % engine->led_num;
+    size_t changed = 0;
+
+    if (engine->force) {
+        for (size_t i = 0; i < engine->led_num; i++) {
+            changed += led_set_pixel(engine, i, led_chase_color(engine, i, head));
+        }
+    } else if (head != engine->chase.last_head) {
+        size_t old_head = engine->chase.last_head;
+        for (size_t d = 0; d <= engine->chase.tail && d < engine->led_num; d++) {
+            size_t i = (old_head + engine->led_num - d) % engine->led_num;
+            changed += led_set_pixel(engine, i, led_chase_color(engine, i, head));
+            i = (head + engine->led_num - d) % engine->led_num;
+            changed += led_set_pixel(engine, i, led_chase_color(engine, i, head));
+        }
+    }
+    engine->chase.last_head = head;
+    return changed;
+}
+
+// 关键帧: 处于保持段的像素在段结束前不再计算
+static size_t led_render_keyframe(led_engine_t *engine, uint32_t now_ms, uint32_t t) {
+    size_t changed = 0;
+    for (size_t i = 0; i < engine->led_num; i++) {
+        if (!engine->force && (int32_t)(now_ms - engine->keyframe.hold_until[i]) < 0) {
+            continue;
+        }
+        const led_keyframe_track_t *track = &engine->keyframe.tracks[i];
+        if (!track->frames || !track->count) {
+            engine->keyframe.hold_until[i] = now_ms + UINT32_MAX / 2;
+            continue;
+        }
+        uint32_t total = track->frames[track->count - 1].time_ms;
+        if (track->count == 1 || !total) {
+            changed += led_set_pixel(engine, i, track->frames[0].color);
+            engine->keyframe.hold_until[i] = now_ms + UINT32_MAX / 2;
+            continue;
+        }
+
+        uint32_t tt = t % total;
+        if (tt < track->frames[0].time_ms) {
+            // 第一帧之前保持第一帧的颜色
+            changed += led_set_pixel(engine, i, track->frames[0].color);
+            engine->keyframe.hold_until[i] = now_ms + (track->frames[0].time_ms - tt);
+            continue;
+        }
+        uint8_t k = 0;
+        while (k + 2 < track->count && track->frames[k + 1].time_ms <= tt) {
+            k++;
+        }
+        const led_keyframe_t *a = &track->frames[k];
+        const led_keyframe_t *b = &track->frames[k + 1];
+        bool same = a->color.red == b->color.red && a->color.green == b->color.green && a->color.blue == b->color.blue;
+        if (!track->interpolate || same) {
+            changed += led_set_pixel(engine, i, a->color);
+            engine->keyframe.hold_until[i] = now_ms + (b->time_ms - tt);
+        } else {
+            uint32_t span = b->time_ms - a->time_ms;
+            uint16_t pos = span ? (tt - a->time_ms) * 256 / span : 256;
+            changed += led_set_pixel(engine, i, led_lerp(a->color, b->color, pos));
+            engine->keyframe.hold_until[i] = now_ms;
+        }
+    }
+    return changed;
+}
+
+esp_err_t led_engine_init(led_engine_t *engine, ws2812_strip_t *strip, size_t led_num, uint32_t frame_period_ms) {
+    if (!engine || !strip || !led_num || !frame_period_ms) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(engine, 0, sizeof(led_engine_t));
+    engine->pixels = calloc(led_num, sizeof(rgb_color));
+    engine->lock = xSemaphoreCreateMutex();
+    if (!engine->pixels || !engine->lock) {
+        free(engine->pixels);
+        if (engine->lock) {
+            vSemaphoreDelete(engine->lock);
+        }
+        return ESP_ERR_NO_MEM;
+    }
+    engine->strip = strip;
+    engine->led_num = led_num;
+    engine->frame_period_ms = frame_period_ms;
+    engine->type = LED_EFFECT_NONE;
+    return ESP_OK;
+}
+
+// 切换灯效 调用者需持有锁
+static void led_engine_switch(led_engine_t *engine, led_effect_type_t type) {
+    if (engine->type == LED_EFFECT_KEYFRAME && type != LED_EFFECT_KEYFRAME) {
+        free(engine->keyframe.hold_until);
+    }
+    engine->type = type;
+    engine->start_ms = esp_timer_get_time() / 1000;
+    engine->force = true;
+}
+
+void led_engine_set_fade(led_engine_t *engine, rgb_color from, rgb_color to, uint32_t period_ms) {
+    xSemaphoreTake(engine->lock, portMAX_DELAY);
+    led_engine_switch(engine, LED_EFFECT_FADE);
+    engine->fade.from = from;
+    engine->fade.to = to;
+    engine->fade.period_ms = period_ms;
+    xSemaphoreGive(engine->lock);
+}
+
+void led_engine_set_rainbow(led_engine_t *engine, uint16_t speed, uint16_t spread) {
+    xSemaphoreTake(engine->lock, portMAX_DELAY);
+    led_engine_switch(engine, LED_EFFECT_RAINBOW);
+    engine->rainbow.speed = speed;
+    engine->rainbow.spread = spread;
+    xSemaphoreGive(engine->lock);
+}
+
+void led_engine_set_chase(led_engine_t *engine, rgb_color color, uint32_t step_ms, uint8_t tail) {
+    xSemaphoreTake(engine->lock, portMAX_DELAY);
+    led_engine_switch(engine, LED_EFFECT_CHASE);
+    engine->chase.color = color;
+    engine->chase.step_ms = step_ms;
+    engine->chase.tail = tail;
+    engine->chase.last_head = 0;
+    xSemaphoreGive(engine->lock);
+}
+
+esp_err_t led_engine_set_keyframes(led_engine_t *engine, const led_keyframe_track_t *tracks) {
+    if (!tracks) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t *hold_until = calloc(engine->led_num, sizeof(uint32_t));
+    if (!hold_until) {
+        return ESP_ERR_NO_MEM;
+    }
+    xSemaphoreTake(engine->lock, portMAX_DELAY);
+    if (engine->type == LED_EFFECT_KEYFRAME) {
+        free(engine->keyframe.hold_until);
+    }
+    led_engine_switch(engine, LED_EFFECT_KEYFRAME);
+    engine->keyframe.tracks = tracks;
+    engine->keyframe.hold_until = hold_until;
+    xSemaphoreGive(engine->lock);
+    return ESP_OK;
+}
+
+void led_engine_set_frame_period(led_engine_t *engine, uint32_t frame_period_ms) {
+    if (!frame_period_ms || !engine->lock) {
+        return;
+    }
+    xSemaphoreTake(engine->lock, portMAX_DELAY);
+    engine->frame_period_ms = frame_period_ms;
+    xSemaphoreGive(engine->lock);
+}
+
+esp_err_t led_engine_set_brightness(led_engine_t *engine, uint8_t brightness, bool gamma) {
+    if (!engine->lock) {
+        return ESP_ERR_INVALID_STATE;   // 尚未初始化
+    }
+    // 持锁修改缩放表, 不会与本引擎的刷新交错
+    xSemaphoreTake(engine->lock, portMAX_DELAY);
+    esp_err_t ret = ws2812_strip_set_brightness(engine->strip, brightness, gamma);
+    engine->refresh = true;
+    xSemaphoreGive(engine->lock);
+    return ret;
+}
+
+// 渲染一帧 调用者需持有锁
+static size_t led_engine_render_locked(led_engine_t *engine, uint32_t now_ms) {
+    uint32_t t = now_ms - engine->start_ms;
+    size_t changed = 0;
+
+    switch (engine->type) {
+    case LED_EFFECT_FADE:
+        changed = led_render_fade(engine, t);
+        break;
+    case LED_EFFECT_RAINBOW:
+        changed = led_render_rainbow(engine, t);
+        break;
+    case LED_EFFECT_CHASE:
+        changed = led_render_chase(engine, t);
+        break;
+    case LED_EFFECT_KEYFRAME:
+        changed = led_render_keyframe(engine, now_ms, t);
+        break;
+    default:
+        break;
+    }
+    engine->force = false;
+    engine->stats.frames++;
+    engine->stats.pixels_changed += changed;
+    return changed;
+}
+
+size_t led_engine_render(led_engine_t *engine, uint32_t now_ms) {
+    xSemaphoreTake(engine->lock, portMAX_DELAY);
+    size_t changed = led_engine_render_locked(engine, now_ms);
+    xSemaphoreGive(engine->lock);
+    return changed;
+}
+
+void led_engine_get_stats(led_engine_t *engine, led_engine_stats_t *stats) {
+    xSemaphoreTake(engine->lock, portMAX_DELAY);
+    *stats = engine->stats;
+    xSemaphoreGive(engine->lock);
+}
+
+void led_engine_task(void *pvParam) {
+    led_engine_t *engine = (led_engine_t *)pvParam;
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+
+    while (1) {
+        int64_t start = esp_timer_get_time();
+
+        xSemaphoreTake(engine->lock, portMAX_DELAY);
+        if (led_engine_render_locked(engine, start / 1000) || engine->refresh) {
+            // 只有像素变化时才刷新灯带
+            engine->refresh = false;
+            esp_err_t ret = ws2812_strip_show(engine->strip, engine->pixels, engine->led_num);
+            if (ret == ESP_OK) {
+                engine->stats.frames_sent++;
+            } else {
+                ESP_LOGE(TAG, "灯带刷新失败: %s", esp_err_to_name(ret));
+            }
+        }
+
+        // 帧预算统计
+        uint32_t frame_us = esp_timer_get_time() - start;
+        engine->stats.last_frame_us = frame_us;
+        if (frame_us > engine->stats.max_frame_us) {
+            engine->stats.max_frame_us = frame_us;
+        }
+        bool overrun = frame_us > engine->frame_period_ms * 1000;
+        if (overrun) {
+            engine->stats.overruns++;
+        }
+        // 帧周期可能在运行中被修改
+        TickType_t xFrequency = pdMS_TO_TICKS(engine->frame_period_ms) ? pdMS_TO_TICKS(engine->frame_period_ms) : 1;
+        xSemaphoreGive(engine->lock);
+
+        if (overrun) {
+            // 超出预算时不追赶丢失的帧, 至少让出一个tick给USB和Wi-Fi任务
+            vTaskDelay(1);
+            xLastWakeTime = xTaskGetTickCount();
+        } else {
+            vTaskDelayUntil(&xLastWakeTime, xFrequency);
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef __LED_EFFECT_H__
+#define __LED_EFFECT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "ws2812.h"
+
+// 灯效类型
+typedef enum {
+    LED_EFFECT_NONE = 0,  // 保持当前颜色
+    LED_EFFECT_FADE,      // 两种颜色之间往返渐变
+    LED_EFFECT_RAINBOW,   // 彩虹流动
+    LED_EFFECT_CHASE,     // 跑马灯(带拖尾)
+    LED_EFFECT_KEYFRAME,  // 逐像素关键帧
+} led_effect_type_t;
+
+// 关键帧
+typedef struct {
+    uint32_t time_ms;     // 相对轨道起点的时间
+    rgb_color color;
+} led_keyframe_t;
+
+// 单个像素的关键帧轨道 时间需递增, 最后一帧的time_ms为轨道总长
+typedef struct {
+    const led_keyframe_t *frames;
+    uint8_t count;
+    bool interpolate;     // true: 关键帧之间线性渐变 false: 保持到下一关键帧
+} led_keyframe_track_t;
+
+// 帧统计
+typedef struct {
+    uint32_t frames;         // 已渲染帧数
+    uint32_t frames_sent;    // 有像素变化并刷新到灯带的帧数
+    uint32_t pixels_changed; // 累计变化的像素数
+    uint32_t overruns;       // 超出帧预算的帧数
+    uint32_t last_frame_us;  // 最近一帧耗时
+    uint32_t max_frame_us;   // 最大帧耗时
+} led_engine_stats_t;
+
+// 灯效引擎
+typedef struct {
+    ws2812_strip_t *strip;
+    rgb_color *pixels;          // 当前帧
+    size_t led_num;
+    uint32_t frame_period_ms;   // 帧周期, 同时也是帧预算
+    SemaphoreHandle_t lock;
+
+    led_effect_type_t type;
+    uint32_t start_ms;          // 当前灯效开始时间
+    bool force;                 // 下一帧强制全部重算
+    bool refresh;               // 下一帧即使像素不变也刷新灯带 (亮度变化后)
+    union {
+        struct {
+            rgb_color from;
+            rgb_color to;
+            uint32_t period_ms;
+            uint16_t last_pos;
+        } fade;
+        struct {
+            uint16_t speed;     // 色相每秒前进量 (一圈为1536)
+            uint16_t spread;    // 相邻像素色相差
+            uint16_t last_hue;
+        } rainbow;
+        struct {
+            rgb_color color;
+            uint32_t step_ms;
+            uint8_t tail;       // 拖尾长度
+            size_t last_head;
+        } chase;
+        struct {
+            const led_keyframe_track_t *tracks; // led_num条轨道
+            uint32_t *hold_until;               // 各像素保持不变的截止时间
+        } keyframe;
+    };
+
+    led_engine_stats_t stats;
+} led_engine_t;
+
+esp_err_t led_engine_init(led_engine_t *engine, ws2812_strip_t *strip, size_t led_num, uint32_t frame_period_ms);
+
+void led_engine_set_fade(led_engine_t *engine, rgb_color from, rgb_color to, uint32_t period_ms);
+void led_engine_set_rainbow(led_engine_t *engine, uint16_t speed, uint16_t spread);
+void led_engine_set_chase(led_engine_t *engine, rgb_color color, uint32_t step_ms, uint8_t tail);
+esp_err_t led_engine_set_keyframes(led_engine_t *engine, const led_keyframe_track_t *tracks);
+
+// 运行中修改帧周期和亮度 下一帧生效
+void led_engine_set_frame_period(led_engine_t *engine, uint32_t frame_period_ms);
+esp_err_t led_engine_set_brightness(led_engine_t *engine, uint8_t brightness, bool gamma);
+
+// 渲染一帧 返回本帧变化的像素数
+size_t led_engine_render(led_engine_t *engine, uint32_t now_ms);
+
+void led_engine_get_stats(led_engine_t *engine, led_engine_stats_t *stats);
+
+// 灯效任务 pvParam为led_engine_t*, 按帧周期渲染, 只有像素变化时才刷新灯带
+void led_engine_task(void *pvParam);
+
+#endif // __LED_EFFECT_H__
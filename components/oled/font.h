@@ -6,6 +6,7 @@ typedef struct ASCIIFont {
     uint8_t h;
     uint8_t w;
     uint8_t *chars;
+    const uint16_t *rle_index; // 非NULL时chars为RLE压缩数据, 第n个字模从chars + rle_index[n]开始
 } ASCIIFont;
 
 extern const ASCIIFont afont8x6;
@@ -13,6 +14,9 @@ extern const ASCIIFont afont12x6;
 extern const ASCIIFont afont16x8;
 extern const ASCIIFont afont24x12;
 
+// RLE压缩字库 由tools/font_rle.py生成(font_rle.c) 压缩后不更小的字库不生成
+extern const ASCIIFont afont24x12_rle;
+
 /**
  * @brief 字体结构体
  * @note  字库前4字节存储utf8编码 剩余字节存储字模数据
@@ -24,12 +28,15 @@ typedef struct Font {
     const uint8_t *chars;   // 字库 字库前4字节存储utf8编码 剩余字节存储字模数据
     uint8_t len;            // 字库长度 超过256则请改为uint16_t
     const ASCIIFont *ascii; // 缺省ASCII字体 当字库中没有对应字符且需要显示ASCII字符时使用
+    const uint16_t *rle_index; // 非NULL时第n个字从chars + rle_index[n]开始 前4字节为utf8编码 其后为RLE压缩字模
 } Font;
 
 extern const Font font16x16;
 
 extern const Font font24x12;
 
+extern const Font font24x12_rle;
+
 
 /**
  * @brief 图片结构体
@@ -39,8 +46,11 @@ typedef struct Image {
     uint8_t w;           // 图片宽度
     uint8_t h;           // 图片高度
     const uint8_t *data; // 图片数据
+    uint8_t rle;         // 非0时data为RLE压缩数据
 } Image;
 
 extern const Image bilibiliImg;
 
+extern const Image bilibiliImg_rle;
+
 #endif // __FONT_H
\ No newline at end of file
@@ -0,0 +1,199 @@
+/**
+ * @file font_rle.c
+ * @brief RLE压缩字库
+ *
+ * @attention
+ * 本文件由 tools/font_rle.py 根据 font.c 自动生成, 请勿手动修改
+ * 压缩结果(含偏移表):
+ *   afont8x6          552 ->    805 bytes (145.8%)  skipped
+ *   afont12x6        1140 ->   1311 bytes (115.0%)  skipped
+ *   afont16x8        1520 ->   1577 bytes (103.8%)  skipped
+ *   afont24x12       3420 ->   2587 bytes ( 75.6%)
+ *   font16x16         144 ->    158 bytes (109.7%)  skipped
+ *   bilibiliImg       306 ->    140 bytes ( 45.8%)
+ *   total            3726 ->   2727 bytes ( 73.2%)
+ */
+// clang-format off
+#include "font.h"
+
+static const uint8_t afont24x12_rle_data[] = {
+    0xa3, 0x00, 0x84, 0x00, 0x82, 0xf0, 0x88, 0x00, 0x02, 0x01, 0x7f, 0x01, 0x88, 0x00, 0x82, 0x1c,
+    0x83, 0x00, 0x81, 0x00, 0x08, 0x80, 0x60, 0x30, 0x1c, 0x8c, 0x60, 0x30, 0x1c, 0x0c, 0x98, 0x00,
+    0x82, 0x00, 0x00, 0xe0, 0x84, 0x00, 0x00, 0xe0, 0x82, 0x00, 0x02, 0x86, 0xe6, 0x9f, 0x83, 0x86,
+    0x06, 0xe6, 0x9f, 0x86, 0x00, 0x00, 0x01, 0x1f, 0x84, 0x01, 0x03, 0x1f, 0x01, 0x01, 0x00, 0x81,
+    0x00, 0x07, 0x80, 0xc0, 0x60, 0x20, 0xf8, 0x20, 0xe0, 0xc0, 0x83, 0x00, 0x07, 0x03, 0x07, 0x0c,
+    0x18, 0xff, 0x70, 0xe1, 0x81, 0x83, 0x00, 0x09, 0x07, 0x0f, 0x10, 0x10, 0x7f, 0x10, 0x0f, 0x07,
+    0x00, 0x00, 0x04, 0x80, 0x60, 0x20, 0x60, 0x80, 0x82, 0x00, 0x0e, 0xe0, 0x20, 0x00, 0x00, 0x0f,
+    0x30, 0x20, 0x30, 0x9f, 0x70, 0xdc, 0x37, 0x10, 0x30, 0xc0, 0x82, 0x00, 0x09, 0x10, 0x0e, 0x03,
+    0x00, 0x07, 0x18, 0x10, 0x18, 0x07, 0x00, 0x81, 0x00, 0x04, 0xc0, 0x20, 0x20, 0xe0, 0xc0, 0x84,
+    0x00, 0x17, 0x80, 0xe0, 0x1f, 0x38, 0xe8, 0x87, 0x03, 0xc4, 0x3c, 0x04, 0x00, 0x00, 0x07, 0x0f,
+    0x18, 0x10, 0x10, 0x0b, 0x07, 0x0d, 0x10, 0x10, 0x08, 0x00, 0x04, 0x00, 0x80, 0x8c, 0x4c, 0x38,
+    0x9e, 0x00, 0x85, 0x00, 0x04, 0x80, 0xe0, 0x30, 0x08, 0x04, 0x85, 0x00, 0x02, 0xfe, 0xff, 0x01,
+    0x89, 0x00, 0x05, 0x03, 0x0f, 0x18, 0x20, 0x40, 0x00, 0x05, 0x00, 0x04, 0x08, 0x30, 0xe0, 0x80,
+    0x89, 0x00, 0x02, 0x01, 0xff, 0xfe, 0x85, 0x00, 0x04, 0x40, 0x20, 0x18, 0x0f, 0x03, 0x85, 0x00,
+    0x85, 0x00, 0x00, 0xc0, 0x85, 0x00, 0x0a, 0x42, 0x66, 0x66, 0x3c, 0x18, 0xff, 0x18, 0x3c, 0x66,
+    0x66, 0x42, 0x85, 0x00, 0x00, 0x03, 0x84, 0x00, 0x85, 0x00, 0x00, 0x80, 0x85, 0x00, 0x84, 0x10,
+    0x00, 0xff, 0x84, 0x10, 0x85, 0x00, 0x00, 0x03, 0x84, 0x00, 0x98, 0x00, 0x03, 0x80, 0x8c, 0x4c,
+    0x38, 0x86, 0x00, 0x8c, 0x00, 0x89, 0x10, 0x8c, 0x00, 0x99, 0x00, 0x82, 0x1c, 0x86, 0x00, 0x87,
+    0x00, 0x02, 0xe0, 0x38, 0x0c, 0x84, 0x00, 0x03, 0x80, 0x70, 0x1c, 0x03, 0x84, 0x00, 0x03, 0x60,
+    0x38, 0x0e, 0x01, 0x86, 0x00, 0x81, 0x00, 0x07, 0x80, 0xc0, 0x60, 0x20, 0x20, 0x60, 0xc0, 0x80,
+    0x82, 0x00, 0x02, 0xfe, 0xff, 0x01, 0x83, 0x00, 0x0f, 0x01, 0xff, 0xfe, 0x00, 0x00, 0x01, 0x07,
+    0x0e, 0x18, 0x10, 0x10, 0x18, 0x0e, 0x07, 0x01, 0x00, 0x81, 0x00, 0x82, 0x80, 0x01, 0xc0, 0xe0,
+    0x89, 0x00, 0x81, 0xff, 0x86, 0x00, 0x82, 0x10, 0x81, 0x1f, 0x82, 0x10, 0x81, 0x00, 0x02, 0x00,
+    0x80, 0x40, 0x83, 0x20, 0x02, 0x60, 0xc0, 0x80, 0x82, 0x00, 0x81, 0x03, 0x06, 0x00, 0x80, 0x40,
+    0x20, 0x38, 0x1f, 0x07, 0x82, 0x00, 0x02, 0x1c, 0x1a, 0x19, 0x84, 0x18, 0x02, 0x1f, 0x00, 0x00,
+    0x02, 0x00, 0x80, 0xc0, 0x82, 0x20, 0x02, 0x60, 0xc0, 0x80, 0x83, 0x00, 0x81, 0x03, 0x06, 0x00,
+    0x10, 0x10, 0x18, 0x2f, 0xe7, 0x80, 0x82, 0x00, 0x01, 0x07, 0x0f, 0x83, 0x10, 0x04, 0x18, 0x0f,
+    0x07, 0x00, 0x00, 0x85, 0x00, 0x02, 0xc0, 0xe0, 0xf0, 0x83, 0x00, 0x09, 0xc0, 0xb0, 0x88, 0x86,
+    0x81, 0x80, 0xff, 0xff, 0x80, 0x80, 0x85, 0x00, 0x81, 0x10, 0x81, 0x1f, 0x81, 0x10, 0x00, 0x00,
+    0x81, 0x00, 0x00, 0xe0, 0x86, 0x60, 0x83, 0x00, 0x01, 0x3f, 0x10, 0x82, 0x08, 0x02, 0x18, 0xf0,
+    0xe0, 0x82, 0x00, 0x01, 0x07, 0x0b, 0x83, 0x10, 0x04, 0x1c, 0x0f, 0x03, 0x00, 0x00, 0x81, 0x00,
+    0x02, 0x80, 0xc0, 0x40, 0x82, 0x20, 0x01, 0xe0, 0xc0, 0x82, 0x00, 0x03, 0xfc, 0xff, 0x21, 0x10,
+    0x82, 0x08, 0x08, 0x18, 0xf0, 0xe0, 0x00, 0x00, 0x01, 0x07, 0x0c, 0x18, 0x82, 0x10, 0x03, 0x08,
+    0x0f, 0x03, 0x00, 0x81, 0x00, 0x01, 0xc0, 0xe0, 0x84, 0x60, 0x01, 0xe0, 0x60, 0x82, 0x00, 0x00,
+    0x03, 0x82, 0x00, 0x02, 0xe0, 0x18, 0x07, 0x87, 0x00, 0x81, 0x1f, 0x84, 0x00, 0x03, 0x00, 0x80,
+    0xc0, 0x60, 0x83, 0x20, 0x13, 0x60, 0xc0, 0x80, 0x00, 0x00, 0x87, 0xef, 0x2c, 0x18, 0x18, 0x30,
+    0x30, 0x68, 0xcf, 0x83, 0x00, 0x00, 0x07, 0x0f, 0x08, 0x83, 0x10, 0x03, 0x18, 0x0f, 0x07, 0x00,
+    0x81, 0x00, 0x81, 0xc0, 0x83, 0x20, 0x01, 0xc0, 0x80, 0x82, 0x00, 0x02, 0x1f, 0x3f, 0x60, 0x82,
+    0x40, 0x03, 0x20, 0x10, 0xff, 0xfe, 0x82, 0x00, 0x01, 0x0c, 0x1c, 0x82, 0x10, 0x04, 0x08, 0x0f,
+    0x03, 0x00, 0x00, 0x90, 0x00, 0x82, 0x0e, 0x88, 0x00, 0x82, 0x1c, 0x83, 0x00, 0x90, 0x00, 0x81,
+    0x0c, 0x89, 0x00, 0x01, 0x58, 0x38, 0x84, 0x00, 0x86, 0x00, 0x03, 0x80, 0x40, 0x20, 0x10, 0x82,
+    0x00, 0x04, 0x10, 0x28, 0x44, 0x82, 0x01, 0x8a, 0x00, 0x05, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00,
+    0x8c, 0x00, 0x89, 0x84, 0x8c, 0x00, 0x81, 0x00, 0x03, 0x10, 0x20, 0x40, 0x80, 0x8b, 0x00, 0x04,
+    0x01, 0x82, 0x44, 0x28, 0x10, 0x82, 0x00, 0x04, 0x10, 0x08, 0x04, 0x02, 0x01, 0x84, 0x00, 0x03,
+    0x00, 0xc0, 0x20, 0x20, 0x83, 0x10, 0x0e, 0x30, 0xe0, 0xc0, 0x00, 0x00, 0x03, 0x03, 0x00, 0x00,
+    0xf0, 0x10, 0x08, 0x0c, 0x07, 0x03, 0x84, 0x00, 0x82, 0x1c, 0x84, 0x00, 0x82, 0x00, 0x02, 0xc0,
+    0x40, 0x60, 0x82, 0x20, 0x1a, 0x40, 0xc0, 0x00, 0x00, 0xfc, 0xff, 0x01, 0xf0, 0x0e, 0x03, 0xc1,
+    0xfe, 0x03, 0x80, 0x7f, 0x00, 0x01, 0x07, 0x0e, 0x08, 0x11, 0x11, 0x10, 0x11, 0x09, 0x04, 0x02,
+    0x83, 0x00, 0x02, 0x80, 0xe0, 0xe0, 0x86, 0x00, 0x0d, 0x80, 0x7c, 0x43, 0x40, 0x47, 0x7f, 0xf8,
+    0x80, 0x00, 0x00, 0x10, 0x18, 0x1f, 0x10, 0x83, 0x00, 0x03, 0x13, 0x1f, 0x1c, 0x10, 0x02, 0x20,
+    0xe0, 0xe0, 0x83, 0x20, 0x02, 0x60, 0xc0, 0x80, 0x82, 0x00, 0x81, 0xff, 0x83, 0x10, 0x07, 0x18,
+    0x2f, 0xe7, 0x80, 0x00, 0x10, 0x1f, 0x1f, 0x84, 0x10, 0x03, 0x18, 0x0f, 0x07, 0x00, 0x81, 0x00,
+    0x02, 0x80, 0xc0, 0x40, 0x83, 0x20, 0x06, 0x60, 0xe0, 0x00, 0x00, 0xfc, 0xff, 0x01, 0x85, 0x00,
+    0x06, 0x01, 0x00, 0x00, 0x01, 0x07, 0x0e, 0x18, 0x82, 0x10, 0x03, 0x08, 0x04, 0x03, 0x00, 0x02,
+    0x20, 0xe0, 0xe0, 0x83, 0x20, 0x02, 0x40, 0xc0, 0x80, 0x82, 0x00, 0x81, 0xff, 0x84, 0x00, 0x06,
+    0x01, 0xff, 0xfe, 0x00, 0x10, 0x1f, 0x1f, 0x82, 0x10, 0x05, 0x18, 0x08, 0x0e, 0x07, 0x01, 0x00,
+    0x02, 0x20, 0xe0, 0xe0, 0x85, 0x20, 0x05, 0x60, 0x80, 0x00, 0x00, 0xff, 0xff, 0x83, 0x10, 0x00,
+    0x7c, 0x83, 0x00, 0x02, 0x10, 0x1f, 0x1f, 0x85, 0x10, 0x02, 0x18, 0x06, 0x00, 0x02, 0x20, 0xe0,
+    0xe0, 0x84, 0x20, 0x81, 0x60, 0x04, 0x80, 0x00, 0x00, 0xff, 0xff, 0x83, 0x10, 0x08, 0x7c, 0x00,
+    0x00, 0x01, 0x00, 0x10, 0x1f, 0x1f, 0x10, 0x87, 0x00, 0x81, 0x00, 0x02, 0x80, 0xc0, 0x60, 0x82,
+    0x20, 0x01, 0x40, 0xe0, 0x82, 0x00, 0x0f, 0xfc, 0xff, 0x01, 0x00, 0x00, 0x40, 0x40, 0xc0, 0xc1,
+    0x40, 0x40, 0x00, 0x01, 0x07, 0x0e, 0x18, 0x82, 0x10, 0x81, 0x0f, 0x81, 0x00, 0x03, 0x20, 0xe0,
+    0xe0, 0x20, 0x83, 0x00, 0x06, 0x20, 0xe0, 0xe0, 0x20, 0x00, 0xff, 0xff, 0x85, 0x10, 0x81, 0xff,
+    0x04, 0x00, 0x10, 0x1f, 0x1f, 0x10, 0x83, 0x00, 0x03, 0x10, 0x1f, 0x1f, 0x10, 0x81, 0x00, 0x82,
+    0x20, 0x81, 0xe0, 0x82, 0x20, 0x86, 0x00, 0x81, 0xff, 0x86, 0x00, 0x82, 0x10, 0x81, 0x1f, 0x82,
+    0x10, 0x81, 0x00, 0x83, 0x00, 0x82, 0x20, 0x81, 0xe0, 0x82, 0x20, 0x86, 0x00, 0x81, 0xff, 0x83,
+    0x00, 0x01, 0x60, 0xe0, 0x82, 0x80, 0x02, 0xc0, 0x7f, 0x3f, 0x82, 0x00, 0x13, 0x20, 0xe0, 0xe0,
+    0x20, 0x00, 0x00, 0x20, 0xa0, 0x60, 0x20, 0x20, 0x00, 0x00, 0xff, 0xff, 0x30, 0x18, 0x7c, 0xe3,
+    0xc0, 0x83, 0x00, 0x0b, 0x10, 0x1f, 0x1f, 0x10, 0x00, 0x00, 0x01, 0x13, 0x1f, 0x1c, 0x18, 0x10,
+    0x03, 0x20, 0xe0, 0xe0, 0x20, 0x88, 0x00, 0x81, 0xff, 0x88, 0x00, 0x02, 0x10, 0x1f, 0x1f, 0x85,
+    0x10, 0x02, 0x18, 0x06, 0x00, 0x00, 0x20, 0x82, 0xe0, 0x83, 0x00, 0x82, 0xe0, 0x18, 0x20, 0x00,
+    0xff, 0x01, 0x3f, 0xfe, 0xc0, 0xe0, 0x1e, 0x01, 0xff, 0xff, 0x00, 0x10, 0x1f, 0x10, 0x00, 0x03,
+    0x1f, 0x03, 0x00, 0x10, 0x1f, 0x1f, 0x10, 0x03, 0x20, 0xe0, 0xe0, 0xc0, 0x84, 0x00, 0x11, 0x20,
+    0xe0, 0x20, 0x00, 0xff, 0x00, 0x03, 0x07, 0x1c, 0x78, 0xe0, 0x80, 0x00, 0xff, 0x00, 0x10, 0x1f,
+    0x10, 0x84, 0x00, 0x03, 0x03, 0x0f, 0x1f, 0x00, 0x81, 0x00, 0x07, 0x80, 0xc0, 0x60, 0x20, 0x20,
+    0x60, 0xc0, 0x80, 0x82, 0x00, 0x02, 0xfe, 0xff, 0x01, 0x84, 0x00, 0x0e, 0xff, 0xfe, 0x00, 0x00,
+    0x01, 0x07, 0x0e, 0x18, 0x10, 0x10, 0x18, 0x0c, 0x07, 0x01, 0x00, 0x02, 0x20, 0xe0, 0xe0, 0x84,
+    0x20, 0x06, 0x60, 0xc0, 0x80, 0x00, 0x00, 0xff, 0xff, 0x84, 0x20, 0x07, 0x30, 0x1f, 0x0f, 0x00,
+    0x10, 0x1f, 0x1f, 0x10, 0x87, 0x00, 0x81, 0x00, 0x07, 0x80, 0xc0, 0x60, 0x20, 0x20, 0x60, 0xc0,
+    0x80, 0x82, 0x00, 0x02, 0xfe, 0xff, 0x01, 0x84, 0x00, 0x0e, 0xff, 0xfe, 0x00, 0x00, 0x01, 0x07,
+    0x0e, 0x11, 0x11, 0x13, 0x3c, 0x7c, 0x67, 0x21, 0x00, 0x02, 0x20, 0xe0, 0xe0, 0x84, 0x20, 0x13,
+    0x60, 0xc0, 0x80, 0x00, 0x00, 0xff, 0xff, 0x10, 0x10, 0x30, 0xf0, 0xd0, 0x08, 0x0f, 0x07, 0x00,
+    0x10, 0x1f, 0x1f, 0x10, 0x82, 0x00, 0x04, 0x03, 0x0f, 0x1c, 0x10, 0x10, 0x03, 0x00, 0x80, 0xc0,
+    0x60, 0x83, 0x20, 0x81, 0x40, 0x11, 0xe0, 0x00, 0x00, 0x07, 0x0f, 0x0c, 0x18, 0x18, 0x30, 0x30,
+    0x60, 0xe0, 0x81, 0x00, 0x00, 0x1f, 0x0c, 0x08, 0x83, 0x10, 0x03, 0x18, 0x0f, 0x07, 0x00, 0x01,
+    0x80, 0x60, 0x82, 0x20, 0x81, 0xe0, 0x82, 0x20, 0x02, 0x60, 0x80, 0x01, 0x83, 0x00, 0x81, 0xff,
+    0x83, 0x00, 0x00, 0x01, 0x83, 0x00, 0x03, 0x10, 0x1f, 0x1f, 0x10, 0x83, 0x00, 0x03, 0x20, 0xe0,
+    0xe0, 0x20, 0x84, 0x00, 0x05, 0x20, 0xe0, 0x20, 0x00, 0xff, 0xff, 0x86, 0x00, 0x05, 0xff, 0x00,
+    0x00, 0x07, 0x0f, 0x18, 0x84, 0x10, 0x02, 0x08, 0x07, 0x00, 0x04, 0x20, 0x60, 0xe0, 0xe0, 0x20,
+    0x82, 0x00, 0x0d, 0x20, 0xe0, 0x60, 0x20, 0x00, 0x00, 0x07, 0x7f, 0xf8, 0x80, 0x00, 0x80, 0x7c,
+    0x03, 0x85, 0x00, 0x03, 0x07, 0x1f, 0x1c, 0x07, 0x83, 0x00, 0x15, 0x20, 0xe0, 0xe0, 0x20, 0x00,
+    0xe0, 0xe0, 0x20, 0x00, 0x20, 0xe0, 0x20, 0x00, 0x07, 0xff, 0xf8, 0xe0, 0x1f, 0xff, 0xfc, 0xe0,
+    0x1f, 0x83, 0x00, 0x06, 0x03, 0x1f, 0x03, 0x00, 0x01, 0x1f, 0x03, 0x82, 0x00, 0x0a, 0x00, 0x20,
+    0x60, 0xe0, 0xa0, 0x00, 0x00, 0x20, 0xe0, 0x60, 0x20, 0x83, 0x00, 0x05, 0x03, 0x8f, 0x7c, 0xf8,
+    0xc6, 0x01, 0x83, 0x00, 0x0a, 0x10, 0x18, 0x1e, 0x13, 0x00, 0x01, 0x17, 0x1f, 0x18, 0x10, 0x00,
+    0x04, 0x20, 0x60, 0xe0, 0xe0, 0x20, 0x82, 0x00, 0x0c, 0x20, 0xe0, 0x60, 0x20, 0x00, 0x00, 0x01,
+    0x07, 0x3e, 0xf8, 0xe0, 0x18, 0x07, 0x85, 0x00, 0x81, 0x10, 0x81, 0x1f, 0x81, 0x10, 0x82, 0x00,
+    0x02, 0x00, 0x80, 0x60, 0x83, 0x20, 0x03, 0xa0, 0xe0, 0xe0, 0x20, 0x84, 0x00, 0x04, 0xc0, 0xf0,
+    0x3e, 0x0f, 0x03, 0x83, 0x00, 0x03, 0x10, 0x1c, 0x1f, 0x17, 0x83, 0x10, 0x02, 0x18, 0x06, 0x00,
+    0x84, 0x00, 0x00, 0xfc, 0x84, 0x04, 0x85, 0x00, 0x00, 0xff, 0x8a, 0x00, 0x00, 0x7f, 0x84, 0x40,
+    0x00, 0x00, 0x81, 0x00, 0x01, 0x10, 0xe0, 0x8b, 0x00, 0x03, 0x03, 0x1c, 0x60, 0x80, 0x8a, 0x00,
+    0x04, 0x03, 0x0c, 0x70, 0x80, 0x00, 0x81, 0x00, 0x84, 0x04, 0x00, 0xfc, 0x8a, 0x00, 0x00, 0xff,
+    0x85, 0x00, 0x84, 0x40, 0x00, 0x7f, 0x83, 0x00, 0x82, 0x00, 0x06, 0x10, 0x08, 0x0c, 0x04, 0x0c,
+    0x08, 0x10, 0x99, 0x00, 0x97, 0x00, 0x8b, 0x80, 0x82, 0x00, 0x81, 0x04, 0x81, 0x08, 0x9c, 0x00,
+    0x8d, 0x00, 0x07, 0x98, 0xd8, 0x44, 0x64, 0x24, 0x24, 0xfc, 0xf8, 0x82, 0x00, 0x02, 0x0f, 0x1f,
+    0x18, 0x82, 0x10, 0x04, 0x08, 0x1f, 0x1f, 0x10, 0x18, 0x03, 0x00, 0x20, 0xe0, 0xf0, 0x89, 0x00,
+    0x81, 0xff, 0x06, 0x18, 0x08, 0x04, 0x04, 0x0c, 0xf8, 0xf0, 0x82, 0x00, 0x02, 0x1f, 0x0f, 0x18,
+    0x82, 0x10, 0x03, 0x18, 0x0f, 0x03, 0x00, 0x8c, 0x00, 0x02, 0xe0, 0xf8, 0x18, 0x82, 0x04, 0x01,
+    0x3c, 0x38, 0x83, 0x00, 0x02, 0x03, 0x0f, 0x0c, 0x83, 0x10, 0x03, 0x08, 0x06, 0x00, 0x00, 0x86,
+    0x00, 0x02, 0x20, 0xe0, 0xf0, 0x82, 0x00, 0x02, 0xe0, 0xf8, 0x1c, 0x82, 0x04, 0x02, 0x08, 0xff,
+    0xff, 0x82, 0x00, 0x02, 0x03, 0x0f, 0x18, 0x82, 0x10, 0x04, 0x08, 0x1f, 0x0f, 0x08, 0x00, 0x8d,
+    0x00, 0x02, 0xe0, 0xf8, 0x48, 0x82, 0x44, 0x02, 0x4c, 0x78, 0x70, 0x82, 0x00, 0x03, 0x03, 0x0f,
+    0x0c, 0x18, 0x82, 0x10, 0x02, 0x08, 0x04, 0x00, 0x83, 0x00, 0x08, 0x80, 0xc0, 0x60, 0x20, 0x20,
+    0xe0, 0xc0, 0x00, 0x00, 0x82, 0x04, 0x81, 0xff, 0x83, 0x04, 0x83, 0x00, 0x81, 0x10, 0x81, 0x1f,
+    0x82, 0x10, 0x82, 0x00, 0x8d, 0x00, 0x0d, 0x70, 0xf8, 0x8c, 0x04, 0x04, 0x8c, 0xf8, 0x74, 0x04,
+    0x0c, 0x00, 0x70, 0x76, 0xcf, 0x82, 0x8d, 0x04, 0x89, 0xc8, 0x78, 0x70, 0x00, 0x03, 0x00, 0x20,
+    0xe0, 0xf0, 0x89, 0x00, 0x81, 0xff, 0x00, 0x08, 0x82, 0x04, 0x01, 0xfc, 0xf8, 0x82, 0x00, 0x0a,
+    0x10, 0x1f, 0x1f, 0x10, 0x00, 0x00, 0x10, 0x1f, 0x1f, 0x10, 0x00, 0x84, 0x00, 0x81, 0x60, 0x86,
+    0x00, 0x82, 0x04, 0x81, 0xfc, 0x86, 0x00, 0x82, 0x10, 0x81, 0x1f, 0x82, 0x10, 0x81, 0x00, 0x86,
+    0x00, 0x81, 0x60, 0x86, 0x00, 0x82, 0x04, 0x81, 0xfc, 0x84, 0x00, 0x81, 0xc0, 0x81, 0x80, 0x02,
+    0xc0, 0x7f, 0x3f, 0x82, 0x00, 0x03, 0x00, 0x20, 0xe0, 0xf0, 0x89, 0x00, 0x81, 0xff, 0x05, 0x80,
+    0xc0, 0xf4, 0x1c, 0x04, 0x04, 0x82, 0x00, 0x0a, 0x10, 0x1f, 0x1f, 0x11, 0x00, 0x03, 0x1f, 0x1c,
+    0x10, 0x10, 0x00, 0x81, 0x00, 0x82, 0x20, 0x01, 0xe0, 0xf0, 0x89, 0x00, 0x81, 0xff, 0x86, 0x00,
+    0x82, 0x10, 0x81, 0x1f, 0x82, 0x10, 0x81, 0x00, 0x8b, 0x00, 0x17, 0x04, 0xfc, 0xfc, 0x08, 0x04,
+    0xfc, 0xfc, 0x08, 0x04, 0xfc, 0xfc, 0x00, 0x10, 0x1f, 0x1f, 0x10, 0x00, 0x1f, 0x1f, 0x10, 0x00,
+    0x1f, 0x1f, 0x10, 0x8c, 0x00, 0x08, 0x04, 0xfc, 0xfc, 0x08, 0x08, 0x04, 0x04, 0xfc, 0xf8, 0x82,
+    0x00, 0x0a, 0x10, 0x1f, 0x1f, 0x10, 0x00, 0x00, 0x10, 0x1f, 0x1f, 0x10, 0x00, 0x8c, 0x00, 0x0e,
+    0xe0, 0xf0, 0x18, 0x0c, 0x04, 0x04, 0x0c, 0x18, 0xf0, 0xe0, 0x00, 0x00, 0x03, 0x0f, 0x0c, 0x83,
+    0x10, 0x03, 0x0c, 0x0f, 0x03, 0x00, 0x8c, 0x00, 0x03, 0x04, 0xfc, 0xfc, 0x08, 0x82, 0x04, 0x0f,
+    0x0c, 0xf8, 0xf0, 0x00, 0x00, 0x80, 0xff, 0xff, 0x88, 0x90, 0x10, 0x10, 0x1c, 0x0f, 0x03, 0x00,
+    0x8c, 0x00, 0x02, 0xe0, 0xf8, 0x1c, 0x82, 0x04, 0x02, 0x08, 0xf8, 0xfc, 0x82, 0x00, 0x0a, 0x03,
+    0x0f, 0x18, 0x10, 0x10, 0x90, 0x88, 0xff, 0xff, 0x80, 0x00, 0x8b, 0x00, 0x82, 0x04, 0x81, 0xfc,
+    0x06, 0x10, 0x08, 0x04, 0x04, 0x0c, 0x0c, 0x00, 0x82, 0x10, 0x81, 0x1f, 0x82, 0x10, 0x83, 0x00,
+    0x8d, 0x00, 0x03, 0x30, 0x78, 0xcc, 0xc4, 0x82, 0x84, 0x01, 0x0c, 0x1c, 0x82, 0x00, 0x01, 0x1e,
+    0x18, 0x82, 0x10, 0x04, 0x11, 0x19, 0x0f, 0x06, 0x00, 0x84, 0x00, 0x00, 0xc0, 0x86, 0x00, 0x82,
+    0x04, 0x81, 0xff, 0x82, 0x04, 0x86, 0x00, 0x01, 0x0f, 0x1f, 0x82, 0x10, 0x02, 0x0c, 0x00, 0x00,
+    0x8c, 0x00, 0x02, 0x04, 0xfc, 0xfe, 0x82, 0x00, 0x02, 0x04, 0xfc, 0xfe, 0x83, 0x00, 0x09, 0x0f,
+    0x1f, 0x18, 0x10, 0x10, 0x08, 0x1f, 0x0f, 0x08, 0x00, 0x8c, 0x00, 0x0a, 0x04, 0x0c, 0x3c, 0xfc,
+    0xc4, 0x00, 0x00, 0xc4, 0x3c, 0x0c, 0x04, 0x83, 0x00, 0x04, 0x01, 0x0f, 0x1e, 0x0e, 0x01, 0x82,
+    0x00, 0x8b, 0x00, 0x17, 0x04, 0x3c, 0xfc, 0xc4, 0x00, 0xe4, 0x7c, 0xfc, 0x84, 0x80, 0x7c, 0x04,
+    0x00, 0x00, 0x07, 0x1f, 0x07, 0x00, 0x00, 0x07, 0x1f, 0x07, 0x00, 0x00, 0x8c, 0x00, 0x81, 0x04,
+    0x14, 0x1c, 0x7c, 0xe4, 0xc0, 0x34, 0x1c, 0x04, 0x04, 0x00, 0x00, 0x10, 0x10, 0x1c, 0x16, 0x01,
+    0x13, 0x1f, 0x1c, 0x18, 0x10, 0x00, 0x8c, 0x00, 0x09, 0x04, 0x0c, 0x3c, 0xfc, 0xc4, 0x00, 0xc4,
+    0x3c, 0x04, 0x04, 0x82, 0x00, 0x05, 0xc0, 0x80, 0xc1, 0x37, 0x0e, 0x01, 0x83, 0x00, 0x8d, 0x00,
+    0x07, 0x1c, 0x04, 0x04, 0xc4, 0xf4, 0x7c, 0x1c, 0x04, 0x83, 0x00, 0x09, 0x10, 0x1c, 0x1f, 0x17,
+    0x11, 0x10, 0x10, 0x18, 0x0e, 0x00, 0x86, 0x00, 0x02, 0xf8, 0x0c, 0x04, 0x86, 0x00, 0x02, 0x10,
+    0x28, 0xef, 0x8a, 0x00, 0x04, 0x3f, 0x60, 0x40, 0x00, 0x00, 0x85, 0x00, 0x00, 0xff, 0x8a, 0x00,
+    0x00, 0xff, 0x8a, 0x00, 0x00, 0xff, 0x84, 0x00, 0x81, 0x00, 0x02, 0x04, 0x0c, 0xf8, 0x8a, 0x00,
+    0x02, 0xef, 0x28, 0x10, 0x86, 0x00, 0x02, 0x40, 0x60, 0x3f, 0x86, 0x00, 0x0b, 0x00, 0x18, 0x06,
+    0x02, 0x02, 0x04, 0x08, 0x10, 0x20, 0x20, 0x30, 0x08, 0x97, 0x00,
+};
+
+static const uint16_t afont24x12_rle_index[] = {
+    0, 2, 18, 32, 63, 98, 135, 170, 178, 201, 224, 248,
+    266, 275, 281, 287, 309, 345, 366, 400, 435, 464, 494, 531,
+    557, 592, 627, 637, 648, 672, 678, 703, 732, 768, 798, 830,
+    863, 896, 925, 953, 989, 1021, 1043, 1068, 1104, 1125, 1159, 1192,
+    1227, 1254, 1289, 1324, 1359, 1389, 1418, 1450, 1485, 1520, 1552, 1584,
+    1602, 1622, 1640, 1652, 1656, 1664, 1689, 1719, 1743, 1775, 1800, 1828,
+    1853, 1883, 1903, 1925, 1955, 1976, 2003, 2029, 2054, 2080, 2106, 2128,
+    2153, 2176, 2201, 2225, 2252, 2278, 2302, 2326, 2346, 2360, 2380, 2395,
+};
+
+const ASCIIFont afont24x12_rle = {24, 12, (uint8_t *)afont24x12_rle_data, afont24x12_rle_index};
+
+static const uint8_t bilibiliImg_rle_data[] = {
+    0x83, 0x00, 0x87, 0x80, 0x0a, 0x86, 0x8f, 0x9f, 0xbf, 0xff, 0xfc, 0xf8, 0xf8, 0xe0, 0xe0, 0xc0,
+    0x84, 0x80, 0x0a, 0xc0, 0xe0, 0xe0, 0xf8, 0xf8, 0xfc, 0xfe, 0xbf, 0x9f, 0x8f, 0x86, 0x86, 0x80,
+    0x84, 0x00, 0x01, 0xf8, 0xfe, 0x83, 0xff, 0xa6, 0x1f, 0x82, 0xff, 0x02, 0xfe, 0xfc, 0xf8, 0x85,
+    0xff, 0x82, 0x00, 0x81, 0xe0, 0x83, 0xf0, 0x85, 0xf8, 0x89, 0x00, 0x85, 0xf8, 0x83, 0xf0, 0x03,
+    0xe0, 0x20, 0x00, 0x00, 0x8b, 0xff, 0x83, 0x00, 0x00, 0x03, 0x83, 0x01, 0x84, 0x00, 0x81, 0x80,
+    0x81, 0x00, 0x07, 0x80, 0xc0, 0xc0, 0x80, 0x00, 0x00, 0x80, 0x80, 0x84, 0x00, 0x82, 0x01, 0x81,
+    0x03, 0x82, 0x00, 0x8b, 0xff, 0x8c, 0x00, 0x00, 0x01, 0x84, 0x07, 0x00, 0x03, 0x84, 0x07, 0x01,
+    0x03, 0x01, 0x8b, 0x00, 0x85, 0xff, 0x02, 0x01, 0x07, 0x07, 0x86, 0x1f, 0x85, 0xff, 0x92, 0x1f,
+    0x00, 0x7f, 0x84, 0xff, 0x00, 0x7f, 0x85, 0x1f, 0x81, 0x07, 0x00, 0x03,
+};
+
+const Image bilibiliImg_rle = {51, 48, bilibiliImg_rle_data, 1};
+
+const Font font24x12_rle = {24, 12, NULL, 0, &afont24x12_rle, NULL};
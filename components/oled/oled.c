@@ -192,6 +192,24 @@ void OLED_Init() {
   OLED_SendCmd(0xAF); /*开启显示 display ON*/
 }
 
+/**
+ * @brief 设置对比度
+ * @param contrast 0-255 越大越亮
+ */
+void OLED_SetContrast(uint8_t contrast) {
+  OLED_SendCmd(0x81);
+  OLED_SendCmd(contrast);
+}
+
+/**
+ * @brief 旋转180度显示
+ * @param flip true时旋转 (分段重映射和扫描方向同时反转)
+ */
+void OLED_SetFlip(bool flip) {
+  OLED_SendCmd(flip ? 0xA0 : 0xA1);
+  OLED_SendCmd(flip ? 0xC0 : 0xC8);
+}
+
 /**
  * @brief 开启OLED显示
  */
@@ -349,6 +367,52 @@ void OLED_SetBits(uint8_t x, uint8_t y, uint8_t data, OLED_ColorMode color) {
   }
 }
 
+/**
+ * @brief 字模数据流 统一原始数据与RLE压缩数据的读取
+ * @note RLE格式: 控制字节最高位为1时, 后1字节重复(低7位+1)次; 最高位为0时, 后跟(低7位+1)字节原始数据
+ */
+typedef struct {
+  const uint8_t *src; // 当前读取位置
+  uint8_t rle;        // 是否为RLE数据
+  uint8_t count;      // 当前段剩余字节数
+  uint8_t repeat;     // 当前段是否为重复段
+  uint8_t value;      // 重复段的数据
+} _OLED_Stream;
+
+/**
+ * @brief 从数据流中取出下一字节
+ */
+static inline uint8_t _OLED_StreamNext(_OLED_Stream *s) {
+  if (!s->rle) return *s->src++;
+  if (!s->count) {
+    uint8_t ctrl = *s->src++;
+    s->repeat = ctrl & 0x80;
+    s->count = (ctrl & 0x7f) + 1;
+    if (s->repeat) s->value = *s->src++;
+  }
+  s->count--;
+  return s->repeat ? s->value : *s->src++;
+}
+
+/**
+ * @brief 按数据流顺序设置一块显存区域
+ * @note 数据按列行式排列, 按字节顺序逐行(页)写入, 因此可以边解码边写入
+ */
+static void _OLED_SetBlockStream(uint8_t x, uint8_t y, _OLED_Stream *s, uint8_t w, uint8_t h, OLED_ColorMode color) {
+  uint8_t fullRow = h / 8; // 完整的行数
+  uint8_t partBit = h % 8; // 不完整的字节中的有效位数
+  for (uint8_t j = 0; j < fullRow; j++) {
+    for (uint8_t i = 0; i < w; i++) {
+      OLED_SetBits(x + i, y + j * 8, _OLED_StreamNext(s), color);
+    }
+  }
+  if (partBit) {
+    for (uint8_t i = 0; i < w; i++) {
+      OLED_SetBits_Fine(x + i, y + (fullRow * 8), _OLED_StreamNext(s), partBit, color);
+    }
+  }
+}
+
 /**
  * @brief 设置一块显存区域
  * @param x 起始横坐标
@@ -361,19 +425,8 @@ void OLED_SetBits(uint8_t x, uint8_t y, uint8_t data, OLED_ColorMode color) {
  * @note data的数据应该采用列行式排列
  */
 void OLED_SetBlock(uint8_t x, uint8_t y, const uint8_t *data, uint8_t w, uint8_t h, OLED_ColorMode color) {
-  uint8_t fullRow = h / 8; // 完整的行数
-  uint8_t partBit = h % 8; // 不完整的字节中的有效位数
-  for (uint8_t i = 0; i < w; i++) {
-    for (uint8_t j = 0; j < fullRow; j++) {
-      OLED_SetBits(x + i, y + j * 8, data[i + j * w], color);
-    }
-  }
-  if (partBit) {
-    uint16_t fullNum = w * fullRow; // 完整的字节数
-    for (uint8_t i = 0; i < w; i++) {
-      OLED_SetBits_Fine(x + i, y + (fullRow * 8), data[fullNum + i], partBit, color);
-    }
-  }
+  _OLED_Stream s = {.src = data, .rle = 0};
+  _OLED_SetBlockStream(x, y, &s, w, h, color);
   // 使用OLED_SetPixel实现
   // for (uint8_t i = 0; i < w; i++) {
   //   for (uint8_t j = 0; j < h; j++) {
@@ -385,6 +438,22 @@ void OLED_SetBlock(uint8_t x, uint8_t y, const uint8_t *data, uint8_t w, uint8_t
   // }
 }
 
+/**
+ * @brief 设置一块显存区域 数据为RLE压缩格式
+ * @param x 起始横坐标
+ * @param y 起始纵坐标
+ * @param data RLE数据的起始地址
+ * @param w 宽度
+ * @param h 高度
+ * @param color 颜色
+ * @note 解码不需要额外缓冲区, 边解码边写入显存
+ * @note RLE数据可以使用tools/font_rle.py生成
+ */
+void OLED_SetBlockRLE(uint8_t x, uint8_t y, const uint8_t *data, uint8_t w, uint8_t h, OLED_ColorMode color) {
+  _OLED_Stream s = {.src = data, .rle = 1};
+  _OLED_SetBlockStream(x, y, &s, w, h, color);
+}
+
 // ========================== 图形绘制函数 ==========================
 /**
  * @brief 绘制一条线段
@@ -632,7 +701,11 @@ void OLED_DrawEllipse(uint8_t x, uint8_t y, uint8_t a, uint8_t b, OLED_ColorMode
  * @param color 颜色
  */
 void OLED_DrawImage(uint8_t x, uint8_t y, const Image *img, OLED_ColorMode color) {
-  OLED_SetBlock(x, y, img->data, img->w, img->h, color);
+  if (img->rle) {
+    OLED_SetBlockRLE(x, y, img->data, img->w, img->h, color);
+  } else {
+    OLED_SetBlock(x, y, img->data, img->w, img->h, color);
+  }
 }
 
 // ================================ 文字绘制 ================================
@@ -646,7 +719,11 @@ void OLED_DrawImage(uint8_t x, uint8_t y, const Image *img, OLED_ColorMode color
  * @param color 颜色
  */
 void OLED_PrintASCIIChar(uint8_t x, uint8_t y, char ch, const ASCIIFont *font, OLED_ColorMode color) {
-  OLED_SetBlock(x, y, font->chars + (ch - ' ') * (((font->h + 7) / 8) * font->w), font->w, font->h, color);
+  if (font->rle_index) {
+    OLED_SetBlockRLE(x, y, font->chars + font->rle_index[ch - ' '], font->w, font->h, color);
+  } else {
+    OLED_SetBlock(x, y, font->chars + (ch - ' ') * (((font->h + 7) / 8) * font->w), font->w, font->h, color);
+  }
 }
 
 /**
@@ -719,9 +796,13 @@ void OLED_PrintString(uint8_t x, uint8_t y, char *str, const Font *font, OLED_Co
 
     // 寻找字符  TODO 优化查找算法, 二分查找或者hash
     for (uint8_t j = 0; j < font->len; j++) {
-      head = (uint8_t *)(font->chars) + (j * oneLen);
+      head = (uint8_t *)(font->chars) + (font->rle_index ? font->rle_index[j] : j * oneLen);
       if (memcmp(str + i, head, utf8Len) == 0) {
-        OLED_SetBlock(x, y, head + 4, font->w, font->h, color);
+        if (font->rle_index) {
+          OLED_SetBlockRLE(x, y, head + 4, font->w, font->h, color);
+        } else {
+          OLED_SetBlock(x, y, head + 4, font->w, font->h, color);
+        }
         // 移动光标
         x += font->w;
         i += utf8Len;
@@ -29,10 +29,14 @@ typedef enum {
 void OLED_Init();
 void OLED_DisPlay_On();
 void OLED_DisPlay_Off();
+void OLED_SetContrast(uint8_t contrast);
+void OLED_SetFlip(bool flip);
 
 void OLED_NewFrame();
 void OLED_ShowFrame();
 void OLED_SetPixel(uint8_t x, uint8_t y, OLED_ColorMode color);
+void OLED_SetBlock(uint8_t x, uint8_t y, const uint8_t *data, uint8_t w, uint8_t h, OLED_ColorMode color);
+void OLED_SetBlockRLE(uint8_t x, uint8_t y, const uint8_t *data, uint8_t w, uint8_t h, OLED_ColorMode color);
 
 void OLED_DrawLine(uint8_t x1, uint8_t y1, uint8_t x2, uint8_t y2, OLED_ColorMode color);
 void OLED_DrawRectangle(uint8_t x, uint8_t y, uint8_t w, uint8_t h, OLED_ColorMode color);
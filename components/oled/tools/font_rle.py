@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+"""
+将 font.c 中的列行式字模/图模压缩为 RLE 格式, 生成 font_rle.c
+
+RLE 格式(与 oled.c 中的 _OLED_StreamNext 对应):
+  控制字节 c:
+    c & 0x80 == 0x80 : 重复段, 后跟 1 字节数据, 重复 (c & 0x7f) + 1 次
+    c & 0x80 == 0x00 : 原样段, 后跟 c + 1 字节原始数据
+  每个字模单独压缩, 并生成一个 uint16_t 偏移表用于随机访问
+  压缩后(含偏移表)不比原始数据小的字库不生成, 继续使用 font.c 中的原始字模
+
+用法:
+  python font_rle.py [font.c] [font_rle.c]
+"""
+import re
+import sys
+from pathlib import Path
+
+HERE = Path(__file__).resolve().parent
+
+# (源数组, 输出前缀, 类型, 参数)
+#   ascii: 参数为 (h, w)
+#   font : 参数为 (h, w, 缺省 ASCII 字体名)
+#   image: 参数为 (w, h)
+SPECS = [
+    ("ascii_8x6", "afont8x6", "ascii", (8, 6)),
+    ("ascii_12x6", "afont12x6", "ascii", (12, 6)),
+    ("ascii_16x8", "afont16x8", "ascii", (16, 8)),
+    ("ascii_24x12", "afont24x12", "ascii", (24, 12)),
+    ("zh16x16", "font16x16", "font", (16, 16, "afont16x8")),
+    ("bilibiliData", "bilibiliImg", "image", (51, 48)),
+]
+
+
+def strip_comments(src):
+    src = re.sub(r"/\*.*?\*/", "", src, flags=re.S)
+    return re.sub(r"//[^\n]*", "", src)
+
+
+def parse_arrays(src):
+    """返回 {数组名: [[字节...], ...]}, 一维数组视为只有一行"""
+    arrays = {}
+    pattern = re.compile(r"(?:const\s+)?(?:unsigned\s+char|uint8_t)\s+(\w+)\s*((?:\[\w*\])+)\s*=\s*\{(.*?)\};", re.S)
+    for m in pattern.finditer(src):
+        name, dims, body = m.group(1), m.group(2), m.group(3)
+        if dims.count("[") == 2:
+            rows = re.findall(r"\{([^{}]*)\}", body)
+        else:
+            rows = [body]
+        arrays[name] = [[int(v, 0) for v in re.findall(r"0[xX][0-9a-fA-F]+|\d+", row)] for row in rows]
+    return arrays
+
+
+def rle_encode(data):
+    out = bytearray()
+    literal = bytearray()
+
+    def flush_literal():
+        while literal:
+            chunk = literal[:128]
+            out.append(len(chunk) - 1)
+            out.extend(chunk)
+            del literal[:128]
+
+    i = 0
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and data[i + run] == data[i] and run < 128:
+            run += 1
+        # 长度为2的重复段不划算, 除非它打断的不是原样段
+        if run >= 3 or (run == 2 and not literal):
+            flush_literal()
+            out.append(0x80 | (run - 1))
+            out.append(data[i])
+            i += run
+        else:
+            literal.append(data[i])
+            i += 1
+    flush_literal()
+    return bytes(out)
+
+
+def rle_decode(data, n):
+    out = bytearray()
+    i = 0
+    while len(out) < n:
+        c = data[i]
+        i += 1
+        if c & 0x80:
+            out.extend([data[i]] * ((c & 0x7F) + 1))
+            i += 1
+        else:
+            out.extend(data[i:i + c + 1])
+            i += c + 1
+    return bytes(out[:n])
+
+
+def glyph_bytes(h, w):
+    return ((h + 7) // 8) * w
+
+
+def c_bytes(data, indent="    ", per_line=16):
+    lines = []
+    for i in range(0, len(data), per_line):
+        lines.append(indent + ", ".join("0x%02x" % b for b in data[i:i + per_line]) + ",")
+    return "\n".join(lines)
+
+
+def c_index(index, indent="    ", per_line=12):
+    lines = []
+    for i in range(0, len(index), per_line):
+        lines.append(indent + ", ".join("%d" % v for v in index[i:i + per_line]) + ",")
+    return "\n".join(lines)
+
+
+def convert(arrays):
+    out = []
+    report = []
+    emitted = set()
+    for src_name, prefix, kind, args in SPECS:
+        rows = arrays[src_name]
+        code = []
+        if kind == "ascii":
+            h, w = args
+            size = glyph_bytes(h, w)
+            stream, index = bytearray(), []
+            for row in rows:
+                glyph = bytes(row[:size]).ljust(size, b"\0")
+                index.append(len(stream))
+                enc = rle_encode(glyph)
+                assert rle_decode(enc, size) == glyph
+                stream += enc
+            index.append(len(stream))
+            raw = size * len(rows)
+            code.append("static const uint8_t %s_rle_data[] = {\n%s\n};\n" % (prefix, c_bytes(stream)))
+            code.append("static const uint16_t %s_rle_index[] = {\n%s\n};\n" % (prefix, c_index(index)))
+            code.append("const ASCIIFont %s_rle = {%d, %d, (uint8_t *)%s_rle_data, %s_rle_index};\n"
+                        % (prefix, h, w, prefix, prefix))
+            packed = len(stream) + 2 * len(index)
+        elif kind == "font":
+            h, w, ascii_name = args
+            size = glyph_bytes(h, w)
+            stream, index = bytearray(), []
+            for row in rows:
+                glyph = bytes(row[4:4 + size]).ljust(size, b"\0")
+                index.append(len(stream))
+                enc = rle_encode(glyph)
+                assert rle_decode(enc, size) == glyph
+                stream += bytes(row[:4]) + enc
+            index.append(len(stream))
+            raw = (size + 4) * len(rows)
+            code.append("static const uint8_t %s_rle_data[] = {\n%s\n};\n" % (prefix, c_bytes(stream)))
+            code.append("static const uint16_t %s_rle_index[] = {\n%s\n};\n" % (prefix, c_index(index)))
+            ascii_ref = ascii_name + "_rle" if ascii_name in emitted else ascii_name
+            code.append("const Font %s_rle = {%d, %d, %s_rle_data, %d, &%s, %s_rle_index};\n"
+                        % (prefix, h, w, prefix, len(rows), ascii_ref, prefix))
+            packed = len(stream) + 2 * len(index)
+        else:
+            w, h = args
+            size = glyph_bytes(h, w)
+            data = bytes(rows[0][:size])
+            stream = rle_encode(data)
+            assert rle_decode(stream, size) == data
+            raw = size
+            code.append("static const uint8_t %s_rle_data[] = {\n%s\n};\n" % (prefix, c_bytes(stream)))
+            code.append("const Image %s_rle = {%d, %d, %s_rle_data, 1};\n" % (prefix, w, h, prefix))
+            packed = len(stream)
+        report.append((prefix, raw, packed))
+        if packed < raw:
+            out += code
+            emitted.add(prefix)
+
+    # 时钟显示使用的 24x12 字体没有中文字模, 只保留 ASCII 缺省字体
+    out.append("const Font font24x12_rle = {24, 12, NULL, 0, &afont24x12_rle, NULL};\n")
+    return out, report
+
+
+def main():
+    src_path = Path(sys.argv[1]) if len(sys.argv) > 1 else HERE.parent / "font.c"
+    dst_path = Path(sys.argv[2]) if len(sys.argv) > 2 else HERE.parent / "font_rle.c"
+    arrays = parse_arrays(strip_comments(src_path.read_text(encoding="utf-8")))
+    body, report = convert(arrays)
+
+    lines = ["%-12s %8d -> %6d bytes (%5.1f%%)%s" % (n, r, p, 100.0 * p / r, "" if p < r else "  skipped")
+             for n, r, p in report]
+    saved = [(r, p) for _, r, p in report if p < r]
+    total_raw = sum(r for r, _ in saved)
+    total_packed = sum(p for _, p in saved)
+    lines.append("%-12s %8d -> %6d bytes (%5.1f%%)" % ("total", total_raw, total_packed, 100.0 * total_packed / total_raw))
+
+    header = [
+        "/**",
+        " * @file font_rle.c",
+        " * @brief RLE压缩字库",
+        " *",
+        " * @attention",
+        " * 本文件由 tools/font_rle.py 根据 font.c 自动生成, 请勿手动修改",
+        " * 压缩结果(含偏移表):",
+    ]
+    header += [" *   " + line for line in lines]
+    header += [" */", "// clang-format off", '#include "font.h"', ""]
+    dst_path.write_text("\n".join(header) + "\n" + "\n".join(body), encoding="utf-8")
+    print("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
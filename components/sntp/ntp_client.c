@@ -0,0 +1,319 @@
+#include "sntp.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+
+#define NTP_SYNCED_BIT BIT0
+#define NTP_ONLINE_BIT BIT1     // 网络可用, 由ntp_client_start/stop控制
+
+typedef struct {
+    char name[NTP_SERVER_NAME_LEN];
+    struct sockaddr_in addr;
+    bool resolved;
+    ntp_filter_t filter;
+} ntp_server_t;
+
+static ntp_server_t s_servers[NTP_MAX_SERVERS];
+static int s_server_num = 0;
+static ntp_discipline_t s_discipline;
+static ntp_slew_t s_slew;           // 上一次校正开始的平滑调整
+static ntp_client_stats_t s_stats;
+static portMUX_TYPE s_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static EventGroupHandle_t s_ntp_event = NULL;
+static TaskHandle_t s_ntp_task = NULL;
+
+// 运行中修改的服务器列表 由客户端任务在下一轮开始前应用
+static char s_pending[NTP_MAX_SERVERS][NTP_SERVER_NAME_LEN];
+static int s_pending_num = 0;
+static bool s_pending_set = false;
+
+
+static bool ntp_resolve(ntp_server_t *server) {
+    const struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = SOCK_DGRAM,
+    };
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(server->name, NULL, &hints, &res) != 0 || !res) {
+        ESP_LOGW(TAG, "解析 %s 失败", server->name);
+        return false;
+    }
+    memcpy(&server->addr, res->ai_addr, sizeof(struct sockaddr_in));
+    server->addr.sin_port = htons(NTP_PORT);
+    freeaddrinfo(res);
+    server->resolved = true;
+    return true;
+}
+
+// 向一个服务器发出请求并等待应答 成功返回true
+static bool ntp_query(int sock, ntp_server_t *server, ntp_sample_t *sample) {
+    uint8_t packet[NTP_PACKET_SIZE];
+    int64_t t1 = time_service_now_us();
+    ntp_build_request(packet, t1);
+    if (sendto(sock, packet, sizeof(packet), 0, (struct sockaddr *)&server->addr, sizeof(server->addr)) < 0) {
+        return false;
+    }
+
+    // 丢弃来源不符或originate不匹配的报文, 直到超时
+    int64_t deadline = esp_timer_get_time() + NTP_RECV_TIMEOUT_MS * 1000;
+    while (esp_timer_get_time() < deadline) {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        int len = recvfrom(sock, packet, sizeof(packet), 0, (struct sockaddr *)&from, &from_len);
+        int64_t t4 = time_service_now_us();
+        if (len < 0) {
+            return false;
+        }
+        if (from.sin_addr.s_addr == server->addr.sin_addr.s_addr &&
+            ntp_parse_response(packet, len, t1, t4, sample)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 完成一轮轮询, 返回下一次的轮询间隔
+static uint32_t ntp_poll_round(int sock, uint32_t poll_s) {
+    int responses = 0;
+    for (int i = 0; i < s_server_num; i++) {
+        ntp_server_t *server = &s_servers[i];
+        ntp_sample_t sample;
+        bool ok = (server->resolved || ntp_resolve(server)) && ntp_query(sock, server, &sample);
+        if (ok) {
+            // 已有样本先计入平滑调整到本样本为止的进度, 与新样本以同一时钟为准
+            ntp_filter_follow(&server->filter, &s_slew, sample.time_us);
+            ntp_filter_add(&server->filter, &sample);
+            responses++;
+        } else {
+            ntp_filter_miss(&server->filter);
+            server->resolved = server->filter.reach != 0; // 连续无应答时重新解析 (池地址可能已变化)
+        }
+        taskENTER_CRITICAL(&s_stats_mux);
+        s_stats.polls++;
+        if (ok) {
+            s_stats.responses++;
+        } else {
+            s_stats.timeouts++;
+        }
+        taskEXIT_CRITICAL(&s_stats_mux);
+    }
+
+    int64_t offset;
+    uint32_t jitter;
+    uint32_t selected = 0;
+    int64_t now = time_service_now_us();
+    ntp_filter_t filters[NTP_MAX_SERVERS];
+    for (int i = 0; i < s_server_num; i++) {
+        ntp_filter_follow(&s_servers[i].filter, &s_slew, now);
+        filters[i] = s_servers[i].filter;
+    }
+    int used = responses ? ntp_combine(filters, s_server_num, &offset, &jitter, &selected) : 0;
+    if (!used) {
+        return NTP_POLL_MIN_S; // 没有可用的服务器, 尽快重试
+    }
+
+    bool stepped = time_service_correct(now + offset);
+    int32_t freq;
+    if (stepped) {
+        ntp_discipline_step(&s_discipline);
+        freq = time_service_get_freq_ppb();
+    } else {
+        freq = ntp_discipline_update(&s_discipline, offset, now);
+        time_service_set_freq_ppb(freq);
+    }
+    // 跳变立即生效; 平滑调整以500ppm进行, 只有已完成的部分才能从样本中扣除,
+    // 否则下一轮的偏差和频率估计都会少算未完成的部分
+    s_slew.start_us = now;
+    s_slew.amount_us = stepped ? 0 : offset;
+    for (int i = 0; i < s_server_num; i++) {
+        ntp_filter_correct(&s_servers[i].filter, stepped ? offset : 0);
+    }
+
+    // 偏差在抖动范围内说明已锁定, 放长轮询间隔; 跳变或偏差过大时缩短
+    int64_t abs_offset = offset < 0 ? -offset : offset;
+    if (stepped) {
+        poll_s = NTP_POLL_MIN_S;
+    } else if (abs_offset <= (int64_t)jitter * 4 + 1000) {
+        poll_s = poll_s * 2 > NTP_POLL_MAX_S ? NTP_POLL_MAX_S : poll_s * 2;
+    } else if (abs_offset > (int64_t)jitter * 16 + 8000) {
+        poll_s = poll_s / 2 < NTP_POLL_MIN_S ? NTP_POLL_MIN_S : poll_s / 2;
+    }
+
+    taskENTER_CRITICAL(&s_stats_mux);
+    s_stats.offset_us = offset;
+    s_stats.jitter_us = jitter;
+    s_stats.freq_ppb = freq;
+    s_stats.poll_s = poll_s;
+    if (stepped) {
+        s_stats.steps++;
+    } else {
+        s_stats.slews++;
+    }
+    for (int i = 0; i < s_server_num; i++) {
+        const ntp_filter_t *f = &filters[i];
+        s_stats.servers[i].reach = f->reach;
+        s_stats.servers[i].offset_us = f->offset_us;
+        s_stats.servers[i].delay_us = f->delay_us;
+        s_stats.servers[i].jitter_us = f->jitter_us;
+        s_stats.servers[i].selected = (selected >> i) & 1;
+    }
+    taskEXIT_CRITICAL(&s_stats_mux);
+
+    ESP_LOGI(TAG, "NTP %d/%d 服务器 偏差 %lldus 抖动 %luus 频率 %ldppb 下次 %lus",
+             used, s_server_num, offset, (unsigned long)jitter, (long)freq, (unsigned long)poll_s);
+    xEventGroupSetBits(s_ntp_event, NTP_SYNCED_BIT);
+    return poll_s;
+}
+
+// 设置服务器列表 名字未变的服务器保留滤波器状态
+static void ntp_set_servers(char names[][NTP_SERVER_NAME_LEN], int num) {
+    ntp_server_t servers[NTP_MAX_SERVERS];
+    memset(servers, 0, sizeof(servers));
+    for (int i = 0; i < num; i++) {
+        int old = -1;
+        for (int j = 0; j < s_server_num; j++) {
+            if (strcmp(s_servers[j].name, names[i]) == 0) {
+                old = j;
+                break;
+            }
+        }
+        if (old >= 0) {
+            servers[i] = s_servers[old];
+        } else {
+            strlcpy(servers[i].name, names[i], NTP_SERVER_NAME_LEN);
+        }
+    }
+    memcpy(s_servers, servers, sizeof(servers));
+
+    taskENTER_CRITICAL(&s_stats_mux);
+    s_server_num = num;
+    s_stats.server_num = num;
+    memset(s_stats.servers, 0, sizeof(s_stats.servers));
+    for (int i = 0; i < num; i++) {
+        s_stats.servers[i].name = s_servers[i].name;
+    }
+    taskEXIT_CRITICAL(&s_stats_mux);
+}
+
+static void ntp_apply_pending(void) {
+    char names[NTP_MAX_SERVERS][NTP_SERVER_NAME_LEN];
+    int num;
+    taskENTER_CRITICAL(&s_stats_mux);
+    bool pending = s_pending_set;
+    num = s_pending_num;
+    memcpy(names, s_pending, sizeof(names));
+    s_pending_set = false;
+    taskEXIT_CRITICAL(&s_stats_mux);
+    if (pending) {
+        ntp_set_servers(names, num);
+        ESP_LOGI(TAG, "NTP服务器列表已更新 (%d个)", num);
+    }
+}
+
+static void ntp_client_task(void *pvParam) {
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "NTP socket创建失败");
+        s_ntp_task = NULL;
+        vTaskDelete(NULL);
+        return;
+    }
+    struct timeval timeout = {
+        .tv_sec = NTP_RECV_TIMEOUT_MS / 1000,
+        .tv_usec = (NTP_RECV_TIMEOUT_MS % 1000) * 1000,
+    };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    uint32_t poll_s = NTP_POLL_MIN_S;
+    int burst = NTP_FILTER_STAGES / 2; // 启动时先快速轮询几轮, 尽快填充滤波器
+    while (1) {
+        xEventGroupWaitBits(s_ntp_event, NTP_ONLINE_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+        ntp_apply_pending();
+        poll_s = ntp_poll_round(sock, poll_s);
+        uint32_t delay_s = poll_s;
+        if (burst > 0) {
+            burst--;
+            delay_s = 2;
+        }
+        // 网络恢复时由ntp_client_start提前唤醒
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(delay_s * 1000));
+    }
+}
+
+esp_err_t ntp_client_start(const char *const servers[], int num) {
+    if (!servers || num <= 0 || num > NTP_MAX_SERVERS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_ntp_task) {
+        // 已在运行 恢复轮询并立即开始下一轮
+        xEventGroupSetBits(s_ntp_event, NTP_ONLINE_BIT);
+        xTaskNotifyGive(s_ntp_task);
+        return ESP_OK;
+    }
+    if (!s_ntp_event) {
+        s_ntp_event = xEventGroupCreate();
+        if (!s_ntp_event) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    memset(s_servers, 0, sizeof(s_servers));
+    s_server_num = 0;
+    memset(&s_discipline, 0, sizeof(s_discipline));
+    memset(&s_slew, 0, sizeof(s_slew));
+    s_discipline.freq_ppb = time_service_get_freq_ppb();
+    taskENTER_CRITICAL(&s_stats_mux);
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.poll_s = NTP_POLL_MIN_S;
+    taskEXIT_CRITICAL(&s_stats_mux);
+
+    char names[NTP_MAX_SERVERS][NTP_SERVER_NAME_LEN];
+    for (int i = 0; i < num; i++) {
+        strlcpy(names[i], servers[i], NTP_SERVER_NAME_LEN);
+    }
+    ntp_set_servers(names, num);
+    xEventGroupSetBits(s_ntp_event, NTP_ONLINE_BIT);
+
+    if (xTaskCreate(ntp_client_task, "ntp_client", NTP_CLIENT_STACK_SIZE, NULL,
+                    NTP_CLIENT_PRIORITY, &s_ntp_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ntp_client_set_servers(const char *const servers[], int num) {
+    if (!servers || num <= 0 || num > NTP_MAX_SERVERS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_ntp_task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    taskENTER_CRITICAL(&s_stats_mux);
+    for (int i = 0; i < num; i++) {
+        strlcpy(s_pending[i], servers[i], NTP_SERVER_NAME_LEN);
+    }
+    s_pending_num = num;
+    s_pending_set = true;
+    taskEXIT_CRITICAL(&s_stats_mux);
+    xTaskNotifyGive(s_ntp_task);
+    return ESP_OK;
+}
+
+void ntp_client_stop(void) {
+    if (s_ntp_event) {
+        xEventGroupClearBits(s_ntp_event, NTP_ONLINE_BIT);
+    }
+}
+
+esp_err_t ntp_client_wait_sync(TickType_t timeout) {
+    if (!s_ntp_event) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    EventBits_t bits = xEventGroupWaitBits(s_ntp_event, NTP_SYNCED_BIT, pdFALSE, pdTRUE, timeout);
+    return (bits & NTP_SYNCED_BIT) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+void ntp_client_get_stats(ntp_client_stats_t *stats) {
+    taskENTER_CRITICAL(&s_stats_mux);
+    *stats = s_stats;
+    taskEXIT_CRITICAL(&s_stats_mux);
+}
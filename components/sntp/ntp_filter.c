@@ -0,0 +1,205 @@
+#include <string.h>
+#include "ntp_filter.h"
+
+// 64位NTP时间戳(1900年起, 32位秒+32位小数)与UTC微秒互转
+static void ntp_write_ts(uint8_t *p, int64_t utc_us) {
+    uint32_t sec = (uint32_t)(utc_us / 1000000 + NTP_UNIX_OFFSET);
+    uint32_t frac = (uint32_t)(((uint64_t)(utc_us % 1000000) << 32) / 1000000);
+    for (int i = 0; i < 4; i++) {
+        p[i] = sec >> (24 - 8 * i);
+        p[4 + i] = frac >> (24 - 8 * i);
+    }
+}
+
+static int64_t ntp_read_ts(const uint8_t *p) {
+    uint32_t sec = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    uint32_t frac = ((uint32_t)p[4] << 24) | ((uint32_t)p[5] << 16) | ((uint32_t)p[6] << 8) | p[7];
+    return ((int64_t)sec - NTP_UNIX_OFFSET) * 1000000 + (int64_t)(((uint64_t)frac * 1000000) >> 32);
+}
+
+void ntp_build_request(uint8_t *packet, int64_t tx_us) {
+    memset(packet, 0, NTP_PACKET_SIZE);
+    packet[0] = (0 << 6) | (4 << 3) | 3; // LI=0, VN=4, Mode=3(客户端)
+    ntp_write_ts(packet + 40, tx_us);    // 发送时间戳 服务器会填入originate字段
+}
+
+bool ntp_parse_response(const uint8_t *packet, int len, int64_t t1_us, int64_t t4_us, ntp_sample_t *sample) {
+    if (len < NTP_PACKET_SIZE) {
+        return false;
+    }
+    uint8_t li = packet[0] >> 6;
+    uint8_t mode = packet[0] & 0x07;
+    uint8_t stratum = packet[1];
+    if (mode != 4 || li == 3 || stratum == 0 || stratum > 15) {
+        return false; // 不是服务器应答, 服务器未同步或为KoD报文
+    }
+    // originate必须与本次请求的发送时间戳一致, 否则是过期或伪造的应答
+    uint8_t expect[8];
+    ntp_write_ts(expect, t1_us);
+    if (memcmp(packet + 24, expect, 8) != 0) {
+        return false;
+    }
+
+    int64_t t2 = ntp_read_ts(packet + 32); // 服务器接收时刻
+    int64_t t3 = ntp_read_ts(packet + 40); // 服务器发送时刻
+    sample->offset_us = ((t2 - t1_us) + (t3 - t4_us)) / 2;
+    sample->delay_us = (t4_us - t1_us) - (t3 - t2);
+    if (sample->delay_us < 0) {
+        sample->delay_us = 0;
+    }
+    sample->time_us = t4_us;
+    return true;
+}
+
+void ntp_filter_reset(ntp_filter_t *filter) {
+    memset(filter, 0, sizeof(ntp_filter_t));
+}
+
+// 选出最小延迟样本, 计算抖动
+static void ntp_filter_select(ntp_filter_t *filter) {
+    int best = 0;
+    for (int i = 1; i < filter->count; i++) {
+        if (filter->samples[i].delay_us < filter->samples[best].delay_us) {
+            best = i;
+        }
+    }
+    filter->offset_us = filter->samples[best].offset_us;
+    filter->delay_us = filter->samples[best].delay_us;
+
+    uint64_t sum = 0;
+    for (int i = 0; i < filter->count; i++) {
+        int64_t d = filter->samples[i].offset_us - filter->offset_us;
+        sum += (uint64_t)(d * d);
+    }
+    uint64_t mean = filter->count > 1 ? sum / (filter->count - 1) : 0;
+
+    // 整数平方根
+    uint64_t root = 0, bit = 1ULL << 62;
+    while (bit > mean) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (mean >= root + bit) {
+            mean -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    filter->jitter_us = root > UINT32_MAX ? UINT32_MAX : (uint32_t)root;
+}
+
+void ntp_filter_add(ntp_filter_t *filter, const ntp_sample_t *sample) {
+    filter->samples[filter->next] = *sample;
+    filter->next = (filter->next + 1) % NTP_FILTER_STAGES;
+    if (filter->count < NTP_FILTER_STAGES) {
+        filter->count++;
+    }
+    filter->reach = (filter->reach << 1) | 1;
+    ntp_filter_select(filter);
+}
+
+void ntp_filter_miss(ntp_filter_t *filter) {
+    filter->reach <<= 1;
+}
+
+void ntp_filter_shift(ntp_filter_t *filter, int64_t delta_us) {
+    for (int i = 0; i < filter->count; i++) {
+        filter->samples[i].offset_us -= delta_us;
+    }
+    filter->offset_us -= delta_us;
+}
+
+int64_t ntp_slew_done(const ntp_slew_t *slew, int64_t time_us) {
+    int64_t dt = time_us - slew->start_us;
+    int64_t done = dt > 0 ? dt * NTP_SLEW_PPM / 1000000 : 0;
+    if (slew->amount_us >= 0) {
+        return done < slew->amount_us ? done : slew->amount_us;
+    }
+    return -done > slew->amount_us ? -done : slew->amount_us;
+}
+
+void ntp_filter_follow(ntp_filter_t *filter, const ntp_slew_t *slew, int64_t time_us) {
+    int64_t done = ntp_slew_done(slew, time_us);
+    ntp_filter_shift(filter, done - filter->slewed_us);
+    filter->slewed_us = done;
+}
+
+void ntp_filter_correct(ntp_filter_t *filter, int64_t step_us) {
+    ntp_filter_shift(filter, step_us);
+    filter->slewed_us = 0;
+}
+
+int ntp_combine(const ntp_filter_t *filters, int num, int64_t *offset_us, uint32_t *jitter_us, uint32_t *selected) {
+    uint64_t best_dist = UINT64_MAX;
+    for (int i = 0; i < num; i++) {
+        if (filters[i].reach && filters[i].count) {
+            uint64_t dist = filters[i].delay_us / 2 + filters[i].jitter_us + 1;
+            if (dist < best_dist) {
+                best_dist = dist;
+            }
+        }
+    }
+    if (best_dist == UINT64_MAX) {
+        return 0;
+    }
+
+    // 按距离倒数加权: 权重 = 2^20 / 距离
+    int64_t sum_offset = 0;
+    uint64_t sum_weight = 0, sum_jitter = 0;
+    uint32_t mask = 0;
+    int used = 0;
+    for (int i = 0; i < num; i++) {
+        if (!filters[i].reach || !filters[i].count) {
+            continue;
+        }
+        uint64_t dist = filters[i].delay_us / 2 + filters[i].jitter_us + 1;
+        if (dist > best_dist * 2) {
+            continue;
+        }
+        uint64_t weight = (1ULL << 20) / dist + 1;
+        sum_offset += filters[i].offset_us * (int64_t)weight;
+        sum_jitter += filters[i].jitter_us * weight;
+        sum_weight += weight;
+        mask |= 1U << i;
+        used++;
+    }
+    if (selected) {
+        *selected = mask;
+    }
+    *offset_us = sum_offset / (int64_t)sum_weight;
+    *jitter_us = sum_jitter / sum_weight;
+    return used;
+}
+
+int32_t ntp_discipline_update(ntp_discipline_t *disc, int64_t offset_us, int64_t now_us) {
+    if (disc->primed) {
+        int64_t dt = now_us - disc->last_time_us;
+        if (dt >= NTP_MIN_FLL_US) {
+            // 上次的偏差在dt内已被平滑修正的部分
+            int64_t last = disc->last_offset_us;
+            int64_t slewed = dt * NTP_SLEW_PPM / 1000000;
+            int64_t residual = last > slewed ? last - slewed : (last < -slewed ? last + slewed : 0);
+            // 剩余偏差的变化量即为频差累积的结果 (us/us * 1e9 = ppb)
+            int64_t err_ppb = (offset_us - residual) * 1000000000 / dt;
+            int64_t freq = disc->freq_ppb + err_ppb / NTP_FLL_GAIN;
+            if (freq > NTP_MAX_FREQ_PPB) {
+                freq = NTP_MAX_FREQ_PPB;
+            } else if (freq < -NTP_MAX_FREQ_PPB) {
+                freq = -NTP_MAX_FREQ_PPB;
+            }
+            disc->freq_ppb = (int32_t)freq;
+        } else {
+            return disc->freq_ppb; // 间隔太短, 保留上一次的基准
+        }
+    }
+    disc->last_time_us = now_us;
+    disc->last_offset_us = offset_us;
+    disc->primed = true;
+    return disc->freq_ppb;
+}
+
+void ntp_discipline_step(ntp_discipline_t *disc) {
+    disc->primed = false;
+}
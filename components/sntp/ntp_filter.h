@@ -0,0 +1,85 @@
+#ifndef __NTP_FILTER_H__
+#define __NTP_FILTER_H__
+
+// NTP报文解析、时钟滤波与频率锁定 不依赖ESP-IDF, 可在主机上单独编译
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NTP_PACKET_SIZE      48
+#define NTP_FILTER_STAGES    8           // 每个服务器保留的样本数
+#define NTP_UNIX_OFFSET      2208988800U // 1900到1970的秒数
+
+#define NTP_FLL_GAIN         4           // 频率锁定增益 每次修正测得频差的1/4
+#define NTP_MAX_FREQ_PPB     500000      // 频率修正上限 (500ppm)
+#define NTP_SLEW_PPM         500         // 相位平滑调整速率 与时间服务一致
+#define NTP_MIN_FLL_US       8000000     // 两次偏差间隔小于此值时不做频率估计
+
+// 一次测量
+typedef struct {
+    int64_t offset_us;   // 本地时钟相对服务器的偏差 (正值表示本地慢)
+    int64_t delay_us;    // 往返延迟
+    int64_t time_us;     // 测量时刻 (本地UTC)
+} ntp_sample_t;
+
+// 单个服务器的时钟滤波器
+typedef struct {
+    ntp_sample_t samples[NTP_FILTER_STAGES];
+    uint8_t count;       // 有效样本数
+    uint8_t next;        // 下一个写入位置
+    uint8_t reach;       // 最近8次请求的应答位图
+    int64_t offset_us;   // 滤波结果: 最小延迟样本的偏差
+    int64_t delay_us;    // 滤波结果: 最小延迟
+    uint32_t jitter_us;  // 其余样本相对最优样本的均方根偏差
+    int64_t slewed_us;   // 当前平滑调整中已计入样本的部分
+} ntp_filter_t;
+
+// 进行中的相位平滑调整 与时间服务一致以NTP_SLEW_PPM进行, 新的校正会丢弃未完成的部分
+typedef struct {
+    int64_t start_us;    // 开始时刻 (本地UTC)
+    int64_t amount_us;   // 调整总量 (带符号, 0表示没有)
+} ntp_slew_t;
+
+// 频率锁定环路状态
+typedef struct {
+    int32_t freq_ppb;    // 当前频率修正
+    int64_t last_time_us;// 上次修正时刻
+    int64_t last_offset_us;
+    bool primed;         // 是否已有上一次的偏差
+} ntp_discipline_t;
+
+// 生成客户端请求 tx_us为本地发送时刻(UTC us), 服务器会原样带回
+void ntp_build_request(uint8_t *packet, int64_t tx_us);
+
+// 解析服务器应答 t1/t4为本地发送/接收时刻, 成功返回true并填写样本
+bool ntp_parse_response(const uint8_t *packet, int len, int64_t t1_us, int64_t t4_us, ntp_sample_t *sample);
+
+void ntp_filter_reset(ntp_filter_t *filter);
+void ntp_filter_add(ntp_filter_t *filter, const ntp_sample_t *sample);
+void ntp_filter_miss(ntp_filter_t *filter);
+
+// 本地时钟被修正delta_us后, 已有样本的偏差随之平移
+void ntp_filter_shift(ntp_filter_t *filter, int64_t delta_us);
+
+// 平滑调整到time_us为止已完成的量
+int64_t ntp_slew_done(const ntp_slew_t *slew, int64_t time_us);
+
+// 把平滑调整到time_us为止完成的部分计入已有样本 加入time_us时刻的新样本之前调用
+void ntp_filter_follow(ntp_filter_t *filter, const ntp_slew_t *slew, int64_t time_us);
+
+// 开始新的校正: 跳变step_us立即计入已有样本, 平滑调整之后由ntp_filter_follow按进度计入
+// 调用前应已用ntp_filter_follow计入上一次平滑调整到校正时刻为止的部分
+void ntp_filter_correct(ntp_filter_t *filter, int64_t step_us);
+
+// 从多个服务器中合成偏差 以延迟/2+抖动为距离, 按距离倒数加权
+// 只有距离不超过最优服务器2倍的服务器参与, selected为参与者位图(可为NULL), 返回参与的服务器数
+int ntp_combine(const ntp_filter_t *filters, int num, int64_t *offset_us, uint32_t *jitter_us, uint32_t *selected);
+
+// 频率锁定 每次偏差都会以NTP_SLEW_PPM平滑修正, 扣除期间已修正的部分后
+// 剩余的偏差变化即为频差, 返回新的频率修正
+int32_t ntp_discipline_update(ntp_discipline_t *disc, int64_t offset_us, int64_t now_us);
+
+// 时钟跳变后调用 跳变前的偏差不再用于频率估计
+void ntp_discipline_step(ntp_discipline_t *disc);
+
+#endif // __NTP_FILTER_H__
@@ -1,8 +1,370 @@
 #include "sntp.h"
 
+// 时钟状态使用顺序锁保护: 写者在临界区内更新(奇数表示正在写), 读者不加锁, 读到一致的副本为止
+static time_clock_t s_clock;
+static atomic_uint s_clock_seq = 0;
+static portMUX_TYPE s_clock_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool s_synced = false;
+static time_source_t s_source = TIME_SOURCE_NONE;
 
-void get_time(time_t now, char* strftime_buf, struct tm timeinfo){
+// 软件复位后保留
+static RTC_NOINIT_ATTR time_persist_t s_persist;
+static int64_t s_nvs_saved_mono = 0;
+static bool s_nvs_saved = false;
 
+// 时区 缓存在转换时更新, 由临界区保护
+static time_zone_t s_tz;
+static bool s_tz_valid = false;
+static portMUX_TYPE s_tz_mux = portMUX_INITIALIZER_UNLOCKED;
 
-    
+// 订阅者
+typedef struct {
+    time_tick_t tick;
+    time_tick_cb_t cb;
+    void *arg;
+} time_subscriber_t;
+
+static time_subscriber_t s_subscribers[TIME_MAX_SUBSCRIBERS];
+static int s_subscriber_num = 0;
+static portMUX_TYPE s_subscriber_mux = portMUX_INITIALIZER_UNLOCKED;
+static esp_timer_handle_t s_tick_timer = NULL;
+static int64_t s_next_tick_sec = 0;
+
+
+// 读取一致的时钟状态副本
+static void time_clock_load(time_clock_t *clock) {
+    unsigned seq;
+    do {
+        seq = atomic_load_explicit(&s_clock_seq, memory_order_acquire);
+        if (seq & 1) {
+            continue;
+        }
+        *clock = s_clock;
+        atomic_thread_fence(memory_order_acquire);
+    } while ((seq & 1) || seq != atomic_load_explicit(&s_clock_seq, memory_order_relaxed));
+}
+
+// 更新时钟状态 (写者之间由临界区互斥)
+static void time_clock_store(const time_clock_t *clock) {
+    atomic_fetch_add_explicit(&s_clock_seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    s_clock = *clock;
+    atomic_fetch_add_explicit(&s_clock_seq, 1, memory_order_release);
+}
+
+// 按时钟状态计算某一单调时间对应的UTC
+static int64_t time_clock_utc(const time_clock_t *clock, int64_t mono) {
+    int64_t dt = mono - clock->mono0;
+    int64_t dslew = dt < clock->slew_len ? dt : clock->slew_len;
+    return clock->utc0 + dt + dt * clock->freq_ppb / 1000000000 + dslew * clock->slew_ppm / 1000000;
+}
+
+int64_t time_service_now_us(void) {
+    time_clock_t clock;
+    time_clock_load(&clock);
+    return time_clock_utc(&clock, esp_timer_get_time());
+}
+
+void time_service_now(struct timeval *tv) {
+    int64_t now = time_service_now_us();
+    tv->tv_sec = now / 1000000;
+    tv->tv_usec = now % 1000000;
+}
+
+bool time_service_is_synced(void) {
+    return s_synced;
+}
+
+time_source_t time_service_get_source(void) {
+    return s_source;
+}
+
+static uint32_t time_persist_crc(const time_persist_t *persist) {
+    return esp_rom_crc32_le(0, (const uint8_t *)persist, offsetof(time_persist_t, crc));
+}
+
+// 把当前时钟锚定到RTC计时器 每次校正后调用, 只写内存, 开销很小
+static void time_persist_rtc(void) {
+    time_clock_t clock;
+    time_clock_load(&clock);
+    uint64_t rtc = esp_rtc_get_time_us();
+    time_persist_t persist = {
+        .magic = TIME_PERSIST_MAGIC,
+        .rtc_us = rtc,
+        .utc_us = time_clock_utc(&clock, esp_timer_get_time()),
+        .freq_ppb = clock.freq_ppb,
+    };
+    persist.crc = time_persist_crc(&persist);
+    s_persist = persist;
+}
+
+// 保存到NVS 首次同步后立即保存, 之后按间隔限速
+static void time_persist_nvs(bool force) {
+    int64_t mono = esp_timer_get_time();
+    if (!force && s_nvs_saved && mono - s_nvs_saved_mono < TIME_NVS_SAVE_INTERVAL_US) {
+        return;
+    }
+    nvs_handle_t handle;
+    if (nvs_open(TIME_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    nvs_set_i64(handle, "utc_us", time_service_now_us());
+    nvs_set_i32(handle, "freq_ppb", time_service_get_freq_ppb());
+    if (nvs_commit(handle) == ESP_OK) {
+        s_nvs_saved = true;
+        s_nvs_saved_mono = mono;
+    }
+    nvs_close(handle);
+}
+
+// 恢复启动时的时钟 返回时间来源
+static time_source_t time_restore(time_clock_t *clock) {
+    esp_reset_reason_t reason = esp_reset_reason();
+    uint64_t rtc = esp_rtc_get_time_us();
+
+    // RTC内存在上电/掉电复位后无效
+    if (reason != ESP_RST_POWERON && reason != ESP_RST_BROWNOUT &&
+        s_persist.magic == TIME_PERSIST_MAGIC && s_persist.crc == time_persist_crc(&s_persist) &&
+        rtc >= s_persist.rtc_us) {
+        int64_t elapsed = rtc - s_persist.rtc_us;
+        clock->utc0 = s_persist.utc_us + elapsed + elapsed * s_persist.freq_ppb / 1000000000;
+        clock->freq_ppb = s_persist.freq_ppb;
+        return TIME_SOURCE_RTC;
+    }
+
+    nvs_handle_t handle;
+    if (nvs_flash_init() != ESP_OK || nvs_open(TIME_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return TIME_SOURCE_NONE;
+    }
+    time_source_t source = TIME_SOURCE_NONE;
+    int64_t utc_us;
+    int32_t freq_ppb;
+    if (nvs_get_i32(handle, "freq_ppb", &freq_ppb) == ESP_OK) {
+        clock->freq_ppb = freq_ppb;
+    }
+    // 断电时长未知, 保存的时间只能作为下限
+    if (nvs_get_i64(handle, "utc_us", &utc_us) == ESP_OK && utc_us > clock->utc0) {
+        clock->utc0 = utc_us;
+        source = TIME_SOURCE_NVS;
+    }
+    nvs_close(handle);
+    return source;
+}
+
+// 同步libc的系统时间 time()/gettimeofday()和FATFS时间戳都以它为准
+// 跳变或偏差过大时直接设置, 否则交给adjtime平滑调整 (偏差按系统时间自身计算, 它不含频率修正)
+static void time_system_sync(int64_t utc_us, bool step) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    int64_t delta = utc_us - ((int64_t)now.tv_sec * 1000000 + now.tv_usec);
+    if (step || delta > TIME_STEP_THRESHOLD_US || delta < -TIME_STEP_THRESHOLD_US) {
+        struct timeval tv = {
+            .tv_sec = utc_us / 1000000,
+            .tv_usec = utc_us % 1000000,
+        };
+        settimeofday(&tv, NULL);
+    } else if (delta) {
+        struct timeval adj = {
+            .tv_sec = delta / 1000000,
+            .tv_usec = delta % 1000000,
+        };
+        adjtime(&adj, NULL);
+    }
+}
+
+// 重新安排下一个秒边界 时钟跳变后也需要调用
+static void time_tick_schedule(void) {
+    if (!s_tick_timer) {
+        return;
+    }
+    int64_t now = time_service_now_us();
+    s_next_tick_sec = now / 1000000 + 1;
+    esp_timer_stop(s_tick_timer);
+    esp_timer_start_once(s_tick_timer, s_next_tick_sec * 1000000 - now);
+}
+
+// 秒边界定时器回调
+static void time_tick_cb(void *arg) {
+    int64_t now = time_service_now_us();
+    int64_t target = s_next_tick_sec * 1000000;
+    if (now < target) {
+        // 平滑调整期间单调时间与UTC略有差异, 提前触发时补足剩余时间
+        esp_timer_start_once(s_tick_timer, target - now);
+        return;
+    }
+
+    time_t sec = s_next_tick_sec;
+    time_subscriber_t subscribers[TIME_MAX_SUBSCRIBERS];
+    taskENTER_CRITICAL(&s_subscriber_mux);
+    int num = s_subscriber_num;
+    memcpy(subscribers, s_subscribers, sizeof(time_subscriber_t) * num);
+    taskEXIT_CRITICAL(&s_subscriber_mux);
+
+    for (int i = 0; i < num; i++) {
+        if (subscribers[i].tick == TIME_TICK_SECOND || (subscribers[i].tick == TIME_TICK_MINUTE && sec % 60 == 0)) {
+            subscribers[i].cb(subscribers[i].tick, sec, subscribers[i].arg);
+        }
+    }
+
+    s_next_tick_sec = now / 1000000 + 1;
+    int64_t delay = s_next_tick_sec * 1000000 - time_service_now_us();
+    esp_timer_start_once(s_tick_timer, delay > 0 ? delay : 0);
+}
+
+void time_service_init(void) {
+    if (s_tick_timer) {
+        return;
+    }
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    time_clock_t clock = {
+        .mono0 = esp_timer_get_time(),
+        .utc0 = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec,
+    };
+    s_source = time_restore(&clock);
+    taskENTER_CRITICAL(&s_clock_mux);
+    time_clock_store(&clock);
+    taskEXIT_CRITICAL(&s_clock_mux);
+    time_persist_rtc();
+    if (s_source != TIME_SOURCE_NONE) {
+        time_system_sync(clock.utc0, false);
+    }
+
+    static const char *const source_name[] = { "无", "NVS", "RTC", "NTP" };
+    ESP_LOGI(TAG, "启动时间来源 %s, 频率修正 %ldppb, 耗时 %lldus",
+             source_name[s_source], (long)clock.freq_ppb, esp_timer_get_time());
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = time_tick_cb,
+        .name = "time_tick",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_tick_timer));
+    time_tick_schedule();
+}
+
+bool time_service_correct(int64_t utc_us) {
+    bool stepped;
+    int64_t err;
+
+    taskENTER_CRITICAL(&s_clock_mux);
+    time_clock_t clock;
+    time_clock_load(&clock);
+    int64_t mono = esp_timer_get_time();
+    int64_t local = time_clock_utc(&clock, mono);
+    err = utc_us - local;
+
+    // 以当前时刻重新设定基准, 保留频率修正, 丢弃未完成的平滑调整
+    clock.mono0 = mono;
+    clock.utc0 = local;
+    clock.slew_ppm = 0;
+    clock.slew_len = 0;
+    // RTC恢复的时间误差通常只有毫秒级, 可以直接平滑调整
+    stepped = s_source < TIME_SOURCE_RTC || err > TIME_STEP_THRESHOLD_US || err < -TIME_STEP_THRESHOLD_US;
+    if (stepped) {
+        clock.utc0 = utc_us;
+    } else if (err) {
+        clock.slew_ppm = err > 0 ? TIME_SLEW_RATE_PPM : -TIME_SLEW_RATE_PPM;
+        clock.slew_len = (err > 0 ? err : -err) * 1000000 / TIME_SLEW_RATE_PPM;
+    }
+    time_clock_store(&clock);
+    bool first = !s_synced;
+    s_synced = true;
+    s_source = TIME_SOURCE_NTP;
+    taskEXIT_CRITICAL(&s_clock_mux);
+
+    ESP_LOGI(TAG, "时钟校正 %s %lldus", stepped ? "跳变" : "平滑调整", err);
+    time_system_sync(utc_us, stepped);
+    time_persist_rtc();
+    time_persist_nvs(first);
+    if (stepped) {
+        time_tick_schedule();
+    }
+    return stepped;
+}
+
+void time_service_set_freq_ppb(int32_t freq_ppb) {
+    taskENTER_CRITICAL(&s_clock_mux);
+    time_clock_t clock;
+    time_clock_load(&clock);
+    int64_t mono = esp_timer_get_time();
+    int64_t dt = mono - clock.mono0;
+
+    // 以当前时刻重新设定基准, 未完成的平滑调整继续进行
+    clock.utc0 = time_clock_utc(&clock, mono);
+    clock.mono0 = mono;
+    clock.slew_len = clock.slew_len > dt ? clock.slew_len - dt : 0;
+    clock.freq_ppb = freq_ppb;
+    time_clock_store(&clock);
+    taskEXIT_CRITICAL(&s_clock_mux);
+    time_persist_rtc();
+}
+
+int32_t time_service_get_freq_ppb(void) {
+    time_clock_t clock;
+    time_clock_load(&clock);
+    return clock.freq_ppb;
+}
+
+esp_err_t time_service_set_timezone(const char *posix_tz) {
+    time_zone_t tz;
+    if (!time_zone_parse(&tz, posix_tz)) {
+        ESP_LOGE(TAG, "无效的时区 %s", posix_tz ? posix_tz : "(null)");
+        return ESP_ERR_INVALID_ARG;
+    }
+    taskENTER_CRITICAL(&s_tz_mux);
+    s_tz = tz;
+    s_tz_valid = true;
+    taskEXIT_CRITICAL(&s_tz_mux);
+
+    setenv("TZ", posix_tz, 1);
+    tzset();
+    return ESP_OK;
+}
+
+void time_service_localtime(time_t utc_sec, struct tm *tm) {
+    taskENTER_CRITICAL(&s_tz_mux);
+    if (s_tz_valid) {
+        time_zone_localtime(&s_tz, utc_sec, tm);
+        taskEXIT_CRITICAL(&s_tz_mux);
+        return;
+    }
+    taskEXIT_CRITICAL(&s_tz_mux);
+    localtime_r(&utc_sec, tm);
+}
+
+void time_service_sntp_sync_cb(struct timeval *tv) {
+    time_service_correct((int64_t)tv->tv_sec * 1000000 + tv->tv_usec);
+}
+
+esp_err_t time_service_subscribe(time_tick_t tick, time_tick_cb_t cb, void *arg) {
+    if (!cb) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t ret = ESP_OK;
+    taskENTER_CRITICAL(&s_subscriber_mux);
+    if (s_subscriber_num < TIME_MAX_SUBSCRIBERS) {
+        s_subscribers[s_subscriber_num++] = (time_subscriber_t) {
+            .tick = tick,
+            .cb = cb,
+            .arg = arg,
+        };
+    } else {
+        ret = ESP_ERR_NO_MEM;
+    }
+    taskEXIT_CRITICAL(&s_subscriber_mux);
+    return ret;
+}
+
+esp_err_t time_service_unsubscribe(time_tick_cb_t cb, void *arg) {
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    taskENTER_CRITICAL(&s_subscriber_mux);
+    for (int i = 0; i < s_subscriber_num; i++) {
+        if (s_subscribers[i].cb == cb && s_subscribers[i].arg == arg) {
+            s_subscribers[i] = s_subscribers[--s_subscriber_num];
+            ret = ESP_OK;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&s_subscriber_mux);
+    return ret;
 }
@@ -1,10 +1,154 @@
 #ifndef __ESP_SNTP__
 #define __ESP_SNTP__
 
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "esp_rtc_time.h"
+#include "esp_rom_crc.h"
+#include "nvs_flash.h"
+#include "nvs.h"
 #include "esp_sntp.h"
 #include "esp_netif_sntp.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "ntp_filter.h"
+#include "time_zone.h"
 
 #define TAG "sntp"
 
+#define TIME_STEP_THRESHOLD_US  128000  // 误差超过此值直接跳变, 否则平滑调整
+#define TIME_SLEW_RATE_PPM      500     // 平滑调整速率 (最多每秒调整500us)
+#define TIME_MAX_SUBSCRIBERS    8       // 最大订阅者数
 
-#endif //  __ESP_SNTP__
\ No newline at end of file
+#define TIME_PERSIST_MAGIC      0x54494d45  // "TIME"
+#define TIME_NVS_NAMESPACE      "time"
+#define TIME_NVS_SAVE_INTERVAL_US (6LL * 3600 * 1000000)  // NVS写入间隔 避免频繁擦写flash
+
+// 时钟状态 UTC(mono) = utc0 + dt + dt * freq_ppb / 1e9 + 平滑调整量, dt = mono - mono0
+typedef struct {
+    int64_t mono0;       // 基准单调时间 (esp_timer, us)
+    int64_t utc0;        // 基准时刻的UTC (us)
+    int32_t freq_ppb;    // 频率修正 (ppb)
+    int32_t slew_ppm;    // 平滑调整速率 (带符号, ppm)
+    int64_t slew_len;    // 平滑调整持续时间 (单调时间, us)
+} time_clock_t;
+
+// 当前时间的来源
+typedef enum {
+    TIME_SOURCE_NONE = 0,  // 无可用时间 (1970年起)
+    TIME_SOURCE_NVS,       // 断电前保存的时间 只是下限, 断电时长未知
+    TIME_SOURCE_RTC,       // 软件复位/深度睡眠前的时间 + RTC计时器经过的时间
+    TIME_SOURCE_NTP,       // 已与服务器同步
+} time_source_t;
+
+// 复位后仍保留的时间锚点 (RTC慢速内存, 上电后内容随机, 以magic和crc校验)
+typedef struct {
+    uint32_t magic;
+    uint64_t rtc_us;     // 锚点的RTC时间
+    int64_t utc_us;      // 锚点的UTC
+    int32_t freq_ppb;
+    uint32_t crc;
+} time_persist_t;
+
+// 订阅的时间边界
+typedef enum {
+    TIME_TICK_SECOND = 0,  // 每秒整点
+    TIME_TICK_MINUTE,      // 每分钟整点
+} time_tick_t;
+
+// 边界回调 在esp_timer任务中执行, 应尽快返回 (例如只发通知)
+typedef void (*time_tick_cb_t)(time_tick_t tick, time_t utc_sec, void *arg);
+
+// 初始化时间服务 优先从RTC内存恢复, 其次从NVS恢复时间与晶振漂移
+void time_service_init(void);
+time_source_t time_service_get_source(void);
+
+// 读取UTC时间 不加锁, 可在任意任务中调用
+int64_t time_service_now_us(void);
+void time_service_now(struct timeval *tv);
+bool time_service_is_synced(void);   // 是否已与NTP同步 (恢复的时间不算)
+
+// 用测得的真实时间校正时钟 误差小时平滑调整, 大时跳变 跳变时返回true
+// libc的系统时间随之更新 (跳变用settimeofday, 平滑调整用adjtime)
+bool time_service_correct(int64_t utc_us);
+
+// 设置频率修正 (ppb), 不影响正在进行的平滑调整
+void time_service_set_freq_ppb(int32_t freq_ppb);
+int32_t time_service_get_freq_ppb(void);
+
+// 设置时区 (POSIX TZ字符串, 如 "CST-8"), 同时更新libc的TZ
+esp_err_t time_service_set_timezone(const char *posix_tz);
+
+// UTC秒转本地时间 使用缓存的时区偏移, 比localtime_r快一个数量级
+void time_service_localtime(time_t utc_sec, struct tm *tm);
+
+// SNTP同步回调 用作esp_sntp_config_t.sync_cb
+void time_service_sntp_sync_cb(struct timeval *tv);
+
+// 订阅秒/分钟边界
+esp_err_t time_service_subscribe(time_tick_t tick, time_tick_cb_t cb, void *arg);
+esp_err_t time_service_unsubscribe(time_tick_cb_t cb, void *arg);
+
+
+// ---------------- 多服务器NTP客户端 ----------------
+
+#define NTP_MAX_SERVERS         4
+#define NTP_SERVER_NAME_LEN     64
+#define NTP_PORT                123
+#define NTP_RECV_TIMEOUT_MS     1000    // 单次请求的应答超时
+#define NTP_POLL_MIN_S          16      // 最短轮询间隔
+#define NTP_POLL_MAX_S          1024    // 最长轮询间隔
+#define NTP_CLIENT_STACK_SIZE   4096
+#define NTP_CLIENT_PRIORITY     4
+
+// 单个服务器的状态
+typedef struct {
+    const char *name;
+    uint8_t reach;       // 最近8次请求的应答位图
+    int64_t offset_us;   // 滤波后的偏差
+    int64_t delay_us;    // 滤波后的往返延迟
+    uint32_t jitter_us;
+    bool selected;       // 最近一次合成时是否被采用
+} ntp_server_stats_t;
+
+// 客户端统计
+typedef struct {
+    int64_t offset_us;   // 最近一次合成的偏差
+    uint32_t jitter_us;  // 最近一次合成的抖动
+    int32_t freq_ppb;    // 当前频率修正 (晶振漂移估计)
+    uint32_t poll_s;     // 当前轮询间隔
+    uint32_t polls;      // 发出的请求数
+    uint32_t responses;  // 有效应答数
+    uint32_t timeouts;   // 超时或无效应答数
+    uint32_t steps;      // 跳变次数
+    uint32_t slews;      // 平滑调整次数
+    int server_num;
+    ntp_server_stats_t servers[NTP_MAX_SERVERS];
+} ntp_client_stats_t;
+
+// 启动NTP客户端任务 服务器名会被复制
+// 任务已在运行时只恢复轮询 (服务器列表不变), 可在网络连通回调中反复调用
+esp_err_t ntp_client_start(const char *const servers[], int num);
+
+// 运行中替换服务器列表 在下一轮轮询前生效, 名字未变的服务器保留滤波器状态
+esp_err_t ntp_client_set_servers(const char *const servers[], int num);
+
+// 暂停轮询 (网络断开时调用), 时钟继续按已估计的频率运行
+void ntp_client_stop(void);
+
+// 等待首次同步 成功返回ESP_OK, 超时返回ESP_ERR_TIMEOUT
+esp_err_t ntp_client_wait_sync(TickType_t timeout);
+
+void ntp_client_get_stats(ntp_client_stats_t *stats);
+
+#endif //  __ESP_SNTP__
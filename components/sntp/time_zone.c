@@ -0,0 +1,303 @@
+#include <string.h>
+#include <ctype.h>
+#include "time_zone.h"
+
+#define SECS_PER_DAY 86400
+
+// 公历日期与1970-01-01起天数互转 (H. Hinnant算法, 无查表)
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+static void civil_from_days(int64_t z, int64_t *y, unsigned *m, unsigned *d) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    *d = doy - (153 * mp + 2) / 5 + 1;
+    *m = mp < 10 ? mp + 3 : mp - 9;
+    *y = (int64_t)yoe + era * 400 + (*m <= 2);
+}
+
+static bool is_leap(int64_t y) {
+    return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+static int64_t floor_div(int64_t a, int64_t b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// ---------------- 解析 ----------------
+
+static const char *tz_parse_name(const char *p, char *name) {
+    const char *start = p;
+    size_t len;
+    if (*p == '<') {
+        start = ++p;
+        while (*p && *p != '>') {
+            p++;
+        }
+        if (*p != '>') {
+            return NULL;
+        }
+        len = p - start;
+        p++;
+    } else {
+        while (isalpha((unsigned char)*p)) {
+            p++;
+        }
+        len = p - start;
+    }
+    if (len < 3) {
+        return NULL;
+    }
+    if (len >= TIME_ZONE_NAME_LEN) {
+        len = TIME_ZONE_NAME_LEN - 1;
+    }
+    memcpy(name, start, len);
+    name[len] = '\0';
+    return p;
+}
+
+static const char *tz_parse_num(const char *p, int min, int max, int *value) {
+    if (!isdigit((unsigned char)*p)) {
+        return NULL;
+    }
+    int v = 0;
+    while (isdigit((unsigned char)*p)) {
+        v = v * 10 + (*p++ - '0');
+        if (v > max) {
+            return NULL;
+        }
+    }
+    if (v < min) {
+        return NULL;
+    }
+    *value = v;
+    return p;
+}
+
+// [+-]hh[:mm[:ss]]
+static const char *tz_parse_time(const char *p, int32_t *sec) {
+    int sign = 1, h, m = 0, s = 0;
+    if (*p == '+' || *p == '-') {
+        sign = *p++ == '-' ? -1 : 1;
+    }
+    if (!(p = tz_parse_num(p, 0, 167, &h))) {
+        return NULL;
+    }
+    if (*p == ':') {
+        if (!(p = tz_parse_num(p + 1, 0, 59, &m))) {
+            return NULL;
+        }
+        if (*p == ':' && !(p = tz_parse_num(p + 1, 0, 59, &s))) {
+            return NULL;
+        }
+    }
+    *sec = sign * (h * 3600 + m * 60 + s);
+    return p;
+}
+
+static const char *tz_parse_rule(const char *p, tz_rule_t *rule) {
+    int v;
+    rule->time = 2 * 3600;  // 默认02:00切换
+    if (*p == 'J') {
+        rule->type = TZ_RULE_JULIAN1;
+        if (!(p = tz_parse_num(p + 1, 1, 365, &v))) {
+            return NULL;
+        }
+        rule->day = v;
+    } else if (*p == 'M') {
+        int m, w, d;
+        rule->type = TZ_RULE_MONTH;
+        if (!(p = tz_parse_num(p + 1, 1, 12, &m)) || *p != '.' ||
+            !(p = tz_parse_num(p + 1, 1, 5, &w)) || *p != '.' ||
+            !(p = tz_parse_num(p + 1, 0, 6, &d))) {
+            return NULL;
+        }
+        rule->month = m;
+        rule->week = w;
+        rule->wday = d;
+    } else {
+        rule->type = TZ_RULE_JULIAN0;
+        if (!(p = tz_parse_num(p, 0, 365, &v))) {
+            return NULL;
+        }
+        rule->day = v;
+    }
+    if (*p == '/') {
+        p = tz_parse_time(p + 1, &rule->time);
+    }
+    return p;
+}
+
+static void tz_cache_clear(time_zone_t *tz) {
+    tz->valid_from = 1;
+    tz->valid_until = 0;
+    tz->day_from = 1;
+    tz->day_until = 0;
+}
+
+bool time_zone_parse(time_zone_t *tz, const char *posix_tz) {
+    time_zone_t zone;
+    memset(&zone, 0, sizeof(zone));
+    const char *p = posix_tz;
+    if (!p || !(p = tz_parse_name(p, zone.std_name)) || !(p = tz_parse_time(p, &zone.std_offset))) {
+        return false;
+    }
+    zone.std_offset = -zone.std_offset;  // POSIX中偏移为西正东负
+    zone.dst_offset = zone.std_offset;
+
+    if (*p) {
+        if (!(p = tz_parse_name(p, zone.dst_name))) {
+            return false;
+        }
+        zone.has_dst = true;
+        zone.dst_offset = zone.std_offset + 3600;
+        if (*p && *p != ',') {
+            if (!(p = tz_parse_time(p, &zone.dst_offset))) {
+                return false;
+            }
+            zone.dst_offset = -zone.dst_offset;
+        }
+        if (*p == ',') {
+            if (!(p = tz_parse_rule(p + 1, &zone.start)) || *p != ',' ||
+                !(p = tz_parse_rule(p + 1, &zone.end))) {
+                return false;
+            }
+        } else {
+            // 未给出规则时与newlib一致, 使用美国规则
+            zone.start = (tz_rule_t) { .type = TZ_RULE_MONTH, .month = 3, .week = 2, .wday = 0, .time = 7200 };
+            zone.end = (tz_rule_t) { .type = TZ_RULE_MONTH, .month = 11, .week = 1, .wday = 0, .time = 7200 };
+        }
+    }
+    if (*p) {
+        return false;
+    }
+    tz_cache_clear(&zone);
+    *tz = zone;
+    return true;
+}
+
+// ---------------- 转换 ----------------
+
+// 规则在year年对应的切换时刻 (UTC), offset为切换前的偏移
+static int64_t tz_rule_utc(const tz_rule_t *rule, int64_t year, int32_t offset) {
+    int64_t days;
+    if (rule->type == TZ_RULE_JULIAN1) {
+        days = days_from_civil(year, 1, 1) + rule->day - 1 + (is_leap(year) && rule->day >= 60);
+    } else if (rule->type == TZ_RULE_JULIAN0) {
+        days = days_from_civil(year, 1, 1) + rule->day;
+    } else {
+        static const uint8_t month_days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        int64_t first = days_from_civil(year, rule->month, 1);
+        int wday1 = (int)((first % 7 + 11) % 7);  // 1970-01-01为星期四
+        int day = (rule->wday - wday1 + 7) % 7 + (rule->week - 1) * 7;
+        int len = month_days[rule->month - 1] + (rule->month == 2 && is_leap(year));
+        if (day >= len) {
+            day -= 7;
+        }
+        days = first + day;
+    }
+    return days * SECS_PER_DAY + rule->time - offset;
+}
+
+// 重新计算utc_sec所在的偏移区间
+static void tz_update_offset(time_zone_t *tz, int64_t utc_sec) {
+    if (!tz->has_dst) {
+        tz->valid_from = INT64_MIN;
+        tz->valid_until = INT64_MAX;
+        tz->offset = tz->std_offset;
+        tz->is_dst = false;
+        return;
+    }
+    int64_t y;
+    unsigned m, d;
+    civil_from_days(floor_div(utc_sec + tz->std_offset, SECS_PER_DAY), &y, &m, &d);
+
+    int64_t start = tz_rule_utc(&tz->start, y, tz->std_offset);
+    int64_t end = tz_rule_utc(&tz->end, y, tz->dst_offset);
+    bool dst;
+    if (start < end) {
+        // 北半球: 夏令时在年内
+        if (utc_sec < start) {
+            tz->valid_from = tz_rule_utc(&tz->end, y - 1, tz->dst_offset);
+            tz->valid_until = start;
+            dst = false;
+        } else if (utc_sec < end) {
+            tz->valid_from = start;
+            tz->valid_until = end;
+            dst = true;
+        } else {
+            tz->valid_from = end;
+            tz->valid_until = tz_rule_utc(&tz->start, y + 1, tz->std_offset);
+            dst = false;
+        }
+    } else {
+        // 南半球: 夏令时跨年
+        if (utc_sec < end) {
+            tz->valid_from = tz_rule_utc(&tz->start, y - 1, tz->std_offset);
+            tz->valid_until = end;
+            dst = true;
+        } else if (utc_sec < start) {
+            tz->valid_from = end;
+            tz->valid_until = start;
+            dst = false;
+        } else {
+            tz->valid_from = start;
+            tz->valid_until = tz_rule_utc(&tz->end, y + 1, tz->dst_offset);
+            dst = true;
+        }
+    }
+    tz->is_dst = dst;
+    tz->offset = dst ? tz->dst_offset : tz->std_offset;
+}
+
+int32_t time_zone_offset(time_zone_t *tz, int64_t utc_sec) {
+    if (utc_sec < tz->valid_from || utc_sec >= tz->valid_until) {
+        tz_update_offset(tz, utc_sec);
+    }
+    return tz->offset;
+}
+
+// 重新计算utc_sec所在的当地日期
+static void tz_update_day(time_zone_t *tz, int64_t utc_sec) {
+    int32_t offset = time_zone_offset(tz, utc_sec);
+    int64_t days = floor_div(utc_sec + offset, SECS_PER_DAY);
+    int64_t y;
+    unsigned m, d;
+    civil_from_days(days, &y, &m, &d);
+
+    tz->day_base = days * SECS_PER_DAY - offset;
+    tz->day_from = tz->day_base > tz->valid_from ? tz->day_base : tz->valid_from;
+    tz->day_until = tz->day_base + SECS_PER_DAY < tz->valid_until ? tz->day_base + SECS_PER_DAY : tz->valid_until;
+
+    memset(&tz->day_tm, 0, sizeof(struct tm));
+    tz->day_tm.tm_year = (int)(y - 1900);
+    tz->day_tm.tm_mon = m - 1;
+    tz->day_tm.tm_mday = d;
+    tz->day_tm.tm_wday = (int)((days % 7 + 11) % 7);
+    tz->day_tm.tm_yday = (int)(days - days_from_civil(y, 1, 1));
+    tz->day_tm.tm_isdst = tz->is_dst;
+}
+
+void time_zone_localtime(time_zone_t *tz, int64_t utc_sec, struct tm *tm) {
+    if (utc_sec < tz->day_from || utc_sec >= tz->day_until) {
+        tz_update_day(tz, utc_sec);
+        tz->misses++;
+    } else {
+        tz->hits++;
+    }
+    int32_t sec = (int32_t)(utc_sec - tz->day_base);
+    *tm = tz->day_tm;
+    tm->tm_hour = sec / 3600;
+    tm->tm_min = sec / 60 % 60;
+    tm->tm_sec = sec % 60;
+}
@@ -0,0 +1,63 @@
+#ifndef __TIME_ZONE_H__
+#define __TIME_ZONE_H__
+
+// POSIX TZ解析与本地时间转换 缓存当前偏移的有效区间和当天的日期,
+// 区间内的转换只需一次减法和比较 不依赖ESP-IDF, 可在主机上单独编译
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#define TIME_ZONE_NAME_LEN  8
+
+// 夏令时切换规则
+typedef enum {
+    TZ_RULE_JULIAN1 = 0,  // Jn  1..365, 不计2月29日
+    TZ_RULE_JULIAN0,      // n   0..365, 计2月29日
+    TZ_RULE_MONTH,        // Mm.w.d  m月第w个星期d (w=5表示最后一个)
+} tz_rule_type_t;
+
+typedef struct {
+    tz_rule_type_t type;
+    uint16_t day;
+    uint8_t month;
+    uint8_t week;
+    uint8_t wday;
+    int32_t time;         // 当地切换时刻 (当天零点起的秒数)
+} tz_rule_t;
+
+typedef struct {
+    char std_name[TIME_ZONE_NAME_LEN];
+    char dst_name[TIME_ZONE_NAME_LEN];
+    int32_t std_offset;   // 本地时间 = UTC + offset (秒)
+    int32_t dst_offset;
+    bool has_dst;
+    tz_rule_t start;      // 进入夏令时
+    tz_rule_t end;        // 退出夏令时
+
+    // 偏移缓存: [valid_from, valid_until) 内偏移不变
+    int64_t valid_from;
+    int64_t valid_until;
+    int32_t offset;
+    bool is_dst;
+    // 日期缓存: [day_from, day_until) 内日期不变, day_base为当地零点对应的UTC
+    int64_t day_from;
+    int64_t day_until;
+    int64_t day_base;
+    struct tm day_tm;
+
+    uint32_t hits;        // 命中日期缓存的次数
+    uint32_t misses;      // 需要重新计算的次数
+} time_zone_t;
+
+// 解析POSIX TZ字符串, 如 "CST-8" "CET-1CEST,M3.5.0,M10.5.0/3" "<+0330>-3:30"
+// 成功返回true 失败时tz不变
+bool time_zone_parse(time_zone_t *tz, const char *posix_tz);
+
+// UTC秒转本地时间 功能等同localtime_r (tm_isdst按规则填写)
+void time_zone_localtime(time_zone_t *tz, int64_t utc_sec, struct tm *tm);
+
+// 返回utc_sec时刻的偏移 (秒)
+int32_t time_zone_offset(time_zone_t *tz, int64_t utc_sec);
+
+#endif // __TIME_ZONE_H__
@@ -121,6 +121,10 @@ typedef enum
   SCSI_CMD_READ_FORMAT_CAPACITY         = 0x23, ///< The command allows the Host to request a list of the possible format capacities for an installed writable media. This command also has the capability to report the writable capacity for a media when it is installed
   SCSI_CMD_READ_10                      = 0x28, ///< The READ (10) command requests that the device server read the specified logical block(s) and transfer them to the data-in buffer.
   SCSI_CMD_WRITE_10                     = 0x2A, ///< The WRITE (10) command requests that the device server transfer the specified logical block(s) from the data-out buffer and write them.
+  SCSI_CMD_SYNCHRONIZE_CACHE_10         = 0x35, ///< The SYNCHRONIZE CACHE (10) command requests that the device server ensure that the specified logical blocks have their most recent data values recorded in non-volatile cache and/or on the medium.
+  SCSI_CMD_UNMAP                        = 0x42, ///< The UNMAP command requests that the device server cause one or more LBAs to be unmapped (no longer hold data).
+  SCSI_CMD_MODE_SENSE_10                = 0x5A, ///< Same as MODE SENSE(6) with a longer header and allocation length, preferred by some hosts.
+  SCSI_CMD_SERVICE_ACTION_IN_16         = 0x9E, ///< SERVICE ACTION IN (16), carries READ CAPACITY (16) with service action 0x10.
 }scsi_cmd_type_t;
 
 /// SCSI Sense Key
@@ -274,6 +278,44 @@ typedef struct TU_ATTR_PACKED
 
 TU_VERIFY_STATIC( sizeof(scsi_mode_sense6_resp_t) == 4, "size is not correct");
 
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t cmd_code     ; ///< SCSI OpCode for \ref SCSI_CMD_MODE_SENSE_10
+
+  uint8_t : 3;
+  uint8_t disable_block_descriptor : 1;
+  uint8_t long_lba_accepted : 1;
+  uint8_t : 3;
+
+  uint8_t page_code : 6;
+  uint8_t page_control : 2;
+
+  uint8_t subpage_code;
+  uint8_t reserved[3];
+  uint16_t alloc_length; ///< Big Endian
+  uint8_t control;
+} scsi_mode_sense10_t;
+
+TU_VERIFY_STATIC( sizeof(scsi_mode_sense10_t) == 10, "size is not correct");
+
+// This is only a Mode parameter header(10).
+typedef struct TU_ATTR_PACKED
+{
+  uint16_t data_len; ///< Big Endian
+  uint8_t  medium_type;
+
+  uint8_t reserved : 7;
+  bool write_protected : 1;
+
+  uint8_t long_lba : 1;
+  uint8_t : 7;
+
+  uint8_t  reserved2;
+  uint16_t block_descriptor_len; ///< Big Endian
+} scsi_mode_sense10_resp_t;
+
+TU_VERIFY_STATIC( sizeof(scsi_mode_sense10_resp_t) == 8, "size is not correct");
+
 typedef struct TU_ATTR_PACKED
 {
   uint8_t cmd_code; ///< SCSI OpCode for \ref SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL
@@ -284,6 +326,20 @@ typedef struct TU_ATTR_PACKED
 
 TU_VERIFY_STATIC( sizeof(scsi_prevent_allow_medium_removal_t) == 6, "size is not correct");
 
+typedef struct TU_ATTR_PACKED
+{
+  uint8_t  cmd_code    ; ///< SCSI OpCode for \ref SCSI_CMD_SYNCHRONIZE_CACHE_10
+  uint8_t  : 1;
+  uint8_t  immed : 1;   ///< Return status before the cache is synchronized
+  uint8_t  : 6;
+  uint32_t lba         ; ///< First logical block, Big Endian
+  uint8_t  group_number;
+  uint16_t block_count ; ///< Number of logical blocks, zero means up to the last one. Big Endian
+  uint8_t  control     ;
+} scsi_synchronize_cache10_t;
+
+TU_VERIFY_STATIC( sizeof(scsi_synchronize_cache10_t) == 10, "size is not correct");
+
 typedef struct TU_ATTR_PACKED
 {
   uint8_t cmd_code;
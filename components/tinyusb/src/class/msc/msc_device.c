@@ -147,6 +147,18 @@ static inline uint16_t rdwr10_get_blocksize(msc_cbw_t const* cbw) {
   return (uint16_t) (cbw->total_bytes / block_count);
 }
 
+// Length of the next Data Stage transfer: remaining bytes capped at class buffer. When the buffer holds at least
+// one block, the chunk is rounded down to whole blocks so that a large buffer is moved as a single multi-packet
+// transfer and callbacks never see a block split across two invocations.
+static inline uint32_t rdwr10_get_xfer_len(mscd_interface_t const* p_msc, uint16_t block_sz) {
+  uint32_t nbytes = tu_min32(CFG_TUD_MSC_EP_BUFSIZE, p_msc->cbw.total_bytes - p_msc->xferred_len);
+  uint32_t const offset = p_msc->xferred_len % block_sz;
+  if (offset == 0 && nbytes > block_sz) {
+    nbytes -= nbytes % block_sz;
+  }
+  return nbytes;
+}
+
 static uint8_t rdwr10_validate_cmd(msc_cbw_t const* cbw) {
   uint8_t status = MSC_CSW_STATUS_PASSED;
   uint16_t const block_count = rdwr10_get_blockcount(cbw);
@@ -193,7 +205,11 @@ TU_ATTR_UNUSED tu_static tu_lookup_entry_t const _msc_scsi_cmd_lookup[] = {
   { .key = SCSI_CMD_REQUEST_SENSE                , .data = "Request Sense" },
   { .key = SCSI_CMD_READ_FORMAT_CAPACITY         , .data = "Read Format Capacity" },
   { .key = SCSI_CMD_READ_10                      , .data = "Read10" },
-  { .key = SCSI_CMD_WRITE_10                     , .data = "Write10" }
+  { .key = SCSI_CMD_WRITE_10                     , .data = "Write10" },
+  { .key = SCSI_CMD_SYNCHRONIZE_CACHE_10         , .data = "Synchronize Cache10" },
+  { .key = SCSI_CMD_MODE_SENSE_10                , .data = "Mode_Sense 10" },
+  { .key = SCSI_CMD_UNMAP                        , .data = "Unmap" },
+  { .key = SCSI_CMD_SERVICE_ACTION_IN_16         , .data = "Service Action In16" }
 };
 
 TU_ATTR_UNUSED tu_static tu_lookup_table_t const _msc_scsi_cmd_table = {
@@ -557,198 +573,229 @@ bool mscd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t event, uint32_t
 /* SCSI Command Process
  *------------------------------------------------------------------*/
 
-// return response's length (copied to buffer). Negative if it is not an built-in command or indicate Failed status (CSW)
-// In case of a failed status, sense key must be set for reason of failure
-static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize) {
-  (void)bufsize; // TODO refractor later
-  int32_t resplen;
+// Builtin command handlers return response's length (copied to buffer).
+// Negative indicate Failed status (CSW), in which case sense key must be set for reason of failure.
+// A negative result without sense passes the command on to tud_msc_scsi_cb()
+typedef int32_t (*proc_scsi_cmd_t)(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize);
+
+// Responses that don't depend on the application, only patched with its answers
+static scsi_mode_sense6_resp_t const _mode_sense6_resp = {
+  .data_len = 3,
+  .medium_type = 0,
+  .write_protected = false,
+  .reserved = 0,
+  .block_descriptor_len = 0 // no block descriptor are included
+};
 
-  mscd_interface_t* p_msc = &_mscd_itf;
+static scsi_mode_sense10_resp_t const _mode_sense10_resp = {
+  .data_len = 0, // Big Endian, set at runtime
+  .medium_type = 0,
+  .write_protected = false,
+  .reserved = 0,
+  .long_lba = 0,
+  .reserved2 = 0,
+  .block_descriptor_len = 0 // no block descriptor are included
+};
 
-  switch (scsi_cmd[0]) {
-    case SCSI_CMD_TEST_UNIT_READY:
-      resplen = 0;
-      if (!tud_msc_test_unit_ready_cb(lun)) {
-        // Failed status response
-        resplen = -1;
+static scsi_read_format_capacity_data_t const _read_format_capacity_resp = {
+  .list_length = 8,
+  .block_num = 0,
+  .descriptor_type = 2, // formatted media
+  .block_size_u16 = 0
+};
 
-        // set default sense if not set by callback
-        if (p_msc->sense_key == 0) {
-          set_sense_medium_not_present(lun);
-        }
-      }
-      break;
+// Failed status for a callback that returned false, with default sense if not set by callback
+static int32_t fail_builtin_scsi(uint8_t lun) {
+  if (_mscd_itf.sense_key == 0) {
+    set_sense_medium_not_present(lun);
+  }
+  return -1;
+}
 
-    case SCSI_CMD_START_STOP_UNIT:
-      resplen = 0;
+static int32_t proc_test_unit_ready(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize) {
+  (void) scsi_cmd; (void) buffer; (void) bufsize;
+  return tud_msc_test_unit_ready_cb(lun) ? 0 : fail_builtin_scsi(lun);
+}
 
-      if (tud_msc_start_stop_cb) {
-        scsi_start_stop_unit_t const* start_stop = (scsi_start_stop_unit_t const*)scsi_cmd;
-        if (!tud_msc_start_stop_cb(lun, start_stop->power_condition, start_stop->start, start_stop->load_eject)) {
-          // Failed status response
-          resplen = -1;
+static int32_t proc_start_stop_unit(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize) {
+  (void) buffer; (void) bufsize;
+  if (tud_msc_start_stop_cb) {
+    scsi_start_stop_unit_t const* start_stop = (scsi_start_stop_unit_t const*)scsi_cmd;
+    if (!tud_msc_start_stop_cb(lun, start_stop->power_condition, start_stop->start, start_stop->load_eject)) {
+      return fail_builtin_scsi(lun);
+    }
+  }
+  return 0;
+}
 
-          // set default sense if not set by callback
-          if (p_msc->sense_key == 0) {
-            set_sense_medium_not_present(lun);
-          }
-        }
-      }
-      break;
+static int32_t proc_prevent_allow_medium_removal(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize) {
+  (void) buffer; (void) bufsize;
+  if (tud_msc_prevent_allow_medium_removal_cb) {
+    scsi_prevent_allow_medium_removal_t const* prevent_allow = (scsi_prevent_allow_medium_removal_t const*)scsi_cmd;
+    if (!tud_msc_prevent_allow_medium_removal_cb(lun, prevent_allow->prohibit_removal, prevent_allow->control)) {
+      return fail_builtin_scsi(lun);
+    }
+  }
+  return 0;
+}
 
-    case SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL:
-      resplen = 0;
+static int32_t proc_synchronize_cache10(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize) {
+  (void) buffer; (void) bufsize;
+  // Writes are completed before their status is sent, only an application cache needs flushing
+  if (tud_msc_synchronize_cache_cb) {
+    scsi_synchronize_cache10_t const* sync = (scsi_synchronize_cache10_t const*)scsi_cmd;
+    uint32_t const lba = tu_ntohl(tu_unaligned_read32(scsi_cmd + offsetof(scsi_synchronize_cache10_t, lba)));
+    uint16_t const block_count = tu_ntohs(tu_unaligned_read16(scsi_cmd + offsetof(scsi_synchronize_cache10_t, block_count)));
+    if (!tud_msc_synchronize_cache_cb(lun, lba, block_count, sync->immed)) {
+      return fail_builtin_scsi(lun);
+    }
+  }
+  return 0;
+}
 
-      if (tud_msc_prevent_allow_medium_removal_cb) {
-        scsi_prevent_allow_medium_removal_t const* prevent_allow = (scsi_prevent_allow_medium_removal_t const*)scsi_cmd;
-        if (!tud_msc_prevent_allow_medium_removal_cb(lun, prevent_allow->prohibit_removal, prevent_allow->control)) {
-          // Failed status response
-          resplen = -1;
+static int32_t proc_read_capacity10(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize) {
+  (void) scsi_cmd;
+  uint32_t block_count;
+  uint16_t block_size;
+  tud_msc_capacity_cb(lun, &block_count, &block_size);
 
-          // set default sense if not set by callback
-          if (p_msc->sense_key == 0) {
-            set_sense_medium_not_present(lun);
-          }
-        }
-      }
-      break;
+  // Invalid block size/count from callback, possibly unit is not ready
+  // stall this request, set sense key to NOT READY
+  if (block_count == 0 || block_size == 0) {
+    return fail_builtin_scsi(lun);
+  }
 
+  scsi_read_capacity10_resp_t read_capa10;
+  read_capa10.last_lba = tu_htonl(block_count-1);
+  read_capa10.block_size = tu_htonl((uint32_t)block_size);
 
-    case SCSI_CMD_READ_CAPACITY_10: {
-      uint32_t block_count;
-      uint32_t block_size;
-      uint16_t block_size_u16;
+  TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, &read_capa10, sizeof(read_capa10)));
+  return sizeof(read_capa10);
+}
 
-      tud_msc_capacity_cb(lun, &block_count, &block_size_u16);
-      block_size = (uint32_t)block_size_u16;
+static int32_t proc_read_format_capacity(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize) {
+  (void) scsi_cmd;
+  uint32_t block_count;
+  uint16_t block_size;
+  tud_msc_capacity_cb(lun, &block_count, &block_size);
 
-      // Invalid block size/count from callback, possibly unit is not ready
-      // stall this request, set sense key to NOT READY
-      if (block_count == 0 || block_size == 0) {
-        resplen = -1;
+  // Invalid block size/count from callback, possibly unit is not ready
+  // stall this request, set sense key to NOT READY
+  if (block_count == 0 || block_size == 0) {
+    return fail_builtin_scsi(lun);
+  }
 
-        // set default sense if not set by callback
-        if (p_msc->sense_key == 0) {
-          set_sense_medium_not_present(lun);
-        }
-      } else {
-        scsi_read_capacity10_resp_t read_capa10;
+  scsi_read_format_capacity_data_t read_fmt_capa = _read_format_capacity_resp;
+  read_fmt_capa.block_num = tu_htonl(block_count);
+  read_fmt_capa.block_size_u16 = tu_htons(block_size);
 
-        read_capa10.last_lba = tu_htonl(block_count-1);
-        read_capa10.block_size = tu_htonl(block_size);
+  TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, &read_fmt_capa, sizeof(read_fmt_capa)));
+  return sizeof(read_fmt_capa);
+}
 
-        resplen = sizeof(read_capa10);
-        TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, &read_capa10, (size_t) resplen));
-      }
-    }
-    break;
+static int32_t proc_inquiry(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize) {
+  // Vital product data pages (EVPD = 1) are left to tud_msc_scsi_cb()
+  if (scsi_cmd[1] & 0x01) {
+    return -1;
+  }
 
-    case SCSI_CMD_READ_FORMAT_CAPACITY: {
-      scsi_read_format_capacity_data_t read_fmt_capa =
-      {
-        .list_length = 8,
-        .block_num = 0,
-        .descriptor_type = 2, // formatted media
-        .block_size_u16 = 0
-      };
+  scsi_inquiry_resp_t inquiry_rsp =
+  {
+    .is_removable = 1,
+    .version = 2,
+    .response_data_format = 2,
+    .additional_length = sizeof(scsi_inquiry_resp_t) - 5,
+  };
 
-      uint32_t block_count;
-      uint16_t block_size;
+  // vendor_id, product_id, product_rev is space padded string
+  memset(inquiry_rsp.vendor_id  , ' ', sizeof(inquiry_rsp.vendor_id));
+  memset(inquiry_rsp.product_id , ' ', sizeof(inquiry_rsp.product_id));
+  memset(inquiry_rsp.product_rev, ' ', sizeof(inquiry_rsp.product_rev));
 
-      tud_msc_capacity_cb(lun, &block_count, &block_size);
+  tud_msc_inquiry_cb(lun, inquiry_rsp.vendor_id, inquiry_rsp.product_id, inquiry_rsp.product_rev);
 
-      // Invalid block size/count from callback, possibly unit is not ready
-      // stall this request, set sense key to NOT READY
-      if (block_count == 0 || block_size == 0) {
-        resplen = -1;
+  TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, &inquiry_rsp, sizeof(inquiry_rsp)));
+  return sizeof(inquiry_rsp);
+}
 
-        // set default sense if not set by callback
-        if (p_msc->sense_key == 0) {
-          set_sense_medium_not_present(lun);
-        }
-      } else {
-        read_fmt_capa.block_num = tu_htonl(block_count);
-        read_fmt_capa.block_size_u16 = tu_htons(block_size);
+static bool is_writable(uint8_t lun) {
+  return tud_msc_is_writable_cb ? tud_msc_is_writable_cb(lun) : true;
+}
 
-        resplen = sizeof(read_fmt_capa);
-        TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, &read_fmt_capa, (size_t) resplen));
-      }
-    }
-    break;
+static int32_t proc_mode_sense6(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize) {
+  (void) scsi_cmd;
+  scsi_mode_sense6_resp_t mode_resp = _mode_sense6_resp;
+  mode_resp.write_protected = !is_writable(lun);
 
-    case SCSI_CMD_INQUIRY: {
-      scsi_inquiry_resp_t inquiry_rsp =
-      {
-        .is_removable = 1,
-        .version = 2,
-        .response_data_format = 2,
-        .additional_length = sizeof(scsi_inquiry_resp_t) - 5,
-      };
+  TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, &mode_resp, sizeof(mode_resp)));
+  return sizeof(mode_resp);
+}
 
-      // vendor_id, product_id, product_rev is space padded string
-      memset(inquiry_rsp.vendor_id  , ' ', sizeof(inquiry_rsp.vendor_id));
-      memset(inquiry_rsp.product_id , ' ', sizeof(inquiry_rsp.product_id));
-      memset(inquiry_rsp.product_rev, ' ', sizeof(inquiry_rsp.product_rev));
+static int32_t proc_mode_sense10(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize) {
+  (void) scsi_cmd;
+  scsi_mode_sense10_resp_t mode_resp = _mode_sense10_resp;
+  mode_resp.data_len = tu_htons(sizeof(mode_resp) - 2);
+  mode_resp.write_protected = !is_writable(lun);
 
-      tud_msc_inquiry_cb(lun, inquiry_rsp.vendor_id, inquiry_rsp.product_id, inquiry_rsp.product_rev);
+  TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, &mode_resp, sizeof(mode_resp)));
+  return sizeof(mode_resp);
+}
 
-      resplen = sizeof(inquiry_rsp);
-      TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, &inquiry_rsp, (size_t) resplen));
-    }
-    break;
+static int32_t proc_request_sense(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize) {
+  (void) scsi_cmd;
+  mscd_interface_t* p_msc = &_mscd_itf;
 
-    case SCSI_CMD_MODE_SENSE_6: {
-      scsi_mode_sense6_resp_t mode_resp =
-      {
-        .data_len = 3,
-        .medium_type = 0,
-        .write_protected = false,
-        .reserved = 0,
-        .block_descriptor_len = 0 // no block descriptor are included
-      };
-
-      bool writable = true;
-      if (tud_msc_is_writable_cb) {
-        writable = tud_msc_is_writable_cb(lun);
-      }
+  scsi_sense_fixed_resp_t sense_rsp =
+  {
+    .response_code = 0x70, // current, fixed format
+    .valid = 1
+  };
 
-      mode_resp.write_protected = !writable;
+  sense_rsp.add_sense_len = sizeof(scsi_sense_fixed_resp_t) - 8;
+  sense_rsp.sense_key = (uint8_t)(p_msc->sense_key & 0x0F);
+  sense_rsp.add_sense_code = p_msc->add_sense_code;
+  sense_rsp.add_sense_qualifier = p_msc->add_sense_qualifier;
 
-      resplen = sizeof(mode_resp);
-      TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, &mode_resp, (size_t) resplen));
-    }
-    break;
+  int32_t resplen = sizeof(sense_rsp);
+  TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, &sense_rsp, (size_t) resplen));
 
-    case SCSI_CMD_REQUEST_SENSE: {
-      scsi_sense_fixed_resp_t sense_rsp =
-      {
-        .response_code = 0x70, // current, fixed format
-        .valid = 1
-      };
+  // request sense callback could overwrite the sense data
+  if (tud_msc_request_sense_cb) {
+    resplen = tud_msc_request_sense_cb(lun, buffer, (uint16_t)bufsize);
+  }
 
-      sense_rsp.add_sense_len = sizeof(scsi_sense_fixed_resp_t) - 8;
-      sense_rsp.sense_key = (uint8_t)(p_msc->sense_key & 0x0F);
-      sense_rsp.add_sense_code = p_msc->add_sense_code;
-      sense_rsp.add_sense_qualifier = p_msc->add_sense_qualifier;
+  // Clear sense data after copy
+  tud_msc_set_sense(lun, 0, 0, 0);
 
-      resplen = sizeof(sense_rsp);
-      TU_VERIFY(0 == tu_memcpy_s(buffer, bufsize, &sense_rsp, (size_t) resplen));
+  return resplen;
+}
 
-      // request sense callback could overwrite the sense data
-      if (tud_msc_request_sense_cb) {
-        resplen = tud_msc_request_sense_cb(lun, buffer, (uint16_t)bufsize);
-      }
+// Sorted by opcode
+static struct {
+  uint8_t opcode;
+  proc_scsi_cmd_t handler;
+} const _builtin_scsi_cmd[] = {
+  { SCSI_CMD_TEST_UNIT_READY             , proc_test_unit_ready              },
+  { SCSI_CMD_REQUEST_SENSE               , proc_request_sense                },
+  { SCSI_CMD_INQUIRY                     , proc_inquiry                      },
+  { SCSI_CMD_MODE_SENSE_6                , proc_mode_sense6                  },
+  { SCSI_CMD_START_STOP_UNIT             , proc_start_stop_unit              },
+  { SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL, proc_prevent_allow_medium_removal },
+  { SCSI_CMD_READ_FORMAT_CAPACITY        , proc_read_format_capacity         },
+  { SCSI_CMD_READ_CAPACITY_10            , proc_read_capacity10              },
+  { SCSI_CMD_SYNCHRONIZE_CACHE_10        , proc_synchronize_cache10          },
+  { SCSI_CMD_MODE_SENSE_10               , proc_mode_sense10                 },
+};
 
-      // Clear sense data after copy
-      tud_msc_set_sense(lun, 0, 0, 0);
+// return response's length (copied to buffer). Negative if it is not an built-in command or indicate Failed status (CSW)
+// In case of a failed status, sense key must be set for reason of failure
+static int32_t proc_builtin_scsi(uint8_t lun, uint8_t const scsi_cmd[16], uint8_t* buffer, uint32_t bufsize) {
+  for (size_t i = 0; i < TU_ARRAY_SIZE(_builtin_scsi_cmd) && _builtin_scsi_cmd[i].opcode <= scsi_cmd[0]; i++) {
+    if (_builtin_scsi_cmd[i].opcode == scsi_cmd[0]) {
+      return _builtin_scsi_cmd[i].handler(lun, scsi_cmd, buffer, bufsize);
     }
-    break;
-
-    default: resplen = -1;
-      break;
   }
-
-  return resplen;
+  return -1;
 }
 
 static void proc_read10_cmd(uint8_t rhport, mscd_interface_t* p_msc) {
@@ -760,8 +807,8 @@ static void proc_read10_cmd(uint8_t rhport, mscd_interface_t* p_msc) {
   // Adjust lba with transferred bytes
   uint32_t const lba = rdwr10_get_lba(p_cbw->command) + (p_msc->xferred_len / block_sz);
 
-  // remaining bytes capped at class buffer
-  int32_t nbytes = (int32_t)tu_min32(CFG_TUD_MSC_EP_BUFSIZE, p_cbw->total_bytes - p_msc->xferred_len);
+  // remaining bytes capped at class buffer, in whole blocks
+  int32_t nbytes = (int32_t)rdwr10_get_xfer_len(p_msc, block_sz);
 
   // Application can consume smaller bytes
   uint32_t const offset = p_msc->xferred_len % block_sz;
@@ -799,8 +846,8 @@ static void proc_write10_cmd(uint8_t rhport, mscd_interface_t* p_msc) {
     return;
   }
 
-  // remaining bytes capped at class buffer
-  uint16_t nbytes = (uint16_t)tu_min32(CFG_TUD_MSC_EP_BUFSIZE, p_cbw->total_bytes - p_msc->xferred_len);
+  // remaining bytes capped at class buffer, in whole blocks
+  uint16_t nbytes = (uint16_t)rdwr10_get_xfer_len(p_msc, rdwr10_get_blocksize(p_cbw));
 
   // Write10 callback will be called later when usb transfer complete
   TU_ASSERT(usbd_edpt_xfer(rhport, p_msc->ep_out, _mscd_epbuf.buf, nbytes),);
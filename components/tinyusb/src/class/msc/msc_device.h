@@ -48,6 +48,9 @@
   #error CFG_TUD_MSC_EP_BUFSIZE must be defined, value of a block size should work well, the more the better
 #endif
 
+// READ10/WRITE10 data is moved in chunks of up to CFG_TUD_MSC_EP_BUFSIZE (rounded down to whole blocks), each chunk
+// is a single multi-packet endpoint transfer followed by one read10/write10 callback. A buffer of several blocks
+// therefore cuts the callback count per command, a 64 KiB command takes 128 callbacks with 512 bytes but 4 with 16 KiB.
 TU_VERIFY_STATIC(CFG_TUD_MSC_EP_BUFSIZE < UINT16_MAX, "Size is not correct");
 
 //--------------------------------------------------------------------+
@@ -105,8 +108,10 @@ void tud_msc_capacity_cb(uint8_t lun, uint32_t* block_count, uint16_t* block_siz
 
 /**
  * Invoked when received an SCSI command not in built-in list below.
- * - READ_CAPACITY10, READ_FORMAT_CAPACITY, INQUIRY, TEST_UNIT_READY, START_STOP_UNIT, MODE_SENSE6, REQUEST_SENSE
+ * - READ_CAPACITY10, READ_FORMAT_CAPACITY, INQUIRY, TEST_UNIT_READY, START_STOP_UNIT, MODE_SENSE6, MODE_SENSE10,
+ *   REQUEST_SENSE, PREVENT_ALLOW_MEDIUM_REMOVAL, SYNCHRONIZE_CACHE10
  * - READ10 and WRITE10 has their own callbacks
+ * - INQUIRY with EVPD = 1 (vital product data pages) is passed to this callback
  *
  * \param[in]   lun         Logical unit number
  * \param[in]   scsi_cmd    SCSI command contents which application must examine to response accordingly
@@ -137,6 +142,10 @@ TU_ATTR_WEAK bool tud_msc_prevent_allow_medium_removal_cb(uint8_t lun, uint8_t p
 // Invoked when received REQUEST_SENSE
 TU_ATTR_WEAK int32_t tud_msc_request_sense_cb(uint8_t lun, void* buffer, uint16_t bufsize);
 
+// Invoked when received SYNCHRONIZE_CACHE10, block_count = 0 means up to the last block
+// Only needed if the application caches writes, succeeds without this callback
+TU_ATTR_WEAK bool tud_msc_synchronize_cache_cb(uint8_t lun, uint32_t lba, uint16_t block_count, bool immed);
+
 // Invoked when Read10 command is complete
 TU_ATTR_WEAK void tud_msc_read10_complete_cb(uint8_t lun);
 
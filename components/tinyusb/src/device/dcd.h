@@ -55,6 +55,9 @@ typedef enum {
 typedef struct TU_ATTR_ALIGNED(4) {
   uint8_t rhport;
   uint8_t event_id;
+#if CFG_TUD_EVENT_STATS
+  uint32_t queued_us; // set by usbd when queued, for latency statistics
+#endif
 
   union {
     // BUS RESET
@@ -49,6 +49,10 @@ TU_ATTR_WEAK void tud_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_is
   (void) rhport; (void) eventid; (void) in_isr;
 }
 
+TU_ATTR_WEAK uint32_t tud_event_time_us_cb(void) {
+  return 0;
+}
+
 TU_ATTR_WEAK void tud_sof_cb(uint32_t frame_count) {
   (void) frame_count;
 }
@@ -345,6 +349,39 @@ tu_static uint8_t _usbd_rhport = RHPORT_INVALID;
 OSAL_QUEUE_DEF(usbd_int_set, _usbd_qdef, CFG_TUD_TASK_QUEUE_SZ, dcd_event_t);
 tu_static osal_queue_t _usbd_q;
 
+// SOF for the application is coalesced: while one is waiting in the queue, later frames only update the frame count
+tu_static volatile bool _usbd_sof_queued;
+tu_static volatile uint32_t _usbd_sof_frame;
+
+#if CFG_TUD_TASK_FUNC_QUEUE_SZ
+typedef struct {
+  osal_task_func_t func;
+  void* param;
+#if CFG_TUD_EVENT_STATS
+  uint32_t queued_us;
+#endif
+} usbd_deferred_func_t;
+
+// Deferred functions, the event queue only carries a single wakeup (USBD_EVENT_FUNC_CALL without function) for them
+OSAL_QUEUE_DEF(usbd_int_set, _usbd_fqdef, CFG_TUD_TASK_FUNC_QUEUE_SZ, usbd_deferred_func_t);
+tu_static osal_queue_t _usbd_fq;
+tu_static volatile bool _usbd_func_wakeup;
+tu_static volatile bool _usbd_func_wakeup_lost; // the wakeup did not fit the event queue, tud_task() sends it again
+
+// Deferred functions taken from the queue and run at once, identical calls among them run only once
+#define USBD_FUNC_BATCH_MAX  8
+#endif
+
+#if CFG_TUD_EVENT_STATS
+tu_static tud_event_stats_t _usbd_event_stats;
+
+static void event_latency_record(uint32_t histogram[TUD_EVENT_LATENCY_BUCKETS], uint32_t queued_us) {
+  uint32_t const us = tud_event_time_us_cb() - queued_us;
+  uint8_t const bucket = (us < 32) ? 0 : (uint8_t) (tu_log2(us) - 4);
+  histogram[tu_min8(bucket, TUD_EVENT_LATENCY_BUCKETS - 1)]++;
+}
+#endif
+
 // Mutex for claiming endpoint
 #if OSAL_MUTEX_REQUIRED
   tu_static osal_mutex_def_t _ubsd_mutexdef;
@@ -354,7 +391,19 @@ tu_static osal_queue_t _usbd_q;
 #endif
 
 TU_ATTR_ALWAYS_INLINE static inline bool queue_event(dcd_event_t const * event, bool in_isr) {
-  TU_ASSERT(osal_queue_send(_usbd_q, event, in_isr));
+#if CFG_TUD_EVENT_STATS
+  dcd_event_t stamped = *event;
+  stamped.queued_us = tud_event_time_us_cb();
+  bool const sent = osal_queue_send(_usbd_q, &stamped, in_isr);
+#else
+  bool const sent = osal_queue_send(_usbd_q, event, in_isr);
+#endif
+#if CFG_TUD_EVENT_STATS
+  if (!sent && event->event_id < DCD_EVENT_COUNT) {
+    _usbd_event_stats.overflow[event->event_id]++;
+  }
+#endif
+  TU_ASSERT(sent);
   tud_event_hook_cb(event->rhport, event->event_id, in_isr);
   return true;
 }
@@ -474,6 +523,8 @@ bool tud_rhport_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
 
   tu_varclr(&_usbd_dev);
   _usbd_queued_setup = 0;
+  _usbd_sof_queued = false;
+  usbd_control_reset(); // a control transfer cut short by tud_deinit() must not resume
 
 #if OSAL_MUTEX_REQUIRED
   // Init device mutex
@@ -484,6 +535,12 @@ bool tud_rhport_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
   // Init device queue & task
   _usbd_q = osal_queue_create(&_usbd_qdef);
   TU_ASSERT(_usbd_q);
+#if CFG_TUD_TASK_FUNC_QUEUE_SZ
+  _usbd_fq = osal_queue_create(&_usbd_fqdef);
+  TU_ASSERT(_usbd_fq);
+  _usbd_func_wakeup = false;
+  _usbd_func_wakeup_lost = false;
+#endif
 
   // Get application driver if available
   if (usbd_app_driver_get_cb) {
@@ -531,6 +588,10 @@ bool tud_deinit(uint8_t rhport) {
   // Deinit device queue & task
   osal_queue_delete(_usbd_q);
   _usbd_q = NULL;
+#if CFG_TUD_TASK_FUNC_QUEUE_SZ
+  osal_queue_delete(_usbd_fq);
+  _usbd_fq = NULL;
+#endif
 
 #if OSAL_MUTEX_REQUIRED
   // TODO make sure there is no task waiting on this mutex
@@ -550,9 +611,19 @@ static void configuration_reset(uint8_t rhport) {
     driver->reset(rhport);
   }
 
+  // Class drivers ask for SOF again once configured, the application's request stays until it revokes it.
+  // SOF interrupt is turned off when nobody is left, otherwise it keeps waking the CPU every (micro) frame.
+  uint8_t const sof_consumer = _usbd_dev.sof_consumer;
+  uint8_t const sof_user = sof_consumer & (uint8_t) (1 << SOF_CONSUMER_USER);
+
   tu_varclr(&_usbd_dev);
   memset(_usbd_dev.itf2drv, DRVID_INVALID, sizeof(_usbd_dev.itf2drv)); // invalid mapping
   memset(_usbd_dev.ep2drv, DRVID_INVALID, sizeof(_usbd_dev.ep2drv)); // invalid mapping
+
+  _usbd_dev.sof_consumer = sof_user;
+  if (sof_consumer && !sof_user) {
+    dcd_sof_enable(rhport, false);
+  }
 }
 
 static void usbd_reset(uint8_t rhport) {
@@ -563,9 +634,96 @@ static void usbd_reset(uint8_t rhport) {
 bool tud_task_event_ready(void) {
   // Skip if stack is not initialized
   if (!tud_inited()) return false;
+#if CFG_TUD_TASK_FUNC_QUEUE_SZ
+  if (!osal_queue_empty(_usbd_fq)) return true;
+#endif
   return !osal_queue_empty(_usbd_q);
 }
 
+#if CFG_TUD_EVENT_STATS
+void tud_event_stats_get(tud_event_stats_t* stats) {
+  *stats = _usbd_event_stats;
+  stats->queue_size = CFG_TUD_TASK_QUEUE_SZ;
+  stats->func_queue_size = CFG_TUD_TASK_FUNC_QUEUE_SZ;
+}
+
+void tud_event_stats_reset(void) {
+  tu_varclr(&_usbd_event_stats);
+}
+#endif
+
+#if CFG_TUD_TASK_FUNC_QUEUE_SZ
+// Run one batch of deferred functions, return false if there was none
+static bool process_deferred_func(void) {
+  usbd_deferred_func_t batch[USBD_FUNC_BATCH_MAX];
+  uint8_t count = 0;
+
+#if CFG_TUD_EVENT_STATS
+  uint32_t const queued = osal_queue_count(_usbd_fq);
+  if (queued > _usbd_event_stats.func_queue_high_water) {
+    _usbd_event_stats.func_queue_high_water = (uint16_t) tu_min32(queued, CFG_TUD_TASK_FUNC_QUEUE_SZ);
+  }
+#endif
+
+  // Bounded by the queue size in case producers keep adding identical calls
+  for (uint32_t n = 0; n < CFG_TUD_TASK_FUNC_QUEUE_SZ && count < USBD_FUNC_BATCH_MAX; n++) {
+    if (!osal_queue_receive(_usbd_fq, &batch[count], 0)) break;
+
+#if CFG_TUD_EVENT_STATS
+    event_latency_record(_usbd_event_stats.func_latency, batch[count].queued_us);
+#endif
+
+    // All calls in the batch were requested before any of them runs, so running an identical one once is enough
+    bool batched = false;
+    for (uint8_t i = 0; i < count; i++) {
+      if (batch[i].func == batch[count].func && batch[i].param == batch[count].param) {
+        batched = true;
+        break;
+      }
+    }
+
+    if (batched) {
+#if CFG_TUD_EVENT_STATS
+      _usbd_event_stats.func_batched++;
+#endif
+    } else {
+      count++;
+    }
+  }
+
+  for (uint8_t i = 0; i < count; i++) {
+    TU_LOG_USBD("USBD Func Call\r\n");
+    batch[i].func(batch[i].param);
+  }
+#if CFG_TUD_EVENT_STATS
+  _usbd_event_stats.handled[USBD_EVENT_FUNC_CALL] += count;
+#endif
+
+  return count > 0;
+}
+
+// Wake up the task, one wakeup waiting in the event queue covers any number of deferred functions.
+// When the event queue is full the functions stay queued, the task is busy anyway and sends the wakeup again
+static void func_wakeup(bool in_isr) {
+  if (_usbd_func_wakeup) return;
+  _usbd_func_wakeup = true;
+
+  dcd_event_t event = {.rhport = 0, .event_id = USBD_EVENT_FUNC_CALL};
+#if CFG_TUD_EVENT_STATS
+  event.queued_us = tud_event_time_us_cb();
+#endif
+  if (osal_queue_send(_usbd_q, &event, in_isr)) {
+    tud_event_hook_cb(event.rhport, event.event_id, in_isr);
+  } else {
+    _usbd_func_wakeup = false;
+    _usbd_func_wakeup_lost = true;
+#if CFG_TUD_EVENT_STATS
+    _usbd_event_stats.func_wakeup_overflow++;
+#endif
+  }
+}
+#endif
+
 /* USB Device Driver task
  * This top level thread manages all device controller event and delegates events to class-specific drivers.
  * This should be called periodically within the mainloop or rtos thread.
@@ -589,7 +747,50 @@ void tud_task_ext(uint32_t timeout_ms, bool in_isr) {
   // Loop until there is no more events in the queue
   while (1) {
     dcd_event_t event;
-    if (!osal_queue_receive(_usbd_q, &event, timeout_ms)) return;
+#if CFG_TUD_TASK_FUNC_QUEUE_SZ
+    // USB events first, deferred functions only run when none is waiting
+    bool const func_pending = !osal_queue_empty(_usbd_fq);
+    uint32_t const wait_ms = func_pending ? 0 : timeout_ms;
+#else
+    uint32_t const wait_ms = timeout_ms;
+#endif
+#if CFG_TUD_EVENT_STATS
+    // Only this task removes events, so the level seen here is the highest since the previous receive
+    uint32_t const queued = tu_max32(osal_queue_count(_usbd_q), 1);
+#endif
+    if (!osal_queue_receive(_usbd_q, &event, wait_ms)) {
+#if CFG_TUD_TASK_FUNC_QUEUE_SZ
+      if (func_pending && process_deferred_func()) {
+  #if CFG_TUSB_OS != OPT_OS_NONE && CFG_TUSB_OS != OPT_OS_PICO
+        if (osal_queue_empty(_usbd_q) && osal_queue_empty(_usbd_fq)) return;
+  #endif
+        continue;
+      }
+#endif
+      return;
+    }
+#if CFG_TUD_TASK_FUNC_QUEUE_SZ
+    // an entry is free now for the wakeup that did not fit
+    if (_usbd_func_wakeup_lost) {
+      _usbd_func_wakeup_lost = false;
+      if (!osal_queue_empty(_usbd_fq)) func_wakeup(false);
+    }
+#endif
+#if CFG_TUD_EVENT_STATS
+    if (queued > _usbd_event_stats.queue_high_water) {
+      _usbd_event_stats.queue_high_water = (uint16_t) tu_min32(queued, CFG_TUD_TASK_QUEUE_SZ);
+    }
+    if (event.event_id == USBD_EVENT_FUNC_CALL) {
+      // without a function it is only the wakeup for the deferred function queue
+      if (event.func_call.func) {
+        _usbd_event_stats.handled[USBD_EVENT_FUNC_CALL]++;
+        event_latency_record(_usbd_event_stats.func_latency, event.queued_us);
+      }
+    } else if (event.event_id < DCD_EVENT_COUNT) {
+      _usbd_event_stats.handled[event.event_id]++;
+      event_latency_record(_usbd_event_stats.event_latency, event.queued_us);
+    }
+#endif
 
 #if CFG_TUSB_DEBUG >= CFG_TUD_LOG_LEVEL
     if (event.event_id == DCD_EVENT_SETUP_RECEIVED) TU_LOG_USBD("\r\n"); // extra line for setup
@@ -684,13 +885,23 @@ void tud_task_ext(uint32_t timeout_ms, bool in_isr) {
 
       case USBD_EVENT_FUNC_CALL:
         TU_LOG_USBD("\r\n");
-        if (event.func_call.func) event.func_call.func(event.func_call.param);
+        if (event.func_call.func) {
+          event.func_call.func(event.func_call.param);
+        }
+#if CFG_TUD_TASK_FUNC_QUEUE_SZ
+        else {
+          // wakeup for the deferred function queue, which is served once no USB event is waiting
+          _usbd_func_wakeup = false;
+        }
+#endif
         break;
 
       case DCD_EVENT_SOF:
+        // clear before invoking so that a frame arriving during the callback is queued again
+        _usbd_sof_queued = false;
         if (tu_bit_test(_usbd_dev.sof_consumer, SOF_CONSUMER_USER)) {
           TU_LOG_USBD("\r\n");
-          tud_sof_cb(event.sof.frame_count);
+          tud_sof_cb(_usbd_sof_frame);
         }
       break;
 
@@ -701,7 +912,11 @@ void tud_task_ext(uint32_t timeout_ms, bool in_isr) {
 
 #if CFG_TUSB_OS != OPT_OS_NONE && CFG_TUSB_OS != OPT_OS_PICO
     // return if there is no more events, for application to run other background
+  #if CFG_TUD_TASK_FUNC_QUEUE_SZ
+    if (osal_queue_empty(_usbd_q) && osal_queue_empty(_usbd_fq)) return;
+  #else
     if (osal_queue_empty(_usbd_q)) return;
+  #endif
 #endif
   }
 }
@@ -1210,8 +1425,19 @@ TU_ATTR_FAST_FUNC void dcd_event_handler(dcd_event_t const* event, bool in_isr)
       }
 
       if (tu_bit_test(_usbd_dev.sof_consumer, SOF_CONSUMER_USER)) {
-        dcd_event_t const event_sof = {.rhport = event->rhport, .event_id = DCD_EVENT_SOF, .sof.frame_count = event->sof.frame_count};
-        queue_event(&event_sof, in_isr);
+        // a slow task would otherwise see the queue filled with SOFs (one per ms) and drop transfer events
+        _usbd_sof_frame = event->sof.frame_count;
+        if (_usbd_sof_queued) {
+#if CFG_TUD_EVENT_STATS
+          _usbd_event_stats.sof_coalesced++;
+#endif
+        } else {
+          _usbd_sof_queued = true;
+          dcd_event_t const event_sof = {.rhport = event->rhport, .event_id = DCD_EVENT_SOF, .sof.frame_count = event->sof.frame_count};
+          if (!queue_event(&event_sof, in_isr)) {
+            _usbd_sof_queued = false;
+          }
+        }
       }
       break;
 
@@ -1271,6 +1497,25 @@ bool usbd_open_edpt_pair(uint8_t rhport, uint8_t const* p_desc, uint8_t ep_count
 
 // Helper to defer an isr function
 void usbd_defer_func(osal_task_func_t func, void* param, bool in_isr) {
+#if CFG_TUD_TASK_FUNC_QUEUE_SZ
+  usbd_deferred_func_t const deferred = {
+      .func  = func,
+      .param = param,
+  #if CFG_TUD_EVENT_STATS
+      .queued_us = tud_event_time_us_cb(),
+  #endif
+  };
+
+  bool const sent = osal_queue_send(_usbd_fq, &deferred, in_isr);
+  #if CFG_TUD_EVENT_STATS
+  if (!sent) {
+    _usbd_event_stats.overflow[USBD_EVENT_FUNC_CALL]++;
+  }
+  #endif
+  TU_ASSERT(sent,);
+
+  func_wakeup(in_isr);
+#else
   dcd_event_t event = {
       .rhport   = 0,
       .event_id = USBD_EVENT_FUNC_CALL,
@@ -1279,6 +1524,7 @@ void usbd_defer_func(osal_task_func_t func, void* param, bool in_isr) {
   event.func_call.param = param;
 
   queue_event(&event, in_isr);
+#endif
 }
 
 //--------------------------------------------------------------------+
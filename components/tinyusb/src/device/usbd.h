@@ -28,6 +28,7 @@
 #define _TUSB_USBD_H_
 
 #include "common/tusb_common.h"
+#include "device/dcd.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -72,6 +73,31 @@ void tud_task (void) {
 // Check if there is pending events need processing by tud_task()
 bool tud_task_event_ready(void);
 
+#if CFG_TUD_EVENT_STATS
+// Latency histogram buckets: bucket 0 is below 32 us, bucket i below (32 << i) us, the last one everything above
+#define TUD_EVENT_LATENCY_BUCKETS  10
+
+// Event queue statistics, enabled with CFG_TUD_EVENT_STATS. A non-zero overflow count means events were lost,
+// CFG_TUD_TASK_QUEUE_SZ (or CFG_TUD_TASK_FUNC_QUEUE_SZ for USBD_EVENT_FUNC_CALL) should then be raised above
+// the reported high water mark.
+typedef struct {
+  uint16_t queue_size;                 // CFG_TUD_TASK_QUEUE_SZ
+  uint16_t queue_high_water;           // most events waiting in the queue at once
+  uint16_t func_queue_size;            // CFG_TUD_TASK_FUNC_QUEUE_SZ
+  uint16_t func_queue_high_water;      // most deferred functions waiting at once
+  uint32_t func_batched;               // deferred calls merged into an identical one waiting with them
+  uint32_t func_wakeup_overflow;       // deferred function wakeups that did not fit the event queue and were sent again
+  uint32_t sof_coalesced;              // SOFs merged into one still waiting in the queue
+  uint32_t handled[DCD_EVENT_COUNT];   // events handled by tud_task(), indexed by event id
+  uint32_t overflow[DCD_EVENT_COUNT];  // events dropped because the queue was full, indexed by event id
+  uint32_t event_latency[TUD_EVENT_LATENCY_BUCKETS]; // USB event queued to handled by tud_task()
+  uint32_t func_latency[TUD_EVENT_LATENCY_BUCKETS];  // usbd_defer_func() to the function running
+} tud_event_stats_t;
+
+void tud_event_stats_get(tud_event_stats_t* stats);
+void tud_event_stats_reset(void);
+#endif
+
 #ifndef TUSB_DCD_H_
 extern void dcd_int_handler(uint8_t rhport);
 #endif
@@ -170,6 +196,10 @@ void tud_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr);
 // Invoked when a new (micro) frame started
 void tud_sof_cb(uint32_t frame_count);
 
+// Invoked to timestamp queued events for the latency statistics, in ISR context as well. Microseconds from any
+// free running counter, without it all latencies are counted as zero.
+uint32_t tud_event_time_us_cb(void);
+
 // Invoked when received control request with VENDOR TYPE
 bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const * request);
 
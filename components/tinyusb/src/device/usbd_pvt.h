@@ -125,6 +125,10 @@ void usbd_sof_enable(uint8_t rhport, sof_consumer_t consumer, bool en);
  *------------------------------------------------------------------*/
 
 bool usbd_open_edpt_pair(uint8_t rhport, uint8_t const* p_desc, uint8_t ep_count, uint8_t xfer_type, uint8_t* ep_out, uint8_t* ep_in);
+
+// Run func(param) later in tud_task(). With CFG_TUD_TASK_FUNC_QUEUE_SZ the call waits in its own queue behind any
+// pending USB event, and identical calls waiting together run once: func must not rely on running once per request
+// nor on running before the next USB event.
 void usbd_defer_func(osal_task_func_t func, void *param, bool in_isr);
 
 
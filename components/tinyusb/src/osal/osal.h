@@ -89,6 +89,7 @@ typedef void (*osal_task_func_t)( void * );
    bool osal_queue_receive(osal_queue_t qhdl, void* data, uint32_t msec);
    bool osal_queue_send(osal_queue_t qhdl, void const * data, bool in_isr);
    bool osal_queue_empty(osal_queue_t qhdl);
+   uint32_t osal_queue_count(osal_queue_t qhdl);
 */
 //--------------------------------------------------------------------+
 
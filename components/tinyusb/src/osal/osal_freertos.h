@@ -222,6 +222,10 @@ TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_empty(osal_queue_t qhdl) {
   return uxQueueMessagesWaiting(qhdl) == 0;
 }
 
+TU_ATTR_ALWAYS_INLINE static inline uint32_t osal_queue_count(osal_queue_t qhdl) {
+  return (uint32_t) uxQueueMessagesWaiting(qhdl);
+}
+
 #ifdef __cplusplus
 }
 #endif
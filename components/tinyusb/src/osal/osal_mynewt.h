@@ -169,6 +169,15 @@ TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_empty(osal_queue_t qhdl) {
   return STAILQ_EMPTY(&qhdl->evq.evq_list);
 }
 
+TU_ATTR_ALWAYS_INLINE static inline uint32_t osal_queue_count(osal_queue_t qhdl) {
+  uint32_t count = 0;
+  struct os_event* ev;
+  STAILQ_FOREACH(ev, &qhdl->evq.evq_list, ev_next) {
+    count++;
+  }
+  return count;
+}
+
 
 #ifdef __cplusplus
  }
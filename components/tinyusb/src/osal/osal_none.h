@@ -189,6 +189,10 @@ TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_empty(osal_queue_t qhdl) {
   return tu_fifo_empty(&qhdl->ff);
 }
 
+TU_ATTR_ALWAYS_INLINE static inline uint32_t osal_queue_count(osal_queue_t qhdl) {
+  return tu_fifo_count(&qhdl->ff);
+}
+
 #ifdef __cplusplus
 }
 #endif
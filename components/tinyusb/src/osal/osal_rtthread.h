@@ -141,6 +141,10 @@ TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_empty(osal_queue_t qhdl) {
   return (qhdl->entry) == 0;
 }
 
+TU_ATTR_ALWAYS_INLINE static inline uint32_t osal_queue_count(osal_queue_t qhdl) {
+  return qhdl->entry;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -166,6 +166,10 @@ TU_ATTR_ALWAYS_INLINE static inline bool osal_queue_empty(osal_queue_t qhdl) {
   return os_mbx_check(qhdl->mbox) == qhdl->depth;
 }
 
+TU_ATTR_ALWAYS_INLINE static inline uint32_t osal_queue_count(osal_queue_t qhdl) {
+  return qhdl->depth - os_mbx_check(qhdl->mbox);
+}
+
 #ifdef __cplusplus
  }
 #endif
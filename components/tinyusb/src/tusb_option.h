@@ -475,6 +475,17 @@
   #define CFG_TUD_TEST_MODE       0
 #endif
 
+// Event queue high water mark and overflow counters, see tud_event_stats_get()
+#ifndef CFG_TUD_EVENT_STATS
+  #define CFG_TUD_EVENT_STATS     0
+#endif
+
+// Deferred functions (usbd_defer_func) get their own queue of this size and run only when no USB event is
+// waiting. Zero queues them with the USB events in order, as before.
+#ifndef CFG_TUD_TASK_FUNC_QUEUE_SZ
+  #define CFG_TUD_TASK_FUNC_QUEUE_SZ  0
+#endif
+
 //------------- Device Class Driver -------------//
 #ifndef CFG_TUD_BTH
   #define CFG_TUD_BTH             0
@@ -52,6 +52,12 @@ bool dcd_init(uint8_t rhport, const tusb_rhport_init_t* rh_init) {
   return true;
 }
 
+bool dcd_deinit(uint8_t rhport) {
+  UNUSED(rhport);
+  state = {false, false, 0};
+  return true;
+}
+
 void dcd_int_handler(uint8_t rhport) {
   assert(_fuzz_data_provider.has_value());
 
@@ -61,14 +67,17 @@ void dcd_int_handler(uint8_t rhport) {
 
   // Choose if we want to generate a signal based on the fuzzed data.
   if (_fuzz_data_provider->ConsumeBool()) {
-    dcd_event_bus_signal(
-        rhport,
-        // Choose a random event based on the fuzz data.
-        (dcd_eventid_t)_fuzz_data_provider->ConsumeIntegralInRange<uint8_t>(
-            DCD_EVENT_INVALID + 1, DCD_EVENT_COUNT - 1),
-        // Identify trigger as either an interrupt or a syncrhonous call
-        // depending on fuzz data.
-        _fuzz_data_provider->ConsumeBool());
+    // Zeroed rather than dcd_event_bus_signal() so the payload of the chosen
+    // event never comes from stack garbage, keeping replays deterministic.
+    dcd_event_t event = {};
+    event.rhport = rhport;
+    // Choose a random event based on the fuzz data. USBD_EVENT_FUNC_CALL is
+    // excluded, it is queued by usbd itself and carries a function pointer.
+    event.event_id = _fuzz_data_provider->ConsumeIntegralInRange<uint8_t>(
+        DCD_EVENT_INVALID + 1, USBD_EVENT_FUNC_CALL - 1);
+    // Identify trigger as either an interrupt or a syncrhonous call
+    // depending on fuzz data.
+    dcd_event_handler(&event, _fuzz_data_provider->ConsumeBool());
   }
 
   if (_fuzz_data_provider->ConsumeBool()) {
@@ -24,6 +24,8 @@
  */
 
 #include "fuzzer/FuzzedDataProvider.h"
+#include "fuzz/fuzz.h"
+#include "tusb.h"
 #include <optional>
 
 std::optional<FuzzedDataProvider> _fuzz_data_provider;
@@ -32,3 +34,11 @@ extern "C" int fuzz_init(const uint8_t *data, size_t size) {
   _fuzz_data_provider.emplace(data, size);
   return 0;
 }
+
+extern "C" __attribute__((weak)) void fuzz_reset_cb(void) {}
+
+extern "C" void fuzz_deinit(void) {
+  tud_deinit(BOARD_TUD_RHPORT);
+  fuzz_reset_cb();
+  _fuzz_data_provider.reset();
+}
@@ -24,6 +24,7 @@
  */
 
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -32,6 +33,13 @@ extern "C" {
 
 int fuzz_init(const uint8_t *data, size_t size);
 
+// Tear the device stack down after an input so the next one starts from the
+// same state, used by the corpus replay driver.
+void fuzz_deinit(void);
+
+// Invoked by fuzz_deinit(), harnesses with their own state reset it here.
+void fuzz_reset_cb(void);
+
 #ifdef __cplusplus
 }
 #endif
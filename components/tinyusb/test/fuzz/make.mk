@@ -31,7 +31,11 @@ SHELL := cmd.exe
 endif
 
 # Build directory
+ifeq ($(REPLAY),1)
+BUILD := _build_replay
+else
 BUILD := _build
+endif
 PROJECT := $(notdir $(CURDIR))
 
 # Handy check parameter function
@@ -63,9 +67,16 @@ else
 endif
 
 #-------------- Fuzz harness flags ------------
+ifeq ($(REPLAY),1)
+# Corpus replay for regression timing: no instrumentation, replay.cc provides main()
+COVERAGE_FLAGS ?=
+SANITIZER_FLAGS ?=
+CFLAGS += -DCFG_TUD_EVENT_STATS=1
+else
 COVERAGE_FLAGS ?= -fsanitize-coverage=trace-pc-guard
 SANITIZER_FLAGS ?= -fsanitize=fuzzer \
                    -fsanitize=address
+endif
 
 CFLAGS += $(COVERAGE_FLAGS) $(SANITIZER_FLAGS)
 
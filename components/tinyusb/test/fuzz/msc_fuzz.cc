@@ -12,6 +12,11 @@
 static std::array<bool, std::numeric_limits<uint8_t>::max()> ejected = {false};
 
 extern "C" {
+// Replay starts every input with all logical units loaded again
+void fuzz_reset_cb(void) {
+  ejected.fill(false);
+}
+
 // Invoked when received SCSI_CMD_INQUIRY
 // Application fill vendor id, product id and revision with string up to 8, 16,
 // 4 characters respectively
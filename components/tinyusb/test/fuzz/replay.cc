@@ -0,0 +1,340 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2024 Ha Thach (tinyusb.org)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+// Corpus replay driver, linked in place of libFuzzer with `make REPLAY=1`.
+// Every input runs on a freshly initialised stack, so its execution time and
+// event counts only depend on the input and the code under test. Results are
+// written as CSV and may be compared against a previous run:
+//
+//   replay [-r repeat] [-o results.csv] [-b baseline.csv] [-t percent]
+//          [-m min_ns] <corpus dir or file>...
+//
+// An input regresses when its best time over `repeat` runs is more than
+// `percent` slower than the baseline, and slower by at least `min_ns` so
+// that timer noise on tiny inputs does not fail the check. The exit code is
+// 1 on any regression.
+
+#include "fuzz/fuzz.h"
+#include "tusb.h"
+
+#include <chrono>
+#include <dirent.h>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#if !CFG_TUD_EVENT_STATS
+#error "Replay counts events with tud_event_stats_get(), CFG_TUD_EVENT_STATS must be enabled"
+#endif
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size);
+
+//--------------------------------------------------------------------+
+// MACRO CONSTANT TYPEDEF PROTYPES
+//--------------------------------------------------------------------+
+#define REPLAY_REPEAT_DEFAULT     20
+#define REPLAY_THRESHOLD_DEFAULT  20   // percent
+#define REPLAY_MIN_NS_DEFAULT     2000
+
+struct ReplayResult {
+  size_t size;
+  uint64_t time_ns;  // best of all repeats
+  uint32_t events;   // events and deferred functions handled by tud_task()
+  uint32_t dropped;  // events lost to a full queue
+};
+
+//--------------------------------------------------------------------+
+// Corpus
+//--------------------------------------------------------------------+
+static bool read_file(const std::string &path, std::vector<uint8_t> &data) {
+  FILE *f = fopen(path.c_str(), "rb");
+  if (f == NULL) {
+    return false;
+  }
+
+  data.clear();
+  uint8_t buf[4096];
+  size_t count;
+  while ((count = fread(buf, 1, sizeof(buf), f)) > 0) {
+    data.insert(data.end(), buf, buf + count);
+  }
+  fclose(f);
+  return true;
+}
+
+// Collect regular files, directories are expanded one level like libFuzzer does
+static void add_corpus(const char *path, std::map<std::string, std::string> &inputs) {
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    fprintf(stderr, "replay: cannot access %s\n", path);
+    exit(2);
+  }
+
+  if (S_ISREG(st.st_mode)) {
+    const char *name = strrchr(path, '/');
+    inputs[name ? name + 1 : path] = path;
+    return;
+  }
+
+  DIR *dir = opendir(path);
+  if (dir == NULL) {
+    fprintf(stderr, "replay: cannot open %s\n", path);
+    exit(2);
+  }
+
+  struct dirent *ent;
+  while ((ent = readdir(dir)) != NULL) {
+    std::string file = std::string(path) + "/" + ent->d_name;
+    if (stat(file.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+      inputs[ent->d_name] = file;
+    }
+  }
+  closedir(dir);
+}
+
+//--------------------------------------------------------------------+
+// Replay
+//--------------------------------------------------------------------+
+static void run_once(const std::vector<uint8_t> &data, uint64_t *time_ns,
+                     uint32_t *events, uint32_t *dropped) {
+  tud_event_stats_reset();
+
+  auto start = std::chrono::steady_clock::now();
+  LLVMFuzzerTestOneInput(data.data(), data.size());
+  auto stop = std::chrono::steady_clock::now();
+
+  tud_event_stats_t stats;
+  tud_event_stats_get(&stats);
+  fuzz_deinit();
+
+  *time_ns = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+  *events = 0;
+  *dropped = 0;
+  for (uint8_t i = 0; i < DCD_EVENT_COUNT; i++) {
+    *events += stats.handled[i];
+    *dropped += stats.overflow[i];
+  }
+}
+
+// Each pass runs every input once, so a slow start of the process (cold
+// caches, clock still ramping up) is spread over the corpus instead of being
+// counted against the first inputs only.
+static bool replay(const std::map<std::string, std::string> &inputs, unsigned repeat,
+                   std::map<std::string, ReplayResult> &results) {
+  bool ok = true;
+  std::map<std::string, std::vector<uint8_t>> corpus;
+  for (const auto &it : inputs) {
+    std::vector<uint8_t> data;
+    if (!read_file(it.second, data)) {
+      fprintf(stderr, "replay: cannot read %s\n", it.second.c_str());
+      ok = false;
+      continue;
+    }
+    results[it.first] = {data.size(), UINT64_MAX, 0, 0};
+    corpus[it.first] = data;
+  }
+
+  for (unsigned i = 0; i < repeat; i++) {
+    for (auto it = corpus.begin(); it != corpus.end();) {
+      ReplayResult &result = results[it->first];
+      uint64_t time_ns;
+      uint32_t events, dropped;
+      run_once(it->second, &time_ns, &events, &dropped);
+
+      if (i > 0 && (events != result.events || dropped != result.dropped)) {
+        fprintf(stderr, "replay: %s is not deterministic, events %u/%u then %u/%u\n",
+                it->first.c_str(), result.events, result.dropped, events, dropped);
+        results.erase(it->first);
+        it = corpus.erase(it);
+        ok = false;
+        continue;
+      }
+
+      result.events = events;
+      result.dropped = dropped;
+      if (time_ns < result.time_ns) {
+        result.time_ns = time_ns;
+      }
+      ++it;
+    }
+  }
+
+  return ok;
+}
+
+//--------------------------------------------------------------------+
+// Results
+//--------------------------------------------------------------------+
+static void write_results(FILE *f, const std::map<std::string, ReplayResult> &results) {
+  fprintf(f, "input,size,time_ns,events,dropped\n");
+  for (const auto &it : results) {
+    const ReplayResult &r = it.second;
+    fprintf(f, "%s,%zu,%llu,%u,%u\n", it.first.c_str(), r.size,
+            (unsigned long long) r.time_ns, r.events, r.dropped);
+  }
+}
+
+static bool load_results(const char *path, std::map<std::string, ReplayResult> &results) {
+  FILE *f = fopen(path, "r");
+  if (f == NULL) {
+    return false;
+  }
+
+  char line[512];
+  while (fgets(line, sizeof(line), f) != NULL) {
+    char *comma = strchr(line, ',');
+    if (comma == NULL || strncmp(line, "input,", 6) == 0) {
+      continue;
+    }
+    *comma = '\0';
+
+    ReplayResult r;
+    unsigned long long time_ns;
+    if (sscanf(comma + 1, "%zu,%llu,%u,%u", &r.size, &time_ns, &r.events, &r.dropped) == 4) {
+      r.time_ns = time_ns;
+      results[line] = r;
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+// Returns number of regressed inputs
+static unsigned compare_results(const std::map<std::string, ReplayResult> &baseline,
+                                const std::map<std::string, ReplayResult> &results,
+                                unsigned threshold, uint64_t min_ns) {
+  unsigned regressed = 0;
+  uint64_t base_total = 0, total = 0;
+
+  for (const auto &it : results) {
+    auto base = baseline.find(it.first);
+    if (base == baseline.end()) {
+      printf("NEW       %s %llu ns\n", it.first.c_str(), (unsigned long long) it.second.time_ns);
+      continue;
+    }
+
+    const ReplayResult &b = base->second;
+    const ReplayResult &r = it.second;
+    base_total += b.time_ns;
+    total += r.time_ns;
+
+    // Event counts are deterministic: a change means behaviour changed and the
+    // timing is no longer comparable like for like, the baseline needs updating.
+    if (r.events != b.events || r.dropped != b.dropped) {
+      printf("CHANGED   %s events %u -> %u, dropped %u -> %u\n", it.first.c_str(),
+             b.events, r.events, b.dropped, r.dropped);
+    }
+
+    if (r.time_ns > b.time_ns + min_ns &&
+        r.time_ns * 100 > b.time_ns * (100 + threshold)) {
+      printf("REGRESSED %s %llu -> %llu ns (+%llu%%)\n", it.first.c_str(),
+             (unsigned long long) b.time_ns, (unsigned long long) r.time_ns,
+             (unsigned long long) ((r.time_ns - b.time_ns) * 100 / (b.time_ns ? b.time_ns : 1)));
+      regressed++;
+    }
+  }
+
+  for (const auto &it : baseline) {
+    if (results.find(it.first) == results.end()) {
+      printf("MISSING   %s\n", it.first.c_str());
+    }
+  }
+
+  printf("total %llu -> %llu ns, %u of %zu inputs regressed by more than %u%%\n",
+         (unsigned long long) base_total, (unsigned long long) total, regressed,
+         results.size(), threshold);
+  return regressed;
+}
+
+//--------------------------------------------------------------------+
+// Main
+//--------------------------------------------------------------------+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "usage: %s [-r repeat] [-o results.csv] [-b baseline.csv] [-t percent] [-m min_ns] "
+          "<corpus dir or file>...\n", prog);
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  unsigned repeat = REPLAY_REPEAT_DEFAULT;
+  unsigned threshold = REPLAY_THRESHOLD_DEFAULT;
+  uint64_t min_ns = REPLAY_MIN_NS_DEFAULT;
+  const char *output = NULL;
+  const char *baseline_path = NULL;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "r:o:b:t:m:")) != -1) {
+    switch (opt) {
+      case 'r': repeat = (unsigned) strtoul(optarg, NULL, 0); break;
+      case 'o': output = optarg; break;
+      case 'b': baseline_path = optarg; break;
+      case 't': threshold = (unsigned) strtoul(optarg, NULL, 0); break;
+      case 'm': min_ns = strtoull(optarg, NULL, 0); break;
+      default: usage(argv[0]);
+    }
+  }
+  if (optind >= argc || repeat == 0) {
+    usage(argv[0]);
+  }
+
+  std::map<std::string, std::string> inputs;
+  for (int i = optind; i < argc; i++) {
+    add_corpus(argv[i], inputs);
+  }
+
+  std::map<std::string, ReplayResult> results;
+  bool const ok = replay(inputs, repeat, results);
+
+  if (output) {
+    FILE *f = fopen(output, "w");
+    if (f == NULL) {
+      fprintf(stderr, "replay: cannot write %s\n", output);
+      return 2;
+    }
+    write_results(f, results);
+    fclose(f);
+  } else if (!baseline_path) {
+    write_results(stdout, results);
+  }
+
+  if (baseline_path) {
+    std::map<std::string, ReplayResult> baseline;
+    if (!load_results(baseline_path, baseline)) {
+      fprintf(stderr, "replay: cannot read baseline %s\n", baseline_path);
+      return 2;
+    }
+    if (compare_results(baseline, results, threshold, min_ns) > 0) {
+      return 1;
+    }
+  }
+
+  return ok ? 0 : 1;
+}
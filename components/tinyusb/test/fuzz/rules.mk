@@ -46,6 +46,12 @@ SRC_CXX += \
 	test/fuzz/net_fuzz.cc \
 	test/fuzz/usbd_fuzz.cc
 
+ifeq ($(REPLAY),1)
+SRC_CXX += test/fuzz/replay.cc
+else ifneq ($(filter replay replay-check replay-baseline,$(MAKECMDGOALS)),)
+$(error replay targets need REPLAY=1)
+endif
+
 # TinyUSB stack include
 INC += $(TOP)/src
 
@@ -144,6 +150,29 @@ endif
 get-deps:
 	$(PYTHON) $(TOP)/tools/get_deps.py $(DEPS_SUBMODULES)
 
+# Replay a fixed corpus and compare timing against a previous run, e.g.
+#   make REPLAY=1 replay CORPUS=corpus REPLAY_ARGS="-o results.csv"
+#   make REPLAY=1 replay CORPUS=corpus REPLAY_ARGS="-b results.csv -t 10"
+.PHONY: replay
+replay: $(BUILD)/$(PROJECT)
+	$(call check_defined, CORPUS)
+	$(BUILD)/$(PROJECT) $(REPLAY_ARGS) $(CORPUS)
+
+# Fixed seed corpus and the results it is checked against, committed next to each fuzzer
+REPLAY_CORPUS ?= corpus
+REPLAY_BASELINE ?= replay_baseline.csv
+
+# Replay the committed corpus, fails on a regression against the committed baseline
+#   make REPLAY=1 replay-check
+# Timings only compare on the machine that wrote them, rewrite the baseline there first
+#   make REPLAY=1 replay-baseline
+.PHONY: replay-check replay-baseline
+replay-check: $(BUILD)/$(PROJECT)
+	$(BUILD)/$(PROJECT) $(REPLAY_ARGS) -b $(REPLAY_BASELINE) $(REPLAY_CORPUS)
+
+replay-baseline: $(BUILD)/$(PROJECT)
+	$(BUILD)/$(PROJECT) $(REPLAY_ARGS) -o $(REPLAY_BASELINE) $(REPLAY_CORPUS)
+
 size: $(BUILD)/$(PROJECT)
 	-@echo ''
 	@$(SIZE) $<
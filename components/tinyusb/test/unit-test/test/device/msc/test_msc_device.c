@@ -280,3 +280,98 @@ void test_msc(void)
 
   tud_task();
 }
+
+// Open the MSC interface and receive the command block wrapper
+static void msc_receive_cbw(msc_cbw_t const* cbw)
+{
+  desc_configuration = data_desc_configuration;
+  uint8_t const* desc_ep = tu_desc_next(tu_desc_next(desc_configuration));
+
+  dcd_event_setup_received(rhport, (uint8_t*) &request_set_configuration, false);
+
+  // open endpoints
+  dcd_edpt_open_ExpectAndReturn(rhport, (tusb_desc_endpoint_t const *) desc_ep, true);
+  dcd_edpt_open_ExpectAndReturn(rhport, (tusb_desc_endpoint_t const *) tu_desc_next(desc_ep), true);
+
+  // Prepare SCSI command
+  dcd_edpt_xfer_ExpectAndReturn(rhport, EDPT_MSC_OUT, NULL, sizeof(msc_cbw_t), true);
+  dcd_edpt_xfer_IgnoreArg_buffer();
+  dcd_edpt_xfer_ReturnMemThruPtr_buffer( (uint8_t*) cbw, sizeof(msc_cbw_t));
+
+  // command received
+  dcd_event_xfer_complete(rhport, EDPT_MSC_OUT, sizeof(msc_cbw_t), 0, true);
+
+  // control status
+  dcd_edpt_xfer_ExpectAndReturn(rhport, EDPT_CTRL_IN, NULL, 0, true);
+}
+
+// SCSI Status then prepare for next command
+static void msc_expect_csw(void)
+{
+  dcd_edpt_xfer_ExpectAndReturn(rhport, EDPT_MSC_IN, NULL, 13, true);
+  dcd_edpt_xfer_IgnoreArg_buffer();
+  dcd_event_xfer_complete(rhport, EDPT_MSC_IN, 13, 0, true);
+
+  dcd_edpt_xfer_ExpectAndReturn(rhport, EDPT_MSC_OUT, NULL, sizeof(msc_cbw_t), true);
+  dcd_edpt_xfer_IgnoreArg_buffer();
+}
+
+void test_msc_mode_sense10(void)
+{
+  // Built-in: answered with the 8 bytes header without reaching tud_msc_scsi_cb()
+  msc_cbw_t cbw =
+  {
+    .signature = MSC_CBW_SIGNATURE,
+    .tag = 0xCAFECAFE,
+    .total_bytes = 8,
+    .lun = 0,
+    .dir = TUSB_DIR_IN_MASK,
+    .cmd_len = sizeof(scsi_mode_sense10_t)
+  };
+
+  scsi_mode_sense10_t cmd =
+  {
+    .cmd_code     = SCSI_CMD_MODE_SENSE_10,
+    .page_code    = 0x3F,
+    .alloc_length = tu_htons(8)
+  };
+
+  memcpy(cbw.command, &cmd, cbw.cmd_len);
+
+  msc_receive_cbw(&cbw);
+
+  // SCSI Data transfer
+  dcd_edpt_xfer_ExpectAndReturn(rhport, EDPT_MSC_IN, NULL, 8, true);
+  dcd_edpt_xfer_IgnoreArg_buffer();
+  dcd_event_xfer_complete(rhport, EDPT_MSC_IN, 8, 0, true);
+
+  msc_expect_csw();
+
+  tud_task();
+}
+
+void test_msc_synchronize_cache10(void)
+{
+  // Built-in: no data stage, status passed
+  msc_cbw_t cbw =
+  {
+    .signature = MSC_CBW_SIGNATURE,
+    .tag = 0xCAFECAFE,
+    .total_bytes = 0,
+    .lun = 0,
+    .dir = 0,
+    .cmd_len = sizeof(scsi_synchronize_cache10_t)
+  };
+
+  scsi_synchronize_cache10_t cmd =
+  {
+    .cmd_code = SCSI_CMD_SYNCHRONIZE_CACHE_10,
+  };
+
+  memcpy(cbw.command, &cmd, cbw.cmd_len);
+
+  msc_receive_cbw(&cbw);
+  msc_expect_csw();
+
+  tud_task();
+}
@@ -29,6 +29,7 @@
 #include "tusb_fifo.h"
 #include "tusb.h"
 #include "usbd.h"
+#include "usbd_pvt.h"
 TEST_SOURCE_FILE("usbd_control.c")
 
 // Mock File
@@ -246,3 +247,199 @@ void test_usbd_control_in_zlp(void)
 
   tud_task();
 }
+
+//--------------------------------------------------------------------+
+// Event Queue
+//--------------------------------------------------------------------+
+static uint32_t sof_cb_count;
+static uint32_t sof_cb_frame;
+
+// order in which SOF callbacks (0xFF) and deferred functions (their param) ran
+static uint8_t call_log[64];
+static uint8_t call_log_count;
+
+void tud_sof_cb(uint32_t frame_count) {
+  sof_cb_count++;
+  sof_cb_frame = frame_count;
+  if (call_log_count < sizeof(call_log)) {
+    call_log[call_log_count++] = 0xFF;
+  }
+}
+
+static uint32_t func_call_count;
+
+static void count_func_call(void* param) {
+  func_call_count++;
+  if (call_log_count < sizeof(call_log)) {
+    call_log[call_log_count++] = (uint8_t) (uintptr_t) param;
+  }
+}
+
+static void event_queue_reset(void) {
+  tud_event_stats_reset();
+  sof_cb_count = 0;
+  func_call_count = 0;
+  call_log_count = 0;
+}
+
+// DCD fires events far faster than tud_task() drains them: SOFs are coalesced and deferred functions wait in
+// their own queue, so that no event is dropped
+void test_usbd_event_queue_burst(void)
+{
+  uint32_t const frame_total = 4*CFG_TUD_TASK_QUEUE_SZ;
+  uint32_t func_total = 0;
+
+  dcd_sof_enable_Expect(rhport, true);
+  tud_sof_cb_enable(true);
+  event_queue_reset();
+
+  // more events than the queue can hold
+  for (uint32_t frame = 0; frame < frame_total; frame++) {
+    dcd_event_sof(rhport, frame, true);
+    if (frame % 32 == 0) {
+      usbd_defer_func(count_func_call, (void*) (uintptr_t) func_total, true);
+      func_total++;
+    }
+  }
+  TEST_ASSERT_GREATER_THAN(CFG_TUD_TASK_QUEUE_SZ, frame_total + func_total);
+  TEST_ASSERT_LESS_OR_EQUAL(CFG_TUD_TASK_FUNC_QUEUE_SZ, func_total);
+
+  tud_task();
+
+  TEST_ASSERT_EQUAL(func_total, func_call_count);
+  TEST_ASSERT_EQUAL(1, sof_cb_count);
+  TEST_ASSERT_EQUAL(frame_total - 1, sof_cb_frame);
+
+  tud_event_stats_t stats;
+  tud_event_stats_get(&stats);
+  TEST_ASSERT_EQUAL(CFG_TUD_TASK_QUEUE_SZ, stats.queue_size);
+  TEST_ASSERT_EQUAL(2, stats.queue_high_water); // one SOF and one deferred function wakeup
+  TEST_ASSERT_EQUAL(func_total, stats.func_queue_high_water);
+  TEST_ASSERT_EQUAL(frame_total - 1, stats.sof_coalesced);
+  for (uint8_t i = 0; i < DCD_EVENT_COUNT; i++) {
+    TEST_ASSERT_EQUAL(0, stats.overflow[i]);
+  }
+
+  // SOF is queued again once the previous one has been handled
+  dcd_event_sof(rhport, frame_total, true);
+  tud_task();
+  TEST_ASSERT_EQUAL(2, sof_cb_count);
+  TEST_ASSERT_EQUAL(frame_total, sof_cb_frame);
+
+  dcd_sof_enable_Expect(rhport, false);
+  tud_sof_cb_enable(false);
+}
+
+// USB events are handled before deferred functions queued earlier
+void test_usbd_deferred_func_after_events(void)
+{
+  dcd_sof_enable_Expect(rhport, true);
+  tud_sof_cb_enable(true);
+  event_queue_reset();
+
+  usbd_defer_func(count_func_call, (void*) 1, false);
+  usbd_defer_func(count_func_call, (void*) 2, false);
+  dcd_event_sof(rhport, 1, true);
+
+  tud_task();
+
+  uint8_t const expected[] = { 0xFF, 1, 2 };
+  TEST_ASSERT_EQUAL(sizeof(expected), call_log_count);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, call_log, sizeof(expected));
+
+  dcd_sof_enable_Expect(rhport, false);
+  tud_sof_cb_enable(false);
+}
+
+// Identical calls waiting together run once, in the position of the first one
+void test_usbd_deferred_func_batched(void)
+{
+  event_queue_reset();
+
+  usbd_defer_func(count_func_call, (void*) 1, false);
+  for (uint8_t i = 0; i < 5; i++) {
+    usbd_defer_func(count_func_call, (void*) 2, false);
+  }
+  usbd_defer_func(count_func_call, (void*) 3, false);
+
+  tud_task();
+
+  uint8_t const expected[] = { 1, 2, 3 };
+  TEST_ASSERT_EQUAL(sizeof(expected), call_log_count);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, call_log, sizeof(expected));
+
+  tud_event_stats_t stats;
+  tud_event_stats_get(&stats);
+  TEST_ASSERT_EQUAL(4, stats.func_batched);
+
+  // a call made after its twin has run is not batched with it
+  usbd_defer_func(count_func_call, (void*) 2, false);
+  tud_task();
+  TEST_ASSERT_EQUAL(4, func_call_count);
+}
+
+// Overflow is counted per event type when a queue really is full
+void test_usbd_event_queue_overflow(void)
+{
+  event_queue_reset();
+
+  for (uint32_t i = 0; i < CFG_TUD_TASK_FUNC_QUEUE_SZ + 3; i++) {
+    usbd_defer_func(count_func_call, (void*) (uintptr_t) i, true);
+  }
+
+  tud_task();
+
+  tud_event_stats_t stats;
+  tud_event_stats_get(&stats);
+  TEST_ASSERT_EQUAL(CFG_TUD_TASK_FUNC_QUEUE_SZ, func_call_count);
+  TEST_ASSERT_EQUAL(CFG_TUD_TASK_FUNC_QUEUE_SZ, stats.func_queue_high_water);
+  TEST_ASSERT_EQUAL(3, stats.overflow[USBD_EVENT_FUNC_CALL]);
+  TEST_ASSERT_EQUAL(0, stats.overflow[DCD_EVENT_XFER_COMPLETE]);
+}
+
+//--------------------------------------------------------------------+
+// SOF
+//--------------------------------------------------------------------+
+
+// SOF requested by the application survives a bus reset
+void test_usbd_sof_enable_survives_bus_reset(void)
+{
+  dcd_sof_enable_Expect(rhport, true);
+  tud_sof_cb_enable(true);
+  event_queue_reset();
+
+  dcd_event_bus_reset(rhport, TUSB_SPEED_FULL, false);
+  mscd_reset_Expect(rhport);
+  tud_task();
+
+  dcd_event_sof(rhport, 7, true);
+  tud_task();
+  TEST_ASSERT_EQUAL(1, sof_cb_count);
+  TEST_ASSERT_EQUAL(7, sof_cb_frame);
+
+  tud_event_stats_t stats;
+  tud_event_stats_get(&stats);
+  TEST_ASSERT_EQUAL(1, stats.handled[DCD_EVENT_BUS_RESET]);
+  TEST_ASSERT_EQUAL(1, stats.handled[DCD_EVENT_SOF]);
+
+  dcd_sof_enable_Expect(rhport, false);
+  tud_sof_cb_enable(false);
+}
+
+// A bus reset drops the class drivers' SOF requests, with nobody left the interrupt is turned off
+void test_usbd_sof_disabled_on_bus_reset(void)
+{
+  dcd_sof_enable_Expect(rhport, true);
+  usbd_sof_enable(rhport, SOF_CONSUMER_AUDIO, true);
+  event_queue_reset();
+
+  dcd_event_bus_reset(rhport, TUSB_SPEED_FULL, false);
+  mscd_reset_Expect(rhport);
+  dcd_sof_enable_Expect(rhport, false);
+  tud_task();
+
+  // a frame already in flight is not delivered to the application
+  dcd_event_sof(rhport, 1, true);
+  tud_task();
+  TEST_ASSERT_EQUAL(0, sof_cb_count);
+}
@@ -74,6 +74,8 @@
 //--------------------------------------------------------------------
 
 #define CFG_TUD_TASK_QUEUE_SZ    100
+#define CFG_TUD_EVENT_STATS      1
+#define CFG_TUD_TASK_FUNC_QUEUE_SZ 16
 #define CFG_TUD_ENDPOINT0_SIZE    64
 
 //------------- CLASS -------------//
@@ -1,32 +1,271 @@
 #include "esp32_wifi.h"
 
+ESP_EVENT_DEFINE_BASE(WIFI_MGR_EVENT);
+
+static wifi_config_t s_wifi_config;
+static wifi_ap_cache_t s_ap_cache;
+static bool s_ap_cache_valid = false;
+static esp_timer_handle_t s_sm_timer = NULL;
+static int64_t s_start_us = 0;
+static wifi_connect_stats_t s_stats;
+static wifi_sm_t s_sm;
+static wifi_link_cb_t s_link_cb = NULL;
+static WIFI s_networks[WIFI_MAX_NETWORKS];
+static int s_network_num = 0;
+static int s_network_idx = 0;
+static void *s_link_cb_arg = NULL;
+
+static bool wifi_cache_load(wifi_ap_cache_t *cache) {
+    nvs_handle_t handle;
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    size_t len = sizeof(wifi_ap_cache_t);
+    esp_err_t err = nvs_get_blob(handle, "ap", cache, &len);
+    nvs_close(handle);
+    return err == ESP_OK && len == sizeof(wifi_ap_cache_t);
+}
+
+static void wifi_cache_save(const wifi_ap_cache_t *cache) {
+    nvs_handle_t handle;
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    nvs_set_blob(handle, "ap", cache, sizeof(wifi_ap_cache_t));
+    nvs_commit(handle);
+    nvs_close(handle);
+}
+
+// 安全复制SSID和密码
+static void wifi_config_set_network(wifi_config_t *config, const WIFI *network) {
+    size_t ssid_len = strnlen(network->ssid, sizeof(network->ssid));
+    if (ssid_len > sizeof(config->sta.ssid) - 1) {
+        ssid_len = sizeof(config->sta.ssid) - 1;
+    }
+    memset(config->sta.ssid, 0, sizeof(config->sta.ssid));
+    memcpy(config->sta.ssid, network->ssid, ssid_len);
+
+    size_t pwd_len = strnlen(network->passport, sizeof(network->passport));
+    if (pwd_len > sizeof(config->sta.password) - 1) {
+        pwd_len = sizeof(config->sta.password) - 1;
+    }
+    memset(config->sta.password, 0, sizeof(config->sta.password));
+    memcpy(config->sta.password, network->passport, pwd_len);
+}
+
+// 缓存直连失败后 改为全信道扫描并按信号强度选择AP
+static void wifi_use_scan(void) {
+    s_wifi_config.sta.bssid_set = false;
+    s_wifi_config.sta.channel = 0;
+    s_wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    s_wifi_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    esp_wifi_set_config(WIFI_IF_STA, &s_wifi_config);
+}
+
+// 定时器在esp_timer任务中触发, 转发到事件循环, 保证状态机只在一个任务中运行
+static void wifi_sm_timer_cb(void *arg) {
+    esp_event_post(WIFI_MGR_EVENT, WIFI_MGR_EVENT_TIMER, NULL, 0, 0);
+}
+
+// 执行状态机要求的动作
+static void wifi_sm_apply(uint32_t act) {
+    if (act & WIFI_SM_ACT_USE_SCAN) {
+        ESP_LOGI(TAG, "cached AP unavailable, fall back to full scan");
+        wifi_use_scan();
+    }
+    if (act & WIFI_SM_ACT_DISCONNECT) {
+        esp_wifi_disconnect();
+    }
+    if (act & (WIFI_SM_ACT_CANCEL_TIMER | WIFI_SM_ACT_ARM_TIMER)) {
+        esp_timer_stop(s_sm_timer);
+    }
+    if (act & WIFI_SM_ACT_ARM_TIMER) {
+        esp_timer_start_once(s_sm_timer, (uint64_t)s_sm.timer_ms * 1000);
+    }
+    if (act & WIFI_SM_ACT_CONNECT) {
+        esp_wifi_connect();
+    }
+    if (act & WIFI_SM_ACT_SAMPLE_RSSI) {
+        int rssi;
+        if (esp_wifi_sta_get_rssi(&rssi) == ESP_OK) {
+            wifi_sm_rssi(&s_sm, rssi);
+        }
+    }
+    if (act & WIFI_SM_ACT_FAILED) {
+        ESP_LOGW(TAG, "failed %lu times, keep retrying in background", (unsigned long)s_sm.retry);
+        xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
+    }
+    if (act & WIFI_SM_ACT_LINK_UP) {
+        xEventGroupClearBits(s_wifi_event_group, WIFI_FAIL_BIT);
+        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+        if (s_link_cb) {
+            s_link_cb(true, s_link_cb_arg);
+        }
+    }
+    if (act & WIFI_SM_ACT_LINK_DOWN) {
+        xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+        if (s_link_cb) {
+            s_link_cb(false, s_link_cb_arg);
+        }
+    }
+    if ((act & WIFI_SM_ACT_ARM_TIMER) && s_sm.state == WIFI_STATE_BACKOFF) {
+        // 配置了多个网络时 每个网络失败WIFI_RETRY_PER_NETWORK次后换下一个
+        if (s_network_num > 1 && s_sm.retry % WIFI_RETRY_PER_NETWORK == 0) {
+            s_network_idx = (s_network_idx + 1) % s_network_num;
+            wifi_config_set_network(&s_wifi_config, &s_networks[s_network_idx]);
+            wifi_use_scan();
+            ESP_LOGI(TAG, "switch to network %s", s_networks[s_network_idx].ssid);
+        }
+        ESP_LOGI(TAG, "connect to the AP fail, retry in %lums", (unsigned long)s_sm.timer_ms);
+    }
+}
+
+// 替换候选网络 当前网络被删除或密码改变时重新连接
+static void wifi_apply_networks(const wifi_networks_t *list) {
+    const WIFI *current = s_network_num > 0 ? &s_networks[s_network_idx] : NULL;
+    int keep = -1;
+    for (int i = 0; current && i < list->num; i++) {
+        if (strncmp(list->networks[i].ssid, current->ssid, sizeof(current->ssid)) == 0 &&
+            strncmp(list->networks[i].passport, current->passport, sizeof(current->passport)) == 0) {
+            keep = i;
+            break;
+        }
+    }
+    memcpy(s_networks, list->networks, list->num * sizeof(WIFI));
+    s_network_num = list->num;
+    if (keep >= 0) {
+        s_network_idx = keep;
+        ESP_LOGI(TAG, "network list updated, keep %s", s_networks[keep].ssid);
+        return;
+    }
+
+    s_network_idx = 0;
+    ESP_LOGI(TAG, "network list updated, switch to %s", s_networks[0].ssid);
+    // 停止后重新开始 旧连接断开的事件会按一次失败处理, 短暂退避后重连
+    wifi_state_t state = s_sm.state;
+    wifi_sm_apply(wifi_sm_event(&s_sm, WIFI_SM_EV_STOP));
+    wifi_config_set_network(&s_wifi_config, &s_networks[0]);
+    wifi_use_scan();
+    if (state != WIFI_STATE_IDLE) {
+        wifi_sm_apply(wifi_sm_event(&s_sm, WIFI_SM_EV_START));
+    }
+}
+
 static void event_handler(void* arg, esp_event_base_t event_base,
                                 int32_t event_id, void* event_data)
 {
+    uint32_t act = 0;
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
-    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        if (s_retry_num < EXAMPLE_ESP_MAXIMUM_RETRY) {
-            esp_wifi_connect();
-            s_retry_num++;
-            ESP_LOGI(TAG, "retry to connect to the AP");
-        } else {
-            xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
+        act = wifi_sm_event(&s_sm, WIFI_SM_EV_START);
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        wifi_event_sta_connected_t *event = (wifi_event_sta_connected_t *) event_data;
+        if (!s_stats.connected_us) {
+            s_stats.connected_us = esp_timer_get_time() - s_start_us;
         }
-        ESP_LOGI(TAG,"connect to the AP fail");
+        s_stats.channel = event->channel;
+        // AP变化时才写NVS
+        wifi_ap_cache_t cache = { .channel = event->channel };
+        memcpy(cache.ssid, s_wifi_config.sta.ssid, sizeof(cache.ssid));
+        memcpy(cache.bssid, event->bssid, sizeof(cache.bssid));
+        if (!s_ap_cache_valid || memcmp(&cache, &s_ap_cache, sizeof(cache)) != 0) {
+            s_ap_cache = cache;
+            s_ap_cache_valid = true;
+            wifi_cache_save(&cache);
+        }
+        act = wifi_sm_event(&s_sm, WIFI_SM_EV_ASSOC);
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        wifi_event_sta_disconnected_t *event = (wifi_event_sta_disconnected_t *) event_data;
+        s_stats.last_reason = event->reason;
+        act = wifi_sm_event(&s_sm, WIFI_SM_EV_DISCONNECTED);
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
-        ESP_LOGI(TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip));
-        s_retry_num = 0;
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
+        if (!s_stats.got_ip_us) {
+            s_stats.got_ip_us = esp_timer_get_time() - s_start_us;
+        }
+        act = wifi_sm_event(&s_sm, WIFI_SM_EV_GOT_IP);
+        ESP_LOGI(TAG, "got ip:" IPSTR " in %lldms (%s, %lu attempts)", IP2STR(&event->ip_info.ip),
+                 s_stats.got_ip_us / 1000, s_sm.fast_path_ok ? "cached AP" : "scan",
+                 (unsigned long)s_sm.attempts);
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_LOST_IP) {
+        act = wifi_sm_event(&s_sm, WIFI_SM_EV_LOST_IP);
+    } else if (event_base == WIFI_MGR_EVENT && event_id == WIFI_MGR_EVENT_TIMER) {
+        act = wifi_sm_event(&s_sm, WIFI_SM_EV_TIMER);
+    } else if (event_base == WIFI_MGR_EVENT && event_id == WIFI_MGR_EVENT_STOP) {
+        act = wifi_sm_event(&s_sm, WIFI_SM_EV_STOP);
+    } else if (event_base == WIFI_MGR_EVENT && event_id == WIFI_MGR_EVENT_RECONFIG) {
+        wifi_apply_networks((const wifi_networks_t *) event_data);
+    }
+    wifi_sm_apply(act);
+}
+
+void wifi_get_connect_stats(wifi_connect_stats_t *stats)
+{
+    wifi_sm_t sm = s_sm;
+    *stats = s_stats;
+    stats->state = sm.state;
+    stats->fast_path_ok = sm.fast_path_ok;
+    stats->attempts = sm.attempts;
+    stats->retry = sm.retry;
+    stats->connects = sm.connects;
+    stats->disconnects = sm.disconnects;
+    stats->timeouts = sm.timeouts;
+    stats->rssi = sm.rssi;
+    stats->rssi_avg = sm.rssi_avg_x16 / 16;
+    stats->rssi_min = sm.rssi_min;
+}
+
+void wifi_set_networks(const WIFI *networks, int num)
+{
+    s_network_num = num < WIFI_MAX_NETWORKS ? num : WIFI_MAX_NETWORKS;
+    memcpy(s_networks, networks, s_network_num * sizeof(WIFI));
+    s_network_idx = 0;
+}
+
+void wifi_set_link_callback(wifi_link_cb_t cb, void *arg)
+{
+    s_link_cb_arg = arg;
+    s_link_cb = cb;
+}
+
+esp_err_t wifi_wait_connected(TickType_t timeout)
+{
+    if (!s_wifi_event_group) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group, WIFI_CONNECTED_BIT, pdFALSE, pdFALSE, timeout);
+    return (bits & WIFI_CONNECTED_BIT) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t wifi_reconfigure(const WIFI *networks, int num)
+{
+    if (!networks || num <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_wifi_event_group) {
+        return ESP_ERR_INVALID_STATE;
     }
+    wifi_networks_t list = { .num = num < WIFI_MAX_NETWORKS ? num : WIFI_MAX_NETWORKS };
+    memcpy(list.networks, networks, list.num * sizeof(WIFI));
+    return esp_event_post(WIFI_MGR_EVENT, WIFI_MGR_EVENT_RECONFIG, &list, sizeof(list), portMAX_DELAY);
+}
+
+void wifi_stop(void)
+{
+    esp_event_post(WIFI_MGR_EVENT, WIFI_MGR_EVENT_STOP, NULL, 0, portMAX_DELAY);
 }
 
 void wifi_init_sta(void *pvParam)
 {
     WIFI* WIFI_LOG = (WIFI*) pvParam;
+    s_start_us = esp_timer_get_time();
     s_wifi_event_group = xEventGroupCreate();
 
+    const esp_timer_create_args_t sm_timer_args = {
+        .callback = wifi_sm_timer_cb,
+        .name = "wifi_sm",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&sm_timer_args, &s_sm_timer));
+
     ESP_ERROR_CHECK(esp_netif_init());
 
     ESP_ERROR_CHECK(esp_event_loop_create_default());
@@ -37,6 +276,8 @@ void wifi_init_sta(void *pvParam)
 
     esp_event_handler_instance_t instance_any_id;
     esp_event_handler_instance_t instance_got_ip;
+    esp_event_handler_instance_t instance_lost_ip;
+    esp_event_handler_instance_t instance_mgr;
     ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
                                                         ESP_EVENT_ANY_ID,
                                                         &event_handler,
@@ -47,6 +288,16 @@ void wifi_init_sta(void *pvParam)
                                                         &event_handler,
                                                         NULL,
                                                         &instance_got_ip));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
+                                                        IP_EVENT_STA_LOST_IP,
+                                                        &event_handler,
+                                                        NULL,
+                                                        &instance_lost_ip));
+    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_MGR_EVENT,
+                                                        ESP_EVENT_ANY_ID,
+                                                        &event_handler,
+                                                        NULL,
+                                                        &instance_mgr));
 
     wifi_config_t wifi_config = {
         .sta = {
@@ -60,21 +311,34 @@ void wifi_init_sta(void *pvParam)
             .sae_h2e_identifier = EXAMPLE_H2E_IDENTIFIER,
         },
     };
-    // 安全复制SSID
-    size_t ssid_len = strlen(WIFI_LOG->ssid);
-    if (ssid_len > sizeof(wifi_config.sta.ssid) - 1) {
-        ssid_len = sizeof(wifi_config.sta.ssid) - 1;
-    }
-    memcpy(wifi_config.sta.ssid, WIFI_LOG->ssid, ssid_len);
-    wifi_config.sta.ssid[ssid_len] = '\0';
-    
-    // 安全复制密码
-    size_t pwd_len = strlen(WIFI_LOG->passport);
-    if (pwd_len > sizeof(wifi_config.sta.password) - 1) {
-        pwd_len = sizeof(wifi_config.sta.password) - 1;
-    }
-    memcpy(wifi_config.sta.password, WIFI_LOG->passport, pwd_len);
-    wifi_config.sta.password[pwd_len] = '\0';
+    if (WIFI_LOG && s_network_num == 0) {
+        s_networks[0] = *WIFI_LOG;
+        s_network_num = 1;
+    }
+
+    // 同一SSID有缓存时从该网络开始, 直接连接缓存的BSSID和信道
+    s_ap_cache_valid = wifi_cache_load(&s_ap_cache);
+    for (int i = 0; s_ap_cache_valid && i < s_network_num; i++) {
+        if (strncmp((const char *)s_ap_cache.ssid, s_networks[i].ssid, sizeof(s_ap_cache.ssid)) == 0) {
+            s_network_idx = i;
+            break;
+        }
+    }
+    wifi_config_set_network(&wifi_config, &s_networks[s_network_idx]);
+
+    if (s_ap_cache_valid && memcmp(s_ap_cache.ssid, wifi_config.sta.ssid, sizeof(s_ap_cache.ssid)) == 0) {
+        wifi_config.sta.bssid_set = true;
+        memcpy(wifi_config.sta.bssid, s_ap_cache.bssid, sizeof(s_ap_cache.bssid));
+        wifi_config.sta.channel = s_ap_cache.channel;
+        wifi_config.sta.scan_method = WIFI_FAST_SCAN;
+        s_stats.fast_path = true;
+        ESP_LOGI(TAG, "fast connect to cached AP on channel %d", s_ap_cache.channel);
+    } else {
+        wifi_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        wifi_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+    }
+    s_wifi_config = wifi_config;
+    wifi_sm_init(&s_sm, s_stats.fast_path, EXAMPLE_ESP_MAXIMUM_RETRY);
 
     printf("%s",wifi_config.sta.ssid);
     printf("%s",wifi_config.sta.password);
@@ -82,25 +346,6 @@ void wifi_init_sta(void *pvParam)
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config) );
     ESP_ERROR_CHECK(esp_wifi_start() );
 
+    // 连接结果由事件驱动, 用wifi_wait_connected()或链路回调获取
     ESP_LOGI(TAG, "wifi_init_sta finished.");
-
-    /* Waiting until either the connection is established (WIFI_CONNECTED_BIT) or connection failed for the maximum
-     * number of re-tries (WIFI_FAIL_BIT). The bits are set by event_handler() (see above) */
-    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
-            WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
-            pdFALSE,
-            pdFALSE,
-            portMAX_DELAY);
-
-    /* xEventGroupWaitBits() returns the bits before the call returned, hence we can test which event actually
-     * happened. */
-    if (bits & WIFI_CONNECTED_BIT) {
-        ESP_LOGI(TAG, "connected to ap SSID:%s password:%s",
-                 wifi_config.sta.ssid, wifi_config.sta.password);
-    } else if (bits & WIFI_FAIL_BIT) {
-        ESP_LOGI(TAG, "Failed to connect to SSID:%s, password:%s",
-                 wifi_config.sta.ssid, wifi_config.sta.password);
-    } else {
-        ESP_LOGE(TAG, "UNEXPECTED EVENT");
-    }
 }
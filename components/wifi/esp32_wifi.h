@@ -9,11 +9,15 @@
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
+#include "nvs.h"
 
 #include "lwip/err.h"
 #include "lwip/sys.h"
 
+#include "wifi_sm.h"
+
 
 typedef struct {
 char ssid[64];
@@ -63,11 +67,75 @@ static EventGroupHandle_t s_wifi_event_group;
 
 #define TAG  "wifi station"
 
-static int s_retry_num = 0;
+#define WIFI_NVS_NAMESPACE      "wifi_fast"
+#define WIFI_MAX_NETWORKS       4
+#define WIFI_RETRY_PER_NETWORK  2       // 多个网络时 每个网络连续失败几次后换下一个
+
+// 连接管理器内部事件 定时器和外部请求都投递到默认事件循环, 状态机只在事件循环任务中运行
+ESP_EVENT_DECLARE_BASE(WIFI_MGR_EVENT);
+enum {
+    WIFI_MGR_EVENT_TIMER = 0,
+    WIFI_MGR_EVENT_STOP,
+    WIFI_MGR_EVENT_RECONFIG,    // 数据为wifi_networks_t
+};
+
+// 候选网络列表 随WIFI_MGR_EVENT_RECONFIG投递 (事件循环会复制数据)
+typedef struct {
+    WIFI networks[WIFI_MAX_NETWORKS];
+    int num;
+} wifi_networks_t;
+
+// 上次连接成功的AP 保存在NVS, 下次启动时直接连接, 跳过全信道扫描
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t bssid[6];
+    uint8_t channel;
+} wifi_ap_cache_t;
+
+// 连接统计 时间均相对wifi_init_sta开始 (us)
+typedef struct {
+    wifi_state_t state;
+    bool fast_path;          // 是否尝试了缓存的BSSID/信道
+    bool fast_path_ok;       // 缓存直连是否成功
+    uint32_t attempts;       // 连接尝试次数
+    uint32_t retry;          // 当前连续失败次数
+    uint32_t connects;       // 获取IP次数
+    uint32_t disconnects;    // 连接后掉线次数
+    uint32_t timeouts;       // 连接超时次数
+    uint8_t last_reason;     // 最近一次断开原因 (wifi_err_reason_t)
+    int64_t connected_us;    // 首次关联成功
+    int64_t got_ip_us;       // 首次获取IP
+    uint8_t channel;
+    int8_t rssi;             // 最近一次RSSI
+    int8_t rssi_avg;         // RSSI滑动平均
+    int8_t rssi_min;
+} wifi_connect_stats_t;
+
+// 链路变化回调 获取IP时up为true, 掉线或停止时为false
+// 在默认事件循环任务中调用, 不能阻塞
+typedef void (*wifi_link_cb_t)(bool up, void *arg);
+
+void wifi_get_connect_stats(wifi_connect_stats_t *stats);
+
+// 设置候选网络 (在wifi_init_sta之前调用), 连接失败时按顺序轮换
+void wifi_set_networks(const WIFI *networks, int num);
+void wifi_set_link_callback(wifi_link_cb_t cb, void *arg);
+
+// 等待获取IP 成功返回ESP_OK, 超时返回ESP_ERR_TIMEOUT
+esp_err_t wifi_wait_connected(TickType_t timeout);
+
+// 运行中替换候选网络 (由事件循环异步执行)
+// 当前连接的网络仍在列表中且密码不变时保持连接, 否则断开并连接新列表的第一个网络
+esp_err_t wifi_reconfigure(const WIFI *networks, int num);
+
+// 断开并停止重连 (由事件循环异步执行)
+void wifi_stop(void);
 
 static void event_handler(void* arg, esp_event_base_t event_base,
                                 int32_t event_id, void* event_data);
 
+// 启动连接管理器 不阻塞, 之后在后台持续连接/重连
+// pvParam为WIFI*, 未调用wifi_set_networks时作为唯一的网络
 void wifi_init_sta(void *pvParam);
 
 #endif // __ESP32_WIFI__
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include <string.h>
+#include "wifi_sm.h"
+
+void wifi_sm_init(wifi_sm_t *sm, bool fast_path, uint32_t max_retry) {
+    memset(sm, 0, sizeof(wifi_sm_t));
+    sm->state = WIFI_STATE_IDLE;
+    sm->max_retry = max_retry;
+    sm->backoff_ms = WIFI_SM_BACKOFF_MIN_MS;
+    sm->fast_path = fast_path;
+    sm->rssi_min = INT8_MAX;
+}
+
+// 发起一次连接, 同时设置超时
+static uint32_t wifi_sm_connect(wifi_sm_t *sm) {
+    sm->state = WIFI_STATE_CONNECTING;
+    sm->attempts++;
+    sm->timer_ms = WIFI_SM_CONNECT_TIMEOUT_MS;
+    return WIFI_SM_ACT_CONNECT | WIFI_SM_ACT_ARM_TIMER;
+}
+
+static uint32_t wifi_sm_disconnected(wifi_sm_t *sm) {
+    uint32_t act = WIFI_SM_ACT_CANCEL_TIMER;
+    if (sm->state == WIFI_STATE_CONNECTED) {
+        sm->disconnects++;
+        act |= WIFI_SM_ACT_LINK_DOWN;
+    }
+    if (sm->fast_path && sm->retry == 0) {
+        sm->fast_path = false;
+        act |= WIFI_SM_ACT_USE_SCAN;
+    }
+    sm->retry++;
+    if (sm->retry == sm->max_retry) {
+        act |= WIFI_SM_ACT_FAILED;
+    }
+
+    // 指数退避
+    sm->state = WIFI_STATE_BACKOFF;
+    sm->timer_ms = sm->backoff_ms;
+    sm->backoff_ms = sm->backoff_ms * 2 > WIFI_SM_BACKOFF_MAX_MS ? WIFI_SM_BACKOFF_MAX_MS : sm->backoff_ms * 2;
+    return act | WIFI_SM_ACT_ARM_TIMER;
+}
+
+uint32_t wifi_sm_event(wifi_sm_t *sm, wifi_sm_event_t event) {
+    switch (event) {
+    case WIFI_SM_EV_START:
+        if (sm->state != WIFI_STATE_IDLE) {
+            return 0;
+        }
+        sm->retry = 0;
+        sm->backoff_ms = WIFI_SM_BACKOFF_MIN_MS;
+        return wifi_sm_connect(sm);
+
+    case WIFI_SM_EV_STOP: {
+        uint32_t act = sm->state == WIFI_STATE_IDLE ? 0 : WIFI_SM_ACT_DISCONNECT | WIFI_SM_ACT_CANCEL_TIMER;
+        if (sm->state == WIFI_STATE_CONNECTED) {
+            act |= WIFI_SM_ACT_LINK_DOWN;
+        }
+        sm->state = WIFI_STATE_IDLE;
+        return act;
+    }
+
+    case WIFI_SM_EV_ASSOC:
+        return 0; // 继续等待IP, 超时仍然有效
+
+    case WIFI_SM_EV_GOT_IP:
+        if (sm->state != WIFI_STATE_CONNECTING) {
+            return 0;
+        }
+        if (sm->fast_path && sm->retry == 0) {
+            sm->fast_path_ok = true;
+        }
+        sm->state = WIFI_STATE_CONNECTED;
+        sm->retry = 0;
+        sm->backoff_ms = WIFI_SM_BACKOFF_MIN_MS;
+        sm->connects++;
+        sm->timer_ms = WIFI_SM_RSSI_PERIOD_MS;
+        return WIFI_SM_ACT_LINK_UP | WIFI_SM_ACT_SAMPLE_RSSI | WIFI_SM_ACT_ARM_TIMER;
+
+    case WIFI_SM_EV_LOST_IP:
+        if (sm->state != WIFI_STATE_CONNECTED) {
+            return 0;
+        }
+        // 仍然关联, 等待DHCP重新分配
+        sm->state = WIFI_STATE_CONNECTING;
+        sm->disconnects++;
+        sm->timer_ms = WIFI_SM_CONNECT_TIMEOUT_MS;
+        return WIFI_SM_ACT_LINK_DOWN | WIFI_SM_ACT_ARM_TIMER;
+
+    case WIFI_SM_EV_DISCONNECTED:
+        if (sm->state == WIFI_STATE_IDLE || sm->state == WIFI_STATE_BACKOFF) {
+            return 0; // 主动断开或重复的断开事件
+        }
+        return wifi_sm_disconnected(sm);
+
+    case WIFI_SM_EV_TIMER:
+        switch (sm->state) {
+        case WIFI_STATE_BACKOFF:
+            return wifi_sm_connect(sm);
+        case WIFI_STATE_CONNECTING:
+            // 超时 先断开, 再按失败处理 (驱动随后的断开事件会被忽略)
+            sm->timeouts++;
+            return WIFI_SM_ACT_DISCONNECT | wifi_sm_disconnected(sm);
+        case WIFI_STATE_CONNECTED:
+            sm->timer_ms = WIFI_SM_RSSI_PERIOD_MS;
+            return WIFI_SM_ACT_SAMPLE_RSSI | WIFI_SM_ACT_ARM_TIMER;
+        default:
+            return 0;
+        }
+    }
+    return 0;
+}
+
+void wifi_sm_rssi(wifi_sm_t *sm, int rssi) {
+    if (sm->rssi_avg_x16 == 0) {
+        sm->rssi_avg_x16 = rssi * 16;
+    } else {
+        sm->rssi_avg_x16 += (rssi * 16 - sm->rssi_avg_x16) / 8;
+    }
+    sm->rssi = rssi;
+    if (rssi < sm->rssi_min) {
+        sm->rssi_min = rssi;
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef __WIFI_SM_H__
+#define __WIFI_SM_H__
+
+// Wi-Fi连接状态机 只根据事件决定动作, 不调用任何驱动接口
+// 不依赖ESP-IDF, 可在主机上用模拟的事件循环测试
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define WIFI_SM_BACKOFF_MIN_MS      250     // 首次重试间隔
+#define WIFI_SM_BACKOFF_MAX_MS      30000   // 最长重试间隔
+#define WIFI_SM_CONNECT_TIMEOUT_MS  15000   // 单次连接(含DHCP)超时
+#define WIFI_SM_RSSI_PERIOD_MS      10000   // 连接后RSSI采样周期
+
+typedef enum {
+    WIFI_STATE_IDLE = 0,    // 未启动或已停止
+    WIFI_STATE_CONNECTING,  // 正在关联或等待IP
+    WIFI_STATE_CONNECTED,   // 已获取IP
+    WIFI_STATE_BACKOFF,     // 连接失败, 等待重试
+} wifi_state_t;
+
+typedef enum {
+    WIFI_SM_EV_START = 0,
+    WIFI_SM_EV_STOP,
+    WIFI_SM_EV_ASSOC,       // 已关联AP
+    WIFI_SM_EV_GOT_IP,
+    WIFI_SM_EV_LOST_IP,
+    WIFI_SM_EV_DISCONNECTED,
+    WIFI_SM_EV_TIMER,
+} wifi_sm_event_t;
+
+// 状态机要求执行的动作 (位图, 按下列顺序执行)
+#define WIFI_SM_ACT_USE_SCAN     (1U << 0)  // 放弃缓存的AP, 改为全信道扫描
+#define WIFI_SM_ACT_DISCONNECT   (1U << 1)
+#define WIFI_SM_ACT_CANCEL_TIMER (1U << 2)
+#define WIFI_SM_ACT_ARM_TIMER    (1U << 3)  // 定时timer_ms后送入WIFI_SM_EV_TIMER
+#define WIFI_SM_ACT_CONNECT      (1U << 4)
+#define WIFI_SM_ACT_SAMPLE_RSSI  (1U << 5)  // 读取RSSI并调用wifi_sm_rssi
+#define WIFI_SM_ACT_LINK_UP      (1U << 6)
+#define WIFI_SM_ACT_LINK_DOWN    (1U << 7)
+#define WIFI_SM_ACT_FAILED       (1U << 8)  // 连续失败达到max_retry (之后仍会继续重试)
+
+typedef struct {
+    wifi_state_t state;
+    uint32_t retry;          // 连续失败次数
+    uint32_t max_retry;
+    uint32_t backoff_ms;     // 下一次失败后的等待时间
+    uint32_t timer_ms;       // WIFI_SM_ACT_ARM_TIMER的定时时长
+    bool fast_path;          // 正在尝试缓存的AP
+    bool fast_path_ok;       // 缓存直连是否成功过
+
+    // 链路质量
+    int8_t rssi;             // 最近一次RSSI
+    int8_t rssi_min;
+    int16_t rssi_avg_x16;    // RSSI滑动平均 (x16)
+    uint32_t attempts;       // 连接尝试次数
+    uint32_t connects;       // 获取IP次数
+    uint32_t disconnects;    // 连接后掉线次数
+    uint32_t timeouts;       // 连接超时次数
+} wifi_sm_t;
+
+void wifi_sm_init(wifi_sm_t *sm, bool fast_path, uint32_t max_retry);
+
+// 送入事件 返回需要执行的动作
+uint32_t wifi_sm_event(wifi_sm_t *sm, wifi_sm_event_t event);
+
+// 记录一次RSSI采样
+void wifi_sm_rssi(wifi_sm_t *sm, int rssi);
+
+#endif // __WIFI_SM_H__
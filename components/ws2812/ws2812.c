@@ -1,122 +1,363 @@
 #include "ws2812.h"
 
-// 全局变量
-static rmt_channel_handle_t tx_channel = NULL;
-static rmt_encoder_handle_t ws2812_encoder = NULL;
-
-
-// WS2812编码器初始化函数
-static size_t rmt_encode_ws2812(rmt_encoder_t *encoder, rmt_channel_handle_t channel,
-                                const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state) {
-    rmt_ws2812_encoder_t *ws2812_encoder = __containerof(encoder, rmt_ws2812_encoder_t, base);
-    rmt_encoder_handle_t copy_encoder = ws2812_encoder->copy_encoder;
-    rmt_encode_state_t session_state = RMT_ENCODING_RESET;
-    rmt_encode_state_t state = RMT_ENCODING_RESET;
-    size_t encoded_symbols = 0;
-    
-    // 首先使用复制编码器处理LED数据
-    encoded_symbols += copy_encoder->encode(copy_encoder, channel, primary_data, data_size, &session_state);
-    
-    if (session_state & RMT_ENCODING_COMPLETE) {
-        // 添加复位信号
-        rmt_symbol_word_t reset_symbol = {
-            .level0 = 0,
-            .duration0 = ws2812_encoder->reset_duration,
-            .level1 = 0,
-            .duration1 = 0,
-        };
-        encoded_symbols += copy_encoder->encode(copy_encoder, channel, &reset_symbol, 
-                                                sizeof(reset_symbol), &session_state);
-        state |= RMT_ENCODING_COMPLETE;
-    }
-    
-    if (session_state & RMT_ENCODING_MEM_FULL) {
-        state |= RMT_ENCODING_MEM_FULL;
-    }
-    
-    *ret_state = state;
-    return encoded_symbols;
+// 默认灯带 (esp32_init_rmt创建, 供set_led_color/ws2812_show使用)
+static ws2812_strip_t *default_strip = NULL;
+
+// 灯带对象
+struct ws2812_strip_t {
+    rmt_channel_handle_t channel;
+    rmt_encoder_handle_t encoder;
+    size_t led_num;
+    uint8_t scale_table[256];            // 亮度/伽马映射表 编码时查表
+    uint64_t encode_cycles;              // 编码累计CPU周期
+    uint64_t encode_bytes;               // 编码累计字节数
+    uint8_t *buffer[2];                  // 双缓冲 GRB数据 RMT发送期间会直接读取缓冲区, 因此发送未完成前不能改写
+    uint8_t buffer_idx;
+    uint32_t tx_queued;                  // 已提交的传输数
+    volatile uint32_t tx_done;           // 已完成的传输数 (在中断中更新)
+};
+
+// 同步发送的灯带组
+struct ws2812_strip_group_t {
+    rmt_sync_manager_handle_t sync_manager;
+    ws2812_strip_t **strips;
+    size_t strip_num;
+    bool started;                        // 是否已有一轮同步发送
+};
+
+// 传输完成回调 (中断上下文)
+static bool IRAM_ATTR rmt_tx_done_cb(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t *edata, void *user_ctx) {
+    ws2812_strip_t *strip = (ws2812_strip_t *)user_ctx;
+    strip->tx_done++;
+    return false;
+}
+
+
+// 字节->RMT符号查找表 每字节展开为8个符号(MSB first), 所有灯带共用
+static rmt_symbol_word_t ws2812_symbol_table[256][8];
+static bool ws2812_symbol_table_ready = false;
+
+// 复位信号 一个符号, 两半都是低电平, 合计RESET_DURATION
+static const rmt_symbol_word_t ws2812_reset_code = {
+    .level0 = 0,
+    .duration0 = RESET_DURATION / 2,
+    .level1 = 0,
+    .duration1 = RESET_DURATION / 2,
+};
+
+// 生成字节->符号查找表
+static void ws2812_init_symbol_table(void) {
+    const rmt_symbol_word_t bit0 = {.level0 = 1, .duration0 = T0H, .level1 = 0, .duration1 = T0L};
+    const rmt_symbol_word_t bit1 = {.level0 = 1, .duration0 = T1H, .level1 = 0, .duration1 = T1L};
+    for (int v = 0; v < 256; v++) {
+        for (int bit = 0; bit < 8; bit++) {
+            ws2812_symbol_table[v][bit] = (v & (0x80 >> bit)) ? bit1 : bit0;
+        }
+    }
+    ws2812_symbol_table_ready = true;
 }
 
+// 生成亮度/伽马映射表 只在设置亮度时计算一次, 编码时查表
+static void ws2812_init_scale_table(uint8_t *table, uint8_t brightness, bool gamma) {
+    for (int v = 0; v < 256; v++) {
+        uint32_t level = v;
+        if (gamma) {
+            level = (uint32_t)(powf(v / 255.0f, WS2812_GAMMA) * 255.0f + 0.5f);
+        }
+        table[v] = (level * (brightness + 1)) >> 8;
+    }
+}
+
+// WS2812编码回调 每字节经亮度/伽马表映射后查表得到8个符号, 数据结束后追加一个复位符号
+static size_t rmt_encode_ws2812(const void *data, size_t data_size, size_t symbols_written, size_t symbols_free,
+                                rmt_symbol_word_t *symbols, bool *done, void *arg) {
+    ws2812_strip_t *strip = (ws2812_strip_t *)arg;
+    const uint8_t *bytes = (const uint8_t *)data;
+    size_t pos = symbols_written / 8;
+
+    if (pos >= data_size) {
+        if (symbols_free < 1) {
+            return 0;
+        }
+        symbols[0] = ws2812_reset_code;
+        *done = true;
+        return 1;
+    }
+
+    size_t num = symbols_free / 8;
+    if (num > data_size - pos) {
+        num = data_size - pos;
+    }
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (size_t i = 0; i < num; i++) {
+        memcpy(&symbols[i * 8], ws2812_symbol_table[strip->scale_table[bytes[pos + i]]], sizeof(ws2812_symbol_table[0]));
+    }
+    strip->encode_cycles += esp_cpu_get_cycle_count() - start;
+    strip->encode_bytes += num;
+    return num * 8;
+}
 
 // 初始化WS2812编码器
-static esp_err_t rmt_new_ws2812_encoder(rmt_encoder_handle_t *ret_encoder) {
-    rmt_ws2812_encoder_t *ws2812_encoder = calloc(1, sizeof(rmt_ws2812_encoder_t));
-    if (!ws2812_encoder) {
+static esp_err_t rmt_new_ws2812_encoder(ws2812_strip_t *strip, rmt_encoder_handle_t *ret_encoder) {
+    if (!ws2812_symbol_table_ready) {
+        ws2812_init_symbol_table();
+    }
+    rmt_simple_encoder_config_t encoder_config = {
+        .callback = rmt_encode_ws2812,
+        .arg = strip,
+        .min_chunk_size = 8, // 至少能放下一个字节的符号
+    };
+    return rmt_new_simple_encoder(&encoder_config, ret_encoder);
+}
+
+// 创建灯带
+esp_err_t ws2812_new_strip(const ws2812_strip_config_t *config, ws2812_strip_t **ret_strip) {
+    esp_err_t ret = ESP_OK;
+    if (!config || !ret_strip || !config->led_num) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ws2812_strip_t *strip = calloc(1, sizeof(ws2812_strip_t));
+    if (!strip) {
         return ESP_ERR_NO_MEM;
     }
-    
-    // 初始化基础编码器
-    ws2812_encoder->base.encode = rmt_encode_ws2812;
-    ws2812_encoder->base.del = NULL;
-    ws2812_encoder->base.reset = NULL;
-    
-    // 创建字节编码器
-    rmt_bytes_encoder_config_t bytes_encoder_config = {
-        .bit0 = {
-            .duration0 = T0H,
-            .level0 = 1,
-            .duration1 = T0L,
-            .level1 = 0,
-        },
-        .bit1 = {
-            .duration0 = T1H,
-            .level0 = 1,
-            .duration1 = T1L,
-            .level1 = 0,
-        },
-        .flags.msb_first = 1, // WS2812使用MSB first
+    strip->led_num = config->led_num;
+    strip->buffer[0] = calloc(2, config->led_num * 3);
+    if (!strip->buffer[0]) {
+        free(strip);
+        return ESP_ERR_NO_MEM;
+    }
+    strip->buffer[1] = strip->buffer[0] + config->led_num * 3;
+    ws2812_init_scale_table(strip->scale_table, 255, false);
+
+    // 配置RMT发送通道
+    rmt_tx_channel_config_t tx_chan_config = {
+        .clk_src = RMT_CLK_SRC_DEFAULT, // 默认时钟源
+        .gpio_num = config->gpio_num,
+        .mem_block_symbols = config->mem_block_symbols,
+        .resolution_hz = RMT_RESOLUTION_HZ,
+        .trans_queue_depth = 4, // 传输队列深度
+        .flags.invert_out = 0, // 不反转输出
+        .flags.with_dma = config->with_dma,
+    };
+    if (!tx_chan_config.mem_block_symbols) {
+        tx_chan_config.mem_block_symbols = config->with_dma ? WS2812_DMA_MEM_SYMBOLS : WS2812_MEM_SYMBOLS;
+    }
+    ret = rmt_new_tx_channel(&tx_chan_config, &strip->channel);
+    if (ret == ESP_ERR_NOT_FOUND && config->with_dma) {
+        // 支持DMA的通道有限(ESP32-S3只有一个), 用完后退回到普通通道
+        ESP_LOGW(TAG, "GPIO%d 没有可用的DMA通道, 改用普通RMT通道", config->gpio_num);
+        tx_chan_config.flags.with_dma = 0;
+        tx_chan_config.mem_block_symbols = config->mem_block_symbols ? config->mem_block_symbols : WS2812_MEM_SYMBOLS;
+        ret = rmt_new_tx_channel(&tx_chan_config, &strip->channel);
+    }
+    if (ret != ESP_OK) {
+        goto err;
+    }
+
+    // 创建WS2812编码器 每个通道一个, 编码器带有状态不能共用
+    ret = rmt_new_ws2812_encoder(strip, &strip->encoder);
+    if (ret != ESP_OK) {
+        goto err;
+    }
+
+    // 注册传输完成回调 用于判断缓冲区是否可以复用
+    rmt_tx_event_callbacks_t cbs = {
+        .on_trans_done = rmt_tx_done_cb,
     };
-    ESP_ERROR_CHECK(rmt_new_bytes_encoder(&bytes_encoder_config, &ws2812_encoder->copy_encoder));
-    
-    ws2812_encoder->reset_duration = RESET_DURATION;
-    *ret_encoder = &ws2812_encoder->base;
+    ret = rmt_tx_register_event_callbacks(strip->channel, &cbs, strip);
+    if (ret != ESP_OK) {
+        goto err;
+    }
+
+    // 启用RMT通道
+    ret = rmt_enable(strip->channel);
+    if (ret != ESP_OK) {
+        goto err;
+    }
+
+    *ret_strip = strip;
     return ESP_OK;
+
+err:
+    if (strip->encoder) {
+        rmt_del_encoder(strip->encoder);
+    }
+    if (strip->channel) {
+        rmt_del_channel(strip->channel);
+    }
+    free(strip->buffer[0]);
+    free(strip);
+    return ret;
 }
 
-// 设置LED颜色
-void set_led_color(rgb_color *led_colors, size_t led_num) {
-    // 为每个LED分配24位数据 (GRB格式)
-    uint8_t *buffer = malloc(led_num * 3);
-    if (!buffer) {
-        ESP_LOGE(TAG, "内存分配失败");
-        return;
+// 删除灯带
+esp_err_t ws2812_del_strip(ws2812_strip_t *strip) {
+    if (!strip) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    rmt_tx_wait_all_done(strip->channel, -1);
+    rmt_disable(strip->channel);
+    rmt_del_channel(strip->channel);
+    rmt_del_encoder(strip->encoder);
+    free(strip->buffer[0]);
+    free(strip);
+    return ESP_OK;
+}
+
+// 设置灯带亮度(0-255)和是否启用伽马校正 在编码时与数据一同处理, 不改动颜色缓冲区
+esp_err_t ws2812_strip_set_brightness(ws2812_strip_t *strip, uint8_t brightness, bool gamma) {
+    if (!strip) {
+        return ESP_ERR_INVALID_ARG;
     }
-    
+    ws2812_init_scale_table(strip->scale_table, brightness, gamma);
+    return ESP_OK;
+}
+
+// 获取编码统计 平均每个像素(3字节)的编码CPU周期
+esp_err_t ws2812_strip_get_encode_stats(ws2812_strip_t *strip, uint32_t *cycles_per_pixel) {
+    if (!strip || !cycles_per_pixel) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *cycles_per_pixel = strip->encode_bytes ? (uint32_t)(strip->encode_cycles * 3 / strip->encode_bytes) : 0;
+    return ESP_OK;
+}
+
+// 写入当前缓冲区并提交传输
+static esp_err_t ws2812_strip_transmit(ws2812_strip_t *strip, const rgb_color *led_colors, size_t led_num) {
+    if (led_num > strip->led_num) {
+        led_num = strip->led_num;
+    }
+
     // 将RGB颜色转换为GRB格式
+    uint8_t *buffer = strip->buffer[strip->buffer_idx];
     for (int i = 0; i < led_num; i++) {
         buffer[i * 3 + 0] = led_colors[i].green;
         buffer[i * 3 + 1] = led_colors[i].red;
         buffer[i * 3 + 2] = led_colors[i].blue;
     }
-    
+
     // 发送数据
     rmt_transmit_config_t tx_config = {
         .loop_count = 0, // 不循环
         .flags.eot_level = 0, // 传输结束时的电平为0
     };
-    
-    ESP_ERROR_CHECK(rmt_transmit(tx_channel, ws2812_encoder, buffer, led_num * 3, &tx_config));
-    free(buffer);
+
+    esp_err_t ret = rmt_transmit(strip->channel, strip->encoder, buffer, led_num * 3, &tx_config);
+    if (ret == ESP_OK) {
+        strip->tx_queued++;
+        strip->buffer_idx ^= 1;
+    }
+    return ret;
+}
+
+// 刷新灯带 不阻塞, 只在即将改写的缓冲区仍被RMT读取时才等待
+esp_err_t ws2812_strip_show(ws2812_strip_t *strip, const rgb_color *led_colors, size_t led_num) {
+    if (!strip || !led_colors) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // 两个缓冲区都在传输中时, 当前缓冲区对应的是更早的那次传输, 等它完成
+    if (strip->tx_queued - strip->tx_done >= 2) {
+        ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(strip->channel, -1), TAG, "wait tx done failed");
+    }
+    return ws2812_strip_transmit(strip, led_colors, led_num);
+}
+
+// 等待灯带发送完成
+esp_err_t ws2812_strip_wait_done(ws2812_strip_t *strip, int timeout_ms) {
+    if (!strip) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return rmt_tx_wait_all_done(strip->channel, timeout_ms);
+}
+
+// 创建同步发送的灯带组 组内所有通道在最后一个通道提交数据后同时开始发送
+esp_err_t ws2812_new_strip_group(ws2812_strip_t **strips, size_t strip_num, ws2812_strip_group_t **ret_group) {
+    esp_err_t ret = ESP_OK;
+    if (!strips || !strip_num || !ret_group) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ws2812_strip_group_t *group = calloc(1, sizeof(ws2812_strip_group_t) + strip_num * sizeof(ws2812_strip_t *));
+    rmt_channel_handle_t *channels = calloc(strip_num, sizeof(rmt_channel_handle_t));
+    if (!group || !channels) {
+        ret = ESP_ERR_NO_MEM;
+        goto out;
+    }
+    group->strips = (ws2812_strip_t **)(group + 1);
+    group->strip_num = strip_num;
+    for (size_t i = 0; i < strip_num; i++) {
+        group->strips[i] = strips[i];
+        channels[i] = strips[i]->channel;
+    }
+
+    rmt_sync_manager_config_t sync_config = {
+        .tx_channel_array = channels,
+        .array_size = strip_num,
+    };
+    ret = rmt_new_sync_manager(&sync_config, &group->sync_manager);
+    if (ret == ESP_OK) {
+        *ret_group = group;
+        group = NULL;
+    }
+
+out:
+    free(channels);
+    free(group);
+    return ret;
+}
+
+// 删除灯带组 (不删除灯带本身)
+esp_err_t ws2812_del_strip_group(ws2812_strip_group_t *group) {
+    if (!group) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    rmt_del_sync_manager(group->sync_manager);
+    free(group);
+    return ESP_OK;
+}
+
+// 同步刷新灯带组 led_colors[i]对应第i条灯带, 长度为该灯带的LED数量
+esp_err_t ws2812_strip_group_show(ws2812_strip_group_t *group, const rgb_color *const led_colors[]) {
+    if (!group || !led_colors) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // 同步管理器每一轮都需要复位, 复位前上一轮必须全部发送完成
+    if (group->started) {
+        for (size_t i = 0; i < group->strip_num; i++) {
+            ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(group->strips[i]->channel, -1), TAG, "wait tx done failed");
+        }
+        ESP_RETURN_ON_ERROR(rmt_sync_reset(group->sync_manager), TAG, "sync reset failed");
+    }
+    for (size_t i = 0; i < group->strip_num; i++) {
+        ESP_RETURN_ON_ERROR(ws2812_strip_transmit(group->strips[i], led_colors[i], group->strips[i]->led_num),
+                            TAG, "transmit failed");
+    }
+    group->started = true;
+    return ESP_OK;
 }
 
-// 初始化RMT通道
+// 刷新默认灯带
+void ws2812_show(const rgb_color *led_colors, size_t led_num) {
+    ESP_ERROR_CHECK(ws2812_strip_show(default_strip, led_colors, led_num));
+}
+
+// 设置LED颜色
+void set_led_color(rgb_color *led_colors, size_t led_num) {
+    ws2812_show(led_colors, led_num);
+}
+
+// 获取默认灯带
+ws2812_strip_t *ws2812_get_default_strip(void) {
+    return default_strip;
+}
+
+// 初始化默认灯带的RMT通道
 void esp32_init_rmt(void) {
-    // 配置RMT发送通道
-    rmt_tx_channel_config_t tx_chan_config = {
-        .clk_src = RMT_CLK_SRC_DEFAULT, // 默认时钟源
+    ws2812_strip_config_t strip_config = {
         .gpio_num = WS2812_GPIO_NUM,
-        .mem_block_symbols = 64, // 内存块大小
-        .resolution_hz = RMT_RESOLUTION_HZ,
-        .trans_queue_depth = 4, // 传输队列深度
-        .flags.invert_out = 0, // 不反转输出
-        .flags.with_dma = 0, // 不使用DMA
+        .led_num = LED_NUMBERS,
+        .with_dma = false,
     };
-    ESP_ERROR_CHECK(rmt_new_tx_channel(&tx_chan_config, &tx_channel));
-    
-    // 创建WS2812编码器
-    ESP_ERROR_CHECK(rmt_new_ws2812_encoder(&ws2812_encoder));
-    
-    // 启用RMT通道
-    ESP_ERROR_CHECK(rmt_enable(tx_channel));
-}
\ No newline at end of file
+    ESP_ERROR_CHECK(ws2812_new_strip(&strip_config, &default_strip));
+}
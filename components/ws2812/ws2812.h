@@ -2,7 +2,15 @@
 #define __WS2812_H__
 #include "driver/rmt_tx.h"
 #include "driver/gpio.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "driver/rmt_encoder.h"
+#include "esp_cpu.h"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_check.h"
 
 #define TAG "WS2812_RMT"
 
@@ -10,6 +18,8 @@
 #define WS2812_GPIO_NUM      48      // 数据引脚
 #define LED_NUMBERS          1       // LED数量
 #define RMT_RESOLUTION_HZ    10000000 // 10MHz RMT时钟 (0.1us/tick)
+#define WS2812_MEM_SYMBOLS      64   // 普通通道内存块大小 (symbol)
+#define WS2812_DMA_MEM_SYMBOLS  1024 // DMA通道缓冲大小 (symbol) 长灯带一次性搬运, 减少中断
 
 // WS2812时序参数 (单位：0.1us)
 #define T0H                  4       // 0码高电平时间 (0.4us)
@@ -17,6 +27,7 @@
 #define T1H                  8       // 1码高电平时间 (0.8us)
 #define T1L                  4       // 1码低电平时间 (0.4us)
 #define RESET_DURATION       500     // 复位时间 (50us)
+#define WS2812_GAMMA         2.2f    // 伽马校正系数
 
 // 颜色结构体
 typedef struct {
@@ -25,23 +36,56 @@ typedef struct {
     uint8_t blue;
 } rgb_color;
 
-// 自定义编码器结构体
+// 灯带配置
 typedef struct {
-    rmt_encoder_t base;
-    rmt_encoder_t *copy_encoder;
-    uint32_t reset_duration; // 复位信号持续时间
-} rmt_ws2812_encoder_t;
+    int gpio_num;              // 数据引脚
+    size_t led_num;            // LED数量
+    size_t mem_block_symbols;  // RMT内存块大小 0则使用默认值
+    bool with_dma;             // 是否使用DMA 没有可用DMA通道时自动退回普通通道
+} ws2812_strip_config_t;
 
-// WS2812编码器初始化函数
-static size_t rmt_encode_ws2812(rmt_encoder_t *encoder, rmt_channel_handle_t channel,
-                                const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state);
+// 灯带对象 每条灯带占用一个RMT通道和一组预分配的双缓冲
+typedef struct ws2812_strip_t ws2812_strip_t;
+
+// 灯带组 组内灯带同步开始发送
+typedef struct ws2812_strip_group_t ws2812_strip_group_t;
+
+// WS2812编码回调 (查表编码)
+static size_t rmt_encode_ws2812(const void *data, size_t data_size, size_t symbols_written, size_t symbols_free,
+                                rmt_symbol_word_t *symbols, bool *done, void *arg);
 
 // 初始化WS2812编码器
-static esp_err_t rmt_new_ws2812_encoder(rmt_encoder_handle_t *ret_encoder);
+static esp_err_t rmt_new_ws2812_encoder(ws2812_strip_t *strip, rmt_encoder_handle_t *ret_encoder);
+
+// 创建/删除灯带
+esp_err_t ws2812_new_strip(const ws2812_strip_config_t *config, ws2812_strip_t **ret_strip);
+esp_err_t ws2812_del_strip(ws2812_strip_t *strip);
+
+// 刷新灯带 (不阻塞, 使用预分配的双缓冲)
+esp_err_t ws2812_strip_show(ws2812_strip_t *strip, const rgb_color *led_colors, size_t led_num);
+esp_err_t ws2812_strip_wait_done(ws2812_strip_t *strip, int timeout_ms);
+
+// 亮度(0-255)与伽马校正 在编码时与数据一同处理
+esp_err_t ws2812_strip_set_brightness(ws2812_strip_t *strip, uint8_t brightness, bool gamma);
+
+// 编码统计 平均每个像素的编码CPU周期
+esp_err_t ws2812_strip_get_encode_stats(ws2812_strip_t *strip, uint32_t *cycles_per_pixel);
+
+// 创建/删除同步灯带组, 同步刷新组内所有灯带
+esp_err_t ws2812_new_strip_group(ws2812_strip_t **strips, size_t strip_num, ws2812_strip_group_t **ret_group);
+esp_err_t ws2812_del_strip_group(ws2812_strip_group_t *group);
+esp_err_t ws2812_strip_group_show(ws2812_strip_group_t *group, const rgb_color *const led_colors[]);
+
+// 刷新默认灯带 (不阻塞, 使用预分配的双缓冲)
+void ws2812_show(const rgb_color *led_colors, size_t led_num);
 
 // 设置LED颜色
 void set_led_color(rgb_color *led_colors, size_t led_num);
 
+// 初始化默认灯带 (WS2812_GPIO_NUM, LED_NUMBERS)
 void esp32_init_rmt(void);
 
+// 获取默认灯带 esp32_init_rmt之前为NULL
+ws2812_strip_t *ws2812_get_default_strip(void);
+
 #endif
\ No newline at end of file
@@ -3,56 +3,85 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
 #include "esp_log.h"
 
 #include "esp_sntp.h"
 #include "esp_netif_sntp.h"
 
 #include "ws2812.h"
+#include "led_effect.h"
 #include "oled.h"
 #include "esp32_wifi.h"
 #include "esp32_usb.h"
+#include "sntp.h"
+#include "msg_bus.h"
 
 #define TAG "main"
 
 #define TASK_RMT_WS2812_STACK_SIZE 4096
 #define TASK_I2C_OLED_SIZE         4096
 #define TASK_WIFI_SIZE             4096
+#define TASK_CONFIG_SIZE           4096
 
 #define TASK_RMT_WS2812_PRIORITY 4
 #define TASK_I2C_OLED_PRIORITY   3
 #define TASK_WIFI_PRIORITY       5
+#define TASK_CONFIG_PRIORITY     2
+
 
 TaskHandle_t create_task_handle     = NULL;
 TaskHandle_t task_rmt_ws2812_handle = NULL;
 TaskHandle_t task_i2c_oled_handle   = NULL;
 TaskHandle_t wifi_connect           = NULL;
 TaskHandle_t sntp_get_time          = NULL;
+TaskHandle_t config_reload          = NULL;
 
 BaseType_t xReturn;
 
-// 定义消息结构
-typedef struct {
-    int command;
-    int value;
-    char text[20];
-} TaskMessage_t;
-
 typedef struct {
     int hour;
     int min;
     int sec;
 } Time;
 
+typedef struct {
+    uint8_t contrast;
+    bool flip;
+} DisplayConfig;
+
+
+// 当前本地时间 只保留最新值, 显示任务落后时不会积压
+MSG_BUS_TOPIC_DEFINE(clock_time_topic, Time);
+// 显示设置 配置重新加载后由显示任务自己应用
+MSG_BUS_TOPIC_DEFINE(display_config_topic, DisplayConfig);
 
-// 创建全局队列句柄
-QueueHandle_t xQueue = NULL;
+#define OLED_NOTIFY_TIME   BIT0  // 显示任务的时间更新通知位
+#define OLED_NOTIFY_CONFIG BIT1  // 显示设置更新通知位
+
+// 任务间共享的启动状态 (app_state)
+#define APP_WIFI_STARTED   BIT0  // 已有WIFI_CONNECT实例读取了网络列表并负责启动
+#define APP_WIFI_RUNNING   BIT1  // 连接管理器已初始化, 可以wifi_reconfigure
+#define APP_LED_READY      BIT2  // 灯效引擎已按配置初始化
 
 void Create_TASK(void *pvParam);
 void RMT_WS2812_TASK(void *pvParam);
 void WIFI_CONNECT(void *pvParam);
 void I2C_OLED_TASK(void *pvParam);
 void SNTP_GET_TIME(void *pvParam);
+void CONFIG_RELOAD_TASK(void *pvParam);
+static void clock_second_cb(time_tick_t tick, time_t utc_sec, void *arg);
+static void wifi_link_cb(bool up, void *arg);
+
+// 配置 启动时从config.txt读取, 主机弹出U盘后由CONFIG_RELOAD_TASK更新
+// 启动后读写都需持有app_config_lock
+static app_config_t app_config;
+static SemaphoreHandle_t app_config_lock = NULL;
+static const char *ntp_servers[APP_CONFIG_MAX_NTP];
+static WIFI wifi_networks[APP_CONFIG_MAX_WIFI];
+static EventGroupHandle_t app_state = NULL;
+static led_engine_t led_engine;
 
 void app_main(void)
 {
@@ -71,6 +100,8 @@ void app_main(void)
 
     //mounted in the app by default
     mount();
+    // 主机占用U盘时应用保留只读视图, 可继续读取配置和日志
+    tinyusb_msc_storage_set_shared(true);
 
     ESP_LOGI(TAG, "USB MSC initialization");
     const tinyusb_config_t tusb_cfg = {
@@ -83,13 +114,16 @@ void app_main(void)
     ESP_ERROR_CHECK(tinyusb_driver_install(&tusb_cfg));
     ESP_LOGI(TAG, "USB MSC initialization DONE");
 
-    WIFI WIFI_LOG;
-    WIFI_LOG = init_usb_device();
+    init_usb_device(&app_config);
+    console_start();
+    app_config_lock = xSemaphoreCreateMutex();
+    app_state = xEventGroupCreate();
+    assert(app_config_lock && app_state);
 
      xReturn = xTaskCreate(Create_TASK,
                  "Create_TASK",
                  4096,
-                 (void *)& WIFI_LOG,
+                 NULL,
                  1,
                  &create_task_handle
              );
@@ -103,8 +137,17 @@ void app_main(void)
 }
 
 void Create_TASK(void *pvParam){
-    WIFI* WIFI_LOG = (WIFI *)pvParam;
-    xQueue = xQueueCreate(10, sizeof(TaskMessage_t));
+
+    //设置时区 配置无效时使用北京时间 (持锁设置, 不会覆盖配置重载设置的新时区)
+    xSemaphoreTake(app_config_lock, portMAX_DELAY);
+    if (time_service_set_timezone(app_config.timezone) != ESP_OK) {
+        ESP_ERROR_CHECK(time_service_set_timezone("CST-8"));
+    }
+    xSemaphoreGive(app_config_lock);
+
+    // 时间服务 在每秒整点通知显示任务, 不再轮询
+    time_service_init();
+    ESP_ERROR_CHECK(time_service_subscribe(TIME_TICK_SECOND, clock_second_cb, NULL));
      xReturn = xTaskCreate(RMT_WS2812_TASK,
                  "RMT_WS2812_TASK",
                  TASK_RMT_WS2812_STACK_SIZE,
@@ -128,13 +171,24 @@ void Create_TASK(void *pvParam){
     xReturn = xTaskCreate(WIFI_CONNECT,
                  "WIFI_CONNECT",
                  TASK_WIFI_SIZE,
-                 (void *)WIFI_LOG,
+                 NULL,
                  TASK_WIFI_PRIORITY,
                  &wifi_connect
              );
     if(xReturn != pdPASS)
         ESP_LOGI(TAG, "WIFI链接失败...");
 
+    xReturn = xTaskCreate(CONFIG_RELOAD_TASK,
+                 "CONFIG_RELOAD_TASK",
+                 TASK_CONFIG_SIZE,
+                 NULL,
+                 TASK_CONFIG_PRIORITY,
+                 &config_reload
+             );
+    if(xReturn != pdPASS)
+        ESP_LOGI(TAG, "配置重载任务创建失败...");
+    storage_set_reload_task(config_reload);
+
      ESP_LOGI(TAG, "任务队列创建结束...");
      vTaskDelete(NULL);
      
@@ -142,83 +196,72 @@ void Create_TASK(void *pvParam){
 
 void RMT_WS2812_TASK(void *pvParam){
 
-    TickType_t xLastWakeTime;
-    const TickType_t xFrequency = pdMS_TO_TICKS(1000); //1S更新一次
-    xLastWakeTime = xTaskGetTickCount();
+    // 颜色循环 每种颜色保持1秒
+    static const led_keyframe_t color_cycle[] = {
+        {.time_ms = 0,    .color = {.red = 25,  .green = 0,  .blue = 0}},  // 红色
+        {.time_ms = 1000, .color = {.red = 0,   .green = 25, .blue = 0}},  // 绿色
+        {.time_ms = 2000, .color = {.red = 0,   .green = 0,  .blue = 25}}, // 蓝色
+        {.time_ms = 3000, .color = {.red = 127, .green = 25, .blue = 0}},  // 黄色
+        {.time_ms = 4000, .color = {.red = 127, .green = 0,  .blue = 25}}, // 紫色
+        {.time_ms = 5000, .color = {.red = 0,   .green = 25, .blue = 25}}, // 青色
+        {.time_ms = 6000, .color = {.red = 25,  .green = 25, .blue = 25}}, // 白色
+        {.time_ms = 7000, .color = {.red = 0,   .green = 0,  .blue = 0}},  // 关闭LED
+        {.time_ms = 8000, .color = {.red = 0,   .green = 0,  .blue = 0}},  // 轨道结束
+    };
+    static led_keyframe_track_t tracks[LED_NUMBERS];
 
     ESP_LOGI(TAG, "初始化WS2812 RMT驱动...");
 
-    // 创建LED颜色数组
-    static rgb_color leds[LED_NUMBERS];
-
     // 初始化RMT
     esp32_init_rmt();
-    
+    // 读取配置和标记就绪在同一次持锁内, 配置重载要么在此之前(这里读到新值), 要么看到就绪后自己应用
+    xSemaphoreTake(app_config_lock, portMAX_DELAY);
+    ESP_ERROR_CHECK(ws2812_strip_set_brightness(ws2812_get_default_strip(), app_config.led_brightness, app_config.led_gamma));
+    ESP_ERROR_CHECK(led_engine_init(&led_engine, ws2812_get_default_strip(), LED_NUMBERS, app_config.led_frame_ms));
+    xEventGroupSetBits(app_state, APP_LED_READY);
+    xSemaphoreGive(app_config_lock);
+
+    for (int i = 0; i < LED_NUMBERS; i++) {
+        tracks[i] = (led_keyframe_track_t){
+            .frames = color_cycle,
+            .count = sizeof(color_cycle) / sizeof(color_cycle[0]),
+            .interpolate = false,
+        };
+    }
+    ESP_ERROR_CHECK(led_engine_set_keyframes(&led_engine, tracks));
+
     ESP_LOGI(TAG, "开始LED颜色循环...");
-    while (1) {
-        // 红色
-        leds[0] = (rgb_color){.red = 255*0.1, .green = 0, .blue = 0};
-        set_led_color(leds, LED_NUMBERS);
-        vTaskDelayUntil(&xLastWakeTime, xFrequency);
-        
-        // 绿色
-        leds[0] = (rgb_color){.red = 0, .green = 255*0.1, .blue = 0};
-        set_led_color(leds, LED_NUMBERS);
-        vTaskDelayUntil(&xLastWakeTime, xFrequency);
-        
-        // 蓝色
-        leds[0] = (rgb_color){.red = 0, .green = 0, .blue = 255*0.1};
-        set_led_color(leds, LED_NUMBERS);
-        vTaskDelayUntil(&xLastWakeTime, xFrequency);
-        
-        // 黄色
-        leds[0] = (rgb_color){.red = 255*0.5, .green = 255*0.1, .blue = 0};
-        set_led_color(leds, LED_NUMBERS);
-        vTaskDelayUntil(&xLastWakeTime, xFrequency);
-        
-        // 紫色
-        leds[0] = (rgb_color){.red = 255*0.5, .green = 0, .blue = 255*0.1};
-        set_led_color(leds, LED_NUMBERS);
-        vTaskDelayUntil(&xLastWakeTime, xFrequency);
-        
-        // 青色
-        leds[0] = (rgb_color){.red = 0, .green = 255*0.1, .blue = 255*0.1};
-        set_led_color(leds, LED_NUMBERS);
-        vTaskDelayUntil(&xLastWakeTime, xFrequency);
-        
-        // 白色
-        leds[0] = (rgb_color){.red = 255*0.1, .green = 255*0.1, .blue = 255*0.1};
-        set_led_color(leds, LED_NUMBERS);
-        vTaskDelayUntil(&xLastWakeTime, xFrequency);
-        
-        // 关闭LED
-        leds[0] = (rgb_color){.red = 0, .green = 0, .blue = 0};
-        set_led_color(leds, LED_NUMBERS);
-        vTaskDelayUntil(&xLastWakeTime, xFrequency);
-        
-}
+    led_engine_task(&led_engine);
 }
 
  void I2C_OLED_TASK(void *pvParam){
 
 
-    TaskMessage_t receivedMsg;
     Time timerecive;
+    DisplayConfig display;
+    msg_sub_t time_sub;
+    msg_sub_t display_sub;
     char buf[20];
      ESP_LOGI(TAG, "初始化OLED I2C驱动...");
+    // 先订阅再读取配置, 两者之间发布的显示设置不会丢失
+    ESP_ERROR_CHECK(msg_bus_subscribe(&display_config_topic, &display_sub, NULL, OLED_NOTIFY_CONFIG));
+    xSemaphoreTake(app_config_lock, portMAX_DELAY);
+    display.contrast = app_config.display_contrast;
+    display.flip = app_config.display_flip;
+    xSemaphoreGive(app_config_lock);
      // 初始化I2C
     esp32_init_i2c();
     vTaskDelay(200);
     OLED_Init();
+    OLED_SetContrast(display.contrast);
+    OLED_SetFlip(display.flip);
     OLED_NewFrame();
     OLED_PrintString(0,0,"Hello World!",&font16x16,OLED_COLOR_NORMAL);
     //OLED_PrintString(0,16,"TASK_COUNTER:0",&font16x16,OLED_COLOR_NORMAL);
-    OLED_PrintString(0,16,"00:00:00",&font24x12,OLED_COLOR_NORMAL);
+    OLED_PrintString(0,16,"00:00:00",&font24x12_rle,OLED_COLOR_NORMAL);
     OLED_ShowFrame();
 
-    if(xQueueReceive(xQueue, &timerecive, portMAX_DELAY) == pdPASS) {
-        sprintf(buf,"%d:%d:%d",(int)timerecive.hour,(int)timerecive.min,(int)(int)timerecive.sec);
-    }
+    ESP_ERROR_CHECK(msg_bus_subscribe(&clock_time_topic, &time_sub, NULL, OLED_NOTIFY_TIME));
 
      while (1){
 
@@ -235,10 +278,16 @@ void RMT_WS2812_TASK(void *pvParam){
         //     }
         // }
 
-        if(xQueueReceive(xQueue, &timerecive, portMAX_DELAY) == pdPASS) {
+        uint32_t bits = msg_bus_wait(OLED_NOTIFY_TIME | OLED_NOTIFY_CONFIG, portMAX_DELAY);
+        if((bits & OLED_NOTIFY_CONFIG) && msg_bus_read_value(&display_sub, &display) == ESP_OK) {
+            OLED_SetContrast(display.contrast);
+            OLED_SetFlip(display.flip);
+            OLED_ShowFrame();
+        }
+        if(msg_bus_read_value(&time_sub, &timerecive) == ESP_OK) {
         snprintf(buf, sizeof(buf), "%02d:%02d:%02d",
                  timerecive.hour, timerecive.min, timerecive.sec);
-        OLED_PrintString(0,16,buf,&font24x12,OLED_COLOR_NORMAL);
+        OLED_PrintString(0,16,buf,&font24x12_rle,OLED_COLOR_NORMAL);
         OLED_ShowFrame();
         //sprintf(buf,"%d:%d:%d",(int)timerecive.hour,(int)timerecive.min,(int)(int)timerecive.sec);
     }
@@ -248,10 +297,33 @@ void RMT_WS2812_TASK(void *pvParam){
 
  }
 
+ // 配置中的网络转换为连接管理器的格式 调用者持有app_config_lock
+ static int wifi_networks_from_config(void){
+    for (int i = 0; i < app_config.wifi_count; i++) {
+        strlcpy(wifi_networks[i].ssid, app_config.wifi[i].ssid, sizeof(wifi_networks[i].ssid));
+        strlcpy(wifi_networks[i].passport, app_config.wifi[i].password, sizeof(wifi_networks[i].passport));
+        ESP_LOGD(TAG, "SSID: %s", wifi_networks[i].ssid);
+    }
+    return app_config.wifi_count;
+ }
+
  void WIFI_CONNECT(void *pvParam){
-    WIFI *WIFI_LOG = (WIFI *)pvParam;
 
-    printf("SSID: %s\n",WIFI_LOG->ssid);
+    xSemaphoreTake(app_config_lock, portMAX_DELAY);
+    int wifi_count = wifi_networks_from_config();
+    // 配置重载可能在本任务启动期间再创建一个实例, 只有第一个负责启动
+    bool claimed = wifi_count > 0 && !(xEventGroupGetBits(app_state) & APP_WIFI_STARTED);
+    if (claimed) {
+        xEventGroupSetBits(app_state, APP_WIFI_STARTED);
+    }
+    xSemaphoreGive(app_config_lock);
+    if (wifi_count == 0) {
+        ESP_LOGE(TAG, "config.txt中没有配置WiFi");
+        vTaskDelete(NULL);
+    }
+    if (!claimed) {
+        vTaskDelete(NULL);
+    }
      //Initialize NVS
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -267,72 +339,127 @@ void RMT_WS2812_TASK(void *pvParam){
     }
 
     ESP_LOGI(TAG, "ESP_WIFI_MODE_STA");
-    wifi_init_sta(WIFI_LOG);
+    wifi_set_networks(wifi_networks, wifi_count);
+    wifi_set_link_callback(wifi_link_cb, NULL);
+    wifi_init_sta(NULL);    // 不阻塞, 连接管理器在后台连接和重连
+    xEventGroupSetBits(app_state, APP_WIFI_RUNNING);
 
-    xReturn = xTaskCreate(SNTP_GET_TIME,
-                 "SNTP_GET_TIME",
-                 TASK_WIFI_SIZE,
-                 NULL,
-                 TASK_WIFI_PRIORITY,
-                 &sntp_get_time
-             );
     vTaskDelete(NULL);
 
  }
 
- void SNTP_GET_TIME(void *pvParam){
+ // 链路回调 在事件循环任务中执行, 只启动/暂停NTP, 不阻塞
+ static void wifi_link_cb(bool up, void *arg){
+    if (!up) {
+        ntp_client_stop();
+        return;
+    }
+    // 客户端会复制服务器名, 之后的修改由配置重载任务通知
+    xSemaphoreTake(app_config_lock, portMAX_DELAY);
+    for (int i = 0; i < app_config.ntp_count; i++) {
+        ntp_servers[i] = app_config.ntp_server[i];
+    }
+    esp_err_t err = ntp_client_start(ntp_servers, app_config.ntp_count);
+    xSemaphoreGive(app_config_lock);
+    ESP_ERROR_CHECK(err);
+    if (sntp_get_time == NULL) {
+        xReturn = xTaskCreate(SNTP_GET_TIME,
+                     "SNTP_GET_TIME",
+                     TASK_WIFI_SIZE,
+                     NULL,
+                     TASK_WIFI_PRIORITY,
+                     &sntp_get_time
+                 );
+    }
+ }
+
+ // 秒边界回调 由时间服务在每秒整点调用
+ static void clock_second_cb(time_tick_t tick, time_t utc_sec, void *arg){
+    struct tm timeinfo;
+    time_service_localtime(utc_sec, &timeinfo);
+
+    Time msg = { .hour = timeinfo.tm_hour,
+                 .min  = timeinfo.tm_min,
+                 .sec  = timeinfo.tm_sec };
+    // 在esp_timer任务中执行, 发布不会阻塞
+    msg_bus_publish_value(&clock_time_topic, &msg);
+ }
 
-    TickType_t xLastWakeTime;
-    const TickType_t xFrequency = pdMS_TO_TICKS(1000); //1S更新一次
-    xLastWakeTime = xTaskGetTickCount();
+ void SNTP_GET_TIME(void *pvParam){
 
-    time_t now;
+    struct timeval now;
     struct tm timeinfo;
     char strftime_buf[64];
 
-    //初始化STNP
-    esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG("pool.ntp.org");
-    esp_netif_sntp_init(&config);
-
-    //同步
-    if (esp_netif_sntp_sync_wait(pdMS_TO_TICKS(15000)) != ESP_OK) {
+    //同步 NTP客户端已在链路回调中启动, 结果交给时间服务平滑校正
+    if (ntp_client_wait_sync(pdMS_TO_TICKS(15000)) != ESP_OK) {
         ESP_LOGE(TAG, "SNTP 同步失败，继续使用本地时间");
     }
 
-    //设置时区
-    setenv("TZ", "CST-8", 1);
-    tzset();
-
     //读取时间
-    time(&now);
-    localtime_r(&now, &timeinfo);
+    time_service_now(&now);
+    time_service_localtime(now.tv_sec, &timeinfo);
     strftime(strftime_buf, sizeof(strftime_buf), "%F %T", &timeinfo);
     ESP_LOGI(TAG, "当前时间: %s", strftime_buf);
 
-    Time msg = {
-        .hour = timeinfo.tm_hour,
-        .min  = timeinfo.tm_min,
-        .sec  = timeinfo.tm_sec
-    };
+    vTaskDelete(NULL);             // 只执行一次就退出, 之后由NTP客户端任务周期同步
+}
 
-    if (xQueueSend(xQueue, &msg, pdMS_TO_TICKS(1000)) != pdPASS) {
-        ESP_LOGE(TAG, "时间消息入队失败");
-    }
+ // 主机弹出U盘后重新解析config.txt, 只应用发生变化的分组
+ // 锁只保护app_config的替换, 应用变化时不持有锁 (链路回调在事件循环中也要取锁)
+ void CONFIG_RELOAD_TASK(void *pvParam){
 
-    //esp_netif_sntp_deinit();       // 仅获取一次
+    static app_config_t config;
+    static WIFI networks[APP_CONFIG_MAX_WIFI];
+    const char *servers[APP_CONFIG_MAX_NTP];
 
     while (1) {
-        time(&now);
-        localtime_r(&now, &timeinfo);
-
-        Time msg = { .hour = timeinfo.tm_hour,
-                     .min  = timeinfo.tm_min,
-                     .sec  = timeinfo.tm_sec };
-        xQueueSend(xQueue, &msg, portMAX_DELAY);
-        //vTaskDelay(pdMS_TO_TICKS(1000));
-        vTaskDelayUntil(&xLastWakeTime, xFrequency);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        if (!config_load(APP_CONFIG_PATH, &config)) {
+            continue;
+        }
+        xSemaphoreTake(app_config_lock, portMAX_DELAY);
+        uint32_t changed = app_config_diff(&app_config, &config);
+        app_config = config;
+        EventBits_t state = xEventGroupGetBits(app_state);
+        xSemaphoreGive(app_config_lock);
+        ESP_LOGI(TAG, "配置已重新加载, 变化: 0x%02lx", (unsigned long)changed);
+
+        if (changed & APP_CONFIG_CHANGED_WIFI) {
+            for (int i = 0; i < config.wifi_count; i++) {
+                strlcpy(networks[i].ssid, config.wifi[i].ssid, sizeof(networks[i].ssid));
+                strlcpy(networks[i].passport, config.wifi[i].password, sizeof(networks[i].passport));
+            }
+            if (state & APP_WIFI_STARTED) {
+                // 正在启动的连接管理器可能读到的是旧列表, 等它初始化完成后再替换
+                xEventGroupWaitBits(app_state, APP_WIFI_RUNNING, pdFALSE, pdTRUE, portMAX_DELAY);
+                wifi_reconfigure(networks, config.wifi_count);
+            } else if (config.wifi_count > 0) {
+                // 启动时没有配置网络 现在补上
+                xTaskCreate(WIFI_CONNECT, "WIFI_CONNECT", TASK_WIFI_SIZE, NULL,
+                            TASK_WIFI_PRIORITY, &wifi_connect);
+            }
+        }
+        if (changed & APP_CONFIG_CHANGED_NTP) {
+            for (int i = 0; i < config.ntp_count; i++) {
+                servers[i] = config.ntp_server[i];
+            }
+            // 客户端尚未启动时返回ESP_ERR_INVALID_STATE, 连网后会用新列表启动
+            ntp_client_set_servers(servers, config.ntp_count);
+        }
+        if (changed & APP_CONFIG_CHANGED_TIMEZONE) {
+            time_service_set_timezone(config.timezone);
+        }
+        // 灯效引擎尚未初始化时跳过, 它初始化时会读到新配置
+        if ((changed & APP_CONFIG_CHANGED_LED) && (state & APP_LED_READY)) {
+            led_engine_set_brightness(&led_engine, config.led_brightness, config.led_gamma);
+            led_engine_set_frame_period(&led_engine, config.led_frame_ms);
+        }
+        if (changed & APP_CONFIG_CHANGED_DISPLAY) {
+            DisplayConfig display = { .contrast = config.display_contrast,
+                                      .flip     = config.display_flip };
+            msg_bus_publish_value(&display_config_topic, &display);
+        }
     }
-
-
-    vTaskDelete(NULL);             // 只执行一次就退出
-}
+ }
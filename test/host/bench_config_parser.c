@@ -0,0 +1,66 @@
+// 配置解析速度: 典型的config.txt整体解析, 以及按app_config_load的128字节分块送入大文件
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "app_config.h"
+#include "bench_host.h"
+
+#define BENCH_MIN_NS 300000000ULL
+
+static const char typical[] =
+    "# config.txt\n"
+    "[wifi]\nssid = home\npassword = \"secret password\"\n\n"
+    "[wifi]\nssid = office\npassword = 'p@ss:word=1'\n\n"
+    "[ntp]\nserver = ntp.aliyun.com\nserver = pool.ntp.org\ntimezone = CET-1CEST,M3.5.0,M10.5.0/3\n\n"
+    "[led]\nbrightness = 128\ngamma = off\nframe_ms = 16\n\n"
+    "[display]\ncontrast = 0x80\nflip = yes\n";
+
+static size_t count_lines(const char *text, size_t len) {
+    size_t lines = 0;
+    for (size_t i = 0; i < len; i++) {
+        lines += text[i] == '\n';
+    }
+    return lines;
+}
+
+static void bench(const char *name, const char *text, size_t len, size_t chunk) {
+    static app_config_t config;
+    cfg_parser_t parser;
+    uint64_t runs = 0;
+    uint64_t start = bench_now_ns();
+    uint64_t elapsed;
+    do {
+        cfg_parser_init(&parser, &app_config_schema, &config);
+        for (size_t pos = 0; pos < len; pos += chunk) {
+            cfg_parser_feed(&parser, text + pos, len - pos < chunk ? len - pos : chunk);
+        }
+        cfg_parser_finish(&parser);
+        bench_keep(&config);
+        runs++;
+        elapsed = bench_now_ns() - start;
+    } while (elapsed < BENCH_MIN_NS);
+
+    double sec = elapsed / 1e9;
+    printf("%-24s %6zu bytes %5zu lines  %9.0f parses/s %8.1f MB/s %7.2f M lines/s  (%u values, %u errors)\n",
+           name, len, count_lines(text, len), runs / sec, runs * len / sec / 1e6,
+           runs * count_lines(text, len) / sec / 1e6, (unsigned)parser.values, (unsigned)parser.errors);
+}
+
+int main(void) {
+    bench("typical, whole", typical, strlen(typical), strlen(typical));
+    bench("typical, 128B chunks", typical, strlen(typical), 128);
+
+    // 大文件: 典型内容重复, 夹杂注释和未知的key (重复的节超出上限后被忽略)
+    size_t cap = 256 * 1024, len = 0;
+    char *big = malloc(cap);
+    while (len + sizeof(typical) + 64 < cap) {
+        memcpy(big + len, typical, sizeof(typical) - 1);
+        len += sizeof(typical) - 1;
+        len += snprintf(big + len, cap - len, "; comment line\nunknown_key = %zu\n", len);
+    }
+    bench("256K file, 128B chunks", big, len, 128);
+    bench("256K file, 1B chunks", big, len, 1);
+    free(big);
+    return 0;
+}
@@ -0,0 +1,20 @@
+#ifndef __BENCH_HOST_H__
+#define __BENCH_HOST_H__
+
+// 主机性能测试的计时工具 结果是本机的数值, 只用于比较同一台机器上的前后差异
+
+#include <stdint.h>
+#include <time.h>
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// 防止编译器把被测代码当作无用计算删掉
+static inline void bench_keep(const void *p) {
+    __asm__ volatile("" : : "r"(p) : "memory");
+}
+
+#endif // __BENCH_HOST_H__
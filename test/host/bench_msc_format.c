@@ -0,0 +1,85 @@
+// MSC存储的快速格式化: 在文件模拟的磨损均衡分区 (1 MiB, 与partitions.csv相同) 上
+// 运行tinyusb_msc_storage_mount(), 分三种情况:
+//   blank      空白闪存, 第一次启动
+//   lost-boot  引导扇区所在的擦除块被擦掉, 其余系统区还在
+//   formatted  已有文件系统, 只挂载
+// 除主机耗时外输出闪存操作数, 以及按数据手册典型值估计的目标上的闪存时间.
+//
+// 与f_mkfs的比较不在这里: FatFs不在本仓库 (IDF的fatfs组件), 主机上没有f_mkfs可运行.
+// 目标上格式化时会输出 "formatted in N ms (fast format)" 或 "(f_mkfs)",
+// 关闭CONFIG_TINYUSB_FAT_FAST_FORMAT即可得到f_mkfs的时间
+
+#include <stdio.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "tusb_msc_storage.h"
+#include "fake_wl.h"
+#include "bench_host.h"
+
+#define PARTITION_SIZE (1024 * 1024)
+#define IMAGE_PATH     "_build/bench_msc_format.img"
+#define REPEAT         20
+
+int64_t esp_timer_get_time(void) {
+    return (int64_t)(bench_now_ns() / 1000);
+}
+
+typedef enum {
+    SCENARIO_BLANK,
+    SCENARIO_LOST_BOOT,
+    SCENARIO_FORMATTED,
+} scenario_t;
+
+static const char *const s_names[] = { "blank", "lost-boot", "formatted" };
+
+static wl_handle_t open_image(scenario_t scenario) {
+    wl_handle_t wl;
+    if (scenario == SCENARIO_BLANK) {
+        unlink(IMAGE_PATH);
+    }
+    ESP_ERROR_CHECK(fake_wl_open(IMAGE_PATH, PARTITION_SIZE, &wl));
+    if (scenario == SCENARIO_LOST_BOOT) {
+        ESP_ERROR_CHECK(wl_erase_range(wl, 0, FAKE_WL_BLOCK_SIZE));
+    }
+    fake_wl_reset_stats(wl);
+    return wl;
+}
+
+static void bench_scenario(scenario_t scenario) {
+    uint64_t best_ns = UINT64_MAX;
+    fake_wl_stats_t stats;
+    for (int i = 0; i < REPEAT; i++) {
+        wl_handle_t wl = open_image(scenario);
+        const tinyusb_msc_spiflash_config_t config = { .wl_handle = wl };
+        ESP_ERROR_CHECK(tinyusb_msc_storage_init_spiflash(&config));
+
+        uint64_t start = bench_now_ns();
+        ESP_ERROR_CHECK(tinyusb_msc_storage_mount("/data"));
+        uint64_t elapsed = bench_now_ns() - start;
+
+        if (elapsed < best_ns) {
+            best_ns = elapsed;
+        }
+        fake_wl_get_stats(wl, &stats);
+        if (stats.program_errors) {
+            fprintf(stderr, "%s: %u writes to unerased flash\n", s_names[scenario], stats.program_errors);
+            abort();
+        }
+        tinyusb_msc_storage_deinit();
+        fake_wl_close(wl);
+    }
+
+    double flash_ms = fake_wl_flash_us(&stats) / 1000.0;
+    printf("%-9s  host %8.1f us  reads %3u (%6llu B)  erases %3u  programmed %6llu B  -> flash ~%6.1f ms\n",
+           s_names[scenario], best_ns / 1000.0, stats.reads, (unsigned long long)stats.read_bytes,
+           stats.erases, (unsigned long long)stats.programmed, flash_ms);
+}
+
+int main(void) {
+    esp_log_level_set("*", ESP_LOG_ERROR);  // 每次格式化都有的 "f_mount failed" 警告
+    bench_scenario(SCENARIO_BLANK);
+    bench_scenario(SCENARIO_LOST_BOOT);
+    bench_scenario(SCENARIO_FORMATTED);
+    unlink(IMAGE_PATH);
+    return 0;
+}
@@ -0,0 +1,105 @@
+// MSC的SCSI命令分发: 重放主机空闲时反复发送的轮询命令, 输出每秒命令数.
+// 命令经过BOT协议 (CBW, 数据阶段, CSW), TinyUSB的MSC驱动和esp_tinyusb存储层,
+// 不支持的命令按BOT规范STALL后清除. 失败的命令之后与主机一样用REQUEST SENSE取走sense
+// (不取走时MSC驱动不再把未知命令交给应用), 计入这条命令的时间. "mix"一行是一轮轮询中的全部命令
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "tusb.h"
+#include "esp_log.h"
+#include "tusb_msc_storage.h"
+#include "fake_usb.h"
+#include "fake_wl.h"
+#include "bench_host.h"
+
+#define PARTITION_SIZE (1024 * 1024)
+#define IMAGE_PATH     "_build/bench_msc_scsi.img"
+#define ROUNDS         20000
+#define REPEAT         5
+
+int64_t esp_timer_get_time(void) {
+    return (int64_t)(bench_now_ns() / 1000);
+}
+
+typedef struct {
+    const char *name;
+    uint8_t cdb[10];
+    uint8_t cdb_len;
+    uint16_t data_len;      // 主机期望的长度, 都是IN方向
+    uint8_t status;         // 期望的CSW状态
+} scsi_cmd_t;
+
+// Windows和Linux在介质就绪后的轮询
+static const scsi_cmd_t s_cmds[] = {
+    { "TEST UNIT READY", { SCSI_CMD_TEST_UNIT_READY }, 6, 0, MSC_CSW_STATUS_PASSED },
+    { "REQUEST SENSE", { SCSI_CMD_REQUEST_SENSE, 0, 0, 0, 18 }, 6, 18, MSC_CSW_STATUS_PASSED },
+    { "INQUIRY", { SCSI_CMD_INQUIRY, 0, 0, 0, 36 }, 6, 36, MSC_CSW_STATUS_PASSED },
+    { "MODE SENSE(6)", { SCSI_CMD_MODE_SENSE_6, 0, 0x3F, 0, 192 }, 6, 192, MSC_CSW_STATUS_PASSED },
+    { "MODE SENSE(10)", { SCSI_CMD_MODE_SENSE_10, 0, 0x3F, 0, 0, 0, 0, 0, 192 }, 10, 192, MSC_CSW_STATUS_PASSED },
+    { "READ FORMAT CAPACITIES", { SCSI_CMD_READ_FORMAT_CAPACITY, 0, 0, 0, 0, 0, 0, 0, 252 }, 10, 252,
+      MSC_CSW_STATUS_PASSED },
+    { "READ CAPACITY(10)", { SCSI_CMD_READ_CAPACITY_10 }, 10, 8, MSC_CSW_STATUS_PASSED },
+    { "SYNCHRONIZE CACHE(10)", { SCSI_CMD_SYNCHRONIZE_CACHE_10 }, 10, 0, MSC_CSW_STATUS_PASSED },
+    { "GET EVENT STATUS (unsupported)", { 0x4A, 0x01, 0, 0, 0x10, 0, 0, 0, 8 }, 10, 8, MSC_CSW_STATUS_FAILED },
+    { "ATA PASS-THROUGH (unsupported)", { 0xA1, 0x08, 0x0E }, 10, 512, MSC_CSW_STATUS_FAILED },
+};
+
+#define CMD_COUNT (sizeof(s_cmds) / sizeof(s_cmds[0]))
+#define CMD_REQUEST_SENSE 1
+
+static uint8_t s_buf[512];
+
+static void run(const scsi_cmd_t *cmd) {
+    uint8_t status = fake_usb_scsi(cmd->cdb, cmd->cdb_len, true, s_buf, cmd->data_len);
+    if (status != cmd->status) {
+        fprintf(stderr, "%s: CSW status %u, expected %u\n", cmd->name, status, cmd->status);
+        abort();
+    }
+    if (status == MSC_CSW_STATUS_FAILED) {
+        run(&s_cmds[CMD_REQUEST_SENSE]);
+    }
+}
+
+// 只运行cmd, 或者cmd为NULL时每轮运行所有命令, 返回每秒命令数
+static double bench(const scsi_cmd_t *cmd) {
+    uint64_t best_ns = UINT64_MAX;
+    for (int r = 0; r < REPEAT; r++) {
+        uint64_t start = bench_now_ns();
+        for (int i = 0; i < ROUNDS; i++) {
+            if (cmd) {
+                run(cmd);
+            } else {
+                for (size_t j = 0; j < CMD_COUNT; j++) {
+                    run(&s_cmds[j]);
+                }
+            }
+        }
+        uint64_t elapsed = bench_now_ns() - start;
+        best_ns = elapsed < best_ns ? elapsed : best_ns;
+    }
+    return (double)ROUNDS * (cmd ? 1 : CMD_COUNT) / (best_ns / 1e9);
+}
+
+int main(void) {
+    unlink(IMAGE_PATH);
+    wl_handle_t wl;
+    ESP_ERROR_CHECK(fake_wl_open(IMAGE_PATH, PARTITION_SIZE, &wl));
+    const tinyusb_msc_spiflash_config_t config = { .wl_handle = wl };
+    ESP_ERROR_CHECK(tinyusb_msc_storage_init_spiflash(&config));
+    fake_usb_init();
+
+    for (size_t i = 0; i < CMD_COUNT; i++) {
+        printf("%-31s %10.0f cmds/s\n", s_cmds[i].name, bench(&s_cmds[i]));
+    }
+    printf("%-31s %10.0f cmds/s\n", "mix", bench(NULL));
+
+    tinyusb_msc_stats_t stats;
+    tinyusb_msc_storage_get_stats(&stats);
+    printf("%u unsupported commands counted, last 0x%02X\n", stats.scsi_unsupported, stats.scsi_last_unsupported);
+
+    tinyusb_msc_storage_deinit();
+    fake_wl_close(wl);
+    unlink(IMAGE_PATH);
+    return 0;
+}
@@ -0,0 +1,237 @@
+// 主机的文件轮换负载下UNMAP的效果: 主机经BOT协议按扇区写入文件, 删除最旧的文件,
+// 比较删除后发送UNMAP和不发送时的闪存擦除次数与写入吞吐量.
+// 主机端的文件系统只是一个模型: 开头32个扇区是元数据 (FAT和目录), 其后的数据区按16 KiB
+// 分成槽, 依次循环分配 (next fit), 每个文件写入后和删除后各更新一个FAT扇区和一个目录扇区.
+// 文件数据按512字节的WRITE(10)写入, 与test_apps/msc_unmap的设备端负载相同.
+//
+// 开始前检查主机据以发送UNMAP的字段: READ CAPACITY(16)的LBPME和擦除块大小,
+// Block Limits (B0h) 和Logical Block Provisioning (B2h) VPD页.
+// 吞吐量一列与bench_msc_xfer相同, 是主机耗时加上按数据手册估计的闪存耗时, 包括UNMAP命令本身
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tusb.h"
+#include "esp_log.h"
+#include "tusb_msc_storage.h"
+#include "fake_usb.h"
+#include "fake_wl.h"
+#include "bench_host.h"
+
+#define PARTITION_SIZE  (1024 * 1024)
+#define IMAGE_PATH      "_build/bench_msc_unmap.img"
+#define SECTOR_SIZE     CONFIG_WL_SECTOR_SIZE
+#define META_SECTORS    32
+#define FILE_SECTORS    (16 * 1024 / SECTOR_SIZE)
+#define LIVE_FILES      4       // 保留的文件数, 写新文件前删除最旧的
+#define WARMUP_ROUNDS   64      // 先把数据区循环一遍, 删除的槽都已UNMAP过
+#define ROUNDS          256
+#define REPEAT          3
+
+int64_t esp_timer_get_time(void) {
+    return (int64_t)(bench_now_ns() / 1000);
+}
+
+static wl_handle_t s_wl;
+static uint32_t s_slots;
+static uint8_t s_buf[64];
+
+static void fail(const char *what) {
+    fprintf(stderr, "%s\n", what);
+    abort();
+}
+
+static uint32_t get_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void put_be32(uint8_t *p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void scsi_in(const uint8_t *cdb, uint8_t cdb_len, uint32_t len) {
+    memset(s_buf, 0, sizeof(s_buf));
+    if (fake_usb_scsi(cdb, cdb_len, true, s_buf, len) != MSC_CSW_STATUS_PASSED) {
+        fail("capability query failed");
+    }
+}
+
+// 主机决定是否及如何发送UNMAP所依据的字段
+static void check_capabilities(uint32_t sectors) {
+    const uint32_t granularity = 4096 / SECTOR_SIZE;
+
+    const uint8_t rc16[16] = { SCSI_CMD_SERVICE_ACTION_IN_16, 0x10, [13] = 32 };
+    scsi_in(rc16, sizeof(rc16), 32);
+    if (get_be32(s_buf) != 0 || get_be32(s_buf + 4) != sectors - 1 || get_be32(s_buf + 8) != SECTOR_SIZE) {
+        fail("READ CAPACITY(16): wrong capacity");
+    }
+    if ((1u << (s_buf[13] & 0x0F)) != granularity || !(s_buf[14] & 0x80)) {
+        fail("READ CAPACITY(16): LBPME or logical blocks per physical block exponent wrong");
+    }
+
+    const uint8_t pages[6] = { SCSI_CMD_INQUIRY, 0x01, 0x00, 0, 64 };
+    scsi_in(pages, sizeof(pages), 64);
+    if (s_buf[3] != 3 || s_buf[4] != 0x00 || s_buf[5] != 0xB0 || s_buf[6] != 0xB2) {
+        fail("supported VPD pages: B0h and B2h not listed");
+    }
+
+    const uint8_t b0[6] = { SCSI_CMD_INQUIRY, 0x01, 0xB0, 0, 64 };
+    scsi_in(b0, sizeof(b0), 64);
+    if (s_buf[1] != 0xB0 || s_buf[3] != 0x3C) {
+        fail("Block Limits VPD: wrong page");
+    }
+    if (get_be32(s_buf + 20) != 256 * 1024 / SECTOR_SIZE ||
+            get_be32(s_buf + 24) != (CONFIG_TINYUSB_MSC_BUFSIZE - 8) / 16) {
+        fail("Block Limits VPD: maximum UNMAP LBA count or descriptor count wrong");
+    }
+    if (get_be32(s_buf + 28) != granularity || get_be32(s_buf + 32) != 0x80000000) {
+        fail("Block Limits VPD: optimal UNMAP granularity or alignment wrong");
+    }
+    const uint32_t max_lba_count = get_be32(s_buf + 20);
+
+    const uint8_t b2[6] = { SCSI_CMD_INQUIRY, 0x01, 0xB2, 0, 8 };
+    scsi_in(b2, sizeof(b2), 8);
+    if (s_buf[1] != 0xB2 || s_buf[3] != 4 || !(s_buf[5] & 0x80) || (s_buf[6] & 0x07) != 2) {
+        fail("Logical Block Provisioning VPD: LBPU or provisioning type wrong");
+    }
+    printf("READ CAPACITY(16) and VPD B0h/B2h: UNMAP supported, granularity %u sectors, up to %u per command\n",
+           granularity, max_lba_count);
+}
+
+static void write_sector(uint32_t lba, uint8_t fill) {
+    static uint8_t data[SECTOR_SIZE];
+    memset(data, fill, sizeof(data));
+    const uint8_t cdb[10] = {
+        SCSI_CMD_WRITE_10, 0, (uint8_t)(lba >> 24), (uint8_t)(lba >> 16), (uint8_t)(lba >> 8), (uint8_t)lba, 0, 0, 1, 0,
+    };
+    if (fake_usb_scsi(cdb, sizeof(cdb), false, data, sizeof(data)) != MSC_CSW_STATUS_PASSED) {
+        fail("WRITE(10) failed");
+    }
+}
+
+static void unmap(uint32_t lba, uint32_t count) {
+    uint8_t list[24] = {0};
+    list[1] = sizeof(list) - 2;
+    list[3] = 16;
+    put_be32(list + 12, lba);
+    put_be32(list + 16, count);
+    const uint8_t cdb[10] = { SCSI_CMD_UNMAP, 0, 0, 0, 0, 0, 0, 0, sizeof(list), 0 };
+    if (fake_usb_scsi(cdb, sizeof(cdb), false, list, sizeof(list)) != MSC_CSW_STATUS_PASSED) {
+        fail("UNMAP failed");
+    }
+}
+
+static uint32_t slot_lba(int round) {
+    return META_SECTORS + (uint32_t)(round % s_slots) * FILE_SECTORS;
+}
+
+// 第round个文件: 删除最旧的文件 (可选UNMAP), 写入新文件, 更新元数据
+static void churn_round(int round, bool use_unmap) {
+    if (round >= LIVE_FILES) {
+        uint32_t old = slot_lba(round - LIVE_FILES);
+        write_sector(1 + (old / FILE_SECTORS) % 15, (uint8_t)round);    // FAT
+        write_sector(16 + (round - LIVE_FILES) % LIVE_FILES, 0xE5);     // 目录项标记为已删除
+        if (use_unmap) {
+            unmap(old, FILE_SECTORS);
+        }
+    }
+    uint32_t lba = slot_lba(round);
+    for (uint32_t i = 0; i < FILE_SECTORS; i++) {
+        write_sector(lba + i, (uint8_t)(round + i));
+    }
+    write_sector(1 + (lba / FILE_SECTORS) % 15, (uint8_t)round);
+    write_sector(16 + round % LIVE_FILES, (uint8_t)round);
+}
+
+// 保留的文件内容完整, UNMAP没有擦到正在使用的扇区
+static void verify_live_files(int next_round) {
+    static uint8_t data[SECTOR_SIZE];
+    for (int round = next_round - LIVE_FILES; round < next_round; round++) {
+        uint32_t lba = slot_lba(round);
+        for (uint32_t i = 0; i < FILE_SECTORS; i++) {
+            const uint8_t cdb[10] = {
+                SCSI_CMD_READ_10, 0, (uint8_t)((lba + i) >> 24), (uint8_t)((lba + i) >> 16),
+                (uint8_t)((lba + i) >> 8), (uint8_t)(lba + i), 0, 0, 1, 0,
+            };
+            if (fake_usb_scsi(cdb, sizeof(cdb), true, data, sizeof(data)) != MSC_CSW_STATUS_PASSED) {
+                fail("READ(10) failed");
+            }
+            for (size_t j = 0; j < sizeof(data); j++) {
+                if (data[j] != (uint8_t)(round + i)) {
+                    fail("live file data lost");
+                }
+            }
+        }
+    }
+}
+
+typedef struct {
+    uint64_t best_ns;               // 每ROUNDS轮的最短主机耗时
+    fake_wl_stats_t flash;          // 所有测量轮中的闪存操作
+    tinyusb_msc_stats_t msc;
+} churn_result_t;
+
+static int churn(int round, bool use_unmap, churn_result_t *result) {
+    for (int end = round + WARMUP_ROUNDS; round < end; round++) {
+        churn_round(round, use_unmap);
+    }
+    fake_wl_reset_stats(s_wl);
+    tinyusb_msc_storage_reset_stats();
+    result->best_ns = UINT64_MAX;
+    for (int r = 0; r < REPEAT; r++) {
+        uint64_t start = bench_now_ns();
+        for (int end = round + ROUNDS; round < end; round++) {
+            churn_round(round, use_unmap);
+        }
+        uint64_t elapsed = bench_now_ns() - start;
+        result->best_ns = elapsed < result->best_ns ? elapsed : result->best_ns;
+    }
+    fake_wl_get_stats(s_wl, &result->flash);
+    tinyusb_msc_storage_get_stats(&result->msc);
+    if (result->flash.program_errors) {
+        fail("writes to unerased flash");
+    }
+    verify_live_files(round);
+    return round;
+}
+
+static void report(const char *name, const churn_result_t *result) {
+    const double rounds = (double)ROUNDS * REPEAT;
+    const double mib = ROUNDS * FILE_SECTORS * SECTOR_SIZE / 1048576.0;
+    const double flash_us = fake_wl_flash_us(&result->flash) / REPEAT;
+    printf("  %-13s  %6.2f erases/file  %5.1f KiB programmed/file  %4u UNMAP  %5u writes without erase  "
+           "host %6.1f MiB/s  -> ~%6.3f MiB/s\n", name,
+           result->flash.erases / rounds, result->flash.programmed / rounds / 1024, result->msc.unmap.count,
+           result->msc.erase_skipped, mib / (result->best_ns / 1e9), mib / ((result->best_ns / 1e3 + flash_us) / 1e6));
+}
+
+int main(void) {
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    unlink(IMAGE_PATH);
+    ESP_ERROR_CHECK(fake_wl_open(IMAGE_PATH, PARTITION_SIZE, &s_wl));
+    const tinyusb_msc_spiflash_config_t config = { .wl_handle = s_wl };
+    ESP_ERROR_CHECK(tinyusb_msc_storage_init_spiflash(&config));
+    fake_usb_init();
+    const uint32_t sectors = tinyusb_msc_storage_get_sector_count();
+    s_slots = (sectors - META_SECTORS) / FILE_SECTORS;
+
+    check_capabilities(sectors);
+    printf("%u x %u KiB slots, %d files kept, %d files per pass\n", s_slots, FILE_SECTORS * SECTOR_SIZE / 1024,
+           LIVE_FILES, ROUNDS);
+
+    // 同一个分区上先不发送UNMAP, 再发送UNMAP, 各自先预热一遍
+    churn_result_t without, with;
+    int round = churn(0, false, &without);
+    churn(round, true, &with);
+    report("without UNMAP", &without);
+    report("with UNMAP", &with);
+
+    tinyusb_msc_storage_deinit();
+    fake_wl_close(s_wl);
+    unlink(IMAGE_PATH);
+    return 0;
+}
@@ -0,0 +1,123 @@
+// MSC存储的传输吞吐量: 主机经BOT协议用64 KiB的READ(10)和WRITE(10)读写整个磁盘,
+// 数据经过TinyUSB的MSC驱动, esp_tinyusb存储层和文件模拟的磨损均衡分区.
+// 每种配置编译成一个程序 (Makefile中的bench_msc_xfer*), 在同一台机器上比较:
+//   bench_msc_xfer          默认配置
+//   bench_msc_xfer_nostats  关闭CONFIG_TINYUSB_MSC_STATS, 与上面的差就是统计的开销
+//   bench_msc_xfer_<N>      CONFIG_TINYUSB_MSC_BUFSIZE为N, 比较每MiB的回调次数
+//
+// 主机上的"闪存"在页缓存中, 比目标上快得多. 所以除主机上的吞吐量外, 还输出每次读写回调
+// 的主机耗时和按数据手册估计的闪存耗时, 开销应与后者比较. 最后一列是主机耗时加上
+// 估计的闪存耗时得到的吞吐量, 没有计入全速总线 (约1 MiB/s) 的限制
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tusb.h"
+#include "esp_log.h"
+#include "tusb_msc_storage.h"
+#include "fake_usb.h"
+#include "fake_wl.h"
+#include "bench_host.h"
+
+#define PARTITION_SIZE (1024 * 1024)
+#define IMAGE_PATH     "_build/bench_msc_xfer.img"
+#define SECTOR_SIZE    CONFIG_WL_SECTOR_SIZE
+#define XFER_SIZE      (64 * 1024)
+#define XFER_SECTORS   (XFER_SIZE / SECTOR_SIZE)
+#define REPEAT         15
+
+int64_t esp_timer_get_time(void) {
+    return (int64_t)(bench_now_ns() / 1000);
+}
+
+static uint32_t s_sectors;
+static uint8_t s_data[PARTITION_SIZE];
+static uint8_t s_readback[PARTITION_SIZE];
+
+static void xfer(bool write, uint32_t lba, uint8_t *data, uint32_t size) {
+    const uint16_t blocks = size / SECTOR_SIZE;
+    const uint8_t cdb[10] = {
+        write ? SCSI_CMD_WRITE_10 : SCSI_CMD_READ_10, 0,
+        (uint8_t)(lba >> 24), (uint8_t)(lba >> 16), (uint8_t)(lba >> 8), (uint8_t)lba,
+        0, (uint8_t)(blocks >> 8), (uint8_t)blocks, 0,
+    };
+    if (fake_usb_scsi(cdb, sizeof(cdb), !write, data, size) != MSC_CSW_STATUS_PASSED) {
+        fprintf(stderr, "%s at lba %u failed\n", write ? "WRITE(10)" : "READ(10)", lba);
+        abort();
+    }
+}
+
+typedef struct {
+    uint64_t best_ns;
+    uint32_t callbacks;         // 一遍中的读写回调次数
+    fake_wl_stats_t flash;      // 一遍中的闪存操作
+} pass_result_t;
+
+// 读或写整个磁盘一遍
+static void pass(wl_handle_t wl, bool write, uint8_t *buf, pass_result_t *result) {
+    fake_usb_reset_counters();
+    fake_wl_reset_stats(wl);
+    uint64_t start = bench_now_ns();
+    for (uint32_t lba = 0; lba < s_sectors; lba += XFER_SECTORS) {
+        uint32_t n = s_sectors - lba < XFER_SECTORS ? s_sectors - lba : XFER_SECTORS;
+        xfer(write, lba, buf + lba * SECTOR_SIZE, n * SECTOR_SIZE);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    if (elapsed < result->best_ns) {
+        result->best_ns = elapsed;
+    }
+    result->callbacks = fake_usb_data_xfers();
+    fake_wl_get_stats(wl, &result->flash);
+    if (result->flash.program_errors) {
+        fprintf(stderr, "%u writes to unerased flash\n", result->flash.program_errors);
+        abort();
+    }
+}
+
+static void report(const char *name, const pass_result_t *result, uint32_t bytes) {
+    const double mib = bytes / 1048576.0;
+    const double flash_us = fake_wl_flash_us(&result->flash);
+    printf("  %-5s  host %7.1f MiB/s  %6.1f callbacks/MiB  %6.2f us per callback  "
+           "flash ~%8.1f us per callback  -> ~%6.3f MiB/s\n", name,
+           mib / (result->best_ns / 1e9), result->callbacks / mib, result->best_ns / 1000.0 / result->callbacks,
+           flash_us / result->callbacks, mib / ((result->best_ns / 1e3 + flash_us) / 1e6));
+}
+
+int main(void) {
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    unlink(IMAGE_PATH);
+    wl_handle_t wl;
+    ESP_ERROR_CHECK(fake_wl_open(IMAGE_PATH, PARTITION_SIZE, &wl));
+    const tinyusb_msc_spiflash_config_t config = { .wl_handle = wl };
+    ESP_ERROR_CHECK(tinyusb_msc_storage_init_spiflash(&config));
+    fake_usb_init();
+    s_sectors = tinyusb_msc_storage_get_sector_count();
+    const uint32_t bytes = s_sectors * SECTOR_SIZE;
+
+    pass_result_t write = { .best_ns = UINT64_MAX };
+    pass_result_t read = { .best_ns = UINT64_MAX };
+    for (int i = 0; i < REPEAT; i++) {
+        for (uint32_t j = 0; j < bytes; j++) {
+            s_data[j] = (uint8_t)(j * 31 + i);
+        }
+        pass(wl, true, s_data, &write);
+        pass(wl, false, s_readback, &read);
+        if (memcmp(s_data, s_readback, bytes) != 0) {
+            fprintf(stderr, "read back data differs\n");
+            abort();
+        }
+    }
+
+    tinyusb_msc_stats_t stats;
+    tinyusb_msc_storage_get_stats(&stats);
+    printf("bufsize %d, statistics %s (%u reads, %u writes recorded)\n", CFG_TUD_MSC_EP_BUFSIZE,
+           CONFIG_TINYUSB_MSC_STATS ? "on" : "off", stats.read.count, stats.write.count);
+    report("write", &write, bytes);
+    report("read", &read, bytes);
+
+    tinyusb_msc_storage_deinit();
+    fake_wl_close(wl);
+    unlink(IMAGE_PATH);
+    return 0;
+}
@@ -0,0 +1,98 @@
+// OLED字模的写入耗时: RLE解码 (OLED_SetBlockRLE) 与原始数据的OLED_SetBlock和原来按像素写入的实现比较
+// 字模是时钟界面用的24x12 ASCII字库的所有可打印字符和51x48的图片, 纵坐标分为页对齐和跨页两种.
+// 最后一列是数据的字节数, RLE字库包括偏移表
+
+#include <stdio.h>
+#include <string.h>
+#include "oled.h"
+#include "oled_ref.h"
+#include "bench_host.h"
+
+#define REPEAT  20
+#define ROUNDS  2000
+
+extern uint8_t OLED_GRAM[8][128];
+
+typedef enum { PATH_PIXEL, PATH_RAW, PATH_RLE } path_t;
+
+static const char *const s_path_names[] = { "per-pixel", "raw", "RLE" };
+
+static void draw_glyphs(path_t path, uint8_t y) {
+    const ASCIIFont *font = &afont24x12;
+    const uint16_t size = ((font->h + 7) / 8) * font->w;
+    for (int c = 0; c < 95; c++) {
+        uint8_t x = (c % 10) * font->w;
+        switch (path) {
+        case PATH_PIXEL:
+            oled_ref_set_block(x, y, font->chars + c * size, font->w, font->h, OLED_COLOR_NORMAL);
+            break;
+        case PATH_RAW:
+            OLED_PrintASCIIChar(x, y, ' ' + c, font, OLED_COLOR_NORMAL);
+            break;
+        case PATH_RLE:
+            OLED_PrintASCIIChar(x, y, ' ' + c, &afont24x12_rle, OLED_COLOR_NORMAL);
+            break;
+        }
+    }
+}
+
+static void draw_image(path_t path, uint8_t y) {
+    switch (path) {
+    case PATH_PIXEL:
+        oled_ref_set_block(40, y, bilibiliImg.data, bilibiliImg.w, bilibiliImg.h, OLED_COLOR_NORMAL);
+        break;
+    case PATH_RAW:
+        OLED_DrawImage(40, y, &bilibiliImg, OLED_COLOR_NORMAL);
+        break;
+    case PATH_RLE:
+        OLED_DrawImage(40, y, &bilibiliImg_rle, OLED_COLOR_NORMAL);
+        break;
+    }
+}
+
+// 返回每个字模的最短耗时 (ns)
+static double bench(void (*draw)(path_t, uint8_t), path_t path, uint8_t y, int per_round) {
+    uint64_t best_ns = UINT64_MAX;
+    for (int r = 0; r < REPEAT; r++) {
+        uint64_t start = bench_now_ns();
+        for (int i = 0; i < ROUNDS; i++) {
+            draw(path, y);
+            bench_keep(OLED_GRAM);
+        }
+        uint64_t elapsed = bench_now_ns() - start;
+        best_ns = elapsed < best_ns ? elapsed : best_ns;
+    }
+    return (double)best_ns / ROUNDS / per_round;
+}
+
+static void report(const char *name, void (*draw)(path_t, uint8_t), int per_round, const unsigned sizes[3]) {
+    for (path_t path = PATH_PIXEL; path <= PATH_RLE; path++) {
+        printf("%-8s %-9s  %8.1f ns aligned  %8.1f ns unaligned  %5u bytes\n", name, s_path_names[path],
+               bench(draw, path, 8, per_round), bench(draw, path, 13, per_round), sizes[path]);
+    }
+}
+
+// 解码出raw字节所需的RLE数据长度
+static unsigned rle_len(const uint8_t *data, unsigned raw) {
+    const uint8_t *p = data;
+    for (unsigned n = 0; n < raw;) {
+        unsigned count = (*p & 0x7F) + 1;
+        n += count;
+        p += (*p & 0x80) ? 2 : count + 1;
+    }
+    return p - data;
+}
+
+int main(void) {
+    const ASCIIFont *font = &afont24x12;
+    const unsigned glyph_size = ((font->h + 7) / 8) * font->w;
+    const unsigned glyph_raw = 95 * glyph_size;
+    const unsigned glyph_rle = afont24x12_rle.rle_index[94] + rle_len(afont24x12_rle.chars + afont24x12_rle.rle_index[94],
+                               glyph_size) + 95 * sizeof(uint16_t);
+    const unsigned image_raw = bilibiliImg.w * ((bilibiliImg.h + 7) / 8);
+    const unsigned image_rle = rle_len(bilibiliImg_rle.data, image_raw);
+
+    report("glyph", draw_glyphs, 95, (const unsigned[]){ glyph_raw, glyph_raw, glyph_rle });
+    report("image", draw_image, 1, (const unsigned[]){ image_raw, image_raw, image_rle });
+    return 0;
+}
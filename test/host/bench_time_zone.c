@@ -0,0 +1,109 @@
+// 本地时间转换速度: time_zone_localtime与glibc localtime_r对比
+//
+// 连续秒: 显示任务每秒一次的访问方式, 几乎总是命中日期缓存
+// 随机:   1970-2100之间的随机时刻, 每次都需重新计算偏移和日期
+// 两种方式都逐项比对结果, 不一致时返回1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "time_zone.h"
+#include "bench_host.h"
+
+#define BENCH_CONSECUTIVE 20000000
+#define BENCH_RANDOM      2000000
+
+static const char *zones[] = {
+    "CST-8",
+    "CET-1CEST,M3.5.0,M10.5.0/3",
+    "EST5EDT,M3.2.0,M11.1.0",
+    "<+0330>-3:30",
+};
+
+static int64_t *random_times;
+
+static bool tm_equal(const struct tm *a, const struct tm *b) {
+    return a->tm_year == b->tm_year && a->tm_mon == b->tm_mon && a->tm_mday == b->tm_mday &&
+           a->tm_hour == b->tm_hour && a->tm_min == b->tm_min && a->tm_sec == b->tm_sec &&
+           a->tm_wday == b->tm_wday && a->tm_yday == b->tm_yday && a->tm_isdst == b->tm_isdst;
+}
+
+// 返回转换速度 (百万次/秒)
+static double run_libc(const int64_t *times, int64_t start, size_t num, struct tm *out) {
+    struct tm tm;
+    uint64_t t0 = bench_now_ns();
+    for (size_t i = 0; i < num; i++) {
+        time_t t = times ? times[i] : start + (int64_t)i;
+        localtime_r(&t, &tm);
+        bench_keep(&tm);
+    }
+    uint64_t ns = bench_now_ns() - t0;
+    *out = tm;
+    return num * 1000.0 / ns;
+}
+
+static double run_cached(time_zone_t *tz, const int64_t *times, int64_t start, size_t num, struct tm *out) {
+    struct tm tm;
+    uint64_t t0 = bench_now_ns();
+    for (size_t i = 0; i < num; i++) {
+        time_zone_localtime(tz, times ? times[i] : start + (int64_t)i, &tm);
+        bench_keep(&tm);
+    }
+    uint64_t ns = bench_now_ns() - t0;
+    *out = tm;
+    return num * 1000.0 / ns;
+}
+
+// 逐项比对 每隔step取一个样本
+static size_t verify(time_zone_t *tz, const int64_t *times, int64_t start, size_t num, size_t step) {
+    size_t mismatches = 0;
+    for (size_t i = 0; i < num; i += step) {
+        time_t t = times ? times[i] : start + (int64_t)i;
+        struct tm expect, actual;
+        localtime_r(&t, &expect);
+        time_zone_localtime(tz, t, &actual);
+        if (!tm_equal(&expect, &actual)) {
+            if (!mismatches) {
+                fprintf(stderr, "mismatch at %lld\n", (long long)t);
+            }
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+int main(void) {
+    random_times = malloc(BENCH_RANDOM * sizeof(int64_t));
+    srand(1);
+    for (size_t i = 0; i < BENCH_RANDOM; i++) {
+        random_times[i] = ((int64_t)rand() << 16 ^ rand()) % (4102444800LL);  // 1970-2100
+    }
+    const int64_t start = 1711846800 - 3600;  // 2024-03-31 欧洲夏令时开始前一小时
+
+    size_t mismatches = 0;
+    printf("%-28s %-12s %10s %10s %7s\n", "zone", "pattern", "libc M/s", "cached M/s", "speedup");
+    for (size_t z = 0; z < sizeof(zones) / sizeof(zones[0]); z++) {
+        setenv("TZ", zones[z], 1);
+        tzset();
+        time_zone_t tz;
+        if (!time_zone_parse(&tz, zones[z])) {
+            fprintf(stderr, "parse failed: %s\n", zones[z]);
+            return 1;
+        }
+
+        struct tm a, b;
+        double libc = run_libc(NULL, start, BENCH_CONSECUTIVE, &a);
+        double cached = run_cached(&tz, NULL, start, BENCH_CONSECUTIVE, &b);
+        printf("%-28s %-12s %10.1f %10.1f %6.1fx\n", zones[z], "consecutive", libc, cached, cached / libc);
+        mismatches += !tm_equal(&a, &b) + verify(&tz, NULL, start, BENCH_CONSECUTIVE, 97);
+
+        libc = run_libc(random_times, 0, BENCH_RANDOM, &a);
+        cached = run_cached(&tz, random_times, 0, BENCH_RANDOM, &b);
+        printf("%-28s %-12s %10.1f %10.1f %6.1fx\n", zones[z], "random", libc, cached, cached / libc);
+        mismatches += !tm_equal(&a, &b) + verify(&tz, random_times, 0, BENCH_RANDOM, 1);
+    }
+    printf("%zu mismatches against localtime_r\n", mismatches);
+    free(random_times);
+    return mismatches != 0;
+}
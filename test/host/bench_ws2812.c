@@ -0,0 +1,57 @@
+// WS2812刷新帧率: 1/60/1000颗LED时的编码耗时与线上传输时间
+//
+// 帧率上限取两者中较慢的一方. 线上时间固定为每bit (T0H+T0L) 加一次复位,
+// 编码耗时在主机上测得, 目标板上的数值用ws2812_strip_get_encode_stats读取
+
+#include <stdio.h>
+#include "ws2812.h"
+#include "fake_rmt.h"
+#include "bench_host.h"
+
+#define BENCH_MIN_NS 200000000ULL  // 每种长度至少运行0.2s
+
+static void bench_strip(size_t led_num, bool with_dma) {
+    ws2812_strip_config_t config = {
+        .gpio_num = 0,
+        .led_num = led_num,
+        .with_dma = with_dma,
+    };
+    ws2812_strip_t *strip;
+    ESP_ERROR_CHECK(ws2812_new_strip(&config, &strip));
+    ESP_ERROR_CHECK(ws2812_strip_set_brightness(strip, 128, true));
+
+    rgb_color *colors = calloc(led_num, sizeof(rgb_color));
+    uint64_t frames = 0;
+    uint64_t start = bench_now_ns();
+    uint64_t elapsed;
+    do {
+        for (size_t i = 0; i < led_num; i++) {
+            colors[i] = (rgb_color){ .red = frames + i, .green = frames * 3 + i, .blue = frames * 7 };
+        }
+        ESP_ERROR_CHECK(ws2812_strip_show(strip, colors, led_num));
+        frames++;
+        elapsed = bench_now_ns() - start;
+    } while (elapsed < BENCH_MIN_NS);
+
+    // 每bit一个符号 1.2us, 结尾复位50us
+    double wire_us = led_num * 24 * (T0H + T0L) / 10.0 + RESET_DURATION / 10.0;
+    double frame_us = elapsed / 1000.0 / frames;
+    double encode_fps = 1e6 / frame_us;
+    double wire_fps = 1e6 / wire_us;
+    printf("%5zu LEDs %-4s  encode %9.2f us/frame (%9.0f fps)  wire %8.1f us (%7.1f fps)  -> %7.1f fps, %zu encoder calls\n",
+           led_num, fake_rmt_with_dma(fake_rmt_last_channel()) ? "DMA" : "RMT", frame_us, encode_fps,
+           wire_us, wire_fps, encode_fps < wire_fps ? encode_fps : wire_fps,
+           fake_rmt_encode_calls(fake_rmt_last_channel()));
+
+    free(colors);
+    ESP_ERROR_CHECK(ws2812_del_strip(strip));
+}
+
+int main(void) {
+    fake_rmt_set_capture(false);
+    bench_strip(1, false);
+    bench_strip(60, false);
+    bench_strip(1000, false);
+    bench_strip(1000, true);
+    return 0;
+}
@@ -0,0 +1,208 @@
+// 主机上的FatFs和VFS替身: 卷和diskio的注册, 挂载
+// 挂载与FatFs一样经diskio读取引导扇区并检查BPB, 成功后填写FATFS中被组件用到的字段.
+// 没有文件操作, 也没有f_mkfs: FatFs的源码在IDF的fatfs组件中, 不在本仓库
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ff.h"
+#include "diskio_impl.h"
+#include "esp_vfs_fat.h"
+
+static const ff_diskio_impl_t *s_diskio[FF_VOLUMES];
+static FATFS *s_volume[FF_VOLUMES];
+static bool s_locked[FF_VOLUMES];
+
+static WORD ld_word(const BYTE *p) {
+    return (WORD)(p[0] | (p[1] << 8));
+}
+
+static DWORD ld_dword(const BYTE *p) {
+    return ld_word(p) | ((DWORD)ld_word(p + 2) << 16);
+}
+
+// "N:"形式的路径, 空路径是默认卷0
+static int volume_of(const TCHAR *path) {
+    if (!path || !path[0]) {
+        return 0;
+    }
+    if (path[0] >= '0' && path[0] < '0' + FF_VOLUMES && path[1] == ':') {
+        return path[0] - '0';
+    }
+    return -1;
+}
+
+// 与FatFs的mount_volume()相同的检查, 只支持没有分区表的卷
+static FRESULT mount_volume(int vol) {
+    FATFS *fs = s_volume[vol];
+    const ff_diskio_impl_t *io = s_diskio[vol];
+    if (!fs) {
+        return FR_NOT_ENABLED;
+    }
+    if (!io) {
+        return FR_NOT_READY;
+    }
+    if (fs->fs_type && !(io->status(vol) & STA_NOINIT)) {
+        return FR_OK;
+    }
+    fs->fs_type = 0;
+    if (io->init(vol) & STA_NOINIT) {
+        return FR_NOT_READY;
+    }
+    WORD ss;
+    if (io->ioctl(vol, GET_SECTOR_SIZE, &ss) != RES_OK || ss < 512 || ss > FF_MAX_SS || (ss & (ss - 1))) {
+        return FR_DISK_ERR;
+    }
+    fs->winsect = (LBA_t)-1;
+    if (io->read(vol, fs->win, 0, 1) != RES_OK) {
+        return FR_DISK_ERR;
+    }
+    fs->winsect = 0;
+
+    const BYTE *bs = fs->win;
+    if (ld_word(bs + 510) != 0xAA55 || (bs[0] != 0xEB && bs[0] != 0xE9 && bs[0] != 0xE8)) {
+        return FR_NO_FILESYSTEM;
+    }
+    WORD csize = bs[13];
+    WORD rsv = ld_word(bs + 14);
+    BYTE n_fats = bs[16];
+    WORD n_rootdir = ld_word(bs + 17);
+    DWORD tsect = ld_word(bs + 19) ? ld_word(bs + 19) : ld_dword(bs + 32);
+    DWORD fasize = ld_word(bs + 22) ? ld_word(bs + 22) : ld_dword(bs + 36);
+    if (ld_word(bs + 11) != ss || csize == 0 || (csize & (csize - 1)) || (n_fats != 1 && n_fats != 2) ||
+            rsv == 0 || fasize == 0 || n_rootdir % (ss / 32)) {
+        return FR_NO_FILESYSTEM;
+    }
+    DWORD sysect = rsv + fasize * n_fats + n_rootdir / (ss / 32);
+    if (tsect < sysect || (tsect - sysect) / csize == 0) {
+        return FR_NO_FILESYSTEM;
+    }
+    DWORD nclst = (tsect - sysect) / csize;
+    BYTE fmt = nclst <= 0xFF5 ? FS_FAT12 : (nclst <= 0xFFF5 ? FS_FAT16 : FS_FAT32);
+    if ((fmt == FS_FAT32) != (n_rootdir == 0)) {
+        return FR_NO_FILESYSTEM;
+    }
+
+    fs->ssize = ss;
+    fs->csize = csize;
+    fs->n_fats = n_fats;
+    fs->n_rootdir = n_rootdir;
+    fs->n_fatent = nclst + 2;
+    fs->fsize = fasize;
+    fs->volbase = 0;
+    fs->fatbase = rsv;
+    fs->dirbase = fmt == FS_FAT32 ? ld_dword(bs + 44) : rsv + fasize * n_fats;
+    fs->database = sysect;
+    fs->last_clst = fs->free_clst = 0xFFFFFFFF;
+    fs->wflag = 0;
+    fs->fsi_flag = 0x80;
+    fs->fs_type = fmt;
+    return FR_OK;
+}
+
+FRESULT f_mount(FATFS *fs, const TCHAR *path, BYTE opt) {
+    int vol = volume_of(path);
+    if (vol < 0) {
+        return FR_INVALID_DRIVE;
+    }
+    if (s_volume[vol]) {
+        s_volume[vol]->fs_type = 0;
+    }
+    s_volume[vol] = fs;
+    if (!fs) {
+        return FR_OK;
+    }
+    fs->fs_type = 0;
+    fs->pdrv = (BYTE)vol;
+    return opt == 1 ? mount_volume(vol) : FR_OK;
+}
+
+FRESULT f_mkfs(const TCHAR *path, const MKFS_PARM *opt, void *work, UINT len) {
+    fprintf(stderr, "fake_fatfs: f_mkfs is not available on the host\n");
+    abort();
+}
+
+FRESULT f_opendir(DIR *dp, const TCHAR *path) {
+    int vol = volume_of(path);
+    if (vol < 0) {
+        return FR_INVALID_DRIVE;
+    }
+    FRESULT res = mount_volume(vol);
+    dp->fs = res == FR_OK ? s_volume[vol] : NULL;
+    return res;
+}
+
+FRESULT f_closedir(DIR *dp) {
+    dp->fs = NULL;
+    return FR_OK;
+}
+
+void *ff_memalloc(UINT msize) {
+    return malloc(msize);
+}
+
+void ff_memfree(void *mblock) {
+    free(mblock);
+}
+
+// 单线程中卷锁不会被别人持有, 已被持有说明重复加锁
+int ff_mutex_take(int vol) {
+    if (s_locked[vol]) {
+        fprintf(stderr, "fake_fatfs: volume %d locked twice\n", vol);
+        abort();
+    }
+    s_locked[vol] = true;
+    return 1;
+}
+
+void ff_mutex_give(int vol) {
+    s_locked[vol] = false;
+}
+
+void ff_diskio_register(BYTE pdrv, const ff_diskio_impl_t *discio_impl) {
+    s_diskio[pdrv] = discio_impl;
+}
+
+esp_err_t ff_diskio_get_drive(BYTE *out_pdrv) {
+    for (BYTE i = 0; i < FF_VOLUMES; i++) {
+        if (!s_diskio[i]) {
+            *out_pdrv = i;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+// VFS: 只分配FATFS对象
+static FATFS *s_vfs_fs;
+
+esp_err_t esp_vfs_fat_register(const char *base_path, const char *fat_drive, size_t max_files, FATFS **out_fs) {
+    if (s_vfs_fs) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_vfs_fs = calloc(1, sizeof(FATFS));
+    if (!s_vfs_fs) {
+        return ESP_ERR_NO_MEM;
+    }
+    *out_fs = s_vfs_fs;
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_fat_unregister_path(const char *base_path) {
+    free(s_vfs_fs);
+    s_vfs_fs = NULL;
+    return ESP_OK;
+}
+
+// 与IDF相同: 限制在1到128个扇区之间
+size_t esp_vfs_fat_get_allocation_unit_size(size_t sector_size, size_t requested_size) {
+    size_t alloc_unit_size = requested_size;
+    if (alloc_unit_size < sector_size) {
+        alloc_unit_size = sector_size;
+    }
+    if (alloc_unit_size > sector_size * 128) {
+        alloc_unit_size = sector_size * 128;
+    }
+    return alloc_unit_size;
+}
@@ -0,0 +1,211 @@
+#include <stdlib.h>
+#include <string.h>
+#include "fake_rmt.h"
+
+#define FAKE_RMT_MAX_SYMBOLS (1 << 20)
+
+struct rmt_channel_t {
+    rmt_tx_channel_config_t config;
+    rmt_tx_done_callback_t on_trans_done;
+    void *user_ctx;
+    bool enabled;
+    rmt_symbol_word_t *symbols;  // 最近一次发送的符号
+    size_t num_symbols;
+    size_t encode_calls;
+    rmt_symbol_word_t *block;    // 模拟的通道内存块
+};
+
+struct rmt_encoder_t {
+    rmt_simple_encoder_config_t config;
+};
+
+struct rmt_sync_manager_t {
+    size_t array_size;
+};
+
+static int dma_channels = 1;
+static bool capture = true;
+static rmt_channel_handle_t last_channel = NULL;
+
+rmt_channel_handle_t fake_rmt_last_channel(void) {
+    return last_channel;
+}
+
+const rmt_symbol_word_t *fake_rmt_symbols(rmt_channel_handle_t channel, size_t *num_symbols) {
+    *num_symbols = channel->num_symbols;
+    return channel->symbols;
+}
+
+size_t fake_rmt_encode_calls(rmt_channel_handle_t channel) {
+    return channel->encode_calls;
+}
+
+size_t fake_rmt_mem_block_symbols(rmt_channel_handle_t channel) {
+    return channel->config.mem_block_symbols;
+}
+
+bool fake_rmt_with_dma(rmt_channel_handle_t channel) {
+    return channel->config.flags.with_dma;
+}
+
+void fake_rmt_set_dma_channels(int num) {
+    dma_channels = num;
+}
+
+void fake_rmt_set_capture(bool enable) {
+    capture = enable;
+}
+
+esp_err_t rmt_new_tx_channel(const rmt_tx_channel_config_t *config, rmt_channel_handle_t *ret_chan) {
+    if (!config || !ret_chan || !config->mem_block_symbols || !config->resolution_hz) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (config->flags.with_dma) {
+        if (dma_channels <= 0) {
+            return ESP_ERR_NOT_FOUND;
+        }
+        dma_channels--;
+    }
+    rmt_channel_handle_t channel = calloc(1, sizeof(*channel));
+    if (!channel) {
+        return ESP_ERR_NO_MEM;
+    }
+    channel->config = *config;
+    channel->symbols = malloc(FAKE_RMT_MAX_SYMBOLS * sizeof(rmt_symbol_word_t));
+    channel->block = malloc(config->mem_block_symbols * sizeof(rmt_symbol_word_t));
+    if (!channel->symbols || !channel->block) {
+        free(channel->symbols);
+        free(channel->block);
+        free(channel);
+        return ESP_ERR_NO_MEM;
+    }
+    *ret_chan = channel;
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_channel(rmt_channel_handle_t channel) {
+    if (!channel) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (channel->config.flags.with_dma) {
+        dma_channels++;
+    }
+    if (last_channel == channel) {
+        last_channel = NULL;
+    }
+    free(channel->symbols);
+    free(channel->block);
+    free(channel);
+    return ESP_OK;
+}
+
+esp_err_t rmt_enable(rmt_channel_handle_t channel) {
+    channel->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t rmt_disable(rmt_channel_handle_t channel) {
+    channel->enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t rmt_tx_register_event_callbacks(rmt_channel_handle_t tx_channel, const rmt_tx_event_callbacks_t *cbs,
+                                          void *user_data) {
+    tx_channel->on_trans_done = cbs->on_trans_done;
+    tx_channel->user_ctx = user_data;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_simple_encoder(const rmt_simple_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder) {
+    if (!config || !config->callback || !ret_encoder) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    rmt_encoder_handle_t encoder = calloc(1, sizeof(*encoder));
+    if (!encoder) {
+        return ESP_ERR_NO_MEM;
+    }
+    encoder->config = *config;
+    if (!encoder->config.min_chunk_size) {
+        encoder->config.min_chunk_size = 64;
+    }
+    *ret_encoder = encoder;
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder) {
+    free(encoder);
+    return ESP_OK;
+}
+
+// 与simple encoder相同的调用方式: 剩余空间不足min_chunk_size或回调返回0时, 等硬件取走内存块中的符号再继续
+esp_err_t rmt_transmit(rmt_channel_handle_t tx_channel, rmt_encoder_handle_t encoder, const void *payload,
+                       size_t payload_bytes, const rmt_transmit_config_t *config) {
+    if (!tx_channel || !encoder || !payload || !config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!tx_channel->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const size_t block_size = tx_channel->config.mem_block_symbols;
+    size_t used = 0;
+    size_t written = 0;
+    bool done = false;
+    tx_channel->encode_calls = 0;
+    while (!done) {
+        size_t n = encoder->config.callback(payload, payload_bytes, written, block_size - used,
+                                            tx_channel->block + used, &done, encoder->config.arg);
+        tx_channel->encode_calls++;
+        if (n > block_size - used) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (n == 0 && !done && used == 0) {
+            return ESP_FAIL;  // 整块空间都写不进一个符号
+        }
+        if (capture) {
+            if (written + n > FAKE_RMT_MAX_SYMBOLS) {
+                return ESP_ERR_NO_MEM;
+            }
+            memcpy(tx_channel->symbols + written, tx_channel->block + used, n * sizeof(rmt_symbol_word_t));
+        }
+        written += n;
+        used += n;
+        if (n == 0 || block_size - used < encoder->config.min_chunk_size) {
+            used = 0;
+        }
+    }
+    tx_channel->num_symbols = capture ? written : 0;
+    last_channel = tx_channel;
+
+    if (tx_channel->on_trans_done) {
+        rmt_tx_done_event_data_t edata = { .num_symbols = written };
+        tx_channel->on_trans_done(tx_channel, &edata, tx_channel->user_ctx);
+    }
+    return ESP_OK;
+}
+
+esp_err_t rmt_tx_wait_all_done(rmt_channel_handle_t tx_channel, int timeout_ms) {
+    return tx_channel ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t rmt_new_sync_manager(const rmt_sync_manager_config_t *config, rmt_sync_manager_handle_t *ret_synchro) {
+    if (!config || !config->tx_channel_array || !config->array_size || !ret_synchro) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    rmt_sync_manager_handle_t synchro = calloc(1, sizeof(*synchro));
+    if (!synchro) {
+        return ESP_ERR_NO_MEM;
+    }
+    synchro->array_size = config->array_size;
+    *ret_synchro = synchro;
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_sync_manager(rmt_sync_manager_handle_t synchro) {
+    free(synchro);
+    return ESP_OK;
+}
+
+esp_err_t rmt_sync_reset(rmt_sync_manager_handle_t synchro) {
+    return synchro ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
@@ -0,0 +1,28 @@
+#ifndef __FAKE_RMT_H__
+#define __FAKE_RMT_H__
+
+// 主机上的RMT替身: rmt_transmit同步运行编码器, 输出的符号保存在通道上供测试检查
+// 编码器每次得到的空间不超过通道的mem_block_symbols, 与硬件分块填充一致
+
+#include "driver/rmt_tx.h"
+
+// 最近一次发送所用的通道 (灯带对象不公开通道句柄)
+rmt_channel_handle_t fake_rmt_last_channel(void);
+
+// 通道最近一次发送的符号 包括结尾的复位符号
+const rmt_symbol_word_t *fake_rmt_symbols(rmt_channel_handle_t channel, size_t *num_symbols);
+
+// 通道最近一次发送中编码回调被调用的次数
+size_t fake_rmt_encode_calls(rmt_channel_handle_t channel);
+
+// 通道的内存块大小和是否使用DMA (创建通道时的实际值)
+size_t fake_rmt_mem_block_symbols(rmt_channel_handle_t channel);
+bool fake_rmt_with_dma(rmt_channel_handle_t channel);
+
+// 剩余可用的DMA通道数 默认1 (与ESP32-S3一致)
+void fake_rmt_set_dma_channels(int num);
+
+// 是否保存发送的符号 性能测试时关闭, 只运行编码器
+void fake_rmt_set_capture(bool capture);
+
+#endif // __FAKE_RMT_H__
@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tusb.h"
+#include "device/dcd.h"
+#include "fake_usb.h"
+
+#define EP_MSC_OUT  0x01
+#define EP_MSC_IN   0x81
+#define EP_MSC_SIZE 64
+
+typedef struct {
+    uint8_t *buffer;
+    uint16_t len;
+    bool busy;      // 设备提交了传输, 等主机完成
+    bool stalled;
+} fake_ep_t;
+
+static fake_ep_t s_ep[16][2];
+static uint32_t s_tag;
+static uint32_t s_data_xfers;
+
+static fake_ep_t *ep_get(uint8_t ep_addr) {
+    return &s_ep[tu_edpt_number(ep_addr)][tu_edpt_dir(ep_addr)];
+}
+
+static void fail(const char *what) {
+    fprintf(stderr, "fake_usb: %s\n", what);
+    abort();
+}
+
+//--------------------------------------------------------------------+
+// 描述符: 一个全速MSC接口
+//--------------------------------------------------------------------+
+static const tusb_desc_device_t s_desc_device = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = 0x303A,
+    .idProduct = 0x4002,
+    .bcdDevice = 0x0100,
+    .bNumConfigurations = 1,
+};
+
+static const uint8_t s_desc_config[] = {
+    TUD_CONFIG_DESCRIPTOR(1, 1, 0, TUD_CONFIG_DESC_LEN + TUD_MSC_DESC_LEN, 0x00, 100),
+    TUD_MSC_DESCRIPTOR(0, 0, EP_MSC_OUT, EP_MSC_IN, EP_MSC_SIZE),
+};
+
+uint8_t const *tud_descriptor_device_cb(void) {
+    return (uint8_t const *)&s_desc_device;
+}
+
+uint8_t const *tud_descriptor_configuration_cb(uint8_t index) {
+    return s_desc_config;
+}
+
+uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+    return NULL;
+}
+
+uint32_t tusb_time_millis_api(void) {
+    return 0;
+}
+
+//--------------------------------------------------------------------+
+// 控制器: 传输只登记下来, 由主机完成
+//--------------------------------------------------------------------+
+bool dcd_init(uint8_t rhport, const tusb_rhport_init_t *rh_init) {
+    memset(s_ep, 0, sizeof(s_ep));
+    return true;
+}
+
+bool dcd_deinit(uint8_t rhport) {
+    return true;
+}
+
+void dcd_int_handler(uint8_t rhport) {}
+void dcd_int_enable(uint8_t rhport) {}
+void dcd_int_disable(uint8_t rhport) {}
+void dcd_remote_wakeup(uint8_t rhport) {}
+void dcd_connect(uint8_t rhport) {}
+void dcd_disconnect(uint8_t rhport) {}
+void dcd_sof_enable(uint8_t rhport, bool en) {}
+
+void dcd_set_address(uint8_t rhport, uint8_t dev_addr) {
+    // 状态阶段由控制器自己发送
+    dcd_edpt_xfer(rhport, tu_edpt_addr(0, TUSB_DIR_IN), NULL, 0);
+}
+
+void dcd_edpt0_status_complete(uint8_t rhport, tusb_control_request_t const *request) {}
+
+bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const *desc_ep) {
+    fake_ep_t *ep = ep_get(desc_ep->bEndpointAddress);
+    memset(ep, 0, sizeof(*ep));
+    return true;
+}
+
+void dcd_edpt_close_all(uint8_t rhport) {
+    for (int i = 1; i < 16; i++) {
+        memset(s_ep[i], 0, sizeof(s_ep[i]));
+    }
+}
+
+void dcd_edpt_close(uint8_t rhport, uint8_t ep_addr) {
+    memset(ep_get(ep_addr), 0, sizeof(fake_ep_t));
+}
+
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t total_bytes) {
+    fake_ep_t *ep = ep_get(ep_addr);
+    if (ep->busy) {
+        fail("transfer submitted on a busy endpoint");
+    }
+    ep->buffer = buffer;
+    ep->len = total_bytes;
+    ep->busy = true;
+    return true;
+}
+
+bool dcd_edpt_iso_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t largest_packet_size) {
+    return false;
+}
+
+bool dcd_edpt_iso_activate(uint8_t rhport, tusb_desc_endpoint_t const *desc_ep) {
+    return false;
+}
+
+void dcd_edpt_stall(uint8_t rhport, uint8_t ep_addr) {
+    fake_ep_t *ep = ep_get(ep_addr);
+    ep->busy = false;
+    ep->stalled = true;
+}
+
+void dcd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr) {
+    ep_get(ep_addr)->stalled = false;
+}
+
+//--------------------------------------------------------------------+
+// 主机
+//--------------------------------------------------------------------+
+static void complete(uint8_t ep_addr, uint32_t len) {
+    ep_get(ep_addr)->busy = false;
+    dcd_event_xfer_complete(0, ep_addr, len, XFER_RESULT_SUCCESS, false);
+    tud_task();
+}
+
+// 没有OUT数据的控制传输
+static void control(uint8_t request_type, uint8_t request, uint16_t value, uint16_t index) {
+    const uint8_t setup[8] = {
+        request_type, request, (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)index, (uint8_t)(index >> 8), 0, 0,
+    };
+    dcd_event_setup_received(0, setup, false);
+    tud_task();
+
+    fake_ep_t *ep0_in = ep_get(0x80);
+    fake_ep_t *ep0_out = ep_get(0x00);
+    if (ep0_in->stalled) {
+        fail("control request stalled");
+    }
+    while (ep0_in->busy || ep0_out->busy) {
+        if (ep0_in->busy) {
+            complete(0x80, ep0_in->len);
+        } else {
+            complete(0x00, 0);
+        }
+    }
+}
+
+static void clear_halt(uint8_t ep_addr) {
+    control(TUSB_REQ_RCPT_ENDPOINT, TUSB_REQ_CLEAR_FEATURE, TUSB_REQ_FEATURE_EDPT_HALT, ep_addr);
+    if (ep_get(ep_addr)->stalled) {
+        fail("endpoint still halted, reset recovery required");
+    }
+}
+
+void fake_usb_init(void) {
+    if (!tusb_init()) {
+        fail("tusb_init failed");
+    }
+    dcd_event_bus_reset(0, TUSB_SPEED_FULL, false);
+    tud_task();
+    control(TUSB_REQ_RCPT_DEVICE, TUSB_REQ_SET_CONFIGURATION, 1, 0);
+    if (!tud_mounted() || !ep_get(EP_MSC_OUT)->busy) {
+        fail("MSC interface not configured");
+    }
+}
+
+uint8_t fake_usb_scsi(const uint8_t *cdb, uint8_t cdb_len, bool dir_in, void *data, uint32_t data_len) {
+    fake_ep_t *in = ep_get(EP_MSC_IN);
+    fake_ep_t *out = ep_get(EP_MSC_OUT);
+    if (!out->busy || out->len < sizeof(msc_cbw_t)) {
+        fail("device is not waiting for a CBW");
+    }
+
+    msc_cbw_t cbw = {
+        .signature = MSC_CBW_SIGNATURE,
+        .tag = ++s_tag,
+        .total_bytes = data_len,
+        .dir = dir_in ? TUSB_DIR_IN_MASK : 0,
+        .lun = 0,
+        .cmd_len = cdb_len,
+    };
+    memcpy(cbw.command, cdb, cdb_len);
+    memcpy(out->buffer, &cbw, sizeof(cbw));
+    complete(EP_MSC_OUT, sizeof(cbw));
+
+    // 数据阶段: 传完, 设备发来短包或者STALL时结束
+    uint8_t *p = data;
+    uint32_t done = 0;
+    bool data_stage = data_len > 0;
+    while (data_stage) {
+        fake_ep_t *ep = dir_in ? in : out;
+        if (ep->stalled || (!dir_in && in->busy)) {
+            break;
+        }
+        if (!ep->busy) {
+            fail("data stage stuck, no transfer submitted");
+        }
+        uint32_t n = ep->len < data_len - done ? ep->len : data_len - done;
+        if (dir_in) {
+            memcpy(p + done, ep->buffer, n);
+        } else {
+            memcpy(ep->buffer, p + done, n);
+        }
+        done += n;
+        s_data_xfers++;
+        complete(dir_in ? EP_MSC_IN : EP_MSC_OUT, n);
+        data_stage = done < data_len && n % EP_MSC_SIZE == 0;
+    }
+
+    // 状态阶段
+    if (out->stalled) {
+        clear_halt(EP_MSC_OUT);
+    }
+    if (in->stalled) {
+        clear_halt(EP_MSC_IN);
+    }
+    if (!in->busy || in->len != sizeof(msc_csw_t)) {
+        fail("device did not send a CSW");
+    }
+    msc_csw_t csw;
+    memcpy(&csw, in->buffer, sizeof(csw));
+    complete(EP_MSC_IN, sizeof(csw));
+    if (csw.signature != MSC_CSW_SIGNATURE || csw.tag != cbw.tag) {
+        fail("invalid CSW");
+    }
+    return csw.status;
+}
+
+uint32_t fake_usb_data_xfers(void) {
+    return s_data_xfers;
+}
+
+void fake_usb_reset_counters(void) {
+    s_data_xfers = 0;
+}
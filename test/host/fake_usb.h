@@ -0,0 +1,22 @@
+#ifndef __FAKE_USB_H__
+#define __FAKE_USB_H__
+
+// 主机上的USB设备控制器替身, 加上一个只会BOT协议的主机
+// 全速总线上只有一个MSC接口. 设备栈 (usbd.c, msc_device.c) 与测试在同一线程中运行:
+// 主机每完成一个传输就调用一次tud_task(), 直到设备提交下一个传输
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 初始化设备栈, 总线复位并设置配置 (tud_mount_cb已被调用)
+void fake_usb_init(void);
+
+// 发送一个SCSI命令并完成数据阶段和状态阶段, 失败命令的STALL按BOT规范清除后读取CSW
+// data_len是CBW中主机期望的长度, 返回CSW状态 (MSC_CSW_STATUS_*)
+uint8_t fake_usb_scsi(const uint8_t *cdb, uint8_t cdb_len, bool dir_in, void *data, uint32_t data_len);
+
+// 数据阶段的传输次数, 每次是设备提交的一个多包传输
+uint32_t fake_usb_data_xfers(void);
+void fake_usb_reset_counters(void);
+
+#endif // __FAKE_USB_H__
@@ -0,0 +1,187 @@
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "sdkconfig.h"
+#include "fake_wl.h"
+
+#define FAKE_WL_MAX_HANDLES     2
+#define FAKE_WL_RESERVED_BLOCKS 4   // 两份状态, 配置和空闲块
+
+// 4 KiB擦除和256字节页编程的典型时间 (W25Q/GD25Q系列), 读取按40 MHz QIO估计
+#define FLASH_ERASE_US     45000.0
+#define FLASH_PAGE_US      700.0
+#define FLASH_READ_MB_S    20.0
+
+typedef struct {
+    int fd;                 // -1: 未使用
+    size_t size;            // 可用大小, 不含保留块
+    fake_wl_stats_t stats;
+    uint8_t block[FAKE_WL_BLOCK_SIZE];
+} fake_wl_t;
+
+static fake_wl_t s_wl[FAKE_WL_MAX_HANDLES] = { { .fd = -1 }, { .fd = -1 } };
+
+static fake_wl_t *wl_get(wl_handle_t handle) {
+    if (handle < 0 || handle >= FAKE_WL_MAX_HANDLES || s_wl[handle].fd < 0) {
+        return NULL;
+    }
+    return &s_wl[handle];
+}
+
+static bool io_ok(ssize_t ret, size_t size) {
+    return ret >= 0 && (size_t)ret == size;
+}
+
+esp_err_t fake_wl_open(const char *path, size_t partition_size, wl_handle_t *out_handle) {
+    if (partition_size % FAKE_WL_BLOCK_SIZE || partition_size <= FAKE_WL_RESERVED_BLOCKS * FAKE_WL_BLOCK_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    wl_handle_t handle = 0;
+    while (handle < FAKE_WL_MAX_HANDLES && s_wl[handle].fd >= 0) {
+        handle++;
+    }
+    if (handle == FAKE_WL_MAX_HANDLES) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        return ESP_FAIL;
+    }
+    fake_wl_t *wl = &s_wl[handle];
+    // 新文件或者大小不对的映像按空白闪存处理
+    if ((size_t)st.st_size != partition_size) {
+        memset(wl->block, 0xFF, sizeof(wl->block));
+        for (size_t addr = 0; addr < partition_size; addr += FAKE_WL_BLOCK_SIZE) {
+            if (!io_ok(pwrite(fd, wl->block, FAKE_WL_BLOCK_SIZE, addr), FAKE_WL_BLOCK_SIZE)) {
+                close(fd);
+                return ESP_FAIL;
+            }
+        }
+    }
+    wl->fd = fd;
+    wl->size = partition_size - FAKE_WL_RESERVED_BLOCKS * FAKE_WL_BLOCK_SIZE;
+    memset(&wl->stats, 0, sizeof(wl->stats));
+    *out_handle = handle;
+    return ESP_OK;
+}
+
+void fake_wl_close(wl_handle_t handle) {
+    fake_wl_t *wl = wl_get(handle);
+    if (wl) {
+        close(wl->fd);
+        wl->fd = -1;
+    }
+}
+
+void fake_wl_get_stats(wl_handle_t handle, fake_wl_stats_t *stats) {
+    *stats = wl_get(handle)->stats;
+}
+
+void fake_wl_reset_stats(wl_handle_t handle) {
+    memset(&wl_get(handle)->stats, 0, sizeof(fake_wl_stats_t));
+}
+
+double fake_wl_flash_us(const fake_wl_stats_t *stats) {
+    return stats->erases * FLASH_ERASE_US + (stats->programmed + 255) / 256 * FLASH_PAGE_US +
+           stats->read_bytes / FLASH_READ_MB_S;
+}
+
+size_t wl_size(wl_handle_t handle) {
+    fake_wl_t *wl = wl_get(handle);
+    return wl ? wl->size : 0;
+}
+
+size_t wl_sector_size(wl_handle_t handle) {
+    return wl_get(handle) ? CONFIG_WL_SECTOR_SIZE : 0;
+}
+
+esp_err_t wl_read(wl_handle_t handle, size_t src_addr, void *dest, size_t size) {
+    fake_wl_t *wl = wl_get(handle);
+    if (!wl) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (src_addr > wl->size || size > wl->size - src_addr) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    wl->stats.reads++;
+    wl->stats.read_bytes += size;
+    return io_ok(pread(wl->fd, dest, size, src_addr), size) ? ESP_OK : ESP_FAIL;
+}
+
+// NOR编程: 结果是原内容与数据按位与
+static esp_err_t program(fake_wl_t *wl, size_t addr, const uint8_t *src, size_t size) {
+    while (size > 0) {
+        size_t n = size < sizeof(wl->block) ? size : sizeof(wl->block);
+        if (!io_ok(pread(wl->fd, wl->block, n, addr), n)) {
+            return ESP_FAIL;
+        }
+        bool mismatch = false;
+        for (size_t i = 0; i < n; i++) {
+            wl->block[i] &= src[i];
+            mismatch |= wl->block[i] != src[i];
+        }
+        if (mismatch) {
+            wl->stats.program_errors++;
+        }
+        if (!io_ok(pwrite(wl->fd, wl->block, n, addr), n)) {
+            return ESP_FAIL;
+        }
+        wl->stats.programmed += n;
+        addr += n;
+        src += n;
+        size -= n;
+    }
+    return ESP_OK;
+}
+
+esp_err_t wl_write(wl_handle_t handle, size_t dest_addr, const void *src, size_t size) {
+    fake_wl_t *wl = wl_get(handle);
+    if (!wl) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (dest_addr > wl->size || size > wl->size - dest_addr) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    wl->stats.writes++;
+    return program(wl, dest_addr, src, size);
+}
+
+esp_err_t wl_erase_range(wl_handle_t handle, size_t start_addr, size_t size) {
+    fake_wl_t *wl = wl_get(handle);
+    if (!wl) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (start_addr % CONFIG_WL_SECTOR_SIZE || size % CONFIG_WL_SECTOR_SIZE ||
+            start_addr > wl->size || size > wl->size - start_addr) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    const size_t end = start_addr + size;
+    for (size_t base = start_addr / FAKE_WL_BLOCK_SIZE * FAKE_WL_BLOCK_SIZE; base < end; base += FAKE_WL_BLOCK_SIZE) {
+        size_t first = start_addr > base ? start_addr - base : 0;
+        size_t last = end - base < FAKE_WL_BLOCK_SIZE ? end - base : FAKE_WL_BLOCK_SIZE;
+        uint8_t keep[FAKE_WL_BLOCK_SIZE];
+        bool partial = first > 0 || last < FAKE_WL_BLOCK_SIZE;
+        if (partial && !io_ok(pread(wl->fd, keep, FAKE_WL_BLOCK_SIZE, base), FAKE_WL_BLOCK_SIZE)) {
+            return ESP_FAIL;
+        }
+        memset(wl->block, 0xFF, FAKE_WL_BLOCK_SIZE);
+        if (!io_ok(pwrite(wl->fd, wl->block, FAKE_WL_BLOCK_SIZE, base), FAKE_WL_BLOCK_SIZE)) {
+            return ESP_FAIL;
+        }
+        wl->stats.erases++;
+        // 块中不在范围内的部分写回
+        if (first > 0 && program(wl, base, keep, first) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        if (last < FAKE_WL_BLOCK_SIZE &&
+                program(wl, base + last, keep + last, FAKE_WL_BLOCK_SIZE - last) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
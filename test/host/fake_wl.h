@@ -0,0 +1,33 @@
+#ifndef __FAKE_WL_H__
+#define __FAKE_WL_H__
+
+// 文件上模拟的磨损均衡分区 (wear_levelling.h)
+// 512字节的WL扇区放在4 KiB的NOR擦除块上, 写入只能把1变成0. 不到整块的擦除
+// 先读出整块, 擦除后写回其余部分, 与IDF wear_levelling的性能模式 (WL_Ext_Perf) 相同.
+// 分区末尾留出WL的状态和配置块, 地址重映射不模拟
+
+#include <stdint.h>
+#include "wear_levelling.h"
+
+#define FAKE_WL_BLOCK_SIZE 4096
+
+typedef struct {
+    uint32_t reads;          // wl_read次数
+    uint64_t read_bytes;
+    uint32_t writes;         // wl_write次数
+    uint64_t programmed;     // 写入闪存的字节数, 包括部分擦除时写回的数据
+    uint32_t erases;         // 擦除的4 KiB块数
+    uint32_t program_errors; // 写到未擦除的位上, 闪存中的结果与写入的数据不同
+} fake_wl_stats_t;
+
+// 打开分区映像, 文件不存在时创建并填充0xFF (空白闪存)
+esp_err_t fake_wl_open(const char *path, size_t partition_size, wl_handle_t *out_handle);
+void fake_wl_close(wl_handle_t handle);
+
+void fake_wl_get_stats(wl_handle_t handle, fake_wl_stats_t *stats);
+void fake_wl_reset_stats(wl_handle_t handle);
+
+// 按数据手册典型值估计这些操作在目标闪存上的耗时 (微秒)
+double fake_wl_flash_us(const fake_wl_stats_t *stats);
+
+#endif // __FAKE_WL_H__
@@ -0,0 +1,80 @@
+// 配置解析的模糊测试目标
+//
+// 同一输入分别整块、逐字节和按输入决定的块大小送入解析器, 三次结果必须完全相同;
+// 解析后的配置必须满足schema的约束 (计数不越界, 字符串有结尾0, 整数在范围内)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "app_config.h"
+#include "fuzz_host.h"
+
+#define FUZZ_CHECK(cond) do {                                                       \
+        if (!(cond)) {                                                              \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);\
+            abort();                                                                \
+        }                                                                           \
+    } while (0)
+
+typedef struct {
+    app_config_t config;
+    cfg_parser_t parser;
+} fuzz_result_t;
+
+static void parse_chunked(const uint8_t *data, size_t size, size_t chunk, fuzz_result_t *out) {
+    memset(out, 0, sizeof(*out));
+    cfg_parser_init(&out->parser, &app_config_schema, &out->config);
+    for (size_t pos = 0; pos < size; pos += chunk) {
+        size_t n = size - pos < chunk ? size - pos : chunk;
+        cfg_parser_feed(&out->parser, (const char *)data + pos, n);
+    }
+    cfg_parser_finish(&out->parser);
+}
+
+static bool str_terminated(const char *s, size_t size) {
+    return memchr(s, '\0', size) != NULL;
+}
+
+static void check_config(const app_config_t *c) {
+    FUZZ_CHECK(c->wifi_count <= APP_CONFIG_MAX_WIFI);
+    for (int i = 0; i < c->wifi_count; i++) {
+        FUZZ_CHECK(str_terminated(c->wifi[i].ssid, sizeof(c->wifi[i].ssid)));
+        FUZZ_CHECK(str_terminated(c->wifi[i].password, sizeof(c->wifi[i].password)));
+        FUZZ_CHECK(c->wifi[i].ssid[0]);
+    }
+    FUZZ_CHECK(c->ntp_count >= 1 && c->ntp_count <= APP_CONFIG_MAX_NTP);
+    for (int i = 0; i < c->ntp_count; i++) {
+        FUZZ_CHECK(str_terminated(c->ntp_server[i], APP_CONFIG_HOST_LEN));
+    }
+    FUZZ_CHECK(str_terminated(c->timezone, sizeof(c->timezone)));
+    FUZZ_CHECK(c->led_frame_ms >= 5 && c->led_frame_ms <= 1000);
+}
+
+static void check_same(const fuzz_result_t *a, const fuzz_result_t *b) {
+    FUZZ_CHECK(memcmp(&a->config, &b->config, sizeof(a->config)) == 0);
+    FUZZ_CHECK(a->parser.values == b->parser.values);
+    FUZZ_CHECK(a->parser.errors == b->parser.errors);
+    FUZZ_CHECK(a->parser.unknown == b->parser.unknown);
+    FUZZ_CHECK(a->parser.error_line == b->parser.error_line);
+    FUZZ_CHECK(strcmp(a->parser.error, b->parser.error) == 0);
+    FUZZ_CHECK(a->parser.line_no == b->parser.line_no);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static fuzz_result_t whole, bytes, chunks;
+
+    parse_chunked(data, size, size ? size : 1, &whole);
+    parse_chunked(data, size, 1, &bytes);
+    parse_chunked(data, size, size ? 1 + data[0] % 200 : 1, &chunks);
+    check_same(&whole, &bytes);
+    check_same(&whole, &chunks);
+
+    // 与app_config_parse的结果一致, 并满足schema约束
+    static app_config_t config;
+    static cfg_parser_t parser;
+    memset(&config, 0, sizeof(config));
+    app_config_parse((const char *)data, size, &config, &parser);
+    FUZZ_CHECK(parser.values == whole.parser.values && parser.errors == whole.parser.errors);
+    check_config(&config);
+    return 0;
+}
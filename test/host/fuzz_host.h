@@ -0,0 +1,11 @@
+#ifndef __FUZZ_HOST_H__
+#define __FUZZ_HOST_H__
+
+// 模糊测试目标的入口 与libFuzzer相同, 可由fuzz_main.c或clang -fsanitize=fuzzer驱动
+
+#include <stddef.h>
+#include <stdint.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+#endif // __FUZZ_HOST_H__
@@ -0,0 +1,224 @@
+// 没有libFuzzer时的模糊测试驱动 (gcc可用)
+//
+//   fuzz_xxx [-n runs] [-s seed] [-m max_len] <语料目录或文件>...
+//
+// 先运行每个语料, 再以语料为种子做runs次随机变异 (改写/插入/删除/复制/拼接字节).
+// 种子固定时结果可复现; 目标中止时 (断言失败或sanitizer报错) 当前输入写入crash-<序号>,
+// 可以直接作为参数重放
+
+#include <dirent.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "fuzz_host.h"
+
+// sanitizer报错时不经过abort, 通过death callback保存输入
+#if defined(__SANITIZE_ADDRESS__)
+#define FUZZ_HAVE_SANITIZER 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define FUZZ_HAVE_SANITIZER 1
+#endif
+#endif
+#ifdef FUZZ_HAVE_SANITIZER
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+#define FUZZ_MAX_SEEDS 256
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+} fuzz_input_t;
+
+static fuzz_input_t seeds[FUZZ_MAX_SEEDS];
+static int seed_num = 0;
+static uint64_t rng_state;
+
+static uint32_t rng(void) {
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 2685821657736338717ULL) >> 32);
+}
+
+static void add_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f || seed_num >= FUZZ_MAX_SEEDS) {
+        if (f) {
+            fclose(f);
+        }
+        return;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(size ? size : 1);
+    if (fread(data, 1, size, f) != (size_t)size) {
+        free(data);
+        fclose(f);
+        return;
+    }
+    fclose(f);
+    seeds[seed_num++] = (fuzz_input_t){data, (size_t)size};
+}
+
+static void add_path(const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "cannot access %s\n", path);
+        exit(2);
+    }
+    if (S_ISREG(st.st_mode)) {
+        add_file(path);
+        return;
+    }
+    DIR *dir = opendir(path);
+    struct dirent *ent;
+    while (dir && (ent = readdir(dir)) != NULL) {
+        char file[1024];
+        snprintf(file, sizeof(file), "%s/%s", path, ent->d_name);
+        if (stat(file, &st) == 0 && S_ISREG(st.st_mode)) {
+            add_file(file);
+        }
+    }
+    if (dir) {
+        closedir(dir);
+    }
+}
+
+// 变异得到的输入写入buf, 返回长度
+static size_t mutate(uint8_t *buf, size_t max_len) {
+    const fuzz_input_t *base = &seeds[rng() % seed_num];
+    size_t len = base->size < max_len ? base->size : max_len;
+    memcpy(buf, base->data, len);
+
+    int rounds = 1 + rng() % 8;
+    for (int r = 0; r < rounds; r++) {
+        size_t pos = len ? rng() % len : 0;
+        switch (rng() % 6) {
+        case 0:  // 改写一个字节
+            if (len) {
+                buf[pos] = rng();
+            }
+            break;
+        case 1:  // 插入一个常见的分隔符
+            if (len < max_len) {
+                static const char special[] = "\n\r\0=:[]#;\"' \t";
+                memmove(buf + pos + 1, buf + pos, len - pos);
+                buf[pos] = special[rng() % (sizeof(special) - 1)];
+                len++;
+            }
+            break;
+        case 2: {  // 删除一段
+            size_t n = len ? rng() % (len - pos + 1) % 32 : 0;
+            memmove(buf + pos, buf + pos + n, len - pos - n);
+            len -= n;
+            break;
+        }
+        case 3: {  // 重复一段 (产生超长行和重复的节)
+            size_t n = len ? rng() % (len - pos + 1) : 0;
+            if (n > max_len - len) {
+                n = max_len - len;
+            }
+            memmove(buf + pos + n, buf + pos, len - pos);
+            len += n;
+            break;
+        }
+        case 4: {  // 拼接另一个种子的一部分
+            const fuzz_input_t *other = &seeds[rng() % seed_num];
+            size_t from = other->size ? rng() % other->size : 0;
+            size_t n = other->size - from;
+            if (n > max_len - len) {
+                n = max_len - len;
+            }
+            memmove(buf + pos + n, buf + pos, len - pos);
+            memcpy(buf + pos, other->data + from, n);
+            len += n;
+            break;
+        }
+        default:  // 截断
+            len = pos;
+            break;
+        }
+    }
+    return len;
+}
+
+// 正在运行的输入 目标中止时保存
+static const uint8_t *current_data;
+static size_t current_size;
+static unsigned long current_run;
+
+static void save_crash(void) {
+    if (!current_data) {
+        return;
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "crash-%lu", current_run);
+    FILE *f = fopen(name, "wb");
+    if (f) {
+        fwrite(current_data, 1, current_size, f);
+        fclose(f);
+        fprintf(stderr, "input written to %s\n", name);
+    }
+    current_data = NULL;
+}
+
+static void on_abort(int sig) {
+    save_crash();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static void run_one(const uint8_t *data, size_t size, unsigned long run) {
+    current_data = data;
+    current_size = size;
+    current_run = run;
+    LLVMFuzzerTestOneInput(data, size);
+    current_data = NULL;
+}
+
+int main(int argc, char **argv) {
+    unsigned long runs = 10000;
+    uint64_t seed = 1;
+    size_t max_len = 4096;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:m:")) != -1) {
+        switch (opt) {
+        case 'n': runs = strtoul(optarg, NULL, 0); break;
+        case 's': seed = strtoull(optarg, NULL, 0); break;
+        case 'm': max_len = strtoul(optarg, NULL, 0); break;
+        default:
+            fprintf(stderr, "usage: %s [-n runs] [-s seed] [-m max_len] <corpus>...\n", argv[0]);
+            return 2;
+        }
+    }
+    for (int i = optind; i < argc; i++) {
+        add_path(argv[i]);
+    }
+    if (!seed_num) {
+        seeds[seed_num++] = (fuzz_input_t){(uint8_t *)"", 0};
+    }
+    rng_state = seed ? seed : 1;
+    signal(SIGABRT, on_abort);
+#ifdef FUZZ_HAVE_SANITIZER
+    __sanitizer_set_death_callback(save_crash);
+#endif
+
+    for (int i = 0; i < seed_num; i++) {
+        run_one(seeds[i].data, seeds[i].size, i);
+    }
+
+    uint8_t *buf = malloc(max_len);
+    for (unsigned long run = 0; run < runs; run++) {
+        run_one(buf, mutate(buf, max_len), seed_num + run);
+    }
+    printf("%d seeds, %lu mutated inputs, seed %llu: ok\n", seed_num, runs, (unsigned long long)seed);
+    free(buf);
+    return 0;
+}
@@ -0,0 +1,21 @@
+#ifndef __OLED_REF_H__
+#define __OLED_REF_H__
+
+// 按像素写入的OLED_SetBlock, 即oled.c中注释掉的实现 (加上反色模式), 作为字模解码的参照
+// 数据按列行式排列, 每字节是一列中的8个像素, 低位在上
+
+#include "oled.h"
+
+static inline void oled_ref_set_block(uint8_t x, uint8_t y, const uint8_t *data, uint8_t w, uint8_t h,
+                                      OLED_ColorMode color) {
+    for (uint8_t i = 0; i < w; i++) {
+        for (uint8_t j = 0; j < (h + 7) / 8; j++) {
+            for (uint8_t k = 0; k < 8 && j * 8 + k < h; k++) {
+                bool on = (data[i + j * w] >> k) & 0x01;
+                OLED_SetPixel(x + i, y + j * 8 + k, on ? color : !color);
+            }
+        }
+    }
+}
+
+#endif // __OLED_REF_H__
@@ -0,0 +1,21 @@
+#ifndef __HOST_DISKIO_IMPL_H__
+#define __HOST_DISKIO_IMPL_H__
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "ff.h"
+
+typedef struct {
+    DSTATUS (*init)(unsigned char pdrv);
+    DSTATUS (*status)(unsigned char pdrv);
+    DRESULT (*read)(unsigned char pdrv, unsigned char *buff, uint32_t sector, unsigned count);
+    DRESULT (*write)(unsigned char pdrv, const unsigned char *buff, uint32_t sector, unsigned count);
+    DRESULT (*ioctl)(unsigned char pdrv, unsigned char cmd, void *buff);
+} ff_diskio_impl_t;
+
+void ff_diskio_register(BYTE pdrv, const ff_diskio_impl_t *discio_impl);
+esp_err_t ff_diskio_get_drive(BYTE *out_pdrv);
+
+#define ff_diskio_unregister(pdrv_) ff_diskio_register(pdrv_, NULL)
+
+#endif // __HOST_DISKIO_IMPL_H__
@@ -0,0 +1,6 @@
+#ifndef __HOST_DISKIO_WL_H__
+#define __HOST_DISKIO_WL_H__
+
+#include "wear_levelling.h"
+
+#endif // __HOST_DISKIO_WL_H__
@@ -0,0 +1,6 @@
+#ifndef __HOST_DRIVER_GPIO_H__
+#define __HOST_DRIVER_GPIO_H__
+
+typedef int gpio_num_t;
+
+#endif // __HOST_DRIVER_GPIO_H__
@@ -0,0 +1,35 @@
+#ifndef __HOST_DRIVER_RMT_ENCODER_H__
+#define __HOST_DRIVER_RMT_ENCODER_H__
+
+// 主机测试用的RMT编码器接口 只支持simple encoder, 实现在fake_rmt.c
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef union {
+    struct {
+        uint16_t duration0 : 15;
+        uint16_t level0 : 1;
+        uint16_t duration1 : 15;
+        uint16_t level1 : 1;
+    };
+    uint32_t val;
+} rmt_symbol_word_t;
+
+typedef struct rmt_encoder_t *rmt_encoder_handle_t;
+
+typedef size_t (*rmt_encode_simple_cb_t)(const void *data, size_t data_size, size_t symbols_written,
+                                         size_t symbols_free, rmt_symbol_word_t *symbols, bool *done, void *arg);
+
+typedef struct {
+    rmt_encode_simple_cb_t callback;
+    void *arg;
+    size_t min_chunk_size;
+} rmt_simple_encoder_config_t;
+
+esp_err_t rmt_new_simple_encoder(const rmt_simple_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder);
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder);
+
+#endif // __HOST_DRIVER_RMT_ENCODER_H__
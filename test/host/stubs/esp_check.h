@@ -0,0 +1,32 @@
+#ifndef __HOST_ESP_CHECK_H__
+#define __HOST_ESP_CHECK_H__
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#define ESP_RETURN_ON_ERROR(x, tag, fmt, ...) do {                                  \
+        esp_err_t err_rc_ = (x);                                                    \
+        if (err_rc_ != ESP_OK) {                                                    \
+            ESP_LOGE(tag, fmt, ##__VA_ARGS__);                                      \
+            return err_rc_;                                                         \
+        }                                                                           \
+    } while (0)
+
+#define ESP_RETURN_ON_FALSE(a, err_code, tag, fmt, ...) do {                        \
+        if (!(a)) {                                                                 \
+            ESP_LOGE(tag, fmt, ##__VA_ARGS__);                                      \
+            return err_code;                                                        \
+        }                                                                           \
+    } while (0)
+
+// 与IDF相同 使用调用处的ret变量
+#define ESP_GOTO_ON_ERROR(x, goto_tag, tag, fmt, ...) do {                          \
+        esp_err_t err_rc_ = (x);                                                    \
+        if (err_rc_ != ESP_OK) {                                                    \
+            ESP_LOGE(tag, fmt, ##__VA_ARGS__);                                      \
+            ret = err_rc_;                                                          \
+            goto goto_tag;                                                          \
+        }                                                                           \
+    } while (0)
+
+#endif // __HOST_ESP_CHECK_H__
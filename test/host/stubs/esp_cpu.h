@@ -0,0 +1,15 @@
+#ifndef __HOST_ESP_CPU_H__
+#define __HOST_ESP_CPU_H__
+
+// 主机上没有CPU周期计数器可用 以纳秒代替, 编码统计的单位随之变为ns
+
+#include <stdint.h>
+#include <time.h>
+
+static inline uint32_t esp_cpu_get_cycle_count(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+#endif // __HOST_ESP_CPU_H__
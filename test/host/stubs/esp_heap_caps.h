@@ -0,0 +1,23 @@
+#ifndef __HOST_ESP_HEAP_CAPS_H__
+#define __HOST_ESP_HEAP_CAPS_H__
+
+// 主机上所有内存都用malloc分配, 能力标志被忽略
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_DEFAULT  (1 << 12)
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+static inline void *heap_caps_malloc(size_t size, uint32_t caps) { (void)caps; return malloc(size); }
+static inline void *heap_caps_calloc(size_t n, size_t size, uint32_t caps) { (void)caps; return calloc(n, size); }
+static inline void heap_caps_free(void *ptr) { free(ptr); }
+
+static inline void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps) {
+    (void)caps;
+    void *ptr = NULL;
+    return posix_memalign(&ptr, alignment < sizeof(void *) ? sizeof(void *) : alignment, size) == 0 ? ptr : NULL;
+}
+
+#endif // __HOST_ESP_HEAP_CAPS_H__
@@ -0,0 +1,39 @@
+#ifndef __HOST_ESP_LOG_H__
+#define __HOST_ESP_LOG_H__
+
+// 主机测试用的esp_log.h 错误和警告输出到stderr, 其余丢弃
+// esp_log_level_set只有全局级别, 性能测试用它关掉预期中的警告
+
+#include <stdio.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+__attribute__((weak)) esp_log_level_t host_log_level = ESP_LOG_WARN;
+
+static inline void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    (void)tag;
+    host_log_level = level;
+}
+
+#define ESP_LOGE(tag, fmt, ...) do {                                                \
+        if (host_log_level >= ESP_LOG_ERROR) {                                      \
+            fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__);                 \
+        }                                                                           \
+    } while (0)
+#define ESP_LOGW(tag, fmt, ...) do {                                                \
+        if (host_log_level >= ESP_LOG_WARN) {                                       \
+            fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__);                 \
+        }                                                                           \
+    } while (0)
+#define ESP_LOGI(tag, fmt, ...) do { (void)(tag); } while (0)
+#define ESP_LOGD(tag, fmt, ...) do { (void)(tag); } while (0)
+#define ESP_LOGV(tag, fmt, ...) do { (void)(tag); } while (0)
+
+#endif // __HOST_ESP_LOG_H__
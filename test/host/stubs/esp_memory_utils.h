@@ -0,0 +1,9 @@
+#ifndef __HOST_ESP_MEMORY_UTILS_H__
+#define __HOST_ESP_MEMORY_UTILS_H__
+
+#include <stdbool.h>
+#include "esp_heap_caps.h"
+
+static inline bool esp_ptr_dma_capable(const void *p) { (void)p; return true; }
+
+#endif // __HOST_ESP_MEMORY_UTILS_H__
@@ -0,0 +1,6 @@
+#ifndef __HOST_ESP_PARTITION_H__
+#define __HOST_ESP_PARTITION_H__
+
+// 分区由fake_wl.c中的文件代替, 这里不需要任何声明
+
+#endif // __HOST_ESP_PARTITION_H__
@@ -0,0 +1,9 @@
+#ifndef __HOST_ESP_RANDOM_H__
+#define __HOST_ESP_RANDOM_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+
+static inline uint32_t esp_random(void) { return ((uint32_t)rand() << 16) ^ (uint32_t)rand(); }
+
+#endif // __HOST_ESP_RANDOM_H__
@@ -0,0 +1,10 @@
+#ifndef __HOST_ESP_TIMER_H__
+#define __HOST_ESP_TIMER_H__
+
+// 由测试程序提供 可以是真实时钟也可以是手动推进的假时钟
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
+
+#endif // __HOST_ESP_TIMER_H__
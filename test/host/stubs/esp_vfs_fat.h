@@ -0,0 +1,24 @@
+#ifndef __HOST_ESP_VFS_FAT_H__
+#define __HOST_ESP_VFS_FAT_H__
+
+// 主机上没有VFS, 注册只分配FATFS对象 (fake_fatfs.c)
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "ff.h"
+#include "wear_levelling.h"
+
+typedef struct {
+    bool format_if_mount_failed;
+    int max_files;
+    size_t allocation_unit_size;
+    bool disk_status_check_enable;
+    bool use_one_fat;
+} esp_vfs_fat_mount_config_t;
+
+esp_err_t esp_vfs_fat_register(const char *base_path, const char *fat_drive, size_t max_files, FATFS **out_fs);
+esp_err_t esp_vfs_fat_unregister_path(const char *base_path);
+size_t esp_vfs_fat_get_allocation_unit_size(size_t sector_size, size_t requested_size);
+
+#endif // __HOST_ESP_VFS_FAT_H__
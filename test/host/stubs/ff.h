@@ -0,0 +1,120 @@
+#ifndef __HOST_FF_H__
+#define __HOST_FF_H__
+
+// 主机测试用的FatFs接口 (R0.15的子集), 实现在fake_fatfs.c
+// FatFs源码在IDF的fatfs组件中, 不在本仓库, 替身只做挂载时对引导扇区的检查
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint8_t  BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef unsigned int UINT;
+typedef DWORD    LBA_t;
+typedef char     TCHAR;
+
+#define FF_VOLUMES  2
+#define FF_MAX_SS   4096
+#define FF_USE_TRIM 1
+
+typedef enum {
+    FR_OK = 0,
+    FR_DISK_ERR,
+    FR_INT_ERR,
+    FR_NOT_READY,
+    FR_NO_FILE,
+    FR_NO_PATH,
+    FR_INVALID_NAME,
+    FR_DENIED,
+    FR_EXIST,
+    FR_INVALID_OBJECT,
+    FR_WRITE_PROTECTED,
+    FR_INVALID_DRIVE,
+    FR_NOT_ENABLED,
+    FR_NO_FILESYSTEM,
+    FR_MKFS_ABORTED,
+    FR_TIMEOUT,
+    FR_LOCKED,
+    FR_NOT_ENOUGH_CORE,
+    FR_TOO_MANY_OPEN_FILES,
+    FR_INVALID_PARAMETER,
+} FRESULT;
+
+// diskio
+typedef BYTE DSTATUS;
+
+typedef enum {
+    RES_OK = 0,
+    RES_ERROR,
+    RES_WRPRT,
+    RES_NOTRDY,
+    RES_PARERR,
+} DRESULT;
+
+#define STA_NOINIT  0x01
+#define STA_NODISK  0x02
+#define STA_PROTECT 0x04
+
+#define CTRL_SYNC        0
+#define GET_SECTOR_COUNT 1
+#define GET_SECTOR_SIZE  2
+#define GET_BLOCK_SIZE   3
+#define CTRL_TRIM        4
+
+// f_mkfs
+#define FM_FAT   0x01
+#define FM_FAT32 0x02
+#define FM_EXFAT 0x04
+#define FM_ANY   0x07
+#define FM_SFD   0x08
+
+#define FS_FAT12 1
+#define FS_FAT16 2
+#define FS_FAT32 3
+#define FS_EXFAT 4
+
+typedef struct {
+    BYTE fmt;
+    BYTE n_fat;
+    UINT align;
+    UINT n_root;
+    DWORD au_size;
+} MKFS_PARM;
+
+typedef struct {
+    BYTE fs_type;       // 0: 未挂载
+    BYTE pdrv;
+    BYTE n_fats;
+    BYTE wflag;
+    BYTE fsi_flag;
+    WORD n_rootdir;
+    WORD csize;
+    WORD ssize;
+    DWORD last_clst;
+    DWORD free_clst;
+    DWORD n_fatent;
+    DWORD fsize;
+    LBA_t volbase;
+    LBA_t fatbase;
+    LBA_t dirbase;
+    LBA_t database;
+    LBA_t winsect;
+    BYTE win[FF_MAX_SS];
+} FATFS;
+
+typedef struct {
+    FATFS *fs;
+} DIR;
+
+FRESULT f_mount(FATFS *fs, const TCHAR *path, BYTE opt);
+FRESULT f_mkfs(const TCHAR *path, const MKFS_PARM *opt, void *work, UINT len);
+FRESULT f_opendir(DIR *dp, const TCHAR *path);
+FRESULT f_closedir(DIR *dp);
+
+void *ff_memalloc(UINT msize);
+void ff_memfree(void *mblock);
+int ff_mutex_take(int vol);
+void ff_mutex_give(int vol);
+
+#endif // __HOST_FF_H__
@@ -0,0 +1,48 @@
+#ifndef __HOST_FREERTOS_H__
+#define __HOST_FREERTOS_H__
+
+// 主机测试用的FreeRTOS 单线程运行, 只提供组件用到的类型和宏
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdFALSE             0
+#define pdTRUE              1
+#define pdPASS              pdTRUE
+#define pdFAIL              pdFALSE
+#define portMAX_DELAY       ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ  1000
+#define pdMS_TO_TICKS(ms)   ((TickType_t)((uint64_t)(ms) * configTICK_RATE_HZ / 1000))
+
+// 临界区 单线程下没有竞争, 仍做一次原子操作, 让性能测试中的开销接近目标上的自旋锁
+// 嵌套进入时中止, 用来发现加锁错误
+typedef struct {
+    atomic_flag owner;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { ATOMIC_FLAG_INIT }
+
+static inline void host_critical_enter(portMUX_TYPE *mux) {
+    if (atomic_flag_test_and_set_explicit(&mux->owner, memory_order_acquire)) {
+        abort();
+    }
+}
+
+static inline void host_critical_exit(portMUX_TYPE *mux) {
+    atomic_flag_clear_explicit(&mux->owner, memory_order_release);
+}
+
+#define portENTER_CRITICAL(mux)      host_critical_enter(mux)
+#define portEXIT_CRITICAL(mux)       host_critical_exit(mux)
+#define portENTER_CRITICAL_SAFE(mux) host_critical_enter(mux)
+#define portEXIT_CRITICAL_SAFE(mux)  host_critical_exit(mux)
+
+#endif // __HOST_FREERTOS_H__
@@ -0,0 +1,55 @@
+#ifndef __HOST_FREERTOS_SEMPHR_H__
+#define __HOST_FREERTOS_SEMPHR_H__
+
+// 单线程下的互斥量 重复获取或释放未持有的锁时中止, 用来发现加锁错误
+
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+
+typedef struct {
+    bool taken;
+    bool binary;    // 二值信号量: 创建时为空, 释放已可用的信号量不算错误
+} host_semaphore_t;
+
+typedef host_semaphore_t *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return calloc(1, sizeof(host_semaphore_t));
+}
+
+static inline SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    SemaphoreHandle_t sem = calloc(1, sizeof(host_semaphore_t));
+    if (sem) {
+        sem->taken = true;
+        sem->binary = true;
+    }
+    return sem;
+}
+
+static inline void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    free(sem);
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    if (sem->taken) {
+        if (ticks == portMAX_DELAY) {
+            abort();  // 单线程中永远等不到
+        }
+        return pdFALSE;
+    }
+    sem->taken = true;
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    if (!sem->taken) {
+        if (sem->binary) {
+            return pdFALSE;
+        }
+        abort();
+    }
+    sem->taken = false;
+    return pdTRUE;
+}
+
+#endif // __HOST_FREERTOS_SEMPHR_H__
@@ -0,0 +1,49 @@
+#ifndef __HOST_FREERTOS_TASK_H__
+#define __HOST_FREERTOS_TASK_H__
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+typedef enum {
+    eNoAction = 0,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite,
+} eNotifyAction;
+
+// 单线程测试中任务函数不会被运行, 延时立即返回
+static inline BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *param,
+                                     UBaseType_t priority, TaskHandle_t *handle) {
+    (void)fn; (void)name; (void)stack; (void)param; (void)priority;
+    static char dummy_task;
+    if (handle) {
+        *handle = &dummy_task;
+    }
+    return pdPASS;
+}
+
+static inline void vTaskDelete(TaskHandle_t task) {
+    if (!task) {
+        abort();  // 只有任务函数自己会删除自己, 而它们不会运行
+    }
+}
+
+// 通知不会被接收, 任务函数不运行
+static inline BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    (void)task; (void)value; (void)action;
+    return pdPASS;
+}
+
+static inline BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value,
+                                         TickType_t ticks) {
+    abort();
+}
+
+static inline TickType_t xTaskGetTickCount(void) { return 0; }
+static inline void vTaskDelay(TickType_t ticks) { (void)ticks; }
+static inline void vTaskDelayUntil(TickType_t *last, TickType_t period) { *last += period; }
+
+#endif // __HOST_FREERTOS_TASK_H__
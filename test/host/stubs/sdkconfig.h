@@ -0,0 +1,26 @@
+#ifndef __HOST_SDKCONFIG_H__
+#define __HOST_SDKCONFIG_H__
+
+// 主机测试用的sdkconfig.h 取项目sdkconfig中用到的值, 可以在编译时用-D覆盖
+
+#define CONFIG_TINYUSB_MSC_ENABLED          1
+#define CONFIG_TINYUSB_MSC_MOUNT_PATH       "/data"
+#define CONFIG_TINYUSB_TASK_QUEUE_SIZE      32
+#define CONFIG_TINYUSB_TASK_FUNC_QUEUE_SIZE 16
+#define CONFIG_TINYUSB_EVENT_STATS          1
+#define CONFIG_TINYUSB_FAT_FORMAT_ANY       1
+#define CONFIG_WL_SECTOR_SIZE               512
+
+#ifndef CONFIG_TINYUSB_MSC_BUFSIZE
+#define CONFIG_TINYUSB_MSC_BUFSIZE          8192
+#endif
+
+#ifndef CONFIG_TINYUSB_MSC_STATS
+#define CONFIG_TINYUSB_MSC_STATS            1
+#endif
+
+#ifndef CONFIG_TINYUSB_FAT_FAST_FORMAT
+#define CONFIG_TINYUSB_FAT_FAST_FORMAT      1
+#endif
+
+#endif // __HOST_SDKCONFIG_H__
@@ -0,0 +1,6 @@
+#ifndef __HOST_SPI_FLASH_MMAP_H__
+#define __HOST_SPI_FLASH_MMAP_H__
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+#endif // __HOST_SPI_FLASH_MMAP_H__
@@ -0,0 +1,6 @@
+#ifndef __HOST_VFS_FAT_INTERNAL_H__
+#define __HOST_VFS_FAT_INTERNAL_H__
+
+#include "esp_vfs_fat.h"
+
+#endif // __HOST_VFS_FAT_INTERNAL_H__
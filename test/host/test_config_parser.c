@@ -0,0 +1,203 @@
+// 配置解析测试: 用app_config的schema解析内存中的config.txt, 检查已知的结果
+// 旧格式的Wi-Fi放在最前面, 可重复的[wifi]节和[ntp]的服务器数组按上限截断, 整数越界被拒绝,
+// app_config_diff按设置项分组报告变化
+
+#include <stdio.h>
+#include <string.h>
+#include "app_config.h"
+#include "test_host.h"
+
+static void parse(const char *text, app_config_t *config, cfg_parser_t *parser) {
+    memset(config, 0xA5, sizeof(*config));  // 没有写到的字段不会恰好是期望值
+    app_config_parse(text, strlen(text), config, parser);
+}
+
+static void test_defaults(void) {
+    app_config_t config;
+    cfg_parser_t parser;
+    parse("", &config, &parser);
+    TEST_ASSERT_EQ(0, parser.errors);
+    TEST_ASSERT_EQ(0, config.wifi_count);
+    TEST_ASSERT_EQ(1, config.ntp_count);
+    TEST_ASSERT_STR_EQ("pool.ntp.org", config.ntp_server[0]);
+    TEST_ASSERT_STR_EQ("CST-8", config.timezone);
+    TEST_ASSERT_EQ(255, config.led_brightness);
+    TEST_ASSERT_EQ(false, config.led_gamma);
+    TEST_ASSERT_EQ(20, config.led_frame_ms);
+    TEST_ASSERT_EQ(0xDF, config.display_contrast);
+    TEST_ASSERT_EQ(false, config.display_flip);
+}
+
+// 旧格式 "wifi ssid:" "wifi passport:" 不在节中, 作为第一个网络排在所有[wifi]节之前
+static void test_legacy_wifi_first(void) {
+    app_config_t config;
+    cfg_parser_t parser;
+    parse("wifi ssid: home\n"
+          "wifi passport: secret\n"
+          "[wifi]\n"
+          "ssid = office\n"
+          "password = \"pass word\"\n",
+          &config, &parser);
+    TEST_ASSERT_EQ(0, parser.errors);
+    TEST_ASSERT_EQ(2, config.wifi_count);
+    TEST_ASSERT_STR_EQ("home", config.wifi[0].ssid);
+    TEST_ASSERT_STR_EQ("secret", config.wifi[0].password);
+    TEST_ASSERT_STR_EQ("office", config.wifi[1].ssid);
+    TEST_ASSERT_STR_EQ("pass word", config.wifi[1].password);
+
+    // 节中的同名键不是旧格式
+    parse("[wifi]\nssid = a\nwifi ssid: b\n", &config, &parser);
+    TEST_ASSERT_EQ(1, config.wifi_count);
+    TEST_ASSERT_STR_EQ("a", config.wifi[0].ssid);
+    TEST_ASSERT_EQ(1, parser.unknown);
+
+    // 节已满时旧格式的网络仍排第一, 挤掉最后一个节
+    parse("wifi ssid: legacy\n"
+          "[wifi]\nssid = w1\n[wifi]\nssid = w2\n[wifi]\nssid = w3\n[wifi]\nssid = w4\n",
+          &config, &parser);
+    TEST_ASSERT_EQ(0, parser.errors);
+    TEST_ASSERT_EQ(APP_CONFIG_MAX_WIFI, config.wifi_count);
+    TEST_ASSERT_STR_EQ("legacy", config.wifi[0].ssid);
+    TEST_ASSERT_STR_EQ("", config.wifi[0].password);
+    TEST_ASSERT_STR_EQ("w1", config.wifi[1].ssid);
+    TEST_ASSERT_STR_EQ("w3", config.wifi[3].ssid);
+}
+
+// [wifi]可重复APP_CONFIG_MAX_WIFI次, 多出的节整节忽略; 没有SSID的节被去掉, 每个节从默认值开始
+static void test_repeated_wifi_sections(void) {
+    app_config_t config;
+    cfg_parser_t parser;
+    parse("[wifi]\nssid = w1\npassword = p1\n"
+          "[wifi]\npassword = orphan\n"
+          "[wifi]\nssid = w2\n"
+          "[wifi]\nssid = w3\npassword = p3\n"
+          "[wifi]\nssid = w4\n"
+          "[led]\nbrightness = 10\n",
+          &config, &parser);
+    TEST_ASSERT_EQ(1, parser.errors);
+    TEST_ASSERT_EQ(11, parser.error_line);
+    TEST_ASSERT(strstr(parser.error, "too many sections") != NULL);
+    TEST_ASSERT_EQ(3, config.wifi_count);
+    TEST_ASSERT_STR_EQ("w1", config.wifi[0].ssid);
+    TEST_ASSERT_STR_EQ("p1", config.wifi[0].password);
+    TEST_ASSERT_STR_EQ("w2", config.wifi[1].ssid);
+    TEST_ASSERT_STR_EQ("", config.wifi[1].password);
+    TEST_ASSERT_STR_EQ("w3", config.wifi[2].ssid);
+    TEST_ASSERT_STR_EQ("p3", config.wifi[2].password);
+    // 之后的节照常解析
+    TEST_ASSERT_EQ(10, config.led_brightness);
+
+    // SSID最长32字节
+    parse("[wifi]\nssid = 0123456789abcdef0123456789abcdef\n[wifi]\nssid = 0123456789abcdef0123456789abcdefX\n",
+          &config, &parser);
+    TEST_ASSERT_EQ(1, parser.errors);
+    TEST_ASSERT(strstr(parser.error, "value too long") != NULL);
+    TEST_ASSERT_EQ(1, config.wifi_count);
+}
+
+// [ntp]的server可重复APP_CONFIG_MAX_NTP次, 一个都没有时使用pool.ntp.org
+static void test_ntp_servers(void) {
+    app_config_t config;
+    cfg_parser_t parser;
+    parse("[ntp]\nserver = ntp.aliyun.com\nserver = time.cloudflare.com\ntimezone = UTC0\n", &config, &parser);
+    TEST_ASSERT_EQ(0, parser.errors);
+    TEST_ASSERT_EQ(2, config.ntp_count);
+    TEST_ASSERT_STR_EQ("ntp.aliyun.com", config.ntp_server[0]);
+    TEST_ASSERT_STR_EQ("time.cloudflare.com", config.ntp_server[1]);
+    TEST_ASSERT_STR_EQ("UTC0", config.timezone);
+
+    parse("[ntp]\nserver = a\nserver = b\nserver = c\nserver = d\nserver = e\n", &config, &parser);
+    TEST_ASSERT_EQ(1, parser.errors);
+    TEST_ASSERT_EQ(6, parser.error_line);
+    TEST_ASSERT(strstr(parser.error, "too many values") != NULL);
+    TEST_ASSERT_EQ(APP_CONFIG_MAX_NTP, config.ntp_count);
+    TEST_ASSERT_STR_EQ("d", config.ntp_server[3]);
+
+    // 只有时区时服务器仍是默认值
+    parse("[ntp]\ntimezone = CET-1CEST\n", &config, &parser);
+    TEST_ASSERT_EQ(1, config.ntp_count);
+    TEST_ASSERT_STR_EQ("pool.ntp.org", config.ntp_server[0]);
+    TEST_ASSERT_STR_EQ("CET-1CEST", config.timezone);
+}
+
+// 越界或无法解析的整数被拒绝, 字段保持默认值
+static void test_int_bounds(void) {
+    static const struct {
+        const char *text;
+        const char *error;      // NULL表示接受
+        int brightness;
+        int frame_ms;
+    } cases[] = {
+        { "[led]\nbrightness = 0\nframe_ms = 5\n", NULL, 0, 5 },
+        { "[led]\nbrightness = 0xFF\nframe_ms = 1000\n", NULL, 255, 1000 },
+        { "[led]\nbrightness = 256\n", "out of range", 255, 20 },
+        { "[led]\nbrightness = -1\n", "out of range", 255, 20 },
+        { "[led]\nframe_ms = 4\n", "out of range", 255, 20 },
+        { "[led]\nframe_ms = 1001\n", "out of range", 255, 20 },
+        { "[led]\nbrightness = 12abc\n", "invalid value", 255, 20 },
+        { "[led]\nbrightness =\n", "invalid value", 255, 20 },
+        // 64位long截断到int32后会是0, 5和-4294967295
+        { "[led]\nbrightness = 4294967296\n", "invalid value", 255, 20 },
+        { "[led]\nframe_ms = 4294967301\n", "invalid value", 255, 20 },
+        { "[led]\nbrightness = -4294967295\n", "invalid value", 255, 20 },
+        { "[led]\nbrightness = 99999999999999999999\n", "invalid value", 255, 20 },
+        { "[led]\ngamma = on\n", NULL, 255, 20 },
+        { "[led]\ngamma = maybe\n", "invalid value", 255, 20 },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        app_config_t config;
+        cfg_parser_t parser;
+        parse(cases[i].text, &config, &parser);
+        if (cases[i].error) {
+            TEST_ASSERT_EQ(1, parser.errors);
+            TEST_ASSERT_EQ(2, parser.error_line);
+            TEST_ASSERT(strstr(parser.error, cases[i].error) != NULL);
+        } else {
+            TEST_ASSERT_EQ(0, parser.errors);
+        }
+        TEST_ASSERT_EQ(cases[i].brightness, config.led_brightness);
+        TEST_ASSERT_EQ(cases[i].frame_ms, config.led_frame_ms);
+    }
+}
+
+// app_config_diff只报告变化所在的分组
+static void test_diff_groups(void) {
+    app_config_t a, b;
+    const char *base = "[wifi]\nssid = w1\npassword = p1\n[ntp]\nserver = s1\n[led]\n[display]\n";
+    parse(base, &a, NULL);
+    parse(base, &b, NULL);
+    TEST_ASSERT_EQ(0, app_config_diff(&a, &b));
+
+    static const struct {
+        const char *text;
+        uint32_t changed;
+    } cases[] = {
+        { "[wifi]\nssid = w1\npassword = p2\n[ntp]\nserver = s1\n", APP_CONFIG_CHANGED_WIFI },
+        { "[wifi]\nssid = w1\npassword = p1\n[wifi]\nssid = w2\n[ntp]\nserver = s1\n", APP_CONFIG_CHANGED_WIFI },
+        { "wifi ssid: w1\nwifi passport: p1\n[ntp]\nserver = s1\n", 0 },
+        { "[wifi]\nssid = w1\npassword = p1\n[ntp]\nserver = s2\n", APP_CONFIG_CHANGED_NTP },
+        { "[wifi]\nssid = w1\npassword = p1\n", APP_CONFIG_CHANGED_NTP },
+        { "[wifi]\nssid = w1\npassword = p1\n[ntp]\nserver = s1\nserver = s2\n", APP_CONFIG_CHANGED_NTP },
+        { "[wifi]\nssid = w1\npassword = p1\n[ntp]\nserver = s1\ntimezone = UTC0\n", APP_CONFIG_CHANGED_TIMEZONE },
+        { "[wifi]\nssid = w1\npassword = p1\n[ntp]\nserver = s1\n[led]\nframe_ms = 40\n", APP_CONFIG_CHANGED_LED },
+        { "[wifi]\nssid = w1\npassword = p1\n[ntp]\nserver = s1\n[led]\ngamma = yes\n", APP_CONFIG_CHANGED_LED },
+        { "[wifi]\nssid = w1\npassword = p1\n[ntp]\nserver = s1\n[display]\nflip = true\n", APP_CONFIG_CHANGED_DISPLAY },
+        { "[ntp]\nserver = s1\ntimezone = UTC0\n[led]\nbrightness = 1\n[display]\ncontrast = 1\n",
+          APP_CONFIG_CHANGED_WIFI | APP_CONFIG_CHANGED_TIMEZONE | APP_CONFIG_CHANGED_LED | APP_CONFIG_CHANGED_DISPLAY },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        parse(cases[i].text, &b, NULL);
+        TEST_ASSERT_EQ(cases[i].changed, app_config_diff(&a, &b));
+        TEST_ASSERT_EQ(cases[i].changed, app_config_diff(&b, &a));
+    }
+}
+
+int main(void) {
+    RUN_TEST(test_defaults);
+    RUN_TEST(test_legacy_wifi_first);
+    RUN_TEST(test_repeated_wifi_sections);
+    RUN_TEST(test_ntp_servers);
+    RUN_TEST(test_int_bounds);
+    RUN_TEST(test_diff_groups);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,56 @@
+#ifndef __TEST_HOST_H__
+#define __TEST_HOST_H__
+
+// 主机测试的最小断言框架 每个测试程序包含一次
+//
+//   static void test_xxx(void) { TEST_ASSERT(...); TEST_ASSERT_EQ(a, b); }
+//   int main(void) { RUN_TEST(test_xxx); return TEST_SUMMARY(); }
+
+#include <stdio.h>
+#include <string.h>
+
+static int test_failures = 0;
+static int test_count = 0;
+static const char *test_current = NULL;
+
+#define TEST_FAIL_AT(fmt, ...) do {                                                 \
+        fprintf(stderr, "%s:%d: %s: " fmt "\n", __FILE__, __LINE__,                 \
+                test_current, ##__VA_ARGS__);                                       \
+        test_failures++;                                                            \
+        return;                                                                     \
+    } while (0)
+
+#define TEST_ASSERT(cond) do {                                                      \
+        if (!(cond)) {                                                              \
+            TEST_FAIL_AT("%s", #cond);                                              \
+        }                                                                           \
+    } while (0)
+
+#define TEST_ASSERT_EQ(expected, actual) do {                                       \
+        long long e_ = (long long)(expected);                                       \
+        long long a_ = (long long)(actual);                                         \
+        if (e_ != a_) {                                                             \
+            TEST_FAIL_AT("%s == %s, expected %lld got %lld",                        \
+                         #expected, #actual, e_, a_);                               \
+        }                                                                           \
+    } while (0)
+
+#define TEST_ASSERT_STR_EQ(expected, actual) do {                                   \
+        const char *e_ = (expected);                                                \
+        const char *a_ = (actual);                                                  \
+        if (strcmp(e_, a_) != 0) {                                                  \
+            TEST_FAIL_AT("%s, expected \"%s\" got \"%s\"", #actual, e_, a_);        \
+        }                                                                           \
+    } while (0)
+
+#define RUN_TEST(fn) do {                                                           \
+        int before_ = test_failures;                                                \
+        test_current = #fn;                                                         \
+        test_count++;                                                               \
+        fn();                                                                       \
+        printf("%s %s\n", test_failures == before_ ? "PASS" : "FAIL", #fn);         \
+    } while (0)
+
+#define TEST_SUMMARY() (printf("%d tests, %d failures\n", test_count, test_failures), test_failures != 0)
+
+#endif // __TEST_HOST_H__
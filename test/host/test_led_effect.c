@@ -0,0 +1,99 @@
+// 灯效引擎测试: 彩虹色相在长灯带上的取模, 关键帧轨道在第一帧之前的取值
+
+#include <stdio.h>
+#include "led_effect.h"
+#include "fake_rmt.h"
+#include "test_host.h"
+
+static int64_t fake_now_us = 0;
+
+int64_t esp_timer_get_time(void) {
+    return fake_now_us;
+}
+
+static ws2812_strip_t *strip = NULL;
+
+static void engine_init(led_engine_t *engine, size_t led_num) {
+    ws2812_strip_config_t config = {.gpio_num = 0, .led_num = led_num};
+    ESP_ERROR_CHECK(ws2812_new_strip(&config, &strip));
+    ESP_ERROR_CHECK(led_engine_init(engine, strip, led_num, 20));
+}
+
+static void engine_deinit(led_engine_t *engine) {
+    if (engine->type == LED_EFFECT_KEYFRAME) {
+        free(engine->keyframe.hold_until);
+    }
+    free(engine->pixels);
+    vSemaphoreDelete(engine->lock);
+    ws2812_del_strip(strip);
+}
+
+static bool color_eq(rgb_color a, rgb_color b) {
+    return a.red == b.red && a.green == b.green && a.blue == b.blue;
+}
+
+// 相邻色相差400时每96个像素色相转过整数圈, 颜色应完全相同,
+// 包括i * spread超过65535之后的像素
+static void test_rainbow_hue_wraps_in_32_bits(void) {
+    led_engine_t engine;
+    engine_init(&engine, 400);
+    led_engine_set_rainbow(&engine, 0, 400);
+    led_engine_render(&engine, 0);
+
+    TEST_ASSERT(color_eq((rgb_color){255, 0, 0}, engine.pixels[0]));
+    for (size_t i = 96; i < 400; i++) {
+        if (!color_eq(engine.pixels[i - 96], engine.pixels[i])) {
+            TEST_FAIL_AT("pixel %zu differs from pixel %zu", i, i - 96);
+        }
+    }
+    engine_deinit(&engine);
+}
+
+// 色相随时间前进 同一时刻重复渲染不产生变化
+static void test_rainbow_skips_unchanged_hue(void) {
+    led_engine_t engine;
+    engine_init(&engine, 10);
+    led_engine_set_rainbow(&engine, 1536, 10);
+    TEST_ASSERT_EQ(10, led_engine_render(&engine, 0));
+    TEST_ASSERT_EQ(0, led_engine_render(&engine, 0));
+    TEST_ASSERT(led_engine_render(&engine, 100) > 0);
+    engine_deinit(&engine);
+}
+
+static const led_keyframe_t late_frames[] = {
+    {.time_ms = 500,  .color = {.red = 200, .green = 0,   .blue = 0}},
+    {.time_ms = 1000, .color = {.red = 0,   .green = 200, .blue = 0}},
+    {.time_ms = 1500, .color = {.red = 0,   .green = 0,   .blue = 0}},
+};
+
+// 第一帧不在0时刻时, 之前的时间保持第一帧的颜色
+static void test_keyframe_before_first_frame(void) {
+    const bool modes[] = {true, false};
+    for (int m = 0; m < 2; m++) {
+        led_engine_t engine;
+        engine_init(&engine, 1);
+        led_keyframe_track_t track = {.frames = late_frames, .count = 3, .interpolate = modes[m]};
+        TEST_ASSERT_EQ(ESP_OK, led_engine_set_keyframes(&engine, &track));
+
+        led_engine_render(&engine, 100);
+        TEST_ASSERT(color_eq(late_frames[0].color, engine.pixels[0]));
+        // 保持到第一帧开始, 期间不再计算
+        TEST_ASSERT_EQ(400, engine.keyframe.hold_until[0] - 100);
+
+        led_engine_render(&engine, 750);
+        rgb_color expected = modes[m] ? (rgb_color){.red = 100, .green = 100, .blue = 0} : late_frames[0].color;
+        TEST_ASSERT(color_eq(expected, engine.pixels[0]));
+
+        // 下一圈的开头同样处理
+        led_engine_render(&engine, 1500 + 200);
+        TEST_ASSERT(color_eq(late_frames[0].color, engine.pixels[0]));
+        engine_deinit(&engine);
+    }
+}
+
+int main(void) {
+    RUN_TEST(test_rainbow_hue_wraps_in_32_bits);
+    RUN_TEST(test_rainbow_skips_unchanged_hue);
+    RUN_TEST(test_keyframe_before_first_frame);
+    return TEST_SUMMARY();
+}
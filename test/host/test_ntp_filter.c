@@ -0,0 +1,421 @@
+// NTP报文与滤波测试: 本机UDP上的替身服务器按配置注入去程/回程延迟、服务器处理时间和时钟偏差,
+// 客户端按ntp_client.c的方式请求和解析, 检查偏差/延迟计算、最小延迟选择、多服务器合成和异常应答的过滤
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#include "ntp_filter.h"
+#include "test_host.h"
+
+#define RECV_TIMEOUT_MS 300
+#define TOLERANCE_US    5000    // 线程调度带来的误差
+
+// 替身服务器 收到请求后按当前配置应答
+typedef struct {
+    int64_t offset_us;     // 服务器时钟领先本地的量
+    int64_t out_us;        // 去程延迟 (服务器记录接收时刻之前等待)
+    int64_t hold_us;       // 服务器处理时间 (接收与发送时刻之间)
+    int64_t back_us;       // 回程延迟 (服务器记录发送时刻之后等待)
+    uint8_t stratum;
+    bool bad_originate;    // 应答中的originate与请求不一致
+    bool drop;             // 不应答
+} server_config_t;
+
+typedef struct {
+    int sock;
+    struct sockaddr_in addr;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    server_config_t config;
+    atomic_bool stop;
+} fake_server_t;
+
+// 两个服务器在main中启动, 各测试只修改配置, 断言失败提前返回时线程仍可安全运行
+static fake_server_t servers[2];
+
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void sleep_us(int64_t us) {
+    if (us > 0) {
+        struct timespec ts = {.tv_sec = us / 1000000, .tv_nsec = us % 1000000 * 1000};
+        nanosleep(&ts, NULL);
+    }
+}
+
+static void write_ts(uint8_t *p, int64_t utc_us) {
+    uint32_t sec = (uint32_t)(utc_us / 1000000 + NTP_UNIX_OFFSET);
+    uint32_t frac = (uint32_t)(((uint64_t)(utc_us % 1000000) << 32) / 1000000);
+    for (int i = 0; i < 4; i++) {
+        p[i] = sec >> (24 - 8 * i);
+        p[4 + i] = frac >> (24 - 8 * i);
+    }
+}
+
+static void *server_task(void *arg) {
+    fake_server_t *server = arg;
+    while (!atomic_load(&server->stop)) {
+        uint8_t packet[NTP_PACKET_SIZE];
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        ssize_t len = recvfrom(server->sock, packet, sizeof(packet), 0, (struct sockaddr *)&from, &from_len);
+        if (len != NTP_PACKET_SIZE) {
+            continue;   // 超时后检查stop
+        }
+        pthread_mutex_lock(&server->lock);
+        server_config_t config = server->config;
+        pthread_mutex_unlock(&server->lock);
+        if (config.drop) {
+            continue;
+        }
+
+        sleep_us(config.out_us);
+        int64_t t2 = now_us() + config.offset_us;
+        sleep_us(config.hold_us);
+
+        uint8_t reply[NTP_PACKET_SIZE] = {0};
+        reply[0] = (0 << 6) | (4 << 3) | 4;  // LI=0, VN=4, Mode=4(服务器)
+        reply[1] = config.stratum;
+        memcpy(reply + 24, packet + 40, 8);  // originate = 请求的发送时间戳
+        if (config.bad_originate) {
+            reply[31] ^= 0xff;
+        }
+        write_ts(reply + 32, t2);
+        write_ts(reply + 40, now_us() + config.offset_us);
+        sleep_us(config.back_us);
+        sendto(server->sock, reply, sizeof(reply), 0, (struct sockaddr *)&from, from_len);
+    }
+    return NULL;
+}
+
+static void server_start(fake_server_t *server) {
+    memset(server, 0, sizeof(*server));
+    server->config.stratum = 2;
+    pthread_mutex_init(&server->lock, NULL);
+    server->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    struct timeval tv = {.tv_sec = 0, .tv_usec = 20000};
+    setsockopt(server->sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    server->addr.sin_family = AF_INET;
+    server->addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    server->addr.sin_port = 0;
+    bind(server->sock, (struct sockaddr *)&server->addr, sizeof(server->addr));
+    socklen_t len = sizeof(server->addr);
+    getsockname(server->sock, (struct sockaddr *)&server->addr, &len);
+    pthread_create(&server->thread, NULL, server_task, server);
+}
+
+static void server_stop(fake_server_t *server) {
+    atomic_store(&server->stop, true);
+    pthread_join(server->thread, NULL);
+    close(server->sock);
+    pthread_mutex_destroy(&server->lock);
+}
+
+static void server_configure(fake_server_t *server, server_config_t config) {
+    if (!config.stratum) {
+        config.stratum = 2;
+    }
+    pthread_mutex_lock(&server->lock);
+    server->config = config;
+    pthread_mutex_unlock(&server->lock);
+}
+
+static void server_set_stratum(fake_server_t *server, uint8_t stratum) {
+    pthread_mutex_lock(&server->lock);
+    server->config.stratum = stratum;
+    pthread_mutex_unlock(&server->lock);
+}
+
+static int client_socket(void) {
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    struct timeval tv = {.tv_sec = 0, .tv_usec = RECV_TIMEOUT_MS * 1000};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return sock;
+}
+
+// 与ntp_client.c中的ntp_query相同: 丢弃不匹配的应答直到超时
+static bool query(int sock, const fake_server_t *server, ntp_sample_t *sample) {
+    uint8_t packet[NTP_PACKET_SIZE];
+    int64_t t1 = now_us();
+    ntp_build_request(packet, t1);
+    if (sendto(sock, packet, sizeof(packet), 0, (const struct sockaddr *)&server->addr, sizeof(server->addr)) < 0) {
+        return false;
+    }
+    int64_t deadline = t1 + RECV_TIMEOUT_MS * 1000;
+    while (now_us() < deadline) {
+        ssize_t len = recv(sock, packet, sizeof(packet), 0);
+        int64_t t4 = now_us();
+        if (len < 0) {
+            return false;
+        }
+        if (ntp_parse_response(packet, (int)len, t1, t4, sample)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int64_t abs64(int64_t v) {
+    return v < 0 ? -v : v;
+}
+
+// 对称延迟时偏差无偏, 延迟为去程+回程
+static void test_symmetric_delay(void) {
+    fake_server_t *server = &servers[0];
+    int sock = client_socket();
+
+    server_configure(server, (server_config_t){.offset_us = 1500000, .out_us = 3000, .back_us = 3000});
+    ntp_sample_t sample;
+    TEST_ASSERT(query(sock, server, &sample));
+    TEST_ASSERT(abs64(sample.offset_us - 1500000) < TOLERANCE_US);
+    TEST_ASSERT(sample.delay_us >= 6000 && sample.delay_us < 6000 + TOLERANCE_US);
+
+    // 本地时钟领先时偏差为负
+    server_configure(server, (server_config_t){.offset_us = -250000});
+    TEST_ASSERT(query(sock, server, &sample));
+    TEST_ASSERT(abs64(sample.offset_us + 250000) < TOLERANCE_US);
+
+    close(sock);
+}
+
+// 服务器处理时间不计入往返延迟, 也不影响偏差
+static void test_server_hold_excluded(void) {
+    fake_server_t *server = &servers[0];
+    int sock = client_socket();
+
+    server_configure(server, (server_config_t){.offset_us = 40000, .hold_us = 20000});
+    ntp_sample_t sample;
+    TEST_ASSERT(query(sock, server, &sample));
+    TEST_ASSERT(sample.delay_us < TOLERANCE_US);
+    TEST_ASSERT(abs64(sample.offset_us - 40000) < TOLERANCE_US);
+
+    close(sock);
+}
+
+// 非对称延迟使单个样本偏差out/2-back/2, 滤波器选用延迟最小的样本
+static void test_filter_picks_min_delay(void) {
+    fake_server_t *server = &servers[0];
+    int sock = client_socket();
+    ntp_filter_t filter;
+    ntp_filter_reset(&filter);
+
+    const int64_t truth = 100000;
+    int64_t worst = truth;
+    for (int i = 0; i < NTP_FILTER_STAGES; i++) {
+        server_config_t config = {.offset_us = truth, .out_us = 30000, .back_us = 0};
+        if (i == 5) {
+            config.out_us = 500;   // 只有这一轮网络通畅
+            config.back_us = 500;
+        }
+        server_configure(server, config);
+        ntp_sample_t sample;
+        TEST_ASSERT(query(sock, server, &sample));
+        ntp_filter_add(&filter, &sample);
+        if (abs64(sample.offset_us - truth) > abs64(worst - truth)) {
+            worst = sample.offset_us;
+        }
+    }
+    TEST_ASSERT_EQ(NTP_FILTER_STAGES, filter.count);
+    TEST_ASSERT_EQ(0xff, filter.reach);
+    TEST_ASSERT(worst - truth > 15000 - TOLERANCE_US);        // 拥塞样本偏差约15ms
+    TEST_ASSERT(abs64(filter.offset_us - truth) < TOLERANCE_US);
+    TEST_ASSERT(filter.delay_us < 1000 + TOLERANCE_US);
+    TEST_ASSERT(filter.jitter_us > 10000);                    // 其余样本相对最优样本约15ms
+
+    // 本地时钟修正后样本随之平移
+    ntp_filter_shift(&filter, filter.offset_us);
+    TEST_ASSERT_EQ(0, filter.offset_us);
+
+    close(sock);
+}
+
+// 两个服务器 距离超过最优服务器2倍的不参与合成
+static void test_combine_servers(void) {
+    fake_server_t *near = &servers[0], *far = &servers[1];
+    int sock = client_socket();
+    ntp_filter_t filters[2];
+    ntp_filter_reset(&filters[0]);
+    ntp_filter_reset(&filters[1]);
+
+    server_configure(near, (server_config_t){.offset_us = 20000, .out_us = 1000, .back_us = 1000});
+    server_configure(far, (server_config_t){.offset_us = 35000, .out_us = 25000, .back_us = 25000});
+    for (int i = 0; i < 3; i++) {
+        ntp_sample_t sample;
+        TEST_ASSERT(query(sock, near, &sample));
+        ntp_filter_add(&filters[0], &sample);
+        TEST_ASSERT(query(sock, far, &sample));
+        ntp_filter_add(&filters[1], &sample);
+    }
+
+    int64_t offset;
+    uint32_t jitter, selected;
+    TEST_ASSERT_EQ(1, ntp_combine(filters, 2, &offset, &jitter, &selected));
+    TEST_ASSERT_EQ(0x1, selected);
+    TEST_ASSERT(abs64(offset - 20000) < TOLERANCE_US);
+
+    // 近的服务器失联后由远的服务器提供偏差
+    for (int i = 0; i < 8; i++) {
+        ntp_filter_miss(&filters[0]);
+    }
+    TEST_ASSERT_EQ(1, ntp_combine(filters, 2, &offset, &jitter, &selected));
+    TEST_ASSERT_EQ(0x2, selected);
+    TEST_ASSERT(abs64(offset - 35000) < TOLERANCE_US);
+
+    // 延迟相近的服务器按距离加权平均
+    server_configure(far, (server_config_t){.offset_us = 30000, .out_us = 1000, .back_us = 1000});
+    ntp_filter_reset(&filters[1]);
+    ntp_sample_t sample;
+    TEST_ASSERT(query(sock, near, &sample));
+    ntp_filter_add(&filters[0], &sample);
+    TEST_ASSERT(query(sock, far, &sample));
+    ntp_filter_add(&filters[1], &sample);
+    TEST_ASSERT_EQ(2, ntp_combine(filters, 2, &offset, &jitter, &selected));
+    TEST_ASSERT(offset > 20000 - TOLERANCE_US && offset < 30000 + TOLERANCE_US);
+
+    close(sock);
+}
+
+// 过期/伪造的应答、KoD和未同步的服务器都不产生样本
+static void test_reject_bad_responses(void) {
+    fake_server_t *server = &servers[0];
+    int sock = client_socket();
+    ntp_filter_t filter;
+    ntp_filter_reset(&filter);
+    ntp_sample_t sample;
+
+    server_configure(server, (server_config_t){.bad_originate = true});
+    TEST_ASSERT(!query(sock, server, &sample));
+    server_configure(server, (server_config_t){0});
+    server_set_stratum(server, 0);   // KoD
+    TEST_ASSERT(!query(sock, server, &sample));
+    server_set_stratum(server, 16);  // 未同步
+    TEST_ASSERT(!query(sock, server, &sample));
+    server_configure(server, (server_config_t){.drop = true});
+    TEST_ASSERT(!query(sock, server, &sample));
+    ntp_filter_miss(&filter);
+    TEST_ASSERT_EQ(0, filter.reach);
+
+    // 之后正常的应答仍可解析
+    server_configure(server, (server_config_t){.offset_us = 5000});
+    TEST_ASSERT(query(sock, server, &sample));
+    ntp_filter_add(&filter, &sample);
+    TEST_ASSERT_EQ(0x1, filter.reach);
+
+    // 报文过短
+    uint8_t packet[NTP_PACKET_SIZE] = {0};
+    TEST_ASSERT(!ntp_parse_response(packet, NTP_PACKET_SIZE - 1, 0, 0, &sample));
+
+    close(sock);
+}
+
+// 本地时钟慢50ppm: 每轮偏差按NTP_SLEW_PPM平滑修正, 频率环路应收敛到+50000ppb
+static void test_discipline_converges(void) {
+    ntp_discipline_t disc = {0};
+    const int64_t drift_ppb = 50000;
+    const int64_t interval_us = 16000000;
+    int64_t now = 0, offset = 0;
+    int32_t freq = 0;
+    for (int i = 0; i < 40; i++) {
+        int64_t slewed = interval_us * NTP_SLEW_PPM / 1000000;
+        int64_t residual = offset > slewed ? offset - slewed : (offset < -slewed ? offset + slewed : 0);
+        offset = residual + (drift_ppb - freq) * interval_us / 1000000000;
+        now += interval_us;
+        freq = ntp_discipline_update(&disc, offset, now);
+    }
+    TEST_ASSERT(abs64(freq - drift_ppb) < drift_ppb / 100);
+
+    // 跳变之后第一次偏差只作为新的基准
+    ntp_discipline_step(&disc);
+    TEST_ASSERT_EQ(freq, ntp_discipline_update(&disc, 900000, now + interval_us));
+    // 间隔太短时不估计频率
+    TEST_ASSERT_EQ(freq, ntp_discipline_update(&disc, 0, now + interval_us + 1000));
+}
+
+// 按ntp_poll_round的顺序: 加入样本前计入平滑调整的进度, 校正前计入到校正时刻, 然后开始新的校正.
+// 本地时钟慢40ms且没有频差, 平滑调整以500ppm进行, 样本偏差为当时尚未修正的部分
+static void add_sample(ntp_filter_t *filter, const ntp_slew_t *slew, int64_t offset, int64_t delay, int64_t time) {
+    ntp_filter_follow(filter, slew, time);
+    ntp_filter_add(filter, &(ntp_sample_t){.offset_us = offset, .delay_us = delay, .time_us = time});
+}
+
+static void correct(ntp_filter_t *filter, ntp_slew_t *slew, int64_t now, int64_t step) {
+    ntp_filter_follow(filter, slew, now);
+    ntp_filter_correct(filter, step);
+    slew->start_us = now;
+    slew->amount_us = step ? 0 : filter->offset_us;
+}
+
+static void test_filter_follows_slew(void) {
+    ntp_filter_t filter;
+    ntp_filter_reset(&filter);
+    ntp_slew_t slew = {0};
+    ntp_discipline_t disc = {0};
+
+    for (int i = 0; i < NTP_FILTER_STAGES; i++) {
+        add_sample(&filter, &slew, 40000, i == 3 ? 1000 : 2000, i * 1000000LL);
+    }
+    TEST_ASSERT_EQ(40000, filter.offset_us);
+    TEST_ASSERT_EQ(0, ntp_discipline_update(&disc, filter.offset_us, 8000000));
+    correct(&filter, &slew, 8000000, 0);
+    // 刚开始平滑调整, 时钟还没有变化, 样本不能当作已修正
+    TEST_ASSERT_EQ(40000, filter.offset_us);
+
+    // 20s后修正了10ms, 旧样本平移同样的量, 与新样本一致
+    add_sample(&filter, &slew, 30000, 5000, 28000000);
+    TEST_ASSERT_EQ(30000, filter.offset_us);
+    TEST_ASSERT_EQ(1000, filter.delay_us);
+    TEST_ASSERT_EQ(0, filter.jitter_us);
+    TEST_ASSERT_EQ(0, ntp_discipline_update(&disc, filter.offset_us, 28000000));
+
+    // 新的校正丢弃未完成的平滑调整, 以剩余的30ms重新开始
+    correct(&filter, &slew, 28000000, 0);
+    add_sample(&filter, &slew, 25000, 5000, 38000000);
+    TEST_ASSERT_EQ(25000, filter.offset_us);
+    TEST_ASSERT_EQ(0, filter.jitter_us);
+    TEST_ASSERT_EQ(0, ntp_discipline_update(&disc, filter.offset_us, 38000000));
+
+    // 平滑调整完成后 (30ms / 500ppm = 60s) 不再平移
+    add_sample(&filter, &slew, 0, 5000, 100000000);
+    TEST_ASSERT_EQ(0, filter.offset_us);
+    add_sample(&filter, &slew, 0, 5000, 200000000);
+    TEST_ASSERT_EQ(0, filter.offset_us);
+    TEST_ASSERT_EQ(0, filter.jitter_us);
+
+    // 跳变立即计入, 之后没有平滑调整
+    add_sample(&filter, &slew, -300000, 100, 201000000);
+    correct(&filter, &slew, 201000000, -300000);
+    TEST_ASSERT_EQ(0, filter.offset_us);
+    add_sample(&filter, &slew, 0, 100, 300000000);
+    TEST_ASSERT_EQ(0, filter.offset_us);
+
+    // 负向调整
+    slew = (ntp_slew_t){.start_us = 1000000, .amount_us = -1000};
+    TEST_ASSERT_EQ(0, ntp_slew_done(&slew, 0));
+    TEST_ASSERT_EQ(-500, ntp_slew_done(&slew, 2000000));
+    TEST_ASSERT_EQ(-1000, ntp_slew_done(&slew, 60000000));
+}
+
+int main(void) {
+    server_start(&servers[0]);
+    server_start(&servers[1]);
+    RUN_TEST(test_symmetric_delay);
+    RUN_TEST(test_server_hold_excluded);
+    RUN_TEST(test_filter_picks_min_delay);
+    RUN_TEST(test_combine_servers);
+    RUN_TEST(test_reject_bad_responses);
+    RUN_TEST(test_discipline_converges);
+    RUN_TEST(test_filter_follows_slew);
+    server_stop(&servers[0]);
+    server_stop(&servers[1]);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,117 @@
+// OLED字模测试: RLE压缩的字库和图片逐像素解码后与原始数据相同
+// 同一个字模分别用按像素写入的参照实现, 原始数据的OLED_SetBlock和RLE数据的OLED_SetBlockRLE
+// 画到显存上, 比较整个显存. 位置包括跨页的纵坐标和超出屏幕右下边缘的裁剪, 两种颜色模式,
+// 显存预先填入随机内容, 字模范围外的像素不能被改动
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "oled.h"
+#include "oled_ref.h"
+#include "test_host.h"
+
+extern uint8_t OLED_GRAM[8][128];
+
+static uint8_t s_background[8][128];
+
+static const struct {
+    uint8_t x, y;
+} s_positions[] = {
+    {0, 0}, {5, 3}, {40, 8}, {60, 17}, {100, 39}, {120, 20}, {123, 45}, {127, 63},
+};
+
+static void fill_background(unsigned seed) {
+    srand(seed);
+    for (int p = 0; p < 8; p++) {
+        for (int c = 0; c < 128; c++) {
+            s_background[p][c] = (uint8_t)rand();
+        }
+    }
+}
+
+typedef void (*draw_fn)(uint8_t x, uint8_t y, OLED_ColorMode color, const void *arg);
+
+// 在所有位置和颜色模式下比较两种画法的结果
+static bool same_pixels(draw_fn expected, draw_fn actual, const void *arg) {
+    uint8_t want[8][128];
+    for (size_t i = 0; i < sizeof(s_positions) / sizeof(s_positions[0]); i++) {
+        for (int color = OLED_COLOR_NORMAL; color <= OLED_COLOR_REVERSED; color++) {
+            memcpy(OLED_GRAM, s_background, sizeof(OLED_GRAM));
+            expected(s_positions[i].x, s_positions[i].y, color, arg);
+            memcpy(want, OLED_GRAM, sizeof(want));
+            memcpy(OLED_GRAM, s_background, sizeof(OLED_GRAM));
+            actual(s_positions[i].x, s_positions[i].y, color, arg);
+            if (memcmp(want, OLED_GRAM, sizeof(want)) != 0) {
+                fprintf(stderr, "pixels differ at (%u, %u), color %d\n", s_positions[i].x, s_positions[i].y, color);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static int s_char;
+
+static void glyph_ref(uint8_t x, uint8_t y, OLED_ColorMode color, const void *arg) {
+    const ASCIIFont *font = arg;
+    oled_ref_set_block(x, y, font->chars + s_char * ((font->h + 7) / 8) * font->w, font->w, font->h, color);
+}
+
+static void glyph_raw(uint8_t x, uint8_t y, OLED_ColorMode color, const void *arg) {
+    OLED_PrintASCIIChar(x, y, ' ' + s_char, arg, color);
+}
+
+static void glyph_rle(uint8_t x, uint8_t y, OLED_ColorMode color, const void *arg) {
+    OLED_PrintASCIIChar(x, y, ' ' + s_char, &afont24x12_rle, color);
+}
+
+// 所有可打印字符: 原始字模与参照一致, RLE字模与参照一致
+static void test_ascii_font_rle(void) {
+    fill_background(1);
+    TEST_ASSERT_EQ(afont24x12.h, afont24x12_rle.h);
+    TEST_ASSERT_EQ(afont24x12.w, afont24x12_rle.w);
+    for (s_char = 0; s_char < 95; s_char++) {
+        TEST_ASSERT(same_pixels(glyph_ref, glyph_raw, &afont24x12));
+        TEST_ASSERT(same_pixels(glyph_ref, glyph_rle, &afont24x12));
+    }
+}
+
+static void image_ref(uint8_t x, uint8_t y, OLED_ColorMode color, const void *arg) {
+    oled_ref_set_block(x, y, bilibiliImg.data, bilibiliImg.w, bilibiliImg.h, color);
+}
+
+static void image_draw(uint8_t x, uint8_t y, OLED_ColorMode color, const void *arg) {
+    OLED_DrawImage(x, y, arg, color);
+}
+
+// 48像素高的图片, 页内的纵坐标不是8的倍数时跨7页
+static void test_image_rle(void) {
+    fill_background(2);
+    TEST_ASSERT(bilibiliImg_rle.rle);
+    TEST_ASSERT_EQ(bilibiliImg.w, bilibiliImg_rle.w);
+    TEST_ASSERT_EQ(bilibiliImg.h, bilibiliImg_rle.h);
+    TEST_ASSERT(same_pixels(image_ref, image_draw, &bilibiliImg));
+    TEST_ASSERT(same_pixels(image_ref, image_draw, &bilibiliImg_rle));
+}
+
+static void string_raw(uint8_t x, uint8_t y, OLED_ColorMode color, const void *arg) {
+    OLED_PrintASCIIString(x, y, (char *)arg, (ASCIIFont *)&afont24x12, color);
+}
+
+static void string_rle(uint8_t x, uint8_t y, OLED_ColorMode color, const void *arg) {
+    OLED_PrintString(x, y, (char *)arg, &font24x12_rle, color);
+}
+
+// 时钟界面的画法: OLED_PrintString经由font24x12_rle的ASCII字库
+static void test_clock_string(void) {
+    fill_background(3);
+    TEST_ASSERT(same_pixels(string_raw, string_rle, "12:34:56"));
+    TEST_ASSERT(same_pixels(string_raw, string_rle, "Az~ !@#"));
+}
+
+int main(void) {
+    RUN_TEST(test_ascii_font_rle);
+    RUN_TEST(test_image_rle);
+    RUN_TEST(test_clock_string);
+    return TEST_SUMMARY();
+}
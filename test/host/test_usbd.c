@@ -0,0 +1,268 @@
+// usbd事件队列测试: 控制器在"中断"中报告传输完成的速度超过tud_task()处理的速度, 其间不断推迟函数调用.
+// 设备栈是TinyUSB的usbd.c, 配置中只有一个厂商接口, 由测试中的类驱动接收传输完成,
+// 控制器是一个只登记传输的替身. 传输完成的长度是序号, 用来检查每个事件都按顺序送达
+
+#include <stdint.h>
+#include "tusb.h"
+#include "device/dcd.h"
+#include "device/usbd_pvt.h"
+#include "test_host.h"
+
+#define EP_OUT      0x01
+#define EP_IN       0x81
+#define EP_SIZE     64
+#define ROUNDS      50
+
+static const tusb_desc_device_t s_desc_device = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = 0x303A,
+    .idProduct = 0x4002,
+    .bcdDevice = 0x0100,
+    .bNumConfigurations = 1,
+};
+
+static const uint8_t s_desc_config[] = {
+    TUD_CONFIG_DESCRIPTOR(1, 1, 0, TUD_CONFIG_DESC_LEN + TUD_VENDOR_DESC_LEN, 0x00, 100),
+    TUD_VENDOR_DESCRIPTOR(0, 0, EP_OUT, EP_IN, EP_SIZE),
+};
+
+uint8_t const *tud_descriptor_device_cb(void) {
+    return (uint8_t const *)&s_desc_device;
+}
+
+uint8_t const *tud_descriptor_configuration_cb(uint8_t index) {
+    return s_desc_config;
+}
+
+uint16_t const *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+    return NULL;
+}
+
+uint32_t tusb_time_millis_api(void) {
+    return 0;
+}
+
+//--------------------------------------------------------------------+
+// 控制器: 只记下端点0上的传输
+//--------------------------------------------------------------------+
+static bool s_ep0_in_busy;
+
+bool dcd_init(uint8_t rhport, const tusb_rhport_init_t *rh_init) {
+    return true;
+}
+
+bool dcd_deinit(uint8_t rhport) {
+    return true;
+}
+
+void dcd_int_handler(uint8_t rhport) {}
+void dcd_int_enable(uint8_t rhport) {}
+void dcd_int_disable(uint8_t rhport) {}
+void dcd_remote_wakeup(uint8_t rhport) {}
+void dcd_connect(uint8_t rhport) {}
+void dcd_disconnect(uint8_t rhport) {}
+void dcd_sof_enable(uint8_t rhport, bool en) {}
+void dcd_edpt0_status_complete(uint8_t rhport, tusb_control_request_t const *request) {}
+void dcd_edpt_close_all(uint8_t rhport) {}
+void dcd_edpt_close(uint8_t rhport, uint8_t ep_addr) {}
+void dcd_edpt_stall(uint8_t rhport, uint8_t ep_addr) {}
+void dcd_edpt_clear_stall(uint8_t rhport, uint8_t ep_addr) {}
+
+void dcd_set_address(uint8_t rhport, uint8_t dev_addr) {
+    dcd_edpt_xfer(rhport, tu_edpt_addr(0, TUSB_DIR_IN), NULL, 0);
+}
+
+bool dcd_edpt_open(uint8_t rhport, tusb_desc_endpoint_t const *desc_ep) {
+    return true;
+}
+
+bool dcd_edpt_xfer(uint8_t rhport, uint8_t ep_addr, uint8_t *buffer, uint16_t total_bytes) {
+    if (ep_addr == 0x80) {
+        s_ep0_in_busy = true;
+    }
+    return true;
+}
+
+bool dcd_edpt_iso_alloc(uint8_t rhport, uint8_t ep_addr, uint16_t largest_packet_size) {
+    return false;
+}
+
+bool dcd_edpt_iso_activate(uint8_t rhport, tusb_desc_endpoint_t const *desc_ep) {
+    return false;
+}
+
+//--------------------------------------------------------------------+
+// 类驱动: 按端点记录收到的传输完成, 检查序号连续
+//--------------------------------------------------------------------+
+static uint32_t s_xfers;
+static uint32_t s_xfer_next;        // 下一个传输完成应带的序号
+static uint32_t s_xfer_out_of_order;
+static uint32_t s_calls;
+static uint32_t s_call_next;
+static uint32_t s_call_out_of_order;
+static uint32_t s_wakeups;          // 成功放入事件队列的函数调用唤醒
+
+static void app_init(void) {}
+
+static bool app_deinit(void) {
+    return true;
+}
+
+static void app_reset(uint8_t rhport) {}
+
+static uint16_t app_open(uint8_t rhport, tusb_desc_interface_t const *itf_desc, uint16_t max_len) {
+    TU_VERIFY(itf_desc->bInterfaceClass == TUSB_CLASS_VENDOR_SPECIFIC, 0);
+    uint8_t ep_out, ep_in;
+    TU_ASSERT(usbd_open_edpt_pair(rhport, tu_desc_next(itf_desc), 2, TUSB_XFER_BULK, &ep_out, &ep_in), 0);
+    return sizeof(tusb_desc_interface_t) + 2 * sizeof(tusb_desc_endpoint_t);
+}
+
+static bool app_control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const *request) {
+    return false;
+}
+
+static bool app_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes) {
+    if (xferred_bytes != s_xfer_next || ep_addr != ((xferred_bytes & 1) ? EP_IN : EP_OUT)) {
+        s_xfer_out_of_order++;
+    }
+    s_xfer_next = xferred_bytes + 1;
+    s_xfers++;
+    return true;
+}
+
+static const usbd_class_driver_t s_app_driver = {
+    .name = "test",
+    .init = app_init,
+    .deinit = app_deinit,
+    .reset = app_reset,
+    .open = app_open,
+    .control_xfer_cb = app_control_xfer_cb,
+    .xfer_cb = app_xfer_cb,
+};
+
+usbd_class_driver_t const *usbd_app_driver_get_cb(uint8_t *driver_count) {
+    *driver_count = 1;
+    return &s_app_driver;
+}
+
+void tud_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr) {
+    if (eventid == USBD_EVENT_FUNC_CALL) {
+        s_wakeups++;
+    }
+}
+
+static void deferred_call(void *param) {
+    if ((uintptr_t)param != s_call_next) {
+        s_call_out_of_order++;
+    }
+    s_call_next = (uintptr_t)param + 1;
+    s_calls++;
+}
+
+// 中断中报告的传输完成, 序号为奇数的在IN端点上
+static void xfer_complete_isr(uint32_t seq) {
+    dcd_event_xfer_complete(0, (seq & 1) ? EP_IN : EP_OUT, seq, XFER_RESULT_SUCCESS, true);
+}
+
+static void reset_counters(void) {
+    s_xfers = s_xfer_next = s_xfer_out_of_order = 0;
+    s_calls = s_call_next = s_call_out_of_order = 0;
+    s_wakeups = 0;
+    tud_event_stats_reset();
+}
+
+static void mount(void) {
+    tusb_init();
+    dcd_event_bus_reset(0, TUSB_SPEED_FULL, false);
+    tud_task();
+    const uint8_t setup[8] = { TUSB_REQ_RCPT_DEVICE, TUSB_REQ_SET_CONFIGURATION, 1, 0, 0, 0, 0, 0 };
+    dcd_event_setup_received(0, setup, false);
+    tud_task();
+    // 状态阶段
+    if (s_ep0_in_busy) {
+        s_ep0_in_busy = false;
+        dcd_event_xfer_complete(0, 0x80, 0, XFER_RESULT_SUCCESS, false);
+        tud_task();
+    }
+}
+
+static void test_mounted(void) {
+    TEST_ASSERT(tud_mounted());
+}
+
+// 每轮把事件队列填到只剩唤醒的位置, 每隔一个传输完成推迟一次函数调用, 直到函数队列也满, 然后才运行任务
+static void test_xfer_flood_with_deferred_calls(void) {
+    reset_counters();
+    uint32_t seq = 0, calls = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < CFG_TUD_TASK_QUEUE_SZ - 1; i++) {
+            xfer_complete_isr(seq++);
+            if (i % 2 == 0 && i / 2 < CFG_TUD_TASK_FUNC_QUEUE_SZ) {
+                usbd_defer_func(deferred_call, (void *)(uintptr_t)calls++, true);
+            }
+        }
+        tud_task();
+        TEST_ASSERT_EQ(seq, s_xfers);
+        TEST_ASSERT_EQ(calls, s_calls);
+    }
+    TEST_ASSERT_EQ(0, s_xfer_out_of_order);
+    TEST_ASSERT_EQ(0, s_call_out_of_order);
+    TEST_ASSERT_EQ(ROUNDS, s_wakeups);
+
+    tud_event_stats_t stats;
+    tud_event_stats_get(&stats);
+    TEST_ASSERT_EQ(seq, stats.handled[DCD_EVENT_XFER_COMPLETE]);
+    TEST_ASSERT_EQ(calls, stats.handled[USBD_EVENT_FUNC_CALL]);
+    TEST_ASSERT_EQ(CFG_TUD_TASK_QUEUE_SZ, stats.queue_high_water);
+    TEST_ASSERT_EQ(CFG_TUD_TASK_FUNC_QUEUE_SZ, stats.func_queue_high_water);
+    TEST_ASSERT_EQ(0, stats.func_batched);
+    TEST_ASSERT_EQ(0, stats.func_wakeup_overflow);
+    for (int i = 0; i < DCD_EVENT_COUNT; i++) {
+        TEST_ASSERT_EQ(0, stats.overflow[i]);
+    }
+}
+
+// 事件队列已满时推迟的函数留在函数队列中: 唤醒记入func_wakeup_overflow, 任务取走一个事件后重新发送
+static void test_deferred_call_with_full_event_queue(void) {
+    reset_counters();
+    for (uint32_t seq = 0; seq < CFG_TUD_TASK_QUEUE_SZ; seq++) {
+        xfer_complete_isr(seq);
+    }
+    usbd_defer_func(deferred_call, (void *)0, true);
+    usbd_defer_func(deferred_call, (void *)1, true);
+
+    tud_event_stats_t stats;
+    tud_event_stats_get(&stats);
+    TEST_ASSERT_EQ(2, stats.func_wakeup_overflow);
+    TEST_ASSERT_EQ(0, stats.overflow[USBD_EVENT_FUNC_CALL]);
+    TEST_ASSERT_EQ(0, s_wakeups);
+
+    tud_task();
+    TEST_ASSERT_EQ(CFG_TUD_TASK_QUEUE_SZ, s_xfers);
+    TEST_ASSERT_EQ(2, s_calls);
+    TEST_ASSERT_EQ(0, s_xfer_out_of_order);
+    TEST_ASSERT_EQ(0, s_call_out_of_order);
+    TEST_ASSERT_EQ(1, s_wakeups);
+
+    // 之后的唤醒照常进入事件队列, 没有多余的重发
+    usbd_defer_func(deferred_call, (void *)2, true);
+    TEST_ASSERT_EQ(2, s_wakeups);
+    tud_task();
+    TEST_ASSERT_EQ(3, s_calls);
+    tud_event_stats_get(&stats);
+    TEST_ASSERT_EQ(2, stats.func_wakeup_overflow);
+    for (int i = 0; i < DCD_EVENT_COUNT; i++) {
+        TEST_ASSERT_EQ(0, stats.overflow[i]);
+    }
+}
+
+int main(void) {
+    mount();
+    RUN_TEST(test_mounted);
+    RUN_TEST(test_xfer_flood_with_deferred_calls);
+    RUN_TEST(test_deferred_call_with_full_event_queue);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,381 @@
+// Wi-Fi状态机测试: 用模拟的事件循环和驱动运行wifi_sm
+//
+// 事件循环按时间顺序分发事件, 动作的执行顺序与esp32_wifi.c的wifi_sm_apply相同.
+// 模拟的驱动在CONNECT后按AP的状态送入ASSOC/GOT_IP或DISCONNECTED, DISCONNECT后送入DISCONNECTED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wifi_sm.h"
+#include "test_host.h"
+
+#define ASSOC_MS        40    // 关联耗时
+#define DHCP_MS         300   // 获取IP耗时
+#define FAIL_MS         1200  // 关联失败前的扫描/认证耗时
+#define DISCONNECT_MS   5     // 主动断开后驱动送出断开事件的延迟
+#define MAX_EVENTS      64
+#define MAX_RECORDS     256
+
+typedef struct {
+    uint32_t at_ms;
+    wifi_sm_event_t event;
+    uint32_t generation;  // 驱动事件所属的连接 旧连接的事件在重新连接后作废
+} sched_event_t;
+
+typedef struct {
+    wifi_sm_t sm;
+    uint32_t now_ms;
+
+    sched_event_t queue[MAX_EVENTS];
+    int queue_num;
+    bool timer_armed;
+    uint32_t timer_at_ms;
+
+    // 模拟的AP和驱动
+    bool ap_up;           // AP是否可连接
+    bool cached_ap_ok;    // 缓存的BSSID/信道是否仍有效
+    bool dhcp_ok;
+    bool scanning;        // 驱动是否已切换为全信道扫描
+    bool associated;
+    uint32_t generation;
+
+    // 记录
+    uint32_t connects;
+    uint32_t use_scan;
+    uint32_t link_up;
+    uint32_t link_down;
+    uint32_t failed;
+    uint32_t rssi_samples;
+    bool link;
+    uint32_t backoff_ms[MAX_RECORDS];  // 每次进入退避时的等待时间
+    int backoff_num;
+} fake_loop_t;
+
+static void post(fake_loop_t *loop, uint32_t delay_ms, wifi_sm_event_t event) {
+    if (loop->queue_num < MAX_EVENTS) {
+        loop->queue[loop->queue_num++] = (sched_event_t){loop->now_ms + delay_ms, event, loop->generation};
+    }
+}
+
+// 驱动开始一次连接
+static void driver_connect(fake_loop_t *loop) {
+    loop->generation++;
+    bool reachable = loop->ap_up && (loop->scanning || loop->cached_ap_ok);
+    if (reachable) {
+        post(loop, ASSOC_MS, WIFI_SM_EV_ASSOC);
+        if (loop->dhcp_ok) {
+            post(loop, ASSOC_MS + DHCP_MS, WIFI_SM_EV_GOT_IP);
+        }
+        loop->associated = true;
+    } else {
+        post(loop, FAIL_MS, WIFI_SM_EV_DISCONNECTED);
+        loop->associated = false;
+    }
+}
+
+static void driver_disconnect(fake_loop_t *loop) {
+    loop->generation++;
+    loop->associated = false;
+    post(loop, DISCONNECT_MS, WIFI_SM_EV_DISCONNECTED);
+}
+
+static void apply(fake_loop_t *loop, uint32_t act) {
+    if (act & WIFI_SM_ACT_USE_SCAN) {
+        loop->use_scan++;
+        loop->scanning = true;
+    }
+    if (act & WIFI_SM_ACT_DISCONNECT) {
+        driver_disconnect(loop);
+    }
+    if (act & (WIFI_SM_ACT_CANCEL_TIMER | WIFI_SM_ACT_ARM_TIMER)) {
+        loop->timer_armed = false;
+    }
+    if (act & WIFI_SM_ACT_ARM_TIMER) {
+        loop->timer_armed = true;
+        loop->timer_at_ms = loop->now_ms + loop->sm.timer_ms;
+        if (loop->sm.state == WIFI_STATE_BACKOFF && loop->backoff_num < MAX_RECORDS) {
+            loop->backoff_ms[loop->backoff_num++] = loop->sm.timer_ms;
+        }
+    }
+    if (act & WIFI_SM_ACT_CONNECT) {
+        loop->connects++;
+        driver_connect(loop);
+    }
+    if (act & WIFI_SM_ACT_SAMPLE_RSSI) {
+        loop->rssi_samples++;
+        wifi_sm_rssi(&loop->sm, -50 - (int)(loop->rssi_samples % 5));
+    }
+    if (act & WIFI_SM_ACT_FAILED) {
+        loop->failed++;
+    }
+    if (act & WIFI_SM_ACT_LINK_UP) {
+        if (loop->link) {
+            fprintf(stderr, "link up while already up at %u ms\n", loop->now_ms);
+            abort();
+        }
+        loop->link = true;
+        loop->link_up++;
+    }
+    if (act & WIFI_SM_ACT_LINK_DOWN) {
+        if (!loop->link) {
+            fprintf(stderr, "link down while already down at %u ms\n", loop->now_ms);
+            abort();
+        }
+        loop->link = false;
+        loop->link_down++;
+    }
+}
+
+static void loop_init(fake_loop_t *loop, bool fast_path, uint32_t max_retry) {
+    memset(loop, 0, sizeof(*loop));
+    wifi_sm_init(&loop->sm, fast_path, max_retry);
+    loop->ap_up = true;
+    loop->cached_ap_ok = true;
+    loop->dhcp_ok = true;
+    loop->scanning = !fast_path;
+}
+
+static void send(fake_loop_t *loop, wifi_sm_event_t event) {
+    apply(loop, wifi_sm_event(&loop->sm, event));
+}
+
+// 运行事件循环直到until_ms
+static void run_until(fake_loop_t *loop, uint32_t until_ms) {
+    while (1) {
+        int next = -1;
+        for (int i = 0; i < loop->queue_num; i++) {
+            if (next < 0 || loop->queue[i].at_ms < loop->queue[next].at_ms) {
+                next = i;
+            }
+        }
+        bool timer = loop->timer_armed && (next < 0 || loop->timer_at_ms < loop->queue[next].at_ms);
+        uint32_t at = timer ? loop->timer_at_ms : next >= 0 ? loop->queue[next].at_ms : UINT32_MAX;
+        if (at > until_ms) {
+            loop->now_ms = until_ms;
+            return;
+        }
+        loop->now_ms = at;
+        if (timer) {
+            loop->timer_armed = false;
+            send(loop, WIFI_SM_EV_TIMER);
+            continue;
+        }
+        sched_event_t ev = loop->queue[next];
+        loop->queue[next] = loop->queue[--loop->queue_num];
+        // 连接已被重新发起, 旧连接的关联/IP事件不会再到来
+        if (ev.generation != loop->generation && ev.event != WIFI_SM_EV_DISCONNECTED) {
+            continue;
+        }
+        if (ev.event == WIFI_SM_EV_DISCONNECTED && ev.generation == loop->generation) {
+            loop->associated = false;
+        }
+        send(loop, ev.event);
+    }
+}
+
+// 驱动侧的变化
+static void ap_drop(fake_loop_t *loop) {
+    loop->ap_up = false;
+    if (loop->associated) {
+        driver_disconnect(loop);
+    }
+}
+
+static void test_connect_fast_path(void) {
+    fake_loop_t loop;
+    loop_init(&loop, true, 5);
+    send(&loop, WIFI_SM_EV_START);
+    TEST_ASSERT_EQ(WIFI_STATE_CONNECTING, loop.sm.state);
+    run_until(&loop, 1000);
+
+    TEST_ASSERT_EQ(WIFI_STATE_CONNECTED, loop.sm.state);
+    TEST_ASSERT_EQ(1, loop.connects);
+    TEST_ASSERT_EQ(1, loop.link_up);
+    TEST_ASSERT_EQ(0, loop.use_scan);
+    TEST_ASSERT(loop.sm.fast_path_ok);
+    TEST_ASSERT_EQ(1, loop.sm.attempts);
+
+    // 连接后每WIFI_SM_RSSI_PERIOD_MS采样一次
+    run_until(&loop, 1000 + 3 * WIFI_SM_RSSI_PERIOD_MS);
+    TEST_ASSERT_EQ(4, loop.rssi_samples);
+    TEST_ASSERT(loop.sm.rssi_min <= -50 && loop.sm.rssi_min >= -54);
+    TEST_ASSERT(loop.sm.rssi_avg_x16 / 16 <= -50 && loop.sm.rssi_avg_x16 / 16 >= -54);
+}
+
+// 缓存的AP失效: 只失败一次就改为扫描, 不会反复发出USE_SCAN
+static void test_cached_ap_falls_back_to_scan(void) {
+    fake_loop_t loop;
+    loop_init(&loop, true, 5);
+    loop.cached_ap_ok = false;
+    send(&loop, WIFI_SM_EV_START);
+    run_until(&loop, 5000);
+
+    TEST_ASSERT_EQ(WIFI_STATE_CONNECTED, loop.sm.state);
+    TEST_ASSERT_EQ(1, loop.use_scan);
+    TEST_ASSERT_EQ(2, loop.connects);
+    TEST_ASSERT_EQ(1, loop.backoff_num);
+    TEST_ASSERT_EQ(WIFI_SM_BACKOFF_MIN_MS, loop.backoff_ms[0]);
+    TEST_ASSERT(!loop.sm.fast_path_ok);
+}
+
+// AP不可用: 退避时间逐次加倍到上限, 第max_retry次失败时上报一次, 之后继续重试
+static void test_backoff_doubles_and_caps(void) {
+    fake_loop_t loop;
+    loop_init(&loop, false, 5);
+    loop.ap_up = false;
+    send(&loop, WIFI_SM_EV_START);
+    run_until(&loop, 10 * 60 * 1000);
+
+    TEST_ASSERT(loop.backoff_num > 10);
+    uint32_t expect = WIFI_SM_BACKOFF_MIN_MS;
+    for (int i = 0; i < loop.backoff_num; i++) {
+        TEST_ASSERT_EQ(expect, loop.backoff_ms[i]);
+        expect = expect * 2 > WIFI_SM_BACKOFF_MAX_MS ? WIFI_SM_BACKOFF_MAX_MS : expect * 2;
+    }
+    TEST_ASSERT_EQ(WIFI_SM_BACKOFF_MAX_MS, loop.backoff_ms[loop.backoff_num - 1]);
+    TEST_ASSERT_EQ(1, loop.failed);
+    TEST_ASSERT_EQ(0, loop.link_up);
+    TEST_ASSERT_EQ(loop.backoff_num, loop.sm.retry);
+
+    // AP恢复后在下一次重试时连上, 退避重置
+    loop.ap_up = true;
+    run_until(&loop, loop.now_ms + WIFI_SM_BACKOFF_MAX_MS + 1000);
+    TEST_ASSERT_EQ(WIFI_STATE_CONNECTED, loop.sm.state);
+    TEST_ASSERT_EQ(0, loop.sm.retry);
+    TEST_ASSERT_EQ(WIFI_SM_BACKOFF_MIN_MS, loop.sm.backoff_ms);
+}
+
+// 连接后掉线: 链路下线一次, 短暂退避后重连
+static void test_disconnect_while_connected(void) {
+    fake_loop_t loop;
+    loop_init(&loop, false, 5);
+    send(&loop, WIFI_SM_EV_START);
+    run_until(&loop, 1000);
+    TEST_ASSERT_EQ(WIFI_STATE_CONNECTED, loop.sm.state);
+
+    ap_drop(&loop);
+    run_until(&loop, 1100);
+    TEST_ASSERT_EQ(WIFI_STATE_BACKOFF, loop.sm.state);
+    TEST_ASSERT_EQ(1, loop.link_down);
+    TEST_ASSERT_EQ(1, loop.sm.disconnects);
+    TEST_ASSERT_EQ(WIFI_SM_BACKOFF_MIN_MS, loop.backoff_ms[0]);
+
+    loop.ap_up = true;
+    run_until(&loop, 3000);
+    TEST_ASSERT_EQ(WIFI_STATE_CONNECTED, loop.sm.state);
+    TEST_ASSERT_EQ(2, loop.link_up);
+    TEST_ASSERT_EQ(2, loop.sm.connects);
+}
+
+// 关联成功但拿不到IP: 超时后主动断开, 驱动随后的断开事件不再计为一次失败
+static void test_dhcp_timeout(void) {
+    fake_loop_t loop;
+    loop_init(&loop, false, 5);
+    loop.dhcp_ok = false;
+    send(&loop, WIFI_SM_EV_START);
+    run_until(&loop, WIFI_SM_CONNECT_TIMEOUT_MS + 100);
+
+    TEST_ASSERT_EQ(WIFI_STATE_BACKOFF, loop.sm.state);
+    TEST_ASSERT_EQ(1, loop.sm.timeouts);
+    TEST_ASSERT_EQ(1, loop.sm.retry);
+    TEST_ASSERT_EQ(1, loop.backoff_num);
+
+    loop.dhcp_ok = true;
+    run_until(&loop, WIFI_SM_CONNECT_TIMEOUT_MS + 2000);
+    TEST_ASSERT_EQ(WIFI_STATE_CONNECTED, loop.sm.state);
+    TEST_ASSERT_EQ(1, loop.link_up);
+    TEST_ASSERT_EQ(0, loop.link_down);
+}
+
+// IP丢失但仍关联: 等待DHCP恢复, 不重新连接; 超时后才断开重连
+static void test_lost_ip(void) {
+    fake_loop_t loop;
+    loop_init(&loop, false, 5);
+    send(&loop, WIFI_SM_EV_START);
+    run_until(&loop, 1000);
+
+    send(&loop, WIFI_SM_EV_LOST_IP);
+    TEST_ASSERT_EQ(WIFI_STATE_CONNECTING, loop.sm.state);
+    TEST_ASSERT_EQ(1, loop.link_down);
+    send(&loop, WIFI_SM_EV_GOT_IP);
+    TEST_ASSERT_EQ(WIFI_STATE_CONNECTED, loop.sm.state);
+    TEST_ASSERT_EQ(2, loop.link_up);
+    TEST_ASSERT_EQ(1, loop.connects);
+
+    send(&loop, WIFI_SM_EV_LOST_IP);
+    run_until(&loop, loop.now_ms + WIFI_SM_CONNECT_TIMEOUT_MS + 10);
+    TEST_ASSERT_EQ(WIFI_STATE_BACKOFF, loop.sm.state);
+    TEST_ASSERT_EQ(1, loop.sm.timeouts);
+    TEST_ASSERT_EQ(2, loop.link_down);
+    run_until(&loop, loop.now_ms + 2000);
+    TEST_ASSERT_EQ(WIFI_STATE_CONNECTED, loop.sm.state);
+    TEST_ASSERT_EQ(2, loop.connects);
+}
+
+// 停止: 任何状态下都回到IDLE, 之后的断开事件和过期的定时器不再产生动作
+static void test_stop(void) {
+    const uint32_t stop_at[] = {10, 100, 1000, 1300};
+    for (size_t i = 0; i < sizeof(stop_at) / sizeof(stop_at[0]); i++) {
+        fake_loop_t loop;
+        loop_init(&loop, false, 5);
+        loop.ap_up = i != 3;  // 最后一种情况在退避中停止
+        send(&loop, WIFI_SM_EV_START);
+        run_until(&loop, stop_at[i]);
+        send(&loop, WIFI_SM_EV_STOP);
+        TEST_ASSERT_EQ(WIFI_STATE_IDLE, loop.sm.state);
+        TEST_ASSERT(!loop.timer_armed);
+        TEST_ASSERT_EQ(loop.link_up, loop.link_down);
+
+        uint32_t connects = loop.connects;
+        run_until(&loop, 60000);
+        TEST_ASSERT_EQ(WIFI_STATE_IDLE, loop.sm.state);
+        TEST_ASSERT_EQ(connects, loop.connects);
+        TEST_ASSERT_EQ(0, wifi_sm_event(&loop.sm, WIFI_SM_EV_DISCONNECTED));
+        TEST_ASSERT_EQ(0, wifi_sm_event(&loop.sm, WIFI_SM_EV_TIMER));
+        TEST_ASSERT_EQ(0, wifi_sm_event(&loop.sm, WIFI_SM_EV_STOP));
+
+        // 重新开始时退避从头计算
+        loop.ap_up = true;
+        send(&loop, WIFI_SM_EV_START);
+        run_until(&loop, 62000);
+        TEST_ASSERT_EQ(WIFI_STATE_CONNECTED, loop.sm.state);
+    }
+}
+
+// 随机的AP/DHCP变化和停止/启动: 链路上下线始终交替 (apply中检查), 状态与定时器一致
+static void test_random_events(void) {
+    fake_loop_t loop;
+    loop_init(&loop, true, 3);
+    loop.cached_ap_ok = false;
+    srand(37);
+    send(&loop, WIFI_SM_EV_START);
+    for (int step = 0; step < 20000; step++) {
+        run_until(&loop, loop.now_ms + rand() % 3000);
+        switch (rand() % 8) {
+        case 0: ap_drop(&loop); break;
+        case 1: loop.ap_up = true; break;
+        case 2: loop.dhcp_ok = !loop.dhcp_ok; break;
+        case 3: send(&loop, WIFI_SM_EV_LOST_IP); break;
+        case 4: if (rand() % 8 == 0) send(&loop, WIFI_SM_EV_STOP); break;
+        case 5: send(&loop, WIFI_SM_EV_START); break;
+        default: break;
+        }
+        TEST_ASSERT_EQ(loop.link, loop.sm.state == WIFI_STATE_CONNECTED);
+        TEST_ASSERT_EQ(loop.sm.state != WIFI_STATE_IDLE, loop.timer_armed);
+        TEST_ASSERT(loop.sm.backoff_ms >= WIFI_SM_BACKOFF_MIN_MS && loop.sm.backoff_ms <= WIFI_SM_BACKOFF_MAX_MS);
+    }
+    TEST_ASSERT(loop.link_up > 10);
+    TEST_ASSERT_EQ(1, loop.use_scan);
+}
+
+int main(void) {
+    RUN_TEST(test_connect_fast_path);
+    RUN_TEST(test_cached_ap_falls_back_to_scan);
+    RUN_TEST(test_backoff_doubles_and_caps);
+    RUN_TEST(test_disconnect_while_connected);
+    RUN_TEST(test_dhcp_timeout);
+    RUN_TEST(test_lost_ip);
+    RUN_TEST(test_stop);
+    RUN_TEST(test_random_events);
+    return TEST_SUMMARY();
+}
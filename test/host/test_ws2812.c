@@ -0,0 +1,168 @@
+// WS2812编码器测试: 通过替身RMT通道把像素编码成符号数组, 检查GRB顺序、位时序、
+// 亮度/伽马映射, 以及内存块分段填充时的结果与一次编码相同
+
+#include <stdio.h>
+#include "ws2812.h"
+#include "fake_rmt.h"
+#include "test_host.h"
+
+static ws2812_strip_t *new_strip(size_t led_num, size_t mem_block_symbols) {
+    ws2812_strip_config_t config = {
+        .gpio_num = 0,
+        .led_num = led_num,
+        .mem_block_symbols = mem_block_symbols,
+    };
+    ws2812_strip_t *strip = NULL;
+    ESP_ERROR_CHECK(ws2812_new_strip(&config, &strip));
+    return strip;
+}
+
+// 把8个符号解码回一个字节 时序不是合法的0码/1码时返回-1
+static int decode_byte(const rmt_symbol_word_t *symbols) {
+    int value = 0;
+    for (int bit = 0; bit < 8; bit++) {
+        const rmt_symbol_word_t *s = &symbols[bit];
+        if (s->level0 != 1 || s->level1 != 0) {
+            return -1;
+        }
+        if (s->duration0 == T1H && s->duration1 == T1L) {
+            value |= 0x80 >> bit;
+        } else if (s->duration0 != T0H || s->duration1 != T0L) {
+            return -1;
+        }
+    }
+    return value;
+}
+
+static bool is_reset(const rmt_symbol_word_t *s) {
+    return s->level0 == 0 && s->level1 == 0 && s->duration0 + s->duration1 == RESET_DURATION;
+}
+
+static void test_encode_grb_order_and_timing(void) {
+    ws2812_strip_t *strip = new_strip(2, 0);
+    const rgb_color colors[2] = {
+        {.red = 0x12, .green = 0x80, .blue = 0x01},
+        {.red = 0xff, .green = 0x00, .blue = 0xa5},
+    };
+    TEST_ASSERT_EQ(ESP_OK, ws2812_strip_show(strip, colors, 2));
+
+    size_t num;
+    const rmt_symbol_word_t *symbols = fake_rmt_symbols(fake_rmt_last_channel(), &num);
+    TEST_ASSERT_EQ(2 * 24 + 1, num);
+    const int expected[6] = {0x80, 0x12, 0x01, 0x00, 0xff, 0xa5};
+    for (int i = 0; i < 6; i++) {
+        TEST_ASSERT_EQ(expected[i], decode_byte(&symbols[i * 8]));
+    }
+    TEST_ASSERT(is_reset(&symbols[48]));
+    ws2812_del_strip(strip);
+}
+
+static void test_encode_brightness(void) {
+    ws2812_strip_t *strip = new_strip(1, 0);
+    const rgb_color color = {.red = 255, .green = 128, .blue = 0};
+
+    TEST_ASSERT_EQ(ESP_OK, ws2812_strip_set_brightness(strip, 127, false));
+    TEST_ASSERT_EQ(ESP_OK, ws2812_strip_show(strip, &color, 1));
+    size_t num;
+    const rmt_symbol_word_t *symbols = fake_rmt_symbols(fake_rmt_last_channel(), &num);
+    TEST_ASSERT_EQ(25, num);
+    TEST_ASSERT_EQ(64, decode_byte(&symbols[0]));   // 128 * 128 / 256
+    TEST_ASSERT_EQ(127, decode_byte(&symbols[8]));  // 255 * 128 / 256
+    TEST_ASSERT_EQ(0, decode_byte(&symbols[16]));
+
+    // 亮度0时全部熄灭
+    TEST_ASSERT_EQ(ESP_OK, ws2812_strip_set_brightness(strip, 0, false));
+    TEST_ASSERT_EQ(ESP_OK, ws2812_strip_show(strip, &color, 1));
+    symbols = fake_rmt_symbols(fake_rmt_last_channel(), &num);
+    TEST_ASSERT_EQ(0, decode_byte(&symbols[0]));
+    TEST_ASSERT_EQ(0, decode_byte(&symbols[8]));
+    ws2812_del_strip(strip);
+}
+
+static void test_encode_gamma(void) {
+    ws2812_strip_t *strip = new_strip(1, 0);
+    const rgb_color color = {.red = 255, .green = 128, .blue = 1};
+
+    TEST_ASSERT_EQ(ESP_OK, ws2812_strip_set_brightness(strip, 255, true));
+    TEST_ASSERT_EQ(ESP_OK, ws2812_strip_show(strip, &color, 1));
+    size_t num;
+    const rmt_symbol_word_t *symbols = fake_rmt_symbols(fake_rmt_last_channel(), &num);
+    TEST_ASSERT_EQ(56, decode_byte(&symbols[0]));   // (128/255)^2.2 * 255
+    TEST_ASSERT_EQ(255, decode_byte(&symbols[8]));
+    TEST_ASSERT_EQ(0, decode_byte(&symbols[16]));
+    ws2812_del_strip(strip);
+}
+
+// 内存块不是8的整数倍时每次只能放下整字节, 余下的空间留空, 结果仍应连续正确
+static void test_encode_in_chunks(void) {
+    static rgb_color colors[100];
+    for (int i = 0; i < 100; i++) {
+        colors[i] = (rgb_color){.red = i, .green = 255 - i, .blue = i * 7};
+    }
+
+    const size_t blocks[] = {8, 60, 64, 1024};
+    for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+        ws2812_strip_t *strip = new_strip(100, blocks[b]);
+        TEST_ASSERT_EQ(ESP_OK, ws2812_strip_show(strip, colors, 100));
+
+        rmt_channel_handle_t channel = fake_rmt_last_channel();
+        size_t num;
+        const rmt_symbol_word_t *symbols = fake_rmt_symbols(channel, &num);
+        TEST_ASSERT_EQ(100 * 24 + 1, num);
+        for (int i = 0; i < 100; i++) {
+            TEST_ASSERT_EQ(colors[i].green, decode_byte(&symbols[i * 24 + 0]));
+            TEST_ASSERT_EQ(colors[i].red, decode_byte(&symbols[i * 24 + 8]));
+            TEST_ASSERT_EQ(colors[i].blue, decode_byte(&symbols[i * 24 + 16]));
+        }
+        TEST_ASSERT(is_reset(&symbols[2400]));
+        // 每次回调最多填满一个内存块
+        size_t per_call = blocks[b] / 8;
+        TEST_ASSERT(fake_rmt_encode_calls(channel) >= (300 + per_call - 1) / per_call);
+        ws2812_del_strip(strip);
+    }
+}
+
+// 数据超过灯带长度时截断
+static void test_encode_truncates_to_strip_length(void) {
+    ws2812_strip_t *strip = new_strip(2, 0);
+    const rgb_color colors[3] = {{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+    TEST_ASSERT_EQ(ESP_OK, ws2812_strip_show(strip, colors, 3));
+    size_t num;
+    fake_rmt_symbols(fake_rmt_last_channel(), &num);
+    TEST_ASSERT_EQ(2 * 24 + 1, num);
+    ws2812_del_strip(strip);
+}
+
+// 没有空闲的DMA通道时退回普通通道和默认内存块
+static void test_dma_fallback(void) {
+    fake_rmt_set_dma_channels(0);
+    ws2812_strip_config_t config = {.gpio_num = 0, .led_num = 10, .with_dma = true};
+    ws2812_strip_t *strip = NULL;
+    TEST_ASSERT_EQ(ESP_OK, ws2812_new_strip(&config, &strip));
+    const rgb_color colors[10] = {0};
+    TEST_ASSERT_EQ(ESP_OK, ws2812_strip_show(strip, colors, 10));
+    TEST_ASSERT(!fake_rmt_with_dma(fake_rmt_last_channel()));
+    TEST_ASSERT_EQ(WS2812_MEM_SYMBOLS, fake_rmt_mem_block_symbols(fake_rmt_last_channel()));
+    ws2812_del_strip(strip);
+    fake_rmt_set_dma_channels(1);
+}
+
+static void test_invalid_args(void) {
+    ws2812_strip_config_t config = {.gpio_num = 0, .led_num = 0};
+    ws2812_strip_t *strip = NULL;
+    TEST_ASSERT_EQ(ESP_ERR_INVALID_ARG, ws2812_new_strip(&config, &strip));
+    TEST_ASSERT_EQ(ESP_ERR_INVALID_ARG, ws2812_new_strip(NULL, &strip));
+    TEST_ASSERT_EQ(ESP_ERR_INVALID_ARG, ws2812_strip_show(NULL, NULL, 0));
+    TEST_ASSERT_EQ(ESP_ERR_INVALID_ARG, ws2812_strip_set_brightness(NULL, 0, false));
+}
+
+int main(void) {
+    RUN_TEST(test_encode_grb_order_and_timing);
+    RUN_TEST(test_encode_brightness);
+    RUN_TEST(test_encode_gamma);
+    RUN_TEST(test_encode_in_chunks);
+    RUN_TEST(test_encode_truncates_to_strip_length);
+    RUN_TEST(test_dma_fallback);
+    RUN_TEST(test_invalid_args);
+    return TEST_SUMMARY();
+}
@@ -0,0 +1,27 @@
+#ifndef __HOST_TUSB_CONFIG_H__
+#define __HOST_TUSB_CONFIG_H__
+
+// 主机上的TinyUSB配置: 无RTOS, 只有MSC, 控制器由fake_usb.c代替
+// MCU按目标ESP32-S3设置, 端点数等限制与目标相同, 但不编译它的dcd驱动
+// 队列和缓冲区大小与项目sdkconfig相同 (经stubs/sdkconfig.h)
+
+#include "sdkconfig.h"
+
+#define CFG_TUSB_MCU                OPT_MCU_ESP32S3
+#define CFG_TUSB_OS                 OPT_OS_NONE
+#define CFG_TUSB_RHPORT0_MODE       (OPT_MODE_DEVICE | OPT_MODE_FULL_SPEED)
+#define CFG_TUSB_DEBUG              0
+#define CFG_TUSB_MEM_SECTION
+#define CFG_TUSB_MEM_ALIGN          __attribute__((aligned(4)))
+
+#define CFG_TUD_ENDPOINT0_SIZE      64
+#define CFG_TUD_TASK_QUEUE_SZ       CONFIG_TINYUSB_TASK_QUEUE_SIZE
+#define CFG_TUD_TASK_FUNC_QUEUE_SZ  CONFIG_TINYUSB_TASK_FUNC_QUEUE_SIZE
+#define CFG_TUD_EVENT_STATS         CONFIG_TINYUSB_EVENT_STATS
+
+#ifndef CFG_TUD_MSC                 // test_usbd只用自己的类驱动
+#define CFG_TUD_MSC                 1
+#endif
+#define CFG_TUD_MSC_BUFSIZE         CONFIG_TINYUSB_MSC_BUFSIZE
+
+#endif // __HOST_TUSB_CONFIG_H__
@@ -14,11 +14,9 @@
 #include "esp_partition.h"
 #include "driver/gpio.h"
 #include "tinyusb.h"
+#include "tusb_tasks.h"
 #include "tusb_msc_storage.h"
-
-
-#define MAX_LINE_LENGTH 256
-#define MAX_VALUE_LENGTH 128
+#include "app_config.h"
 
 
 #ifdef CONFIG_EXAMPLE_STORAGE_MEDIA_SDMMC
@@ -119,6 +117,7 @@ static char const *string_desc_arr[] = {
 /*********************************************************************** TinyUSB descriptors*/
 
 #define BASE_PATH "/data" // base path to mount the partition
+#define APP_CONFIG_PATH BASE_PATH "/config.txt"
 
 #define PROMPT_STR CONFIG_IDF_TARGET
 
@@ -164,7 +163,8 @@ static int console_unmount(int argc, char **argv)
 // read BASE_PATH/README.MD and print its contents
 static int console_read(int argc, char **argv)
 {
-    if (tinyusb_msc_storage_in_use_by_usb_host()) {
+    // 共享模式下主机占用时仍可只读访问
+    if (tinyusb_msc_storage_in_use_by_usb_host() && !tinyusb_msc_storage_is_shared()) {
         ESP_LOGE(TAG, "storage exposed over USB. Application can't read from storage.");
         return -1;
     }
@@ -207,8 +207,21 @@ static int console_write(const char *filename)
     if (!fd) {
         ESP_LOGW(TAG, "config.txt doesn't exist yet, creating");
         fd = fopen(filename, "w");
-        fprintf(fd, "wifi ssid:\n");
-        fprintf(fd, "wifi passport:\n");
+        fprintf(fd, "# [wifi] 可以重复多次, 按顺序尝试\n");
+        fprintf(fd, "[wifi]\n");
+        fprintf(fd, "ssid =\n");
+        fprintf(fd, "password =\n");
+        fprintf(fd, "\n[ntp]\n");
+        fprintf(fd, "server = pool.ntp.org\n");
+        fprintf(fd, "server = ntp.aliyun.com\n");
+        fprintf(fd, "timezone = CST-8\n");
+        fprintf(fd, "\n[led]\n");
+        fprintf(fd, "brightness = 255\n");
+        fprintf(fd, "gamma = false\n");
+        fprintf(fd, "frame_ms = 20\n");
+        fprintf(fd, "\n[display]\n");
+        fprintf(fd, "contrast = 223\n");
+        fprintf(fd, "flip = false\n");
         fclose(fd);
     }    
     }
@@ -228,6 +241,129 @@ static int console_size(int argc, char **argv)
     return 0;
 }
 
+// Show whether the USB host owns the storage
+static int console_status(int argc, char **argv)
+{
+    printf("storage exposed over USB: %s\n", tinyusb_msc_storage_in_use_by_usb_host() ? "Yes" : "No");
+    return 0;
+}
+
+static void print_op_stats(const char *name, const tinyusb_msc_op_stats_t *op)
+{
+    printf("%-6s %8lu ops %10llu B %6lu err avg %6llu us max %7lu us\n", name,
+           op->count, op->bytes, op->errors, op->count ? op->total_us / op->count : 0, op->max_us);
+    // 延迟直方图 每行一个大小档: <=512B, <=4KB, >4KB; 列为 <64us, <128us ... <16ms, 其余
+    for (int size = 0; size < TINYUSB_MSC_STATS_SIZE_CLASSES; size++) {
+        printf("  ");
+        for (int i = 0; i < TINYUSB_MSC_STATS_LATENCY_BUCKETS; i++) {
+            printf(" %6lu", op->histogram[size][i]);
+        }
+        printf("\n");
+    }
+}
+
+// 打印MSC读写统计, 带参数"reset"时清零
+static int console_msc_stats(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        tinyusb_msc_storage_reset_stats();
+#if CFG_TUD_EVENT_STATS
+        tud_event_stats_reset();
+#endif
+        return 0;
+    }
+    tinyusb_msc_stats_t stats;
+    tinyusb_msc_storage_get_stats(&stats);
+    print_op_stats("read", &stats.read);
+    print_op_stats("write", &stats.write);
+    print_op_stats("erase", &stats.erase);
+    print_op_stats("unmap", &stats.unmap);
+    printf("erases skipped after unmap %lu\n", stats.erase_skipped);
+    printf("deferred writes %lu (max %lu, max wait %lu us)\n",
+           stats.defer_pending, stats.defer_max_pending, stats.defer_max_wait_us);
+    printf("throughput read %lu B/s write %lu B/s\n", stats.read_bytes_per_sec, stats.write_bytes_per_sec);
+    // 每MiB数据的回调次数, 由CONFIG_TINYUSB_MSC_BUFSIZE决定
+    printf("callbacks per MiB read %llu write %llu (buffer %d B)\n",
+           stats.read.bytes ? stats.read.count * 1048576ULL / stats.read.bytes : 0,
+           stats.write.bytes ? stats.write.count * 1048576ULL / stats.write.bytes : 0,
+           CONFIG_TINYUSB_MSC_BUFSIZE);
+    printf("unsupported scsi commands %lu (last 0x%02x)\n", stats.scsi_unsupported, stats.scsi_last_unsupported);
+#if CFG_TUD_EVENT_STATS
+    // USB事件队列 溢出即丢失了传输完成事件
+    tud_event_stats_t event_stats;
+    tud_event_stats_get(&event_stats);
+    printf("usb event queue high water %u/%u, sof coalesced %lu, overflow xfer %lu setup %lu func %lu sof %lu\n",
+           event_stats.queue_high_water, event_stats.queue_size, event_stats.sof_coalesced,
+           event_stats.overflow[DCD_EVENT_XFER_COMPLETE], event_stats.overflow[DCD_EVENT_SETUP_RECEIVED],
+           event_stats.overflow[USBD_EVENT_FUNC_CALL], event_stats.overflow[DCD_EVENT_SOF]);
+    printf("usb deferred queue high water %u/%u, batched %lu, wakeups resent %lu\n",
+           event_stats.func_queue_high_water, event_stats.func_queue_size, event_stats.func_batched,
+           event_stats.func_wakeup_overflow);
+    // 延迟直方图 列为 <32us, <64us ... <8ms, 其余
+    printf("usb event latency   ");
+    for (int i = 0; i < TUD_EVENT_LATENCY_BUCKETS; i++) {
+        printf(" %6lu", event_stats.event_latency[i]);
+    }
+    printf("\nusb deferred latency");
+    for (int i = 0; i < TUD_EVENT_LATENCY_BUCKETS; i++) {
+        printf(" %6lu", event_stats.func_latency[i]);
+    }
+    printf("\n");
+    // 挂载后空闲时唤醒应接近0
+    tusb_task_stats_t task_stats;
+    if (tusb_task_get_stats(&task_stats) == ESP_OK) {
+        printf("usb task wakeups %lu (%lu/s), sof only %lu (%lu/s)\n", task_stats.wakeups, task_stats.wakeups_per_sec,
+               task_stats.idle_wakeups, task_stats.idle_wakeups_per_sec);
+    }
+#endif
+    return 0;
+}
+
+// 在UART上启动控制台并注册上面的命令, 提示符为 "<目标>>"
+void console_start(void)
+{
+    static const esp_console_cmd_t cmds[] = {
+        {
+            .command = "read",
+            .help = "read BASE_PATH/README.MD and print its contents",
+            .func = &console_read,
+        },
+        {
+            .command = "size",
+            .help = "show storage size",
+            .func = &console_size,
+        },
+        {
+            .command = "expose",
+            .help = "unmount storage from the application and expose it to the USB host",
+            .func = &console_unmount,
+        },
+        {
+            .command = "status",
+            .help = "show whether storage is exposed over USB",
+            .func = &console_status,
+        },
+        {
+            .command = "msc_stats",
+            .help = "print MSC and USB event statistics, \"msc_stats reset\" clears them",
+            .hint = "[reset]",
+            .func = &console_msc_stats,
+        },
+    };
+
+    esp_console_repl_t *repl = NULL;
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    repl_config.prompt = PROMPT_STR ">";
+    repl_config.max_cmdline_length = 64;
+    esp_console_dev_uart_config_t hw_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    ESP_ERROR_CHECK(esp_console_new_repl_uart(&hw_config, &repl_config, &repl));
+    ESP_ERROR_CHECK(esp_console_register_help_command());
+    for (size_t i = 0; i < sizeof(cmds) / sizeof(cmds[0]); i++) {
+        ESP_ERROR_CHECK(esp_console_cmd_register(&cmds[i]));
+    }
+    ESP_ERROR_CHECK(esp_console_start_repl(repl));
+}
+
 esp_err_t storage_init_spiflash(wl_handle_t *wl_handle)
 {
     ESP_LOGI(TAG, "Initializing wear levelling");
@@ -241,93 +377,52 @@ esp_err_t storage_init_spiflash(wl_handle_t *wl_handle)
     return wl_mount(data_partition, wl_handle);
 }
 
+// 主机弹出U盘后存储重新挂载到应用时通知该任务重新读取config.txt
+static TaskHandle_t s_config_reload_task = NULL;
+
+void storage_set_reload_task(TaskHandle_t task)
+{
+    s_config_reload_task = task;
+}
+
 // callback that is delivered when storage is mounted/unmounted by application.
 void storage_mount_changed_cb(tinyusb_msc_event_t *event)
 {
     ESP_LOGI(TAG, "Storage mounted to application: %s", event->mount_changed_data.is_mounted ? "Yes" : "No");
-}
-
-void trim_whitespace(char *str) {
-    if (!str || !*str) return;
-    
-    // 去除尾部空白
-    char *end = str + strlen(str) - 1;
-    while (end > str && isspace((unsigned char)*end)) end--;
-    *(end + 1) = '\0';
-    
-    // 去除首部空白
-    char *start = str;
-    while (*start && isspace((unsigned char)*start)) start++;
-    
-    // 移动字符串内容
-    if (start != str) {
-        memmove(str, start, strlen(start) + 1);
+    if (event->mount_changed_data.is_mounted && s_config_reload_task) {
+        xTaskNotifyGive(s_config_reload_task);
     }
 }
 
-static WIFI config_read(const char *filename){
-    WIFI read_wifi;
-    char line[MAX_LINE_LENGTH];
-    char ssid[MAX_VALUE_LENGTH] = {0};
-    char password[MAX_VALUE_LENGTH] = {0};
-
-    FILE *fd = fopen(filename, "r");
-    
-    while (fgets(line, sizeof(line), fd)) {
-        // 查找冒号位置
-        char *colon = strchr(line, ':');
-        if (!colon) continue;  // 跳过没有冒号的行
-        
-        // 跳过冒号并移动到值的位置
-        char *value_start = colon + 1;
-        
-        // 去除值前后的空白字符
-        trim_whitespace(value_start);
-        
-        // 检查是否是SSID行
-        if (strstr(line, "wifi ssid") != NULL) {
-            strncpy(ssid, value_start, sizeof(ssid) - 1);
-        } 
-        // 检查是否是密码行
-        else if (strstr(line, "wifi passport") != NULL) {
-            strncpy(password, value_start, sizeof(password) - 1);
-        }
+// 解析config.txt并打印诊断信息 文件不存在时返回false, 配置为默认值
+bool config_load(const char *config_file, app_config_t *config){
+    cfg_parser_t parser;
+    if (!app_config_load(config_file, config, &parser)) {
+        ESP_LOGE(TAG, "can't open %s, using defaults", config_file);
+        return false;
     }
-
-    fclose(fd);
-
-    // 输出结果
-    if (ssid[0] != '\0') {
-        printf("提取的WiFi SSID: [%s]\n", ssid);
-    } else {
-        printf("未找到WiFi SSID\n");
+    ESP_LOGI(TAG, "config: %lu values, %d networks, %d NTP servers",
+             (unsigned long)parser.values, config->wifi_count, config->ntp_count);
+    if (parser.errors) {
+        ESP_LOGW(TAG, "config: %lu errors, first at line %lu: %s",
+                 (unsigned long)parser.errors, (unsigned long)parser.error_line, parser.error);
     }
-    
-    if (password[0] != '\0') {
-        printf("提取的WiFi密码: [%s]\n", password);
-    } else {
-        printf("未找到WiFi密码\n");
+    if (parser.unknown) {
+        ESP_LOGW(TAG, "config: %lu unknown keys ignored", (unsigned long)parser.unknown);
     }
-    strcpy(read_wifi.ssid , ssid);
-    strcpy(read_wifi.passport , password);
-    //printf("%s",read_wifi.ssid);
-    return read_wifi;
-
+    return true;
 }
 
-WIFI init_usb_device(){
-    WIFI wifi_log;
+// 读取config.txt 文件不存在时先创建模板, 解析错误不影响其余配置项
+void init_usb_device(app_config_t *config){
     const char *readme_file = BASE_PATH "/README.MD";
     if (access(readme_file, F_OK) == -1) {
         console_write(readme_file);
     }
-    const char *config_file = BASE_PATH "/config.txt";
-    if (access(config_file, F_OK) == -1) {
-        console_write(config_file);
+    if (access(APP_CONFIG_PATH, F_OK) == -1) {
+        console_write(APP_CONFIG_PATH);
     }
 
-    wifi_log = config_read(config_file);
-
-    return wifi_log;
+    config_load(APP_CONFIG_PATH, config);
 }
 #endif
\ No newline at end of file